@@ -43,6 +43,8 @@
 #include "Engine/Settings.h"
 #include "Engine/KnobTypes.h"
 #include "Engine/NoOp.h"
+#include "Engine/OutputSchedulerThread.h"
+#include "Engine/RenderWorker.h"
 
 using namespace Natron;
 
@@ -329,6 +331,34 @@ AppInstance::getWritersWorkForCL(const CLArgs& cl,std::list<AppInstance::RenderR
     }
 }
 
+void
+AppInstance::renderOnLocalWorkers(const CLArgs& cl,const QString& projectPath)
+{
+    const std::list<CLArgs::WriterArg>& writers = cl.getWriterArgs();
+    if (!cl.hasFrameRange() || writers.empty()) {
+        throw std::invalid_argument(tr("A Write node and a frame range must be given with the --workers option").toStdString());
+    }
+    
+    RenderCoordinator coordinator(projectPath, cl.getRenderWorkersCount());
+    for (std::list<CLArgs::WriterArg>::const_iterator it = writers.begin(); it != writers.end(); ++it) {
+        if (it->mustCreate) {
+            throw std::invalid_argument(tr("The -o option cannot be used with the --workers option").toStdString());
+        }
+        
+        RenderWorkerRequest request;
+        request.writerName = it->name;
+        request.frameRanges.push_back( cl.getFrameRange() );
+        if ( !it->filename.isEmpty() ) {
+            request.paramOverrides.push_back( std::make_pair(it->name + "." kOfxImageEffectFileParamName, it->filename) );
+        }
+        
+        QString error;
+        if ( !coordinator.render(request, 0, &error) ) {
+            throw std::runtime_error( error.toStdString() );
+        }
+    }
+}
+
 NodePtr
 AppInstance::createWriter(const std::string& filename,
                           const boost::shared_ptr<NodeCollection>& collection,
@@ -390,6 +420,16 @@ AppInstance::load(const CLArgs& cl)
             throw std::invalid_argument(tr("Specified file does not exist").toStdString());
         }
         
+        if (cl.getRenderWorkersCount() > 0) {
+            ///The workers load the project, this process only distributes the frames
+            if (info.suffix() != NATRON_PROJECT_FILE_EXT) {
+                throw std::invalid_argument(tr("Render workers can only render ." NATRON_PROJECT_FILE_EXT " project files").toStdString());
+            }
+            renderOnLocalWorkers(cl, info.absoluteFilePath());
+            
+            return;
+        }
+        
         std::list<AppInstance::RenderRequest> writersWork;
 
         if (info.suffix() == NATRON_PROJECT_FILE_EXT) {
@@ -412,6 +452,20 @@ AppInstance::load(const CLArgs& cl)
         
         startWritersRendering(writersWork);
         
+    } else if (appPTR->getAppType() == AppManager::eAppTypeBackgroundRenderWorker) {
+        
+        QFileInfo info(cl.getFilename());
+        if (!info.exists() || info.suffix() != NATRON_PROJECT_FILE_EXT) {
+            throw std::invalid_argument(tr("A render worker must be given an existing ." NATRON_PROJECT_FILE_EXT " project file").toStdString());
+        }
+        if ( !_imp->_currentProject->loadProject(info.path(),info.fileName()) ) {
+            throw std::invalid_argument(tr("Project file loading failed.").toStdString());
+        }
+        
+        ///Blocking, returns once the coordinator asks the worker to quit
+        RenderWorker worker(this, appPTR->getProcessInputChannel());
+        worker.exec();
+        
     } else if (appPTR->getAppType() == AppManager::eAppTypeInterpreter) {
         QFileInfo info(cl.getFilename());
         if (info.exists() && info.suffix() == "py") {
@@ -819,6 +873,12 @@ AppInstance::triggerAutoSave()
     _imp->_currentProject->triggerAutoSave();
 }
 
+void
+AppInstance::triggerAutoSave(const boost::shared_ptr<Natron::Node> & changedNode)
+{
+    _imp->_currentProject->triggerAutoSave(changedNode);
+}
+
 
 void
 AppInstance::startWritersRendering(const std::list<RenderRequest>& writers)
@@ -884,8 +944,24 @@ AppInstance::startWritersRendering(const std::list<RenderWork>& writers)
     
     if ( appPTR->isBackground() ) {
         
+        ///Render the writers frame by frame together so that the images of the nodes they share are computed once
+        boost::shared_ptr<OutputRenderGroup> renderGroup;
+        if (writers.size() > 1) {
+            renderGroup.reset(new OutputRenderGroup);
+            for (std::list<RenderWork>::const_iterator it = writers.begin(); it != writers.end(); ++it) {
+                renderGroup->registerWriter(it->writer);
+                it->writer->setRenderGroup(renderGroup);
+            }
+        }
+        
         //blocking call, we don't want this function to return pre-maturely, in which case it would kill the app
         QtConcurrent::blockingMap( writers,boost::bind(&AppInstance::startRenderingFullSequence,this,_1,false,QString()) );
+        
+        if (renderGroup) {
+            for (std::list<RenderWork>::const_iterator it = writers.begin(); it != writers.end(); ++it) {
+                it->writer->setRenderGroup( boost::shared_ptr<OutputRenderGroup>() );
+            }
+        }
     } else {
         
         //Take a snapshot of the graph at this time, this will be the version loaded by the process
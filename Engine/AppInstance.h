@@ -356,6 +356,9 @@ public Q_SLOTS:
 
     void triggerAutoSave();
 
+    ///@see Project::triggerAutoSave(const NodePtr&)
+    void triggerAutoSave(const boost::shared_ptr<Natron::Node> & changedNode);
+
     void clearOpenFXPluginsCaches();
 
     void clearAllLastRenderedImages();
@@ -385,6 +388,11 @@ private:
     
     void getWritersWorkForCL(const CLArgs& cl,std::list<AppInstance::RenderRequest>& requests);
 
+    /**
+     * @brief Renders the writers given on the command line on cl.getRenderWorkersCount() worker processes, @see RenderCoordinator
+     **/
+    void renderOnLocalWorkers(const CLArgs& cl,const QString& projectPath);
+
 
     boost::shared_ptr<Natron::Node> createNodeInternal(const QString & pluginID,const std::string & multiInstanceParentName,
                                                        int majorVersion,int minorVersion,
@@ -21,6 +21,7 @@
 
 #include <clocale>
 #include <cstddef>
+#include <iostream>
 #include <QDebug>
 #include <QTextCodec>
 #include <QProcess>
@@ -31,6 +32,7 @@
 #include <QThread>
 #include <QTemporaryFile>
 #include <QThreadPool>
+#include <QElapsedTimer>
 #include <QtCore/QAtomicInt>
 
 #if defined(Q_OS_MAC)
@@ -47,6 +49,7 @@
 #include "Global/Enums.h"
 
 #include "Engine/AppInstance.h"
+#include "Engine/CacheIO.h"
 #include "Engine/OfxHost.h"
 #include "Engine/Settings.h"
 #include "Engine/LibraryBinary.h"
@@ -67,6 +70,7 @@
 #include "Engine/NoOp.h"
 #include "Engine/Project.h"
 #include "Engine/BackDrop.h"
+#include "Engine/RenderScheduler.h"
 
 
 BOOST_CLASS_EXPORT(Natron::FrameParams)
@@ -95,6 +99,7 @@ struct AppManagerPrivate
     boost::shared_ptr<Natron::Cache<Natron::Image> >  _nodeCache; //< Images cache
     boost::shared_ptr<Natron::Cache<Natron::Image> >  _diskCache; //< Images disk cache (used by DiskCache nodes)
     boost::shared_ptr<Natron::Cache<Natron::FrameEntry> > _viewerCache; //< Viewer textures cache
+    boost::scoped_ptr<RenderScheduler> renderScheduler; //< prioritized scheduler for viewer/preview/analysis renders
     
     mutable QMutex diskCachesLocationMutex;
     QString diskCachesLocation;
@@ -152,6 +157,11 @@ struct AppManagerPrivate
     QLocalSocket* crashServerConnection;
 #endif
     
+    bool startupTimingEnabled; //< set by the --startup-timing command line option
+    bool streamingRenderEnabled; //< set by the --streaming command line option
+    QElapsedTimer startupTimer; //< started when loading begins
+    qint64 lastStartupPhaseTime; //< the time at which the last reported phase ended
+    
     AppManagerPrivate();
     
     ~AppManagerPrivate()
@@ -173,6 +183,8 @@ struct AppManagerPrivate
     bool checkForCacheDiskStructure(const QString & cachePath);
 
     void cleanUpCacheDiskStructure(const QString & cachePath);
+    
+    void createCacheDiskStructure(const QString & cachePath);
 
     /**
      * @brief Called on startup to initialize the max opened files
@@ -183,6 +195,11 @@ struct AppManagerPrivate
     
     void declareSettingsToPython();
     
+    /**
+     * @brief If startup timing is enabled, prints the time spent since the previous phase ended.
+     **/
+    void reportStartupPhase(const QString& phase);
+    
 #ifdef NATRON_USE_BREAKPAD
     void initBreakpad();
 #endif
@@ -214,6 +231,7 @@ AppManagerPrivate::AppManagerPrivate()
 , _nodeCache()
 , _diskCache()
 , _viewerCache()
+, renderScheduler( new RenderScheduler() )
 , diskCachesLocationMutex()
 , diskCachesLocation()
 ,_backgroundIPC(0)
@@ -243,6 +261,10 @@ AppManagerPrivate::AppManagerPrivate()
 ,crashClientServer()
 ,crashServerConnection(0)
 #endif
+,startupTimingEnabled(false)
+,streamingRenderEnabled(false)
+,startupTimer()
+,lastStartupPhaseTime(0)
 {
     setMaxCacheFiles();
     
@@ -251,6 +273,18 @@ AppManagerPrivate::AppManagerPrivate()
 
 
 
+void
+AppManagerPrivate::reportStartupPhase(const QString& phase)
+{
+    if (!startupTimingEnabled) {
+        return;
+    }
+    qint64 now = startupTimer.elapsed();
+    std::cout << QObject::tr("Startup: ").toStdString() << phase.toStdString() << ": " << (now - lastStartupPhaseTime)
+              << " ms (" << QObject::tr("total").toStdString() << ": " << now << " ms)" << std::endl;
+    lastStartupPhaseTime = now;
+}
+
 void
 AppManager::saveCaches() const
 {
@@ -326,6 +360,14 @@ struct CLArgsPrivate
     
     bool isEmpty;
     
+    bool startupTiming;
+    
+    bool streaming;
+    
+    bool renderWorker;
+    
+    int renderWorkersCount;
+    
     CLArgsPrivate()
     : args()
     , filename()
@@ -338,6 +380,10 @@ struct CLArgsPrivate
     , range()
     , rangeSet(false)
     , isEmpty(true)
+    , startupTiming(false)
+    , streaming(false)
+    , renderWorker(false)
+    , renderWorkersCount(0)
     {
         
     }
@@ -417,6 +463,8 @@ CLArgs::printUsage(const std::string& programName)
               "start it."
               "NatronRenderer and " NATRON_APPLICATION_NAME "will do the same thing in this mode, only the init.py script will be loaded.");
     W_LINE("\n");
+    W_TR_LINE("[--startup-timing] prints the time spent in each phase of the startup (settings, caches, plug-ins, Python, project).");
+    W_LINE("\n");
     
     W_TR_LINE("- Options for the execution of " NATRON_APPLICATION_NAME " projects:\n");
     W_LINE(programName + " <project file path>");
@@ -428,12 +476,20 @@ CLArgs::printUsage(const std::string& programName)
               " firstFrame-lastFrame (e.g: 10-40). \n"
               "Note that several -w options can be set to specify multiple Write nodes to render.\n"
               "Note that if specified, then the frame range will be the same for all Write nodes that will render.");
+    W_TR_LINE("[--streaming] renders long sequences with a bounded memory usage: the images computed for a frame are "
+              "removed from the cache as soon as no frame left to render needs them, and the images that are used by a single frame "
+              "are not cached at all.");
+    W_TR_LINE("[--workers] <count> starts count render worker processes on this machine and distributes the frames to render to them "
+              "in small chunks. A Write node and a frame range must be given with this option.");
+    W_TR_LINE("[--worker] starts a render worker: the project is loaded once and the process then renders the requests sent on the pipe "
+              "given by the --IPCpipe option by a coordinator until it is asked to quit. See RenderWorker.h for the protocol.");
     W_TR_LINE("Some examples of usage of the tool:\n");
     W_LINE("./Natron /Users/Me/MyNatronProjects/MyProject.ntp");
     W_LINE("./Natron -b -w MyWriter /Users/Me/MyNatronProjects/MyProject.ntp");
     W_LINE("./NatronRenderer -w MyWriter /Users/Me/MyNatronProjects/MyProject.ntp");
     W_LINE("./NatronRenderer -w MyWriter /FastDisk/Pictures/sequence###.exr 1-100 /Users/Me/MyNatronProjects/MyProject.ntp");
     W_LINE("./NatronRenderer -w MyWriter -w MySecondWriter 1-10 /Users/Me/MyNatronProjects/MyProject.ntp");
+    W_LINE("./NatronRenderer --workers 4 -w MyWriter 1-1000 /Users/Me/MyNatronProjects/MyProject.ntp");
     W_LINE("\n");
     W_TR_LINE("- Options for the execution of Python scripts:\n");
     W_LINE(programName + " <Python script path>");
@@ -532,6 +588,30 @@ CLArgs::isPythonScript() const
     return _imp->isPythonScript;
 }
 
+bool
+CLArgs::isStartupTimingEnabled() const
+{
+    return _imp->startupTiming;
+}
+
+bool
+CLArgs::isStreamingRenderEnabled() const
+{
+    return _imp->streaming;
+}
+
+bool
+CLArgs::isRenderWorker() const
+{
+    return _imp->renderWorker;
+}
+
+int
+CLArgs::getRenderWorkersCount() const
+{
+    return _imp->renderWorkersCount;
+}
+
 QStringList::iterator
 CLArgsPrivate::hasFileNameWithExtension(const QString& extension)
 {
@@ -636,14 +716,75 @@ CLArgsPrivate::parse()
     }
     
     
+    {
+        QStringList::iterator it = hasToken("startup-timing", "");
+        if (it != args.end()) {
+            startupTiming = true;
+            args.erase(it);
+        }
+    }
+    
+    {
+        QStringList::iterator it = hasToken("streaming", "");
+        if (it != args.end()) {
+            streaming = true;
+            args.erase(it);
+        }
+    }
+    
     {
         QStringList::iterator it = hasToken("IPCpipe", "");
         if (it != args.end()) {
-            ipcPipe = *it;
+            QStringList::iterator next = it;
+            ++next;
+            if (next == args.end()) {
+                std::cout << QObject::tr("You must specify the name of the pipe when using the --IPCpipe option").toStdString() << std::endl;
+                error = 1;
+                return;
+            }
+            ipcPipe = *next;
+            ++next;
+            args.erase(it,next);
+        }
+    }
+    
+    {
+        QStringList::iterator it = hasToken("worker", "");
+        if (it != args.end()) {
+            if (!isBackground || isInterpreterMode || ipcPipe.isEmpty()) {
+                std::cout << QObject::tr("The --worker option can only be used in background mode with the --IPCpipe option").toStdString() << std::endl;
+                error = 1;
+                return;
+            }
+            renderWorker = true;
             args.erase(it);
         }
     }
     
+    {
+        QStringList::iterator it = hasToken("workers", "");
+        if (it != args.end()) {
+            QStringList::iterator next = it;
+            ++next;
+            bool ok = false;
+            if (next != args.end()) {
+                renderWorkersCount = next->toInt(&ok);
+            }
+            if (!ok || renderWorkersCount <= 0) {
+                std::cout << QObject::tr("You must specify a number of workers greater than 0 when using the --workers option").toStdString() << std::endl;
+                error = 1;
+                return;
+            }
+            if (!isBackground || isInterpreterMode || renderWorker) {
+                std::cout << QObject::tr("The --workers option can only be used in background mode").toStdString() << std::endl;
+                error = 1;
+                return;
+            }
+            ++next;
+            args.erase(it,next);
+        }
+    }
+    
     {
         QStringList::iterator it = hasFileNameWithExtension(NATRON_PROJECT_FILE_EXT);
         if (it == args.end()) {
@@ -858,6 +999,9 @@ AppManager::~AppManager()
 
     _instance = 0;
 
+    ///Don't start any more prioritized renders and wait for the running ones
+    _imp->renderScheduler->quitAndWaitForDone();
+
     ///Caches may have launched some threads to delete images, wait for them to be done
     QThreadPool::globalInstance()->waitForDone();
     
@@ -869,6 +1013,9 @@ AppManager::~AppManager()
     _imp->_viewerCache.reset();
     _imp->_diskCache.reset();
     
+    ///Finish writing the entries cached on disk
+    Natron::CacheIO::quit();
+    
     tearDownPython();
     
 #ifdef NATRON_USE_BREAKPAD
@@ -949,6 +1096,10 @@ AppManager::loadInternal(const CLArgs& cl)
 {
     assert(!_imp->_loaded);
 
+    _imp->startupTimingEnabled = cl.isStartupTimingEnabled();
+    _imp->streamingRenderEnabled = cl.isStreamingRenderEnabled();
+    _imp->startupTimer.start();
+
     _imp->_binaryPath = QCoreApplication::applicationDirPath();
 
     registerEngineMetaTypes();
@@ -1022,11 +1173,14 @@ AppManager::loadInternal(const CLArgs& cl)
     _imp->_settings->initializeKnobsPublic();
     ///Call restore after initializing knobs
     _imp->_settings->restoreSettings();
+    _imp->reportStartupPhase( tr("settings") );
 
     ///basically show a splashScreen
     initGui();
+    _imp->reportStartupPhase( tr("user interface") );
 
 
+    Natron::CacheIO::setWriteBehindEnabled( _imp->_settings->isDiskCacheWriteBehindEnabled() );
     try {
         size_t maxCacheRAM = _imp->_settings->getRamMaximumPercent() * getSystemTotalRAM();
         U64 maxViewerDiskCache = _imp->_settings->getMaximumViewerDiskCacheSize();
@@ -1038,12 +1192,14 @@ AppManager::loadInternal(const CLArgs& cl)
         _imp->_nodeCache.reset( new Cache<Image>("NodeCache",NATRON_CACHE_VERSION, maxCacheRAM - playbackSize,1.) );
         _imp->_diskCache.reset( new Cache<Image>("DiskCache",NATRON_CACHE_VERSION, maxDiskCacheNode,0.) );
         _imp->_viewerCache.reset( new Cache<FrameEntry>("ViewerCache",NATRON_CACHE_VERSION,viewerCacheSize,(double)playbackSize / (double)viewerCacheSize) );
+        _imp->_diskCache->setSharedAcrossProcesses( _imp->_settings->isDiskCacheNodeSharedAcrossProcesses() );
     } catch (std::logic_error) {
         // ignore
     }
 
     setLoadingStatus( tr("Restoring the image cache...") );
     _imp->restoreCaches();
+    _imp->reportStartupPhase( tr("caches") );
 
     setLoadingStatus( tr("Restoring user settings...") );
 
@@ -1055,6 +1211,8 @@ AppManager::loadInternal(const CLArgs& cl)
         // ignore
     }
 
+    _imp->reportStartupPhase( tr("OpenFX host properties") );
+
     /*loading all plugins*/
     loadAllPlugins();
     _imp->loadBuiltinFormats();
@@ -1068,7 +1226,9 @@ AppManager::loadInternal(const CLArgs& cl)
         _imp->_appType = eAppTypeInterpreter;
     } else if ( isBackground() ) {
         if ( !cl.getFilename().isEmpty() ) {
-            if (!cl.getIPCPipeName().isEmpty()) {
+            if ( cl.isRenderWorker() ) {
+                _imp->_appType = eAppTypeBackgroundRenderWorker;
+            } else if (!cl.getIPCPipeName().isEmpty()) {
                 _imp->_appType = eAppTypeBackgroundAutoRunLaunchedFromGui;
             } else {
                 _imp->_appType = eAppTypeBackgroundAutoRun;
@@ -1081,6 +1241,7 @@ AppManager::loadInternal(const CLArgs& cl)
     }
 
     AppInstance* mainInstance = newAppInstance(cl);
+    _imp->reportStartupPhase( tr("application instance and project") );
     
     hideSplashScreen();
 
@@ -1092,6 +1253,7 @@ AppManager::loadInternal(const CLArgs& cl)
         ///In background project auto-run the rendering is finished at this point, just exit the instance
         if ( (_imp->_appType == eAppTypeBackgroundAutoRun ||
               _imp->_appType == eAppTypeBackgroundAutoRunLaunchedFromGui ||
+              _imp->_appType == eAppTypeBackgroundRenderWorker ||
               _imp->_appType == eAppTypeInterpreter) && mainInstance ) {
             mainInstance->quit();
         }
@@ -1279,6 +1441,12 @@ AppManager::writeToOutputPipe(const QString & longMessage,
     return true;
 }
 
+ProcessInputChannel*
+AppManager::getProcessInputChannel() const
+{
+    return _imp->_backgroundIPC;
+}
+
 void
 AppManager::registerAppInstance(AppInstance* app)
 {
@@ -1342,9 +1510,11 @@ AppManager::loadAllPlugins()
     /*loading node plugins*/
 
     loadBuiltinNodePlugins(&readersMap, &writersMap);
+    _imp->reportStartupPhase( tr("built-in plug-ins") );
 
     /*loading ofx plugins*/
     _imp->ofxHost->loadOFXPlugins( &readersMap, &writersMap);
+    _imp->reportStartupPhase( _imp->ofxHost->wasLoadedFromRegistry() ? tr("OpenFX plug-ins (from registry)") : tr("OpenFX plug-ins (full scan)") );
     
     std::vector<Natron::Plugin*> ignoredPlugins;
     _imp->_settings->populatePluginsTab(ignoredPlugins);
@@ -1400,12 +1570,15 @@ AppManager::loadAllPlugins()
     
     _imp->_settings->populateReaderPluginsAndFormats(readersMap);
     _imp->_settings->populateWriterPluginsAndFormats(writersMap);
+    _imp->reportStartupPhase( tr("plug-ins settings") );
 
     _imp->declareSettingsToPython();
+    _imp->reportStartupPhase( tr("Python settings") );
     
     //Load python groups and init.py & initGui.py scripts
     //Should be done after settings are declared
     loadPythonGroups();
+    _imp->reportStartupPhase( tr("Python groups and init scripts") );
 
     onAllPluginsLoaded();
 }
@@ -1942,6 +2115,12 @@ AppManager::getKnobFactory() const
     return *(_imp->_knobFactory);
 }
 
+RenderScheduler*
+AppManager::getRenderScheduler() const
+{
+    return _imp->renderScheduler.get();
+}
+
 Natron::Plugin*
 AppManagerPrivate::findPluginById(const QString& newId,int major, int minor) const
 {
@@ -2089,6 +2268,12 @@ AppManager::removeAllTexturesFromCacheWithMatchingKey(U64 treeVersion)
     _imp->_viewerCache->removeAllImagesFromCacheWithMatchingKey(treeVersion);
 }
 
+std::size_t
+AppManager::removeAllImagesFromCacheWithMatchingKeyOutsideTimeRange(const std::map<U64,std::pair<SequenceTime,SequenceTime> >& rangesToKeep)
+{
+    return _imp->_nodeCache->removeAllImagesFromCacheWithMatchingKeyOutsideTimeRange(rangesToKeep);
+}
+
 const QString &
 AppManager::getApplicationBinaryPath() const
 {
@@ -2168,6 +2353,12 @@ AppManager::isAggressiveCachingEnabled() const
     return _imp->_settings->isAggressiveCachingEnabled();
 }
 
+bool
+AppManager::isStreamingRenderEnabled() const
+{
+    return _imp->streamingRenderEnabled;
+}
+
 U64
 AppManager::getCachesTotalMemorySize() const
 {
@@ -2221,6 +2412,12 @@ AppManager::registerEngineMetaTypes() const
 template <typename T>
 void saveCache(Natron::Cache<T>* cache)
 {
+    if ( cache->isSharedAcrossProcesses() ) {
+        ///The shared index is the table of contents of the cache, other processes may still be using it
+        cache->publishAllEntries();
+        return;
+    }
+    
     std::ofstream ofile;
     ofile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
     std::string cacheRestoreFilePath = cache->getRestoreFilePath();
@@ -2284,6 +2481,12 @@ AppManagerPrivate::saveCaches()
 template <typename T>
 void restoreCache(AppManagerPrivate* p,Natron::Cache<T>* cache)
 {
+    if ( cache->isSharedAcrossProcesses() ) {
+        ///Never wipe a cache shared with other processes, entries are fetched from the shared index when needed
+        p->createCacheDiskStructure( cache->getCachePath() );
+        return;
+    }
+    
     if ( p->checkForCacheDiskStructure( cache->getCachePath() ) ) {
         std::ifstream ifile;
         std::string settingsFilePath = cache->getRestoreFilePath();
@@ -2377,6 +2580,9 @@ AppManagerPrivate::restoreCaches()
     if (!appPTR->isBackground()) {
         restoreCache<FrameEntry>(this, _viewerCache.get());
         restoreCache<Image>(this, _diskCache.get());
+    } else if ( _diskCache->isSharedAcrossProcesses() ) {
+        ///Background renders may use the images written by other processes
+        restoreCache<Image>(this, _diskCache.get());
     }
 } // restoreCaches
 
@@ -2441,6 +2647,13 @@ AppManagerPrivate::cleanUpCacheDiskStructure(const QString & cachePath)
         cacheFolder.removeRecursively();
     }
 #endif
+    createCacheDiskStructure(cachePath);
+}
+
+void
+AppManagerPrivate::createCacheDiskStructure(const QString & cachePath)
+{
+    QDir cacheFolder(cachePath);
     cacheFolder.mkpath(".");
 
     QStringList etr = cacheFolder.entryList(QDir::NoDotAndDotDot);
@@ -16,6 +16,7 @@
 #include <Python.h>
 
 #include <list>
+#include <map>
 #include <string>
 #include "Global/GlobalDefines.h"
 CLANG_DIAG_OFF(deprecated)
@@ -47,6 +48,8 @@ class Settings;
 class KnobHolder;
 class NodeSerialization;
 class KnobSerialization;
+class RenderScheduler;
+class ProcessInputChannel;
 
 namespace Natron {
 class Node;
@@ -123,6 +126,16 @@ public:
     
     bool isPythonScript() const;
     
+    bool isStartupTimingEnabled() const;
+    
+    bool isStreamingRenderEnabled() const;
+    
+    ///True if --worker was given: the process renders the requests of a coordinator, @see RenderWorker
+    bool isRenderWorker() const;
+    
+    ///The number of worker processes given with --workers, 0 if the frames must be rendered by this process
+    int getRenderWorkersCount() const;
+    
 private:
     
     boost::scoped_ptr<CLArgsPrivate> _imp;
@@ -146,6 +159,9 @@ public:
         
         eAppTypeBackgroundAutoRunLaunchedFromGui, //same as eAppTypeBackgroundAutoRun but a bg process launched by GUI of a main process
         
+        eAppTypeBackgroundRenderWorker, //< a background AppInstance that loads a project and renders the requests of a coordinator
+                                        //read from the IPC pipe, @see RenderWorker
+        
         eAppTypeInterpreter, //< running in Python interpreter mode
 
         eAppTypeGui //< a GUI AppInstance, the end-user can interact with it.
@@ -265,16 +281,32 @@ public:
     void  removeAllImagesFromCacheWithMatchingKey(U64 treeVersion);
     void  removeAllImagesFromDiskCacheWithMatchingKey(U64 treeVersion);
     void  removeAllTexturesFromCacheWithMatchingKey(U64 treeVersion);
+    /**
+     * @brief For each tree version of the map, removes from the node cache the images with a matching tree version
+     * whose time is outside of the associated range. Returns the count of cache entries scanned.
+     **/
+    std::size_t removeAllImagesFromCacheWithMatchingKeyOutsideTimeRange(const std::map<U64,std::pair<SequenceTime,SequenceTime> >& rangesToKeep);
 
     boost::shared_ptr<Settings> getCurrentSettings() const WARN_UNUSED_RETURN;
     const KnobFactory & getKnobFactory() const WARN_UNUSED_RETURN;
 
+    /**
+     * @brief Returns the scheduler through which viewer, preview and analysis renders are prioritized.
+     **/
+    RenderScheduler* getRenderScheduler() const WARN_UNUSED_RETURN;
+
     /**
      * @brief If the current process is a background process, then it will right the output pipe the
      * short message. Otherwise the longMessage is printed to stdout
      **/
     bool writeToOutputPipe(const QString & longMessage,const QString & shortMessage);
 
+    /**
+     * @brief The channel on which the main process sends messages to this background process, or NULL if
+     * the process was not given the --IPCpipe option.
+     **/
+    ProcessInputChannel* getProcessInputChannel() const;
+
     void abortAnyProcessing();
 
     bool hasAbortAnyProcessingBeenCalled() const;
@@ -412,6 +444,12 @@ public:
     
     bool isAggressiveCachingEnabled() const;
     
+    /**
+     * @brief True when NatronRenderer was given the --streaming option: renders on disk then release
+     * each image as soon as no frame left to render needs it, see OutputSchedulerThread.
+     **/
+    bool isStreamingRenderEnabled() const;
+    
     void setDiskCacheLocation(const QString& path);
     const QString& getDiskCacheLocation() const;
     
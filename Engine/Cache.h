@@ -17,10 +17,12 @@
 #include <Python.h>
 
 #include <vector>
+#include <cstdio>
 #include <sstream>
 #include <fstream>
 #include <functional>
 #include <list>
+#include <map>
 #include <cstddef>
 #include <utility>
 
@@ -58,7 +60,9 @@ CLANG_DIAG_ON(unused-parameter)
 #include "Engine/FrameParamsSerialization.h"
 #include "Engine/CacheEntry.h"
 #include "Engine/LRUHashTable.h"
+#include "Engine/SharedCacheIndex.h"
 #include "Engine/StandardPaths.h"
+#include "Engine/Timer.h"
 #include "Engine/ImageLocker.h"
 #include "Global/MemoryInfo.h"
 
@@ -68,6 +72,14 @@ CLANG_DIAG_ON(unused-parameter)
 //Beyond that percentage of occupation, the cache will start evicting LRU entries
 #define NATRON_CACHE_LIMIT_PERCENT 0.9
 
+///Entries moved to the disk portion of a shared cache are published by batches of that many entries...
+#define NATRON_SHARED_CACHE_PUBLICATION_BATCH 16
+///...or after that many seconds since the last publication
+#define NATRON_SHARED_CACHE_PUBLICATION_INTERVAL 1.
+
+///The shared index is compacted when it holds more than twice as many records as published entries, plus that
+#define NATRON_SHARED_CACHE_COMPACTION_MIN_RECORDS 1024
+
 ///When defined, number of opened files, memory size and disk size of the cache are printed whenever there's activity.
 //#define NATRON_DEBUG_CACHE
 
@@ -306,6 +318,99 @@ public:
 
     typedef std::list< SerializedEntry > CacheTOC;
 
+    /**
+     * @brief An entry of the index shared with other processes (@see SharedCacheIndex).
+     * lastAccess is the position in the index of the last record that published or accessed it, so that
+     * all processes reading the index agree on which entries are the least recently used.
+     **/
+    struct SharedEntry
+    {
+        SerializedEntry entry;
+        U64 lastAccess;
+    };
+
+    /**
+     * @brief The published entries, as known from the records of the shared index read by this process.
+     * Only modified while the shared index is locked.
+     **/
+    struct SharedIndexState
+    {
+        std::map<std::string, SharedEntry> entries; //< indexed by file path
+        std::multimap<hash_type, std::string> filesByHash;
+        std::map<U64, std::string> filesByAccess; //< the least recently used first
+        U64 accessCounter;
+        U64 totalSize;
+
+        SharedIndexState()
+        : entries()
+        , filesByHash()
+        , filesByAccess()
+        , accessCounter(0)
+        , totalSize(0)
+        {
+        }
+
+        void clear()
+        {
+            entries.clear();
+            filesByHash.clear();
+            filesByAccess.clear();
+            accessCounter = 0;
+            totalSize = 0;
+        }
+
+        void publish(const SerializedEntry& entry)
+        {
+            typename std::map<std::string, SharedEntry>::iterator found = entries.find(entry.filePath);
+            if ( found != entries.end() ) {
+                touch(found);
+                return;
+            }
+            SharedEntry& shared = entries[entry.filePath];
+            shared.entry = entry;
+            shared.lastAccess = ++accessCounter;
+            filesByHash.insert( std::make_pair(entry.hash, entry.filePath) );
+            filesByAccess.insert( std::make_pair(shared.lastAccess, entry.filePath) );
+            totalSize += entry.size;
+        }
+
+        void access(const std::string& filePath)
+        {
+            typename std::map<std::string, SharedEntry>::iterator found = entries.find(filePath);
+            if ( found != entries.end() ) {
+                touch(found);
+            }
+        }
+
+        void remove(const std::string& filePath)
+        {
+            typename std::map<std::string, SharedEntry>::iterator found = entries.find(filePath);
+            if ( found == entries.end() ) {
+                return;
+            }
+            std::pair<typename std::multimap<hash_type, std::string>::iterator,
+                      typename std::multimap<hash_type, std::string>::iterator> range = filesByHash.equal_range(found->second.entry.hash);
+            for (typename std::multimap<hash_type, std::string>::iterator it = range.first; it != range.second; ++it) {
+                if (it->second == filePath) {
+                    filesByHash.erase(it);
+                    break;
+                }
+            }
+            filesByAccess.erase(found->second.lastAccess);
+            totalSize = found->second.entry.size > totalSize ? 0 : totalSize - found->second.entry.size;
+            entries.erase(found);
+        }
+
+    private:
+
+        void touch(typename std::map<std::string, SharedEntry>::iterator it)
+        {
+            filesByAccess.erase(it->second.lastAccess);
+            it->second.lastAccess = ++accessCounter;
+            filesByAccess.insert( std::make_pair(it->second.lastAccess, it->first) );
+        }
+    };
+
 public:
 
 
@@ -405,6 +510,23 @@ private:
     mutable Natron::DeleterThread<EntryType> _deleterThread;
     mutable QWaitCondition _memoryFullCondition; //< protected by _sizeLock
     
+    ///Non-null if the disk portion is shared with other processes. Set once before the cache is used.
+    boost::scoped_ptr<SharedCacheIndex> _sharedIndex;
+    
+    ///Entries moved to the disk portion that must be published in the shared index, protected by _lock.
+    ///Holding a reference prevents them from being evicted until they are published.
+    mutable std::list<EntryTypePtr> _pendingPublications;
+
+    ///Files of published entries used by this process since the last publication, protected by _lock
+    mutable std::list<std::string> _pendingSharedAccesses;
+
+    ///When the pending publications were last published, in seconds since _sharedPublicationTimer was created
+    TimeLapse _sharedPublicationTimer;
+    mutable double _lastSharedPublication; //< protected by _lock
+
+    mutable QMutex _sharedStateLock; //< protects _sharedState
+    mutable SharedIndexState _sharedState;
+    
 public:
 
 
@@ -432,6 +554,13 @@ public:
           ,_tearingDown(false)
           ,_deleterThread(this)
           ,_memoryFullCondition()
+          ,_sharedIndex()
+          ,_pendingPublications()
+          ,_pendingSharedAccesses()
+          ,_sharedPublicationTimer()
+          ,_lastSharedPublication(0)
+          ,_sharedStateLock()
+          ,_sharedState()
     {
     }
 
@@ -439,6 +568,8 @@ public:
     {
         QMutexLocker locker(&_lock);
         _tearingDown = true;
+        _pendingPublications.clear();
+        _pendingSharedAccesses.clear();
         _memoryCache.clear();
         _diskCache.clear();
         delete _signalEmitter;
@@ -468,9 +599,20 @@ public:
         ///Be atomic, so it cannot be created by another thread in the meantime
         QMutexLocker getlocker(&_getLock);
 
-        ///lock the cache before reading it.
-        QMutexLocker locker(&_lock);
-        return getInternal(key,returnValue);
+        {
+            ///lock the cache before reading it.
+            QMutexLocker locker(&_lock);
+            if ( getInternal(key,returnValue) ) {
+                return true;
+            }
+        }
+        
+        ///Another process sharing the disk portion may have produced it already
+        if ( _sharedIndex && importSharedEntries( key.getHash() ) ) {
+            QMutexLocker locker(&_lock);
+            return getInternal(key,returnValue);
+        }
+        return false;
         
     } // get
     
@@ -670,19 +812,31 @@ public:
                 QMutexLocker locker(&_lock);
                 didGetSucceed = getInternal(key,&entries);
             }
-            if (didGetSucceed) {
-                for (typename std::list<EntryTypePtr>::iterator it = entries.begin(); it != entries.end(); ++it) {
-                    if (*(*it)->getParams() == *params) {
-                        *returnValue = *it;
-                        return true;
-                    }
+            if ( didGetSucceed && findEntryWithParams(entries, params, returnValue) ) {
+                return true;
+            }
+            
+            ///Another process sharing the disk portion may have produced it already
+            if ( _sharedIndex && importSharedEntries( key.getHash() ) ) {
+                entries.clear();
+                {
+                    QMutexLocker locker(&_lock);
+                    didGetSucceed = getInternal(key,&entries);
+                }
+                if ( didGetSucceed && findEntryWithParams(entries, params, returnValue) ) {
+                    return true;
                 }
             }
             
             createInternal(key,params,imageLocker,returnValue);
-            return false;
             
         } // getlocker
+        
+        ///createInternal() may have moved entries to the disk portion
+        if (_sharedIndex) {
+            publishPendingEntries(false);
+        }
+        return false;
     }
     
     /**
@@ -718,6 +872,8 @@ public:
      **/
     void clearDiskPortion()
     {
+        clearSharedIndex();
+        
         if (_signalEmitter) {
             ///block signals otherwise the we would be spammed of notifications
             _signalEmitter->blockSignals(true);
@@ -790,10 +946,14 @@ public:
                 if ( existingDiskCacheEntry == _diskCache.end() ) {
                     _diskCache.insert(evictedFromMemory.second->getHashKey(),evictedFromMemory.second);
                 }
+                queueForPublication(evictedFromMemory.second);
             }
 
             evictedFromMemory = _memoryCache.evict();
         }
+        locker.unlock();
+        
+        publishPendingEntries(true);
 
         _signalEmitter->blockSignals(false);
         if (emitSignals) {
@@ -1062,6 +1222,36 @@ public:
 
         return newCachePath.toStdString();
     }
+    
+    /**
+     * @brief Shares the disk portion of the cache with the other processes using the same cache path.
+     * Entries moved to the disk portion are published in an index shared by all processes, and entries
+     * published by other processes are looked-up in that index when they are not found locally.
+     * Must be called before the cache is used.
+     **/
+    void setSharedAcrossProcesses(bool shared)
+    {
+        if (shared) {
+            _sharedIndex.reset( new SharedCacheIndex( getCachePath().toStdString(), _version ) );
+        } else {
+            _sharedIndex.reset();
+        }
+    }
+    
+    virtual bool isSharedAcrossProcesses() const OVERRIDE FINAL
+    {
+        return _sharedIndex.get() != 0;
+    }
+    
+    /**
+     * @brief Moves the memory portion to disk and publishes all complete entries in the shared index.
+     * This replaces save() for caches shared across processes: the shared index is their table of contents.
+     **/
+    void publishAllEntries()
+    {
+        clearInMemoryPortion(false);
+        publishPendingEntries(true);
+    }
 
     void setMaximumCacheSize(U64 newSize)
     {
@@ -1233,6 +1423,68 @@ public:
     }
 
     
+    /**
+     * @brief For each tree version of the map, removes the entries with a matching tree version whose time is outside of the
+     * associated range [first,last]. Entries with another tree version, or whose key does not depend on the time,
+     * are left untouched. Returns the count of entries scanned.
+     **/
+    std::size_t removeAllImagesFromCacheWithMatchingKeyOutsideTimeRange(const std::map<U64,std::pair<SequenceTime,SequenceTime> >& rangesToKeep)
+    {
+        if ( rangesToKeep.empty() ) {
+            return 0;
+        }
+        std::size_t entriesScanned;
+        std::list<EntryTypePtr> toDelete;
+        {
+            QMutexLocker locker(&_lock);
+            entriesScanned = _memoryCache.size() + _diskCache.size();
+            
+            std::list<hash_type> memHashes,diskHashes;
+            for (CacheIterator memIt = _memoryCache.begin(); memIt != _memoryCache.end(); ++memIt) {
+                std::list<EntryTypePtr> & entries = getValueFromIterator(memIt);
+                if ( !entries.empty() && isOutsideTimeRange(entries.front()->getKey(), rangesToKeep) ) {
+                    memHashes.push_back( entries.front()->getHashKey() );
+                }
+            }
+            for (CacheIterator dIt = _diskCache.begin(); dIt != _diskCache.end(); ++dIt) {
+                std::list<EntryTypePtr> & entries = getValueFromIterator(dIt);
+                if ( !entries.empty() && isOutsideTimeRange(entries.front()->getKey(), rangesToKeep) ) {
+                    diskHashes.push_back( entries.front()->getHashKey() );
+                }
+            }
+            
+            ///Entries sharing a hash share the same key, so the whole list goes
+            for (typename std::list<hash_type>::iterator it = memHashes.begin(); it != memHashes.end(); ++it) {
+                CacheIterator found = _memoryCache(*it);
+                if ( found != _memoryCache.end() ) {
+                    std::list<EntryTypePtr> & entries = getValueFromIterator(found);
+                    for (typename std::list<EntryTypePtr>::iterator e = entries.begin(); e != entries.end(); ++e) {
+                        (*e)->scheduleForDestruction();
+                        toDelete.push_back(*e);
+                    }
+                    _memoryCache.erase(found);
+                }
+            }
+            for (typename std::list<hash_type>::iterator it = diskHashes.begin(); it != diskHashes.end(); ++it) {
+                CacheIterator found = _diskCache(*it);
+                if ( found != _diskCache.end() ) {
+                    std::list<EntryTypePtr> & entries = getValueFromIterator(found);
+                    for (typename std::list<EntryTypePtr>::iterator e = entries.begin(); e != entries.end(); ++e) {
+                        (*e)->scheduleForDestruction();
+                        toDelete.push_back(*e);
+                    }
+                    _diskCache.erase(found);
+                }
+            }
+        }
+        if (!toDelete.empty()) {
+            _deleterThread.appendToQueue(toDelete);
+            toDelete.clear();
+        }
+        
+        return entriesScanned;
+    }
+
     /*Saves cache to disk as a settings file.
      */
     void save(CacheTOC* tableOfContents)
@@ -1313,7 +1565,330 @@ public:
     }
 
 private:
+    
+    static bool isOutsideTimeRange(const typename EntryType::key_type & key,
+                                   const std::map<U64,std::pair<SequenceTime,SequenceTime> >& rangesToKeep)
+    {
+        ///The image of a node that does not vary over time was rendered once for all frames
+        if ( !key.isFrameVaryingOrAnimated() ) {
+            return false;
+        }
+        std::map<U64,std::pair<SequenceTime,SequenceTime> >::const_iterator found = rangesToKeep.find( key.getTreeVersion() );
+        if ( found == rangesToKeep.end() ) {
+            return false;
+        }
+        SequenceTime time = key.getTime();
+
+        return time < found->second.first || time > found->second.second;
+    }
+
+    static bool findEntryWithParams(const std::list<EntryTypePtr>& entries,
+                                    const ParamsTypePtr& params,
+                                    EntryTypePtr* returnValue)
+    {
+        for (typename std::list<EntryTypePtr>::const_iterator it = entries.begin(); it != entries.end(); ++it) {
+            if (*(*it)->getParams() == *params) {
+                *returnValue = *it;
+                return true;
+            }
+        }
+        return false;
+    }
+    
+    /**
+     * @brief Called when an entry was moved to the disk portion, i.e: its backing file is flushed.
+     **/
+    void queueForPublication(const EntryTypePtr& entry) const
+    {
+        assert( !_lock.tryLock() );
+        if ( _sharedIndex && !entry->isBackingFileShared() && entry->canBeSharedAcrossProcesses() ) {
+            _pendingPublications.push_back(entry);
+        }
+    }
+    
+    /**
+     * @brief Updates _sharedState with the records appended to the shared index by other processes.
+     * The index must be locked.
+     **/
+    void syncSharedIndex_locked() const
+    {
+        SharedCacheIndex::RecordList records;
+        bool reset;
+        _sharedIndex->readNewRecords(&records, &reset);
+
+        QMutexLocker k(&_sharedStateLock);
+        if (reset) {
+            _sharedState.clear();
+        }
+        applySharedRecords_locked(records);
+    }
+
+    void applySharedRecords_locked(const SharedCacheIndex::RecordList& records) const
+    {
+        assert( !_sharedStateLock.tryLock() );
+        for (SharedCacheIndex::RecordList::const_iterator it = records.begin(); it != records.end(); ++it) {
+            switch ( (SharedCacheIndex::RecordTypeEnum)it->type ) {
+            case SharedCacheIndex::eRecordTypePublish: {
+                SerializedEntry entry;
+                try {
+                    std::istringstream ss(it->data);
+                    boost::archive::binary_iarchive iArchive(ss,boost::archive::no_header);
+                    iArchive >> entry;
+                } catch (const std::exception & e) {
+                    qDebug() << "Failed to read the shared cache index: " << e.what();
+                    continue;
+                }
+                _sharedState.publish(entry);
+                break;
+            }
+            case SharedCacheIndex::eRecordTypeAccess:
+                _sharedState.access(it->data);
+                break;
+            case SharedCacheIndex::eRecordTypeRemove:
+                _sharedState.remove(it->data);
+                break;
+            }
+        }
+    }
 
+    static bool makePublishRecord(const SerializedEntry& entry,
+                                  SharedCacheIndex::Record* record)
+    {
+        try {
+            std::ostringstream ss;
+            {
+                boost::archive::binary_oarchive oArchive(ss,boost::archive::no_header);
+                oArchive << entry;
+            }
+            *record = SharedCacheIndex::Record(SharedCacheIndex::eRecordTypePublish, ss.str());
+        } catch (const std::exception & e) {
+            qDebug() << "Failed to write the shared cache index: " << e.what();
+            return false;
+        }
+        return true;
+    }
+    
+    /**
+     * @brief Publishes the entries queued by queueForPublication() in the shared index so that other processes can use them,
+     * along with the accesses to published entries, and evicts the least recently used entries of all processes.
+     * Unless force is true, this is done by batches so that the index is not locked on each entry.
+     * Must not be called with _lock held.
+     **/
+    void publishPendingEntries(bool force) const
+    {
+        if (!_sharedIndex) {
+            return;
+        }
+        std::list<EntryTypePtr> toPublish;
+        std::list<std::string> accesses;
+        {
+            QMutexLocker locker(&_lock);
+            double now = _sharedPublicationTimer.getTimeSinceCreation();
+            if ( !force && (_pendingPublications.size() + _pendingSharedAccesses.size() < NATRON_SHARED_CACHE_PUBLICATION_BATCH) &&
+                 (now - _lastSharedPublication < NATRON_SHARED_CACHE_PUBLICATION_INTERVAL) ) {
+                return;
+            }
+            _lastSharedPublication = now;
+            toPublish.swap(_pendingPublications);
+            accesses.swap(_pendingSharedAccesses);
+            
+            ///Other processes must not read the files still being written by the cache I/O thread: publish them next time
+            for (typename std::list<EntryTypePtr>::iterator it = toPublish.begin(); it != toPublish.end();) {
+                if ( (*it)->isBackingFileWritePending() ) {
+                    _pendingPublications.push_back(*it);
+                    it = toPublish.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+        }
+        if ( toPublish.empty() && accesses.empty() ) {
+            return;
+        }
+        
+        SharedCacheIndex::Locker indexLocker( _sharedIndex.get() );
+        if ( !indexLocker.isLocked() ) {
+            QMutexLocker locker(&_lock);
+            _pendingPublications.splice(_pendingPublications.end(), toPublish);
+            return;
+        }
+        syncSharedIndex_locked();
+        
+        SharedCacheIndex::RecordList records;
+        for (std::list<std::string>::const_iterator it = accesses.begin(); it != accesses.end(); ++it) {
+            records.push_back( SharedCacheIndex::Record(SharedCacheIndex::eRecordTypeAccess, *it) );
+        }
+        for (typename std::list<EntryTypePtr>::iterator it = toPublish.begin(); it != toPublish.end(); ++it) {
+            const std::string& filePath = (*it)->getFilePath();
+            if ( filePath.empty() ) {
+                continue;
+            }
+            SerializedEntry entry;
+            entry.hash = (*it)->getHashKey();
+            entry.params = (*it)->getParams();
+            entry.key = (*it)->getKey();
+            ///The file is closed at this point, size() would return 0
+            entry.size = (*it)->getParams()->getElementsCount() * sizeof(typename EntryType::data_t);
+            entry.filePath = filePath;
+            SharedCacheIndex::Record record;
+            if ( makePublishRecord(entry, &record) ) {
+                records.push_back(record);
+            }
+            ///From now on the file belongs to the shared index
+            (*it)->setBackingFileShared(true);
+        }
+        
+        std::size_t maximumCacheSize;
+        {
+            QMutexLocker k(&_sizeLock);
+            maximumCacheSize = _maximumCacheSize;
+        }
+        
+        QMutexLocker k(&_sharedStateLock);
+        applySharedRecords_locked(records);
+        
+        ///Remove the least recently used entries of all processes until the shared index fits in the maximum cache size.
+        ///Processes still holding an evicted entry will fail to re-open it and drop it.
+        while ( _sharedState.totalSize > maximumCacheSize && !_sharedState.filesByAccess.empty() ) {
+            std::string lru = _sharedState.filesByAccess.begin()->second;
+            int ret_code = std::remove( lru.c_str() );
+            (void)ret_code;
+            _sharedState.remove(lru);
+            records.push_back( SharedCacheIndex::Record(SharedCacheIndex::eRecordTypeRemove, lru) );
+        }
+        
+        if ( _sharedIndex->getRecordsCount() + records.size() > 2 * _sharedState.entries.size() + NATRON_SHARED_CACHE_COMPACTION_MIN_RECORDS ) {
+            ///Most records are obsolete: rewrite the index with the published entries only, the least recently used first
+            SharedCacheIndex::RecordList compacted;
+            for (std::map<U64, std::string>::const_iterator it = _sharedState.filesByAccess.begin(); it != _sharedState.filesByAccess.end(); ++it) {
+                SharedCacheIndex::Record record;
+                if ( makePublishRecord(_sharedState.entries[it->second].entry, &record) ) {
+                    compacted.push_back(record);
+                }
+            }
+            if ( _sharedIndex->rewrite(compacted) ) {
+                _sharedState.clear();
+                applySharedRecords_locked(compacted);
+            }
+        } else {
+            _sharedIndex->appendRecords(records);
+        }
+    }
+    
+    /**
+     * @brief Inserts in the disk portion the entries with the given hash that were published by other processes
+     * and that are not known by this process yet. Returns true if any entry was inserted.
+     * The shared index is only read if another process modified it since it was last read.
+     **/
+    bool importSharedEntries(hash_type hash) const
+    {
+        if (!_sharedIndex) {
+            return false;
+        }
+        if ( _sharedIndex->hasChanged() ) {
+            SharedCacheIndex::Locker indexLocker( _sharedIndex.get() );
+            if ( indexLocker.isLocked() ) {
+                syncSharedIndex_locked();
+            }
+        }
+        
+        CacheTOC found;
+        {
+            QMutexLocker k(&_sharedStateLock);
+            std::pair<typename std::multimap<hash_type, std::string>::const_iterator,
+                      typename std::multimap<hash_type, std::string>::const_iterator> range = _sharedState.filesByHash.equal_range(hash);
+            for (typename std::multimap<hash_type, std::string>::const_iterator it = range.first; it != range.second; ++it) {
+                typename std::map<std::string, SharedEntry>::const_iterator entry = _sharedState.entries.find(it->second);
+                assert( entry != _sharedState.entries.end() );
+                found.push_back(entry->second.entry);
+            }
+        }
+        if ( found.empty() ) {
+            return false;
+        }
+        
+        bool ret = false;
+        for (typename CacheTOC::const_iterator it = found.begin(); it != found.end(); ++it) {
+            {
+                QMutexLocker locker(&_lock);
+                if ( isFileInCache(hash, it->filePath) ) {
+                    continue;
+                }
+            }
+            EntryTypePtr value;
+            try {
+                value.reset( new EntryType(it->key,it->params,this,Natron::eStorageModeDisk,it->filePath) );
+                
+                ///This will not put the entry back into RAM, instead we just insert back the entry into the disk cache
+                value->restoreMetaDataFromFile(it->size);
+            } catch (const std::bad_alloc & e) {
+                ///The file was evicted in the meantime
+                continue;
+            }
+            value->setBackingFileShared(true);
+            {
+                QMutexLocker locker(&_lock);
+                sealEntry(value, false);
+                ///Mark it as recently used with the next publication so other processes do not evict it first
+                _pendingSharedAccesses.push_back(it->filePath);
+            }
+            ret = true;
+        }
+        return ret;
+    }
+    
+    bool isFileInCache(hash_type hash,
+                       const std::string& filePath) const
+    {
+        assert( !_lock.tryLock() );
+        CacheIterator existing = _memoryCache(hash);
+        if ( existing != _memoryCache.end() ) {
+            std::list<EntryTypePtr> & entries = getValueFromIterator(existing);
+            for (typename std::list<EntryTypePtr>::const_iterator it = entries.begin(); it != entries.end(); ++it) {
+                if ( (*it)->getFilePath() == filePath ) {
+                    return true;
+                }
+            }
+        }
+        existing = _diskCache(hash);
+        if ( existing != _diskCache.end() ) {
+            std::list<EntryTypePtr> & entries = getValueFromIterator(existing);
+            for (typename std::list<EntryTypePtr>::const_iterator it = entries.begin(); it != entries.end(); ++it) {
+                if ( (*it)->getFilePath() == filePath ) {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+    
+    /**
+     * @brief Removes all the files published in the shared index, and empties the index.
+     **/
+    void clearSharedIndex() const
+    {
+        if (!_sharedIndex) {
+            return;
+        }
+        {
+            QMutexLocker locker(&_lock);
+            _pendingPublications.clear();
+            _pendingSharedAccesses.clear();
+        }
+        SharedCacheIndex::Locker indexLocker( _sharedIndex.get() );
+        if ( !indexLocker.isLocked() ) {
+            return;
+        }
+        syncSharedIndex_locked();
+        
+        QMutexLocker k(&_sharedStateLock);
+        for (typename std::map<std::string, SharedEntry>::const_iterator it = _sharedState.entries.begin(); it != _sharedState.entries.end(); ++it) {
+            int ret_code = std::remove( it->first.c_str() );
+            (void)ret_code;
+        }
+        _sharedIndex->rewrite( SharedCacheIndex::RecordList() );
+        _sharedState.clear();
+    }
     
     bool getInternal(const typename EntryType::key_type & key,
              std::list<EntryTypePtr>* returnValue) const
@@ -1472,7 +2047,7 @@ private:
         if ( evicted.second->isStoredOnDisk() ) {
             assert( evicted.second.unique() );
             
-            ///This is EXPENSIVE! it calls msync
+            ///This is EXPENSIVE! it calls msync, unless the cache I/O thread writes the entry (see Natron::CacheIO)
             evicted.second->deallocate();
             
             /*insert it back into the disk portion */
@@ -1516,6 +2091,7 @@ private:
             } else {   /*append to the existing list*/
                 getValueFromIterator(existingDiskCacheEntry).push_back(evicted.second);
             }
+            queueForPublication(evicted.second);
         } else {
             entriesToBeDeleted.push_back(evicted.second);
         }
@@ -5,9 +5,12 @@
 // "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
 #include <Python.h>
 
+#include <algorithm>
 #include <iostream>
 #include <cassert>
 #include <cstdio> // for std::remove
+#include <cstdlib>
+#include <cstring>
 #include <stdexcept>
 #include <vector>
 #include <fstream>
@@ -19,6 +22,7 @@
 #include <boost/shared_ptr.hpp>
 #include <boost/scoped_ptr.hpp>
 #endif
+#include "Engine/CacheIO.h"
 #include "Engine/Hash64.h"
 #include "Engine/MemoryFile.h"
 #include "Engine/NonKeyParams.h"
@@ -28,9 +32,17 @@ namespace Natron {
 /////////////////////////////////////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////BUFFER////////////////////////////////////////////////////
 
+///RAM buffers at least this large are allocated directly from the system, so that only the pages
+///actually written use memory
+#define NATRON_BUFFER_LAZY_COMMIT_MIN_SIZE (1024 * 1024)
+
 
 /** @brief Buffer represents  an internal buffer that can be allocated on different devices.
  * For now the class is simple and can only be either on disk using mmap or in RAM using malloc.
+ * Large RAM buffers are committed lazily (see Natron::allocateLazilyCommittedMemory): their memory is only
+ * used once written to, which makes buffers of which only a portion is rendered cheap.
+ * When write-behind is enabled (see Natron::CacheIO), buffers stored on disk are not mapped: they are held in RAM
+ * until deallocate() hands them to the cache I/O thread, and are read back from the file by reOpenFileMapping().
  * The cost parameter given to the allocate() function is a hint that the Buffer classes uses
  * to select a device to use. By default -1 means it should not allocate any memory,
  * 0 means RAM and >= 1 means the data will be stored on disk using mmap. We could see this
@@ -51,9 +63,13 @@ public:
 
     Buffer()
         : _path()
-          , _buffer()
+          , _ramData(0)
+          , _ramCount(0)
           , _backingFile()
           , _storageMode(eStorageModeRAM)
+          , _writeBehind(false)
+          , _sharedAcrossProcesses(false)
+          , _pendingWrite()
     {
     }
 
@@ -62,14 +78,19 @@ public:
         deallocate();
     }
 
+    /**
+     * @brief sharedAcrossProcesses must be true if the file belongs to the disk portion of a cache shared
+     * with other processes (@see SharedCacheIndex).
+     **/
     void allocate( U64 count,
                    Natron::StorageModeEnum storage,
-                   std::string path = std::string() )
+                   std::string path = std::string(),
+                   bool sharedAcrossProcesses = false )
     {
         /*allocate should be called only once.*/
         assert( _path.empty() );
-        assert( ( (_buffer.size() == 0) && !_backingFile ) || ( (_buffer.size() != 0) && !_backingFile ) || (!(_buffer.size() != 0) && _backingFile) );
-        if ( (_buffer.size() > 0) || _backingFile ) {
+        assert( ( (_ramCount == 0) && !_backingFile ) || ( (_ramCount != 0) && !_backingFile ) || (!(_ramCount != 0) && _backingFile) );
+        if ( (_ramCount > 0) || _backingFile ) {
             return;
         }
 
@@ -77,8 +98,28 @@ public:
         if (storage == Natron::eStorageModeDisk) {
             _storageMode = eStorageModeDisk;
             _path = path;
+            _sharedAcrossProcesses = sharedAcrossProcesses;
+            _writeBehind = Natron::CacheIO::isWriteBehindEnabled();
+            if (_writeBehind) {
+                ///Only create the file to reserve its name, it is written once the buffer is deallocated
+                if ( !Natron::CacheIO::createFile(_path) ) {
+                    _path.clear();
+                    _writeBehind = false;
+                    allocate(count,Natron::eStorageModeRAM, path);
+
+                    return;
+                }
+                _ramData = allocateRAM(count, true);
+                _ramCount = count;
+
+                return;
+            }
             try {
-                _backingFile.reset( new MemoryFile(_path,MemoryFile::eFileOpenModeEnumIfExistsKeepElseCreate) );
+                ///When shared, fail if the file exists: the name was picked because no file had it, but another
+                ///process sharing the cache directory might have created it in the meantime.
+                _backingFile.reset( new MemoryFile(_path,_sharedAcrossProcesses ?
+                                                   MemoryFile::eFileOpenModeEnumIfExistsFailElseCreate :
+                                                   MemoryFile::eFileOpenModeEnumIfExistsKeepElseCreate) );
             } catch (const std::runtime_error & r) {
                 std::cout << r.what() << std::endl;
 
@@ -96,7 +137,8 @@ public:
             }
         } else if (storage == Natron::eStorageModeRAM) {
             _storageMode = eStorageModeRAM;
-            _buffer.resize(count);
+            _ramData = allocateRAM( count, isLazyRAM(count) );
+            _ramCount = count;
         }
     }
 
@@ -108,9 +150,13 @@ public:
      **/
     void reallocate(U64 count)
     {
-        if (_storageMode == eStorageModeRAM) {
-            assert(_buffer.size() > 0); // could be 0 if we allocate 0...
-            _buffer.resize(count);
+        if ( (_storageMode == eStorageModeRAM) || _writeBehind ) {
+            assert(_ramCount > 0); // could be 0 if we allocate 0...
+            DataType* data = allocateRAM( count, usesLazyRAM(count) );
+            std::memcpy( data, _ramData, std::min(count, _ramCount) * sizeof(DataType) );
+            freeRAM( _ramData, usesLazyRAM(_ramCount), _ramCount );
+            _ramData = data;
+            _ramCount = count;
         } else if (_storageMode == eStorageModeDisk) {
             assert(_backingFile);
             _backingFile->resize( count * sizeof(DataType) );
@@ -124,24 +170,62 @@ public:
     void reOpenFileMapping() const
     {
         assert(!_backingFile && _storageMode == eStorageModeDisk);
+        if (_writeBehind) {
+            assert(!_ramData);
+            ///If the data was not written yet, just take it back
+            void* data = Natron::CacheIO::reclaimWrite(_pendingWrite);
+            _pendingWrite.reset();
+            if (data) {
+                _ramData = static_cast<DataType*>(data);
+            } else {
+                std::size_t size;
+                data = Natron::CacheIO::readFile(_path, &size);
+                if (!data) {
+                    throw std::bad_alloc();
+                }
+                if ( (_ramCount > 0) && (size != _ramCount * sizeof(DataType)) ) {
+                    ///The write failed
+                    Natron::freeLazilyCommittedMemory(data, size);
+                    throw std::bad_alloc();
+                }
+                _ramData = static_cast<DataType*>(data);
+                _ramCount = size / sizeof(DataType);
+            }
+
+            return;
+        }
         try{
-            _backingFile.reset( new MemoryFile(_path,MemoryFile::eFileOpenModeEnumIfExistsKeepElseCreate) );
+            ///When shared, never re-create the file: it may have been evicted by another process sharing the cache
+            _backingFile.reset( new MemoryFile(_path,_sharedAcrossProcesses ?
+                                               MemoryFile::eFileOpenModeEnumIfExistsKeepElseFail :
+                                               MemoryFile::eFileOpenModeEnumIfExistsKeepElseCreate) );
         } catch (const std::exception & e) {
             _backingFile.reset();
             throw std::bad_alloc();
         }
     }
 
-    void restoreBufferFromFile(const std::string & path)
+    void restoreBufferFromFile(const std::string & path,
+                               bool sharedAcrossProcesses)
     {
         _path = path;
         _storageMode = eStorageModeDisk;
+        _sharedAcrossProcesses = sharedAcrossProcesses;
+        _writeBehind = Natron::CacheIO::isWriteBehindEnabled();
     }
 
     void deallocate()
     {
         if (_storageMode == eStorageModeRAM) {
-            _buffer.clear();
+            freeRAM( _ramData, isLazyRAM(_ramCount), _ramCount );
+            _ramData = 0;
+            _ramCount = 0;
+        } else if (_writeBehind) {
+            if (_ramData) {
+                ///The cache I/O thread writes the data and frees it
+                _pendingWrite = Natron::CacheIO::queueWrite( _path, _ramData, _ramCount * sizeof(DataType) );
+                _ramData = 0;
+            }
         } else {
             if (_backingFile) {
                 bool flushOk = _backingFile->flush();
@@ -156,6 +240,17 @@ public:
     bool removeAnyBackingFile() const
     {
         if (_storageMode == eStorageModeDisk) {
+            if (_writeBehind) {
+                Natron::CacheIO::discardWrite(_pendingWrite);
+                _pendingWrite.reset();
+                bool wasInRAM = _ramData != 0;
+                freeRAM(_ramData, true, _ramCount);
+                _ramData = 0;
+                int ret_code = std::remove( _path.c_str() );
+                (void)ret_code;
+
+                return wasInRAM;
+            }
             if (_backingFile) {
                 _backingFile->remove();
                 _backingFile.reset();
@@ -169,13 +264,40 @@ public:
         return false;
     }
 
+    /**
+     * @brief Closes the mapping without removing the file. Returns true if a mapping was opened.
+     **/
+    bool closeBackingFile() const
+    {
+        if (_storageMode == eStorageModeDisk && _writeBehind) {
+            ///The file must be complete once this returns
+            bool wasInRAM = _ramData != 0;
+            if (wasInRAM) {
+                _pendingWrite = Natron::CacheIO::queueWrite( _path, _ramData, _ramCount * sizeof(DataType) );
+                _ramData = 0;
+            }
+            Natron::CacheIO::waitForWrite(_pendingWrite);
+            _pendingWrite.reset();
+
+            return wasInRAM;
+        }
+        if (_storageMode == eStorageModeDisk && _backingFile) {
+            _backingFile->flush();
+            _backingFile.reset();
+            return true;
+        }
+        return false;
+    }
+
     /**
      * @brief Returns the size of the buffer in bytes.
      **/
     size_t size() const
     {
         if (_storageMode == eStorageModeRAM) {
-            return _buffer.size() * sizeof(DataType);
+            return _ramCount * sizeof(DataType);
+        } else if (_writeBehind) {
+            return _ramData ? _ramCount * sizeof(DataType) : 0;
         } else {
             return _backingFile ? _backingFile->size() : 0;
         }
@@ -183,28 +305,49 @@ public:
 
     bool isAllocated() const
     {
-        return (_buffer.size() > 0) || ( _backingFile && _backingFile->data() );
+        if (_storageMode == eStorageModeRAM) {
+            return _ramCount > 0;
+        } else if (_writeBehind) {
+            return _ramData != 0;
+        }
+        return _backingFile && _backingFile->data();
+    }
+
+    /**
+     * @brief Returns true if the buffer was handed to the cache I/O thread and is not completely written yet.
+     **/
+    bool isWritePending() const
+    {
+        return Natron::CacheIO::isWritePending(_pendingWrite);
+    }
+
+    /**
+     * @brief Returns true if the memory of the buffer is only used once written to.
+     **/
+    bool isLazilyCommitted() const
+    {
+        return _storageMode == eStorageModeRAM && isLazyRAM(_ramCount);
     }
 
     DataType* writable()
     {
-        if (_storageMode == eStorageModeDisk) {
+        if ( (_storageMode == eStorageModeDisk) && !_writeBehind ) {
             if (_backingFile) {
                 return (DataType*)_backingFile->data();
             } else {
                 return NULL;
             }
         } else {
-            return &_buffer.front();
+            return _ramData;
         }
     }
 
     const DataType* readable() const
     {
-        if (_storageMode == eStorageModeDisk) {
+        if ( (_storageMode == eStorageModeDisk) && !_writeBehind ) {
             return (const DataType*)_backingFile->data();
         } else {
-            return &_buffer.front();
+            return _ramData;
         }
     }
 
@@ -215,13 +358,61 @@ public:
 
 private:
 
+    static bool isLazyRAM(U64 count)
+    {
+        return count * sizeof(DataType) >= NATRON_BUFFER_LAZY_COMMIT_MIN_SIZE;
+    }
+
+    ///Buffers written behind are handed to the cache I/O thread, which frees them as lazily committed memory
+    bool usesLazyRAM(U64 count) const
+    {
+        return _writeBehind || isLazyRAM(count);
+    }
+
+    ///Zero-initialized, like the std::vector this replaces
+    static DataType* allocateRAM(U64 count,
+                                 bool lazy)
+    {
+        if (count == 0) {
+            return 0;
+        }
+        void* ret;
+        if (lazy) {
+            ret = Natron::allocateLazilyCommittedMemory(count * sizeof(DataType));
+        } else {
+            ret = std::calloc( count, sizeof(DataType) );
+            if (!ret) {
+                throw std::bad_alloc();
+            }
+        }
+
+        return static_cast<DataType*>(ret);
+    }
+
+    static void freeRAM(DataType* data,
+                        bool lazy,
+                        U64 count)
+    {
+        if (lazy) {
+            Natron::freeLazilyCommittedMemory(data, count * sizeof(DataType));
+        } else {
+            std::free(data);
+        }
+    }
+
     std::string _path;
-    std::vector<DataType> _buffer;
+
+    /*mutable so that the reOpenFileMapping function can read back buffers written behind*/
+    mutable DataType* _ramData;
+    mutable U64 _ramCount;
 
     /*mutable so the reOpenFileMapping function can reopen the mmaped file. It doesn't
        change the underlying data*/
     mutable boost::scoped_ptr<MemoryFile> _backingFile;
     Natron::StorageModeEnum _storageMode;
+    bool _writeBehind; //< stored on disk with Natron::CacheIO instead of a mapped file
+    bool _sharedAcrossProcesses; //< the file belongs to a cache shared with other processes
+    mutable Natron::CacheIO::PendingWritePtr _pendingWrite; //< the last write of the buffer handed to the cache I/O thread
 };
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -266,6 +457,11 @@ public:
      **/
     virtual void notifyEntryStorageChanged(Natron::StorageModeEnum oldStorage,Natron::StorageModeEnum newStorage,
                                            int time,size_t size) const = 0;
+
+    /**
+     * @brief Returns true if the disk portion of the cache is shared with other processes
+     **/
+    virtual bool isSharedAcrossProcesses() const = 0;
     
     
 #ifdef DEBUG
@@ -374,6 +570,7 @@ public:
     , _data()
     , _cache()
     , _removeBackingFileBeforeDestruction(false)
+    , _backingFileShared(false)
     , _requestedStorage(eStorageModeNone)
     {
     }
@@ -394,6 +591,7 @@ public:
           , _data()
           , _cache(cache)
           , _removeBackingFileBeforeDestruction(false)
+          , _backingFileShared(false)
           , _requestedPath(path)
           , _requestedStorage(storage)
     {
@@ -586,7 +784,13 @@ public:
         }
         
         bool isAlloc = _data.isAllocated();
-        bool hasRemovedFile = _data.removeAnyBackingFile();
+        bool hasRemovedFile;
+        if (_backingFileShared) {
+            ///The file belongs to the index shared with other processes, which is in charge of removing it
+            hasRemovedFile = _data.closeBackingFile();
+        } else {
+            hasRemovedFile = _data.removeAnyBackingFile();
+        }
         if (hasRemovedFile) {
             _cache->backingFileClosed();
         }
@@ -605,6 +809,38 @@ public:
         _removeBackingFileBeforeDestruction = true;
     }
 
+    /**
+     * @brief When set, the backing file was published in the index of a cache shared with other processes:
+     * removing the entry from this process only closes the file, it is up to the shared index to remove it.
+     **/
+    void setBackingFileShared(bool shared)
+    {
+        _backingFileShared = shared;
+    }
+
+    bool isBackingFileShared() const
+    {
+        return _backingFileShared;
+    }
+
+    /**
+     * @brief Returns true if the backing file is still being written by the cache I/O thread, @see Natron::CacheIO
+     **/
+    bool isBackingFileWritePending() const
+    {
+        return _data.isWritePending();
+    }
+
+    /**
+     * @brief Returns true if the content of the backing file is complete and may be used by other processes.
+     * Derived classes holding meta-data that are not stored in the file (e.g: the bitmap of an Image) should
+     * override this.
+     **/
+    virtual bool canBeSharedAcrossProcesses() const
+    {
+        return true;
+    }
+
     virtual SequenceTime getTime() const OVERRIDE FINAL
     {
         return _key.getTime();
@@ -678,7 +914,7 @@ private:
             }
 #endif
         }
-        _data.allocate(count, storage, fileName);
+        _data.allocate( count, storage, fileName, _cache && _cache->isSharedAcrossProcesses() );
     }
 
     /** @brief This function is called in allocateMeory() and before the object is exposed
@@ -691,7 +927,7 @@ private:
         if (!fileExists(path)) {
             throw std::bad_alloc();
         }
-        _data.restoreBufferFromFile(path);
+        _data.restoreBufferFromFile( path, _cache && _cache->isSharedAcrossProcesses() );
        
     }
 
@@ -702,6 +938,7 @@ protected:
     Buffer<DataType> _data;
     const CacheAPI* _cache;
     bool _removeBackingFileBeforeDestruction;
+    bool _backingFileShared;
     std::string _requestedPath;
     Natron::StorageModeEnum _requestedStorage;
 };
@@ -0,0 +1,551 @@
+//  Natron
+//
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+
+#include "CacheIO.h"
+
+#include <algorithm>
+#include <list>
+
+#if defined(__NATRON_UNIX__)
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+CLANG_DIAG_OFF(deprecated)
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QFile>
+#include <QtCore/QMutex>
+#include <QtCore/QThread>
+#include <QtCore/QWaitCondition>
+CLANG_DIAG_ON(deprecated)
+
+#include "Engine/MemoryFile.h"
+
+///Writes are issued in chunks of this size. On Linux the write-back of each chunk is started right away
+///so that dirty pages do not pile up until the system flushes them all at once.
+#define NATRON_CACHE_IO_CHUNK_SIZE (8 * 1024 * 1024)
+
+///The buffers queued for writing are not accounted in the cache anymore: bound the RAM they hold
+#define NATRON_CACHE_IO_MAX_PENDING_SIZE (512 * 1024 * 1024)
+
+using namespace Natron;
+
+namespace Natron {
+class CacheIO::PendingWrite
+{
+public:
+
+    enum StateEnum
+    {
+        eStateQueued = 0,
+        eStateWriting,
+        eStateDone,
+        eStateFailed,
+        eStateCancelled
+    };
+
+    std::string path;
+    void* data;
+    std::size_t size;
+    StateEnum state;
+    QElapsedTimer queuedTimer;
+
+    PendingWrite(const std::string& path,
+                 void* data,
+                 std::size_t size)
+    : path(path)
+    , data(data)
+    , size(size)
+    , state(eStateQueued)
+    , queuedTimer()
+    {
+        queuedTimer.start();
+    }
+};
+} // namespace Natron
+
+namespace {
+
+class CacheIOThread : public QThread
+{
+public:
+
+    CacheIOThread()
+    : QThread()
+    {
+        setObjectName("Cache I/O");
+    }
+
+private:
+
+    virtual void run() OVERRIDE FINAL;
+};
+
+///All the members below are protected by ioMutex
+QMutex ioMutex;
+QWaitCondition queueNotEmptyCond;
+QWaitCondition writeDoneCond; //< woken up whenever a write is done or cancelled
+std::list<CacheIO::PendingWritePtr> queue;
+std::size_t pendingSize = 0; //< bytes queued or being written
+CacheIOThread* ioThread = 0;
+bool ioThreadMustQuit = false;
+bool ioThreadQuit = false;
+bool writeBehindEnabled = false;
+CacheIO::Stats ioStats;
+std::list<CacheIO::Stats*> recordersStats; //< the stats of the StatsRecorder alive
+
+///The functions below update the stats of the application and of the recorders, ioMutex must be held
+void
+statsWriteQueued(std::size_t size,
+                 bool throttled)
+{
+    pendingSize += size;
+    ioStats.queueDepth += 1;
+    ioStats.maxQueueDepth = std::max(ioStats.maxQueueDepth, ioStats.queueDepth);
+    ioStats.throttledWrites += throttled ? 1 : 0;
+    for (std::list<CacheIO::Stats*>::iterator it = recordersStats.begin(); it != recordersStats.end(); ++it) {
+        (*it)->queueDepth += 1;
+        (*it)->maxQueueDepth = std::max( (*it)->maxQueueDepth, (*it)->queueDepth );
+        (*it)->throttledWrites += throttled ? 1 : 0;
+    }
+}
+
+void
+statsWriteDequeued(std::size_t size)
+{
+    pendingSize -= size;
+    ioStats.queueDepth -= 1;
+    for (std::list<CacheIO::Stats*>::iterator it = recordersStats.begin(); it != recordersStats.end(); ++it) {
+        (*it)->queueDepth = std::max(0, (*it)->queueDepth - 1);
+    }
+    writeDoneCond.wakeAll();
+}
+
+void
+addWriteStats(CacheIO::Stats* stats,
+              bool ok,
+              std::size_t size,
+              double latency)
+{
+    if (ok) {
+        ++stats->writes;
+        stats->bytesWritten += size;
+        stats->writeLatency += latency;
+        stats->maxWriteLatency = std::max(stats->maxWriteLatency, latency);
+    } else {
+        ++stats->failedWrites;
+    }
+}
+
+void
+addReadStats(CacheIO::Stats* stats,
+             std::size_t size,
+             double latency)
+{
+    ++stats->reads;
+    stats->bytesRead += size;
+    stats->readLatency += latency;
+}
+
+#if defined(__NATRON_UNIX__)
+bool
+writeFile(const std::string& path,
+          const char* data,
+          std::size_t size)
+{
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+
+    if (fd == -1) {
+        return false;
+    }
+    std::size_t offset = 0;
+    bool ok = true;
+    while (ok && offset < size) {
+        std::size_t chunkEnd = std::min(size, offset + NATRON_CACHE_IO_CHUNK_SIZE);
+        std::size_t chunkStart = offset;
+        while (offset < chunkEnd) {
+            ssize_t written = ::pwrite(fd, data + offset, chunkEnd - offset, offset);
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                ok = false;
+                break;
+            }
+            offset += written;
+        }
+#ifdef __linux__
+        if (ok) {
+            ::sync_file_range(fd, chunkStart, chunkEnd - chunkStart, SYNC_FILE_RANGE_WRITE);
+        }
+#else
+        (void)chunkStart;
+#endif
+    }
+    if (::close(fd) != 0) {
+        ok = false;
+    }
+
+    return ok;
+}
+
+#else // !__NATRON_UNIX__
+
+bool
+writeFile(const std::string& path,
+          const char* data,
+          std::size_t size)
+{
+    QFile f( QString::fromUtf8( path.c_str() ) );
+
+    if ( !f.open(QIODevice::WriteOnly | QIODevice::Truncate) ) {
+        return false;
+    }
+    std::size_t offset = 0;
+    while (offset < size) {
+        qint64 written = f.write( data + offset, std::min( (std::size_t)NATRON_CACHE_IO_CHUNK_SIZE, size - offset ) );
+        if (written <= 0) {
+            return false;
+        }
+        offset += written;
+    }
+
+    return true;
+}
+
+#endif // __NATRON_UNIX__
+
+///Called with the write in the writing state, without ioMutex
+void
+processWrite(const CacheIO::PendingWritePtr& w)
+{
+    bool ok = writeFile(w->path, (const char*)w->data, w->size);
+
+    Natron::freeLazilyCommittedMemory(w->data, w->size);
+
+    QMutexLocker l(&ioMutex);
+    w->data = 0;
+    w->state = ok ? CacheIO::PendingWrite::eStateDone : CacheIO::PendingWrite::eStateFailed;
+    double latency = w->queuedTimer.elapsed() / 1000.;
+    addWriteStats(&ioStats, ok, w->size, latency);
+    for (std::list<CacheIO::Stats*>::iterator it = recordersStats.begin(); it != recordersStats.end(); ++it) {
+        addWriteStats(*it, ok, w->size, latency);
+    }
+    statsWriteDequeued(w->size);
+}
+
+void
+CacheIOThread::run()
+{
+    for (;;) {
+        CacheIO::PendingWritePtr w;
+        {
+            QMutexLocker l(&ioMutex);
+            while ( queue.empty() && !ioThreadMustQuit ) {
+                queueNotEmptyCond.wait(&ioMutex);
+            }
+            if ( queue.empty() ) {
+                ///Everything queued was written
+                return;
+            }
+            w = queue.front();
+            queue.pop_front();
+            w->state = CacheIO::PendingWrite::eStateWriting;
+        }
+        processWrite(w);
+    }
+}
+} // anon namespace
+
+void
+CacheIO::setWriteBehindEnabled(bool enabled)
+{
+    QMutexLocker l(&ioMutex);
+
+    writeBehindEnabled = enabled;
+}
+
+bool
+CacheIO::isWriteBehindEnabled()
+{
+    QMutexLocker l(&ioMutex);
+
+    return writeBehindEnabled;
+}
+
+CacheIO::PendingWritePtr
+CacheIO::queueWrite(const std::string& path,
+                    void* data,
+                    std::size_t size)
+{
+    PendingWritePtr w( new PendingWrite(path, data, size) );
+    {
+        QMutexLocker l(&ioMutex);
+
+        ///Backpressure: let the I/O thread catch up rather than piling up buffers in RAM.
+        ///A write larger than the limit is queued alone.
+        bool throttled = false;
+        while ( !ioThreadQuit && (pendingSize > 0) && (pendingSize + size > NATRON_CACHE_IO_MAX_PENDING_SIZE) ) {
+            throttled = true;
+            writeDoneCond.wait(&ioMutex);
+        }
+        ///The latency is measured from the moment the write is actually queued
+        w->queuedTimer.restart();
+        statsWriteQueued(size, throttled);
+        if (!ioThreadQuit) {
+            if (!ioThread) {
+                ioThread = new CacheIOThread;
+                ioThread->start();
+            }
+            queue.push_back(w);
+            queueNotEmptyCond.wakeOne();
+
+            return w;
+        }
+        w->state = PendingWrite::eStateWriting;
+    }
+    ///The application is quitting: write it now
+    processWrite(w);
+
+    return w;
+}
+
+void*
+CacheIO::reclaimWrite(const PendingWritePtr& write)
+{
+    if (!write) {
+        return 0;
+    }
+    QMutexLocker l(&ioMutex);
+    if (write->state == PendingWrite::eStateQueued) {
+        queue.remove(write);
+        write->state = PendingWrite::eStateCancelled;
+        void* ret = write->data;
+        write->data = 0;
+        ++ioStats.reclaimedWrites;
+        for (std::list<CacheIO::Stats*>::iterator it = recordersStats.begin(); it != recordersStats.end(); ++it) {
+            ++(*it)->reclaimedWrites;
+        }
+        statsWriteDequeued(write->size);
+
+        return ret;
+    }
+    while (write->state == PendingWrite::eStateWriting) {
+        writeDoneCond.wait(&ioMutex);
+    }
+
+    return 0;
+}
+
+bool
+CacheIO::waitForWrite(const PendingWritePtr& write)
+{
+    if (!write) {
+        return true;
+    }
+    QMutexLocker l(&ioMutex);
+    while (write->state == PendingWrite::eStateQueued || write->state == PendingWrite::eStateWriting) {
+        writeDoneCond.wait(&ioMutex);
+    }
+
+    return write->state != PendingWrite::eStateFailed;
+}
+
+bool
+CacheIO::isWritePending(const PendingWritePtr& write)
+{
+    if (!write) {
+        return false;
+    }
+    QMutexLocker l(&ioMutex);
+
+    return write->state == PendingWrite::eStateQueued || write->state == PendingWrite::eStateWriting;
+}
+
+void
+CacheIO::discardWrite(const PendingWritePtr& write)
+{
+    if (!write) {
+        return;
+    }
+    void* data = 0;
+    {
+        QMutexLocker l(&ioMutex);
+        if (write->state == PendingWrite::eStateQueued) {
+            queue.remove(write);
+            write->state = PendingWrite::eStateCancelled;
+            data = write->data;
+            write->data = 0;
+            statsWriteDequeued(write->size);
+        }
+        while (write->state == PendingWrite::eStateWriting) {
+            writeDoneCond.wait(&ioMutex);
+        }
+    }
+    Natron::freeLazilyCommittedMemory(data, write->size);
+}
+
+bool
+CacheIO::createFile(const std::string& path)
+{
+#if defined(__NATRON_UNIX__)
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+    if (fd == -1) {
+        return false;
+    }
+    ::close(fd);
+
+    return true;
+#else
+    QFile f( QString::fromUtf8( path.c_str() ) );
+    if ( f.exists() ) {
+        return false;
+    }
+
+    return f.open(QIODevice::WriteOnly);
+#endif
+}
+
+void*
+CacheIO::readFile(const std::string& path,
+                  std::size_t* size)
+{
+    QElapsedTimer timer;
+
+    timer.start();
+    char* data = 0;
+    *size = 0;
+#if defined(__NATRON_UNIX__)
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd == -1) {
+        return 0;
+    }
+    struct stat sbuf;
+    if ( (::fstat(fd, &sbuf) == -1) || (sbuf.st_size <= 0) ) {
+        ::close(fd);
+
+        return 0;
+    }
+    std::size_t fileSize = sbuf.st_size;
+#if defined(POSIX_FADV_SEQUENTIAL)
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+    try {
+        data = (char*)Natron::allocateLazilyCommittedMemory(fileSize);
+    } catch (const std::bad_alloc &) {
+        ::close(fd);
+
+        return 0;
+    }
+    std::size_t offset = 0;
+    while (offset < fileSize) {
+        ssize_t nRead = ::pread(fd, data + offset, fileSize - offset, offset);
+        if ( (nRead < 0) && (errno == EINTR) ) {
+            continue;
+        }
+        if (nRead <= 0) {
+            Natron::freeLazilyCommittedMemory(data, fileSize);
+            ::close(fd);
+
+            return 0;
+        }
+        offset += nRead;
+    }
+#if defined(POSIX_FADV_DONTNEED)
+    ///The data is in RAM now, the system does not need to keep the file in its page cache as well
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+#endif
+    ::close(fd);
+#else
+    QFile f( QString::fromUtf8( path.c_str() ) );
+    if ( !f.open(QIODevice::ReadOnly) || (f.size() <= 0) ) {
+        return 0;
+    }
+    std::size_t fileSize = f.size();
+    try {
+        data = (char*)Natron::allocateLazilyCommittedMemory(fileSize);
+    } catch (const std::bad_alloc &) {
+        return 0;
+    }
+    if ( f.read(data, fileSize) != (qint64)fileSize ) {
+        Natron::freeLazilyCommittedMemory(data, fileSize);
+
+        return 0;
+    }
+#endif
+
+    *size = fileSize;
+    {
+        QMutexLocker l(&ioMutex);
+        double latency = timer.elapsed() / 1000.;
+        addReadStats(&ioStats, fileSize, latency);
+        for (std::list<CacheIO::Stats*>::iterator it = recordersStats.begin(); it != recordersStats.end(); ++it) {
+            addReadStats(*it, fileSize, latency);
+        }
+    }
+
+    return data;
+}
+
+void
+CacheIO::getStats(Stats* stats)
+{
+    QMutexLocker l(&ioMutex);
+
+    *stats = ioStats;
+}
+
+CacheIO::StatsRecorder::StatsRecorder()
+: _stats()
+{
+    QMutexLocker l(&ioMutex);
+
+    ///The writes queued before count in the queue depth but not in the writes done
+    _stats.queueDepth = ioStats.queueDepth;
+    _stats.maxQueueDepth = ioStats.queueDepth;
+    recordersStats.push_back(&_stats);
+}
+
+CacheIO::StatsRecorder::~StatsRecorder()
+{
+    QMutexLocker l(&ioMutex);
+
+    recordersStats.remove(&_stats);
+}
+
+void
+CacheIO::StatsRecorder::getStats(Stats* stats) const
+{
+    QMutexLocker l(&ioMutex);
+
+    *stats = _stats;
+}
+
+void
+CacheIO::quit()
+{
+    CacheIOThread* thread;
+    {
+        QMutexLocker l(&ioMutex);
+        ioThreadQuit = true;
+        thread = ioThread;
+        ioThread = 0;
+        if (!thread) {
+            return;
+        }
+        ioThreadMustQuit = true;
+        queueNotEmptyCond.wakeOne();
+    }
+    thread->wait();
+    delete thread;
+}
@@ -0,0 +1,157 @@
+//  Natron
+//
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef NATRON_ENGINE_CACHEIO_H_
+#define NATRON_ENGINE_CACHEIO_H_
+
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+
+#include <cstddef>
+#include <string>
+
+#if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+#endif
+
+#include "Global/GlobalDefines.h"
+
+namespace Natron {
+
+/**
+ * @brief Write-behind I/O for the disk portion of the caches.
+ *
+ * By default the entries cached on disk are files mapped in memory: render threads write the pixels in the mapping
+ * and the system writes the dirty pages back whenever it likes, which may stall the render threads on page faults.
+ * When write-behind is enabled, entries cached on disk live in RAM buffers while they are in the memory portion
+ * of the cache. Once evicted to the disk portion, their buffer is handed to a dedicated I/O thread that writes it
+ * with large sequential writes and frees it. Entries fetched again from the disk portion are read back in a new RAM buffer.
+ * The buffers waiting to be written are bounded: queueWrite() blocks while the disk cannot keep up.
+ *
+ * This class is thread-safe.
+ **/
+class CacheIO
+{
+public:
+
+    struct Stats
+    {
+        U64 writes; //< writes completed
+        U64 failedWrites;
+        U64 bytesWritten;
+        double writeLatency; //< total seconds between queuing the writes and their completion
+        double maxWriteLatency;
+        U64 reclaimedWrites; //< writes cancelled because their data was needed again before being written
+        U64 throttledWrites; //< writes that had to wait for the queue to drain before being queued
+        U64 reads;
+        U64 bytesRead;
+        double readLatency; //< total seconds spent reading
+        int queueDepth; //< writes waiting or being written
+        int maxQueueDepth;
+
+        Stats()
+        : writes(0)
+        , failedWrites(0)
+        , bytesWritten(0)
+        , writeLatency(0.)
+        , maxWriteLatency(0.)
+        , reclaimedWrites(0)
+        , throttledWrites(0)
+        , reads(0)
+        , bytesRead(0)
+        , readLatency(0.)
+        , queueDepth(0)
+        , maxQueueDepth(0)
+        {
+        }
+    };
+
+    /**
+     * @brief Collects the stats of the I/O done while it exists, e.g: during a render.
+     * The I/O thread is shared by the whole application: the I/O of everything running at the same time is counted.
+     **/
+    class StatsRecorder
+        : boost::noncopyable
+    {
+    public:
+
+        StatsRecorder();
+
+        ~StatsRecorder();
+
+        void getStats(Stats* stats) const;
+
+    private:
+
+        Stats _stats; //< protected by the I/O mutex
+    };
+
+    class PendingWrite;
+    typedef boost::shared_ptr<PendingWrite> PendingWritePtr;
+
+    /**
+     * @brief Whether the buffers of the entries cached on disk that are allocated from now on use write-behind I/O
+     * instead of memory mapped files. This is set from the settings when the application starts.
+     **/
+    static void setWriteBehindEnabled(bool enabled);
+
+    static bool isWriteBehindEnabled();
+
+    /**
+     * @brief Queues the write of the size bytes at data to the file at the given path, which is truncated.
+     * The data must have been allocated with Natron::allocateLazilyCommittedMemory(size): it belongs to the I/O thread
+     * from now on, which frees it once written.
+     * If the writes already queued hold too much memory, this waits for some of them to be done first.
+     **/
+    static PendingWritePtr queueWrite(const std::string& path,void* data,std::size_t size);
+
+    /**
+     * @brief If the write did not start yet, cancels it and gives back its data to the caller. Otherwise waits for it
+     * to be done and returns NULL, the data is then in the file.
+     **/
+    static void* reclaimWrite(const PendingWritePtr& write);
+
+    /**
+     * @brief Waits for the write to be done. Returns false if it failed.
+     **/
+    static bool waitForWrite(const PendingWritePtr& write);
+
+    /**
+     * @brief Returns true if the write is queued or being written.
+     **/
+    static bool isWritePending(const PendingWritePtr& write);
+
+    /**
+     * @brief Cancels the write if it did not start yet (its data is freed), otherwise waits for it to be done.
+     **/
+    static void discardWrite(const PendingWritePtr& write);
+
+    /**
+     * @brief Creates an empty file at the given path. Returns false if the file already exists or cannot be created.
+     **/
+    static bool createFile(const std::string& path);
+
+    /**
+     * @brief Reads the whole file at the given path in a buffer allocated with Natron::allocateLazilyCommittedMemory.
+     * Returns NULL if the file could not be read, otherwise size is set to the size of the file.
+     **/
+    static void* readFile(const std::string& path,std::size_t* size);
+
+    /**
+     * @brief Returns the stats of the I/O done since the application started.
+     **/
+    static void getStats(Stats* stats);
+
+    /**
+     * @brief Writes everything that is queued and stops the I/O thread. Writes queued afterwards are done synchronously.
+     **/
+    static void quit();
+};
+} // namespace Natron
+
+#endif // NATRON_ENGINE_CACHEIO_H_
@@ -373,6 +373,40 @@ Curve::addKeyFrame(KeyFrame key)
     return it.second;
 }
 
+void
+Curve::addKeyFrames(const std::vector<KeyFrame> & keys,
+                    std::list<double>* addedTimes)
+{
+    if ( keys.empty() ) {
+        return;
+    }
+    QWriteLocker l(&_imp->_lock);
+    bool constantInterp = (_imp->type == CurvePrivate::eCurveTypeBool) || (_imp->type == CurvePrivate::eCurveTypeString) ||
+                          (_imp->type == CurvePrivate::eCurveTypeIntConstantInterp);
+
+    for (std::vector<KeyFrame>::const_iterator it = keys.begin(); it != keys.end(); ++it) {
+        std::pair<KeyFrameSet::iterator,bool> ret;
+        if (constantInterp) {
+            KeyFrame key = *it;
+            key.setInterpolation(Natron::eKeyframeTypeConstant);
+            ret = addKeyFrameNoUpdate(key);
+        } else {
+            ret = addKeyFrameNoUpdate(*it);
+        }
+        if (addedTimes && ret.second) {
+            addedTimes->push_back( ret.first->getTime() );
+        }
+    }
+
+    ///The derivatives of a keyframe only depend on its neighbours, which are all in place now
+    for (KeyFrameSet::iterator it = _imp->keyFrames.begin(); it != _imp->keyFrames.end(); ++it) {
+        if ( (it->getInterpolation() != Natron::eKeyframeTypeBroken) && (it->getInterpolation() != Natron::eKeyframeTypeFree) &&
+             ( it->getInterpolation() != Natron::eKeyframeTypeNone) ) {
+            it = refreshDerivatives(eCurveChangedReasonDerivativesChanged, it);
+        }
+    }
+}
+
 std::pair<KeyFrameSet::iterator,bool> Curve::addKeyFrameNoUpdate(const KeyFrame & cp)
 {
     // PRIVATE - should not lock
@@ -774,6 +808,110 @@ Curve::getValueAt(double t,bool doClamp) const
     }
 } // getValueAt
 
+void
+Curve::getValuesAt(double first,
+                   double step,
+                   int count,
+                   double* values,
+                   bool doClamp) const
+{
+    assert(step > 0.);
+    if (count <= 0) {
+        return;
+    }
+    std::vector<double> times(count);
+    for (int i = 0; i < count; ++i) {
+        times[i] = first + i * step;
+    }
+    getValuesAt(&times.front(), count, values, doClamp);
+}
+
+void
+Curve::getValuesAt(const double* times,
+                   int count,
+                   double* values,
+                   bool doClamp) const
+{
+    if (count <= 0) {
+        return;
+    }
+    QReadLocker l(&_imp->_lock);
+
+    if ( _imp->keyFrames.empty() ) {
+        throw std::runtime_error("Curve has no control points!");
+    }
+
+    double tcur,tnext;
+    double vcurDerivRight,vnextDerivLeft,vcur,vnext;
+    Natron::KeyframeTypeEnum interp,interpNext;
+    // find the first keyframe with time greater than the first time
+    KeyFrameSet::const_iterator itup = _imp->keyFrames.upper_bound( KeyFrame(times[0],0.) );
+    int i = 0;
+    while (i < count) {
+        // the times in [i, i + n[ are before itup, hence in the same segment
+        int n = 0;
+        if ( itup == _imp->keyFrames.end() ) {
+            n = count - i;
+        } else {
+            const double tup = itup->getTime();
+            while (i + n < count && times[i + n] < tup) {
+                assert(n == 0 || times[i + n - 1] <= times[i + n]);
+                ++n;
+            }
+        }
+        if (n > 0) {
+            interParams(_imp->keyFrames,
+                        times[i],
+                        itup,
+                        &tcur,
+                        &vcur,
+                        &vcurDerivRight,
+                        &interp,
+                        &tnext,
+                        &vnext,
+                        &vnextDerivLeft,
+                        &interpNext);
+            Natron::interpolate_array(tcur,vcur,
+                                      vcurDerivRight,
+                                      vnextDerivLeft,
+                                      tnext,vnext,
+                                      times + i,
+                                      n,
+                                      interp,
+                                      interpNext,
+                                      values + i);
+            i += n;
+        }
+        if ( itup != _imp->keyFrames.end() ) {
+            ++itup;
+        }
+    }
+
+    if ( doClamp && mustClamp() ) {
+        std::pair<double,double> minmax = getCurveYRange();
+        for (int k = 0; k < count; ++k) {
+            values[k] = std::max( minmax.first, std::min(minmax.second, values[k]) );
+        }
+    }
+
+    switch (_imp->type) {
+    case CurvePrivate::eCurveTypeString:
+    case CurvePrivate::eCurveTypeInt:
+        for (int k = 0; k < count; ++k) {
+            values[k] = std::floor(values[k] + 0.5);
+        }
+        break;
+    case CurvePrivate::eCurveTypeBool:
+        for (int k = 0; k < count; ++k) {
+            values[k] = values[k] >= 0.5 ? 1. : 0.;
+        }
+        break;
+    case CurvePrivate::eCurveTypeDouble:
+    default:
+        break;
+    }
+} // getValuesAt
+
 double
 Curve::getDerivativeAt(double t) const
 {
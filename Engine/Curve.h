@@ -17,6 +17,7 @@
 #include <Python.h>
 
 #include <vector>
+#include <list>
 #include <map>
 #include <set>
 
@@ -193,6 +194,13 @@ public:
     ///existing key at this time.
     bool addKeyFrame(KeyFrame key);
 
+    /**
+     * @brief Adds all the keys under a single lock of the curve, the derivatives are refreshed once all the keys are in
+     * instead of after each insertion. Keys at the time of an existing keyframe replace it.
+     * @param addedTimes[out] If not NULL, the times of the keys that did not replace an existing keyframe.
+     **/
+    void addKeyFrames(const std::vector<KeyFrame> & keys,std::list<double>* addedTimes);
+
     void removeKeyFrameWithTime(double time);
 
     void removeKeyFrameWithIndex(int index);
@@ -225,6 +233,19 @@ public:
 
     double getValueAt(double t,bool clamp = true) const WARN_UNUSED_RETURN;
 
+    /**
+     * @brief Evaluates the curve at the times first, first + step, ..., first + (count - 1) * step (step must be positive)
+     * and stores the results in values, which must be able to hold count values.
+     * The results are the same as calling getValueAt() for each time, but the keyframes are walked only once
+     * and each segment is evaluated over all the times it covers at once.
+     **/
+    void getValuesAt(double first,double step,int count,double* values,bool clamp = true) const;
+
+    /**
+     * @brief Same as above for arbitrary times, which must be sorted in increasing order.
+     **/
+    void getValuesAt(const double* times,int count,double* values,bool clamp = true) const;
+
     double getDerivativeAt(double t) const WARN_UNUSED_RETURN;
 
     double getIntegrateFromTo(double t1, double t2) const WARN_UNUSED_RETURN;
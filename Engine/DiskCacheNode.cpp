@@ -14,34 +14,269 @@
 
 #include "DiskCacheNode.h"
 
+#include <algorithm>
+#include <stdexcept>
+
+CLANG_DIAG_OFF(deprecated)
+#include <QtCore/QCoreApplication>
+#include <QtCore/QCryptographicHash>
+#include <QtCore/QDir>
+#include <QtCore/QMutex>
+#include <QtCore/QRunnable>
+#include <QtCore/QThread>
+#include <QtCore/QThreadPool>
+#include <QtCore/QDebug>
+CLANG_DIAG_ON(deprecated)
+
+#include "Engine/AppManager.h"
 #include "Engine/Node.h"
 #include "Engine/Image.h"
 #include "Engine/AppInstance.h"
+#include "Engine/DiskCacheNodeStorage.h"
 #include "Engine/KnobTypes.h"
+#include "Engine/NodeGroup.h"
+#include "Engine/Project.h"
+#include "Engine/Settings.h"
 #include "Engine/TimeLine.h"
 
 using namespace Natron;
 
 struct DiskCacheNodePrivate
 {
+    DiskCacheNode* publicInterface;
     boost::shared_ptr<Choice_Knob> frameRange;
     boost::shared_ptr<Int_Knob> firstFrame;
     boost::shared_ptr<Int_Knob> lastFrame;
     boost::shared_ptr<Button_Knob> preRender;
+    boost::shared_ptr<Bool_Knob> keepFrames;
+    boost::shared_ptr<Button_Knob> clearStorage;
+    
+    DiskCacheNodeStorage storage;
+    QMutex storageDirectoryMutex; //< protects the 2 fields below and serializes the changes of the storage directory
+    bool storageDirectoryValid; //< false until the directory is computed, and again when the project or the node is renamed
+    bool storageIsTemporary; //< true when the project was never saved: the frames only live for the session
     
-    DiskCacheNodePrivate()
+    ///The pre-caching renders frames on low priority threads of its own
+    QThreadPool preCacheThreads;
+    mutable QMutex preCacheMutex; //< protects all fields below
+    int preCacheNextFrame;
+    int preCacheLastFrame;
+    bool preCacheAborted;
+    
+    DiskCacheNodePrivate(DiskCacheNode* publicInterface)
+    : publicInterface(publicInterface)
+    , frameRange()
+    , firstFrame()
+    , lastFrame()
+    , preRender()
+    , keepFrames()
+    , clearStorage()
+    , storage()
+    , storageDirectoryMutex()
+    , storageDirectoryValid(false)
+    , storageIsTemporary(false)
+    , preCacheThreads()
+    , preCacheMutex()
+    , preCacheNextFrame(0)
+    , preCacheLastFrame(-1)
+    , preCacheAborted(false)
     {
-        
+        ///Leave the other cores to the user interface and the viewer
+        preCacheThreads.setMaxThreadCount( std::max(1, QThread::idealThreadCount() / 2) );
+    }
+    
+    /**
+     * @brief The frames of a node are stored in a directory named after the project and the node,
+     * so that they can be found again when the project is re-opened.
+     **/
+    void ensureStorageDirectory()
+    {
+        QMutexLocker k(&storageDirectoryMutex);
+        if (storageDirectoryValid) {
+            return;
+        }
+        boost::shared_ptr<Project> project = publicInterface->getApp()->getProject();
+        QString projectPath = project->getProjectPath();
+        bool wasTemporary = storageIsTemporary;
+        storageIsTemporary = projectPath.isEmpty();
+        QString id;
+        if (storageIsTemporary) {
+            id = QString::number( QCoreApplication::applicationPid() ) + '_' + QString::number( publicInterface->getApp()->getAppID() );
+        } else {
+            id = projectPath + project->getProjectName();
+        }
+        id += '|' + QString( publicInterface->getNode()->getFullyQualifiedName().c_str() );
+        QString dirName = QCryptographicHash::hash(id.toUtf8(), QCryptographicHash::Sha1).toHex();
+
+        QString directory = appPTR->getDiskCacheLocation() + QDir::separator() + "DiskCacheNode" + QDir::separator() + dirName;
+        if (wasTemporary) {
+            ///The frames of a project that was never saved only belong to this session
+            storage.moveToDirectory(directory);
+        } else {
+            ///The project saved under the previous name still refers to the frames stored under it
+            storage.copyToDirectory(directory);
+        }
+        storageDirectoryValid = true;
+    }
+    
+    void startPreCaching(int first,int last);
+    
+    void preCacheFrames();
+    
+    void preCacheFrame(int time,int view);
+};
+
+namespace {
+class PreCacheRunnable
+    : public QRunnable
+{
+    DiskCacheNodePrivate* _imp;
+
+public:
+
+    PreCacheRunnable(DiskCacheNodePrivate* imp)
+        : QRunnable()
+          , _imp(imp)
+    {
+    }
+
+    virtual void run() OVERRIDE FINAL
+    {
+        QThread::currentThread()->setPriority(QThread::LowPriority);
+        _imp->preCacheFrames();
     }
 };
+}
+
+void
+DiskCacheNodePrivate::startPreCaching(int first,
+                                      int last)
+{
+    {
+        QMutexLocker k(&preCacheMutex);
+        preCacheNextFrame = first;
+        preCacheLastFrame = last;
+        preCacheAborted = false;
+    }
+    int nThreads = std::min( preCacheThreads.maxThreadCount(), last - first + 1 );
+    for (int i = 0; i < nThreads; ++i) {
+        preCacheThreads.start( new PreCacheRunnable(this) );
+    }
+}
+
+void
+DiskCacheNodePrivate::preCacheFrames()
+{
+    int viewsCount = publicInterface->getApp()->getProject()->getProjectViewsCount();
+    for (;;) {
+        int time;
+        {
+            QMutexLocker k(&preCacheMutex);
+            if ( preCacheAborted || (preCacheNextFrame > preCacheLastFrame) ) {
+                return;
+            }
+            time = preCacheNextFrame++;
+        }
+        for (int view = 0; view < viewsCount; ++view) {
+            preCacheFrame(time, view);
+        }
+    }
+}
+
+void
+DiskCacheNodePrivate::preCacheFrame(int time,
+                                    int view)
+{
+    boost::shared_ptr<Node> node = publicInterface->getNode();
+    U64 nodeHash = node->getHashValue();
+    if ( publicInterface->isFrameInStorage(nodeHash, time, view, 0) ) {
+        return;
+    }
+    ParallelRenderArgsSetter frameRenderArgs(node.get(),
+                                             time,
+                                             view,
+                                             false,
+                                             false,
+                                             true,
+                                             nodeHash,
+                                             false,
+                                             publicInterface->getApp()->getTimeLine().get());
+    RenderScale scale;
+    scale.x = scale.y = 1.;
+    RectD rod;
+    bool isProjectFormat;
+    Natron::StatusEnum stat = publicInterface->getRegionOfDefinition_public(nodeHash, time, scale, view, &rod, &isProjectFormat);
+    if ( (stat == eStatusFailed) || rod.isNull() ) {
+        return;
+    }
+    RectI renderWindow;
+    rod.toPixelEnclosing(0, publicInterface->getPreferredAspectRatio(), &renderWindow);
+    
+    Natron::ImageComponentsEnum components;
+    Natron::ImageBitDepthEnum depth;
+    publicInterface->getPreferredDepthAndComponents(-1, &components, &depth);
+    
+    ///The render action stores the image
+    try {
+        (void)publicInterface->renderRoI( EffectInstance::RenderRoIArgs( time,
+                                                                         scale,
+                                                                         0,
+                                                                         view,
+                                                                         false,
+                                                                         renderWindow,
+                                                                         rod,
+                                                                         components,
+                                                                         depth ) );
+    } catch (const std::exception & e) {
+        qDebug() << "Failed to pre-cache frame" << time << "of" << node->getScriptName().c_str() << ":" << e.what();
+    }
+}
 
 DiskCacheNode::DiskCacheNode(boost::shared_ptr<Node> node)
 : OutputEffectInstance(node)
-, _imp(new DiskCacheNodePrivate())
+, _imp(new DiskCacheNodePrivate(this))
 {
     setSupportsRenderScaleMaybe(eSupportsYes);
 }
 
+DiskCacheNode::~DiskCacheNode()
+{
+    abortPreCaching();
+    QMutexLocker k(&_imp->storageDirectoryMutex);
+    if (_imp->storageIsTemporary) {
+        _imp->storage.clear();
+    }
+}
+
+void
+DiskCacheNode::refreshStorageDirectory()
+{
+    {
+        QMutexLocker k(&_imp->storageDirectoryMutex);
+        if (!_imp->storageDirectoryValid) {
+            ///Nothing was stored yet
+            return;
+        }
+        _imp->storageDirectoryValid = false;
+    }
+    _imp->ensureStorageDirectory();
+}
+
+void
+DiskCacheNode::refreshStorageDirectories(const std::list<boost::shared_ptr<Natron::Node> >& nodes)
+{
+    for (std::list<boost::shared_ptr<Natron::Node> >::const_iterator it = nodes.begin(); it != nodes.end(); ++it) {
+        DiskCacheNode* isDiskCache = dynamic_cast<DiskCacheNode*>( (*it)->getLiveInstance() );
+        if (isDiskCache) {
+            isDiskCache->refreshStorageDirectory();
+        }
+        NodeGroup* isGroup = dynamic_cast<NodeGroup*>( (*it)->getLiveInstance() );
+        if (isGroup) {
+            refreshStorageDirectories( isGroup->getNodes() );
+        }
+    }
+}
+
 
 void
 DiskCacheNode::addAcceptedComponents(int /*inputNb*/,std::list<Natron::ImageComponentsEnum>* comps)
@@ -59,7 +294,45 @@ DiskCacheNode::addSupportedBitDepth(std::list<Natron::ImageBitDepthEnum>* depths
 bool
 DiskCacheNode::shouldCacheOutput() const
 {
-    return true;
+    ///Images are kept in the node storage instead
+    return false;
+}
+
+void
+DiskCacheNode::getImagesFromStorage(const Natron::ImageKey& key,
+                                    unsigned int mipMapLevel,
+                                    std::list<boost::shared_ptr<Natron::Image> >* images) const
+{
+    _imp->ensureStorageDirectory();
+    _imp->storage.setDecodedFramesMaxSize( appPTR->getCurrentSettings()->getDiskCacheNodeDecodedFramesMaxSize() );
+    _imp->storage.get(key, mipMapLevel, _imp->keepFrames->getValue(), images);
+}
+
+bool
+DiskCacheNode::isFrameInStorage(U64 hash,
+                                SequenceTime time,
+                                int view,
+                                unsigned int mipMapLevel) const
+{
+    _imp->ensureStorageDirectory();
+
+    return _imp->storage.hasFrame(hash, time, view, mipMapLevel, _imp->keepFrames->getValue());
+}
+
+bool
+DiskCacheNode::isPreCaching() const
+{
+    return _imp->preCacheThreads.activeThreadCount() > 0;
+}
+
+void
+DiskCacheNode::abortPreCaching()
+{
+    {
+        QMutexLocker k(&_imp->preCacheMutex);
+        _imp->preCacheAborted = true;
+    }
+    _imp->preCacheThreads.waitForDone();
 }
 
 void
@@ -101,10 +374,26 @@ DiskCacheNode::initializeKnobs()
     _imp->preRender = Natron::createKnob<Button_Knob>(this, "Pre-cache");
     _imp->preRender->setName("preRender");
     _imp->preRender->setEvaluateOnChange(false);
-    _imp->preRender->setHintToolTip("Cache the frame range specified by rendering images at zoom-level 100% only.");
+    _imp->preRender->setHintToolTip("Cache the frame range specified by rendering images at zoom-level 100% only. "
+                                    "The frames are rendered in the background at a low priority, press the button again to stop.");
+    _imp->preRender->setAddNewLine(false);
     page->addKnob(_imp->preRender);
     
+    _imp->clearStorage = Natron::createKnob<Button_Knob>(this, "Clear");
+    _imp->clearStorage->setName("clear");
+    _imp->clearStorage->setEvaluateOnChange(false);
+    _imp->clearStorage->setHintToolTip("Removes all the frames cached by this node from the disk.");
+    page->addKnob(_imp->clearStorage);
     
+    _imp->keepFrames = Natron::createKnob<Bool_Knob>(this, "Keep frames when the input changes");
+    _imp->keepFrames->setName("keepFrames");
+    _imp->keepFrames->setAnimationEnabled(false);
+    _imp->keepFrames->setEvaluateOnChange(false);
+    _imp->keepFrames->setDefaultValue(false);
+    _imp->keepFrames->setHintToolTip("When checked, the cached frames are used even if a parameter or a node upstream changed "
+                                     "since they were rendered (use the Clear button to refresh them). "
+                                     "When unchecked, all the cached frames are discarded as soon as the input changes.");
+    page->addKnob(_imp->keepFrames);
 }
 
 void
@@ -127,13 +416,20 @@ DiskCacheNode::knobChanged(KnobI* k, Natron::ValueChangedReasonEnum /*reason*/,
                 break;
         }
     } else if (_imp->preRender.get() == k) {
-        AppInstance::RenderWork w;
-        w.writer = this;
-        w.firstFrame = INT_MIN;
-        w.lastFrame = INT_MAX;
-        std::list<AppInstance::RenderWork> works;
-        works.push_back(w);
-        getApp()->startWritersRendering(works);
+        if ( isPreCaching() ) {
+            abortPreCaching();
+        } else {
+            SequenceTime first = INT_MIN,last = INT_MAX;
+            getFrameRange(&first, &last);
+            if ( (first != INT_MIN) && (last != INT_MAX) && (first <= last) ) {
+                _imp->startPreCaching(first, last);
+            }
+        }
+    } else if (_imp->clearStorage.get() == k) {
+        abortPreCaching();
+        _imp->ensureStorageDirectory();
+        _imp->storage.clear();
+        evaluate_public(NULL, true, eValueChangedReasonUserEdited);
     }
 }
 
@@ -233,6 +529,12 @@ DiskCacheNode::render(SequenceTime time,
         output->pasteFrom(*srcImg, roi, output->usesBitMap() && srcImg->usesBitMap());
     }
     
+    ///Tiles are not supported so the whole image is rendered at once
+    if ( roi.contains( output->getBounds() ) ) {
+        _imp->ensureStorageDirectory();
+        _imp->storage.store(getRenderHash(), time, view, output, _imp->keepFrames->getValue());
+    }
+    
     return eStatusOK;
 }
 
@@ -27,6 +27,8 @@ public:
     }
     
     DiskCacheNode(boost::shared_ptr<Natron::Node> node);
+
+    virtual ~DiskCacheNode();
     
     virtual int getMajorVersion() const OVERRIDE FINAL WARN_UNUSED_RETURN
     {
@@ -59,12 +61,14 @@ public:
     {
         return "This node caches all images of the connected input node onto the disk with full 32bit floating point raw data. "
     "When an image is found in the cache, " NATRON_APPLICATION_NAME " will then not request the input branch to render out that image. "
-    "The DiskCache node only caches full images and does not split up the images in chunks.  "
+    "The images are compressed without loss and stored in a directory of the node, "
+    "in the same location that is used for the viewer cache (you can set it in the preferences). "
     "The DiskCache node is useful if you're working with a large and complex node tree: this allows to break the tree into smaller "
-    "branches and cache any branch that you're no longer working on. The cached images are saved by default in the same directory that is used "
-    "for the viewer cache but you can set its location and size in the preferences. A solid state drive disk is recommended for efficiency of this node. "
+    "branches and cache any branch that you're no longer working on. A solid state drive disk is recommended for efficiency of this node. "
     "By default all images that pass into the node are cached but they depend on the zoom-level of the viewer. For convenience you can cache "
-    "a specific frame range at scale 100% much like a writer node would do. \n"
+    "a specific frame range at scale 100% in the background while you keep working. "
+    "The cached images are kept across sessions for projects that were saved. By default they are discarded as soon as anything changes "
+    "upstream, unless \"Keep frames when the input changes\" is checked.\n"
     "WARNING: The DiskCache node must be part of the tree when you want to read cached data from it. ";
     }
 
@@ -117,6 +121,40 @@ public:
 
     virtual double getPreferredAspectRatio() const OVERRIDE FINAL;
 
+    /**
+     * @brief Reads back from the node storage the image of the frame of the given key
+     * at mipMapLevel or at the closest higher resolution. It is not put in the cache.
+     **/
+    void getImagesFromStorage(const Natron::ImageKey& key,
+                              unsigned int mipMapLevel,
+                              std::list<boost::shared_ptr<Natron::Image> >* images) const;
+
+    /**
+     * @brief Returns true if getImagesFromStorage would find the frame.
+     **/
+    bool isFrameInStorage(U64 hash,
+                          SequenceTime time,
+                          int view,
+                          unsigned int mipMapLevel) const WARN_UNUSED_RETURN;
+
+    bool isPreCaching() const WARN_UNUSED_RETURN;
+
+    /**
+     * @brief Stops the pre-caching of the frame range and waits for the frames being rendered.
+     **/
+    void abortPreCaching();
+
+    /**
+     * @brief Must be called when the project or the node is renamed: the storage directory is named after them.
+     * The frames already stored are moved to the new directory.
+     **/
+    void refreshStorageDirectory();
+
+    /**
+     * @brief Calls refreshStorageDirectory() on all DiskCache nodes among the given nodes and in their groups.
+     **/
+    static void refreshStorageDirectories(const std::list<boost::shared_ptr<Natron::Node> >& nodes);
+
 private:
 
     virtual void knobChanged(KnobI* k, Natron::ValueChangedReasonEnum reason, int view, SequenceTime time,
@@ -0,0 +1,786 @@
+//  Natron
+//
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+
+#include "DiskCacheNodeStorage.h"
+
+#include <list>
+#include <map>
+#include <vector>
+#include <algorithm>
+#include <cassert>
+
+CLANG_DIAG_OFF(deprecated)
+#include <QtCore/QByteArray>
+#include <QtCore/QDataStream>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QMutex>
+#include <QtCore/QReadWriteLock>
+#include <QtCore/QDebug>
+CLANG_DIAG_ON(deprecated)
+
+#include "Engine/Image.h"
+#include "Engine/ImageKey.h"
+
+#define NATRON_DISKCACHENODE_STORAGE_MAGIC 0x4e444353 // "NDCS"
+#define NATRON_DISKCACHENODE_STORAGE_VERSION 1
+
+///Number of rows of an image compressed together
+#define NATRON_DISKCACHENODE_CHUNK_ROWS 64
+
+///Favour speed: the storage is written while rendering
+#define NATRON_DISKCACHENODE_COMPRESSION_LEVEL 1
+
+///The data file is compacted when more than half of it is made of replaced frames, and at least this size
+#define NATRON_DISKCACHENODE_MIN_COMPACT_SIZE (64 * 1024 * 1024)
+
+///The frames read most recently are kept decoded in RAM up to this size by default, so that redrawing them does not
+///read the disk again. See DiskCacheNodeStorage::setDecodedFramesMaxSize()
+#define NATRON_DISKCACHENODE_DECODED_FRAMES_MAX_SIZE (256 * 1024 * 1024)
+
+using namespace Natron;
+
+namespace {
+
+struct StoredChunk
+{
+    qint64 offset;
+    qint32 size;
+};
+
+struct StoredFrame
+{
+    U64 hash;
+    RectD rod;
+    RectI bounds;
+    double par;
+    bool isProjectFormat;
+    qint32 components;
+    qint32 bitdepth;
+    std::vector<StoredChunk> chunks;
+
+    qint64 getDataSize() const
+    {
+        qint64 ret = 0;
+
+        for (U32 i = 0; i < chunks.size(); ++i) {
+            ret += chunks[i].size;
+        }
+
+        return ret;
+    }
+};
+
+struct FrameId
+{
+    SequenceTime time;
+    int view;
+    unsigned int mipMapLevel;
+
+    bool operator<(const FrameId& other) const
+    {
+        if (time != other.time) {
+            return time < other.time;
+        }
+        if (view != other.view) {
+            return view < other.view;
+        }
+
+        return mipMapLevel < other.mipMapLevel;
+    }
+};
+
+typedef std::map<FrameId,StoredFrame> FramesMap;
+
+struct DecodedFrame
+{
+    FrameId id;
+    Natron::ImageKey key;
+    boost::shared_ptr<Natron::Image> image;
+    std::size_t size;
+};
+
+typedef std::list<DecodedFrame> DecodedFramesList;
+
+///Groups the n-th byte of all elements together: the exponent and high bits of the mantissa of
+///floating point pixels vary slowly and compress much better once they are contiguous.
+void
+shuffleBytes(const unsigned char* src,
+             std::size_t elementsCount,
+             int elementSize,
+             unsigned char* dst)
+{
+    for (int k = 0; k < elementSize; ++k) {
+        unsigned char* dstPlane = dst + k * elementsCount;
+        const unsigned char* srcIt = src + k;
+        for (std::size_t i = 0; i < elementsCount; ++i, srcIt += elementSize) {
+            dstPlane[i] = *srcIt;
+        }
+    }
+}
+
+void
+unshuffleBytes(const unsigned char* src,
+               std::size_t elementsCount,
+               int elementSize,
+               unsigned char* dst)
+{
+    for (int k = 0; k < elementSize; ++k) {
+        const unsigned char* srcPlane = src + k * elementsCount;
+        unsigned char* dstIt = dst + k;
+        for (std::size_t i = 0; i < elementsCount; ++i, dstIt += elementSize) {
+            *dstIt = srcPlane[i];
+        }
+    }
+}
+
+QByteArray
+serializeFrame(const FrameId& id,
+               const StoredFrame& frame)
+{
+    QByteArray record;
+    QDataStream out(&record, QIODevice::WriteOnly);
+
+    out.setVersion(QDataStream::Qt_4_8);
+    out << (quint64)frame.hash << (qint32)id.time << (qint32)id.view << (quint32)id.mipMapLevel
+        << frame.rod.x1 << frame.rod.y1 << frame.rod.x2 << frame.rod.y2
+        << (qint32)frame.bounds.x1 << (qint32)frame.bounds.y1 << (qint32)frame.bounds.x2 << (qint32)frame.bounds.y2
+        << frame.par << frame.isProjectFormat << frame.components << frame.bitdepth << (quint32)frame.chunks.size();
+    for (U32 i = 0; i < frame.chunks.size(); ++i) {
+        out << frame.chunks[i].offset << frame.chunks[i].size;
+    }
+
+    return record;
+}
+
+bool
+deserializeFrame(const QByteArray& record,
+                 FrameId* id,
+                 StoredFrame* frame)
+{
+    QDataStream in(record);
+
+    in.setVersion(QDataStream::Qt_4_8);
+    quint64 hash;
+    qint32 time,view;
+    quint32 mipMapLevel,nChunks;
+    qint32 x1,y1,x2,y2;
+    in >> hash >> time >> view >> mipMapLevel
+       >> frame->rod.x1 >> frame->rod.y1 >> frame->rod.x2 >> frame->rod.y2
+       >> x1 >> y1 >> x2 >> y2
+       >> frame->par >> frame->isProjectFormat >> frame->components >> frame->bitdepth >> nChunks;
+    if (in.status() != QDataStream::Ok) {
+        return false;
+    }
+    frame->hash = hash;
+    frame->bounds.set(x1, y1, x2, y2);
+    id->time = time;
+    id->view = view;
+    id->mipMapLevel = mipMapLevel;
+    frame->chunks.resize(nChunks);
+    for (quint32 i = 0; i < nChunks; ++i) {
+        in >> frame->chunks[i].offset >> frame->chunks[i].size;
+    }
+
+    return in.status() == QDataStream::Ok;
+}
+
+///Appends a record to the index, prefixed by its size so a record that was only partially written can be detected
+bool
+writeIndexRecord(QFile & indexFile,
+                 const FrameId& id,
+                 const StoredFrame& frame)
+{
+    QByteArray record = serializeFrame(id, frame);
+    QDataStream out(&indexFile);
+
+    out.setVersion(QDataStream::Qt_4_8);
+    out << (quint32)record.size();
+    out.writeRawData( record.constData(), record.size() );
+
+    return out.status() == QDataStream::Ok;
+}
+
+bool
+openIndexForAppend(QFile & indexFile)
+{
+    if ( !indexFile.open(QIODevice::WriteOnly | QIODevice::Append) ) {
+        return false;
+    }
+    if (indexFile.size() == 0) {
+        QDataStream out(&indexFile);
+        out.setVersion(QDataStream::Qt_4_8);
+        out << (quint32)NATRON_DISKCACHENODE_STORAGE_MAGIC << (quint32)NATRON_DISKCACHENODE_STORAGE_VERSION;
+    }
+
+    return true;
+}
+}
+
+struct DiskCacheNodeStoragePrivate
+{
+    mutable QReadWriteLock lock; //< protects all fields and the files on disk
+    QString directory;
+    FramesMap frames;
+    qint64 dataFileSize;
+    qint64 liveDataSize; //< the size of the chunks of the frames in the index, the rest of the data file is dead
+    U64 framesVersion; //< incremented whenever frames are replaced or removed
+
+    mutable QMutex decodedFramesMutex; //< protects decodedFrames, decodedFramesSize and decodedFramesMaxSize, taken after lock
+    mutable DecodedFramesList decodedFrames; //< the most recently used first
+    mutable std::size_t decodedFramesSize;
+    std::size_t decodedFramesMaxSize;
+
+    DiskCacheNodeStoragePrivate()
+    : lock()
+    , directory()
+    , frames()
+    , dataFileSize(0)
+    , liveDataSize(0)
+    , framesVersion(0)
+    , decodedFramesMutex()
+    , decodedFrames()
+    , decodedFramesSize(0)
+    , decodedFramesMaxSize(NATRON_DISKCACHENODE_DECODED_FRAMES_MAX_SIZE)
+    {
+    }
+
+    QString getDataFilePath() const
+    {
+        return directory + QDir::separator() + "frames.data";
+    }
+
+    QString getIndexFilePath() const
+    {
+        return directory + QDir::separator() + "frames.index";
+    }
+
+    void loadIndex_locked();
+
+    void removeFiles_locked();
+
+    void compact_locked();
+
+    bool readChunks_locked(const StoredFrame& frame,std::vector<QByteArray>* chunks) const;
+
+    ///Drops the decoded frames of the given time and view, or all of them if all is true. The write lock must be held.
+    void removeDecodedFrames_locked(const FrameId& id,bool all);
+
+    void insertDecodedFrame(const DecodedFrame& frame) const;
+
+    ///Drops the least recently used decoded frames above decodedFramesMaxSize. decodedFramesMutex must be held.
+    void trimDecodedFrames_locked() const;
+};
+
+void
+DiskCacheNodeStoragePrivate::removeDecodedFrames_locked(const FrameId& id,
+                                                        bool all)
+{
+    ++framesVersion;
+
+    QMutexLocker k(&decodedFramesMutex);
+    for (DecodedFramesList::iterator it = decodedFrames.begin(); it != decodedFrames.end();) {
+        if ( all || ( (it->id.time == id.time) && (it->id.view == id.view) ) ) {
+            decodedFramesSize -= it->size;
+            it = decodedFrames.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void
+DiskCacheNodeStoragePrivate::insertDecodedFrame(const DecodedFrame& frame) const
+{
+    QMutexLocker k(&decodedFramesMutex);
+
+    decodedFrames.push_front(frame);
+    decodedFramesSize += frame.size;
+    trimDecodedFrames_locked();
+}
+
+void
+DiskCacheNodeStoragePrivate::trimDecodedFrames_locked() const
+{
+    assert( !decodedFramesMutex.tryLock() );
+    while ( (decodedFramesSize > decodedFramesMaxSize) && (decodedFrames.size() > 1) ) {
+        decodedFramesSize -= decodedFrames.back().size;
+        decodedFrames.pop_back();
+    }
+}
+
+void
+DiskCacheNodeStoragePrivate::loadIndex_locked()
+{
+    removeDecodedFrames_locked(FrameId(), true);
+    frames.clear();
+    dataFileSize = QFileInfo( getDataFilePath() ).size();
+    liveDataSize = 0;
+
+    QFile indexFile( getIndexFilePath() );
+    if ( !indexFile.open(QIODevice::ReadOnly) ) {
+        return;
+    }
+    QByteArray raw = indexFile.readAll();
+    indexFile.close();
+
+    QDataStream in(raw);
+    in.setVersion(QDataStream::Qt_4_8);
+    quint32 magic,version;
+    in >> magic >> version;
+    if ( (in.status() != QDataStream::Ok) || (magic != NATRON_DISKCACHENODE_STORAGE_MAGIC) || (version != NATRON_DISKCACHENODE_STORAGE_VERSION) ) {
+        ///Written by another version, start over
+        removeFiles_locked();
+
+        return;
+    }
+
+    ///Later records replace earlier ones for the same frame
+    qint64 validSize = in.device()->pos();
+    while ( !in.atEnd() ) {
+        quint32 recordSize;
+        in >> recordSize;
+        if ( (in.status() != QDataStream::Ok) || ( (qint64)recordSize > raw.size() - in.device()->pos() ) ) {
+            break;
+        }
+        QByteArray record(recordSize, 0);
+        in.readRawData(record.data(), recordSize);
+        FrameId id;
+        StoredFrame frame;
+        if ( !deserializeFrame(record, &id, &frame) ) {
+            break;
+        }
+        validSize = in.device()->pos();
+
+        bool dataValid = true;
+        for (U32 i = 0; i < frame.chunks.size(); ++i) {
+            if (frame.chunks[i].offset + frame.chunks[i].size > dataFileSize) {
+                dataValid = false;
+                break;
+            }
+        }
+        FramesMap::iterator found = frames.find(id);
+        if ( found != frames.end() ) {
+            liveDataSize -= found->second.getDataSize();
+            frames.erase(found);
+        }
+        if (dataValid) {
+            liveDataSize += frame.getDataSize();
+            frames.insert( std::make_pair(id, frame) );
+        }
+    }
+
+    ///Drop a record that was only partially written so the next ones are appended after a valid record
+    if ( validSize < raw.size() ) {
+        QFile::resize(getIndexFilePath(), validSize);
+    }
+}
+
+void
+DiskCacheNodeStoragePrivate::removeFiles_locked()
+{
+    removeDecodedFrames_locked(FrameId(), true);
+    frames.clear();
+    dataFileSize = 0;
+    liveDataSize = 0;
+    if ( directory.isEmpty() ) {
+        return;
+    }
+    QFile::remove( getDataFilePath() );
+    QFile::remove( getIndexFilePath() );
+}
+
+bool
+DiskCacheNodeStoragePrivate::readChunks_locked(const StoredFrame& frame,
+                                               std::vector<QByteArray>* chunks) const
+{
+    QFile dataFile( getDataFilePath() );
+
+    if ( !dataFile.open(QIODevice::ReadOnly) ) {
+        return false;
+    }
+    chunks->resize( frame.chunks.size() );
+    for (U32 i = 0; i < frame.chunks.size(); ++i) {
+        if ( !dataFile.seek(frame.chunks[i].offset) ) {
+            return false;
+        }
+        (*chunks)[i] = dataFile.read(frame.chunks[i].size);
+        if ( (*chunks)[i].size() != frame.chunks[i].size ) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void
+DiskCacheNodeStoragePrivate::compact_locked()
+{
+    QString tmpDataPath = getDataFilePath() + ".tmp";
+    QString tmpIndexPath = getIndexFilePath() + ".tmp";
+    FramesMap newFrames;
+    qint64 newSize = 0;
+    bool ok = true;
+    {
+        QFile::remove(tmpIndexPath);
+        QFile newData(tmpDataPath);
+        QFile newIndex(tmpIndexPath);
+        if ( !newData.open(QIODevice::WriteOnly | QIODevice::Truncate) || !openIndexForAppend(newIndex) ) {
+            return;
+        }
+        for (FramesMap::iterator it = frames.begin(); ok && it != frames.end(); ++it) {
+            std::vector<QByteArray> chunks;
+            if ( !readChunks_locked(it->second, &chunks) ) {
+                continue;
+            }
+            StoredFrame frame = it->second;
+            for (U32 i = 0; i < chunks.size(); ++i) {
+                frame.chunks[i].offset = newSize;
+                ok = newData.write(chunks[i]) == chunks[i].size();
+                newSize += chunks[i].size();
+            }
+            ok = ok && writeIndexRecord(newIndex, it->first, frame);
+            newFrames.insert( std::make_pair(it->first, frame) );
+        }
+    }
+    if (!ok) {
+        qDebug() << "Failed to compact the DiskCache node storage in" << directory;
+        QFile::remove(tmpDataPath);
+        QFile::remove(tmpIndexPath);
+
+        return;
+    }
+    QFile::remove( getDataFilePath() );
+    QFile::remove( getIndexFilePath() );
+    if ( !QFile::rename( tmpDataPath, getDataFilePath() ) || !QFile::rename( tmpIndexPath, getIndexFilePath() ) ) {
+        removeFiles_locked();
+
+        return;
+    }
+    frames = newFrames;
+    dataFileSize = newSize;
+    liveDataSize = newSize;
+}
+
+DiskCacheNodeStorage::DiskCacheNodeStorage()
+: _imp( new DiskCacheNodeStoragePrivate() )
+{
+}
+
+DiskCacheNodeStorage::~DiskCacheNodeStorage()
+{
+}
+
+void
+DiskCacheNodeStorage::setDirectory(const QString& directory)
+{
+    QWriteLocker k(&_imp->lock);
+
+    if (_imp->directory == directory) {
+        return;
+    }
+    _imp->directory = directory;
+    _imp->loadIndex_locked();
+}
+
+void
+DiskCacheNodeStorage::moveToDirectory(const QString& directory)
+{
+    QWriteLocker k(&_imp->lock);
+
+    if (_imp->directory == directory) {
+        return;
+    }
+    QString oldDirectory = _imp->directory;
+    _imp->directory = directory;
+    if ( oldDirectory.isEmpty() || !QDir(oldDirectory).exists() ) {
+        _imp->loadIndex_locked();
+
+        return;
+    }
+
+    ///Whatever was stored under the new name is stale
+    _imp->removeFiles_locked();
+    QDir().rmdir(directory);
+    QDir().mkpath( QFileInfo(directory).absolutePath() );
+    if ( !QDir().rename(oldDirectory, directory) ) {
+        qDebug() << "Failed to move the DiskCache node storage from" << oldDirectory << "to" << directory;
+        _imp->directory = oldDirectory;
+        _imp->removeFiles_locked();
+        QDir().rmdir(oldDirectory);
+        _imp->directory = directory;
+    }
+    _imp->loadIndex_locked();
+}
+
+void
+DiskCacheNodeStorage::copyToDirectory(const QString& directory)
+{
+    QWriteLocker k(&_imp->lock);
+
+    if (_imp->directory == directory) {
+        return;
+    }
+    QString oldDirectory = _imp->directory;
+    QString oldDataPath = _imp->getDataFilePath();
+    QString oldIndexPath = _imp->getIndexFilePath();
+    _imp->directory = directory;
+    if ( oldDirectory.isEmpty() ) {
+        _imp->loadIndex_locked();
+
+        return;
+    }
+
+    ///Whatever was stored under the new name is stale
+    _imp->removeFiles_locked();
+    if ( QFile::exists(oldIndexPath) ) {
+        QDir().mkpath(directory);
+        if ( !QFile::copy( oldDataPath, _imp->getDataFilePath() ) || !QFile::copy( oldIndexPath, _imp->getIndexFilePath() ) ) {
+            qDebug() << "Failed to copy the DiskCache node storage from" << oldDirectory << "to" << directory;
+            _imp->removeFiles_locked();
+        }
+    }
+    _imp->loadIndex_locked();
+}
+
+void
+DiskCacheNodeStorage::setDecodedFramesMaxSize(std::size_t size)
+{
+    QMutexLocker k(&_imp->decodedFramesMutex);
+
+    _imp->decodedFramesMaxSize = size;
+    _imp->trimDecodedFrames_locked();
+}
+
+QString
+DiskCacheNodeStorage::getDirectory() const
+{
+    QReadLocker k(&_imp->lock);
+
+    return _imp->directory;
+}
+
+bool
+DiskCacheNodeStorage::store(U64 hash,
+                            SequenceTime time,
+                            int view,
+                            const boost::shared_ptr<Natron::Image>& image,
+                            bool ignoreHash)
+{
+    FrameId id;
+    id.time = time;
+    id.view = view;
+    id.mipMapLevel = image->getMipMapLevel();
+
+    StoredFrame frame;
+    frame.hash = hash;
+    frame.rod = image->getRoD();
+    frame.bounds = image->getBounds();
+    frame.par = image->getPixelAspectRatio();
+    frame.isProjectFormat = image->getParams()->isRodProjectFormat();
+    frame.components = (qint32)image->getComponents();
+    frame.bitdepth = (qint32)image->getBitDepth();
+
+    ///Compress outside of the lock, this is the expensive part
+    int elementSize = getSizeOfForBitDepth( image->getBitDepth() );
+    std::size_t rowElements = image->getRowElements();
+    std::vector<QByteArray> chunks;
+    std::vector<unsigned char> shuffled;
+    for (int y = frame.bounds.y1; y < frame.bounds.y2; y += NATRON_DISKCACHENODE_CHUNK_ROWS) {
+        int rows = std::min(NATRON_DISKCACHENODE_CHUNK_ROWS, frame.bounds.y2 - y);
+        std::size_t elementsCount = rowElements * rows;
+        shuffled.resize(elementsCount * elementSize);
+        shuffleBytes(image->pixelAt(frame.bounds.x1, y), elementsCount, elementSize, &shuffled.front());
+        chunks.push_back( qCompress(&shuffled.front(), (int)shuffled.size(), NATRON_DISKCACHENODE_COMPRESSION_LEVEL) );
+    }
+
+    QWriteLocker k(&_imp->lock);
+    if ( _imp->directory.isEmpty() ) {
+        return false;
+    }
+
+    if (!ignoreHash) {
+        for (FramesMap::iterator it = _imp->frames.begin(); it != _imp->frames.end(); ++it) {
+            if (it->second.hash != frame.hash) {
+                _imp->removeFiles_locked();
+                break;
+            }
+        }
+    }
+    _imp->removeDecodedFrames_locked(id, false);
+
+    QDir().mkpath(_imp->directory);
+    {
+        QFile dataFile( _imp->getDataFilePath() );
+        if ( !dataFile.open(QIODevice::WriteOnly | QIODevice::Append) ) {
+            qDebug() << "Failed to open" << _imp->getDataFilePath() << "for writing";
+
+            return false;
+        }
+        qint64 offset = dataFile.size();
+        for (U32 i = 0; i < chunks.size(); ++i) {
+            if ( dataFile.write(chunks[i]) != chunks[i].size() ) {
+                return false;
+            }
+            StoredChunk c;
+            c.offset = offset;
+            c.size = chunks[i].size();
+            frame.chunks.push_back(c);
+            offset += c.size;
+        }
+        _imp->dataFileSize = offset;
+    }
+    {
+        ///The index is written after the data so it never references chunks that are not on disk
+        QFile indexFile( _imp->getIndexFilePath() );
+        if ( !openIndexForAppend(indexFile) || !writeIndexRecord(indexFile, id, frame) ) {
+            return false;
+        }
+    }
+
+    FramesMap::iterator found = _imp->frames.find(id);
+    if ( found != _imp->frames.end() ) {
+        _imp->liveDataSize -= found->second.getDataSize();
+        found->second = frame;
+    } else {
+        _imp->frames.insert( std::make_pair(id, frame) );
+    }
+    _imp->liveDataSize += frame.getDataSize();
+
+    qint64 deadSize = _imp->dataFileSize - _imp->liveDataSize;
+    if ( (deadSize > _imp->liveDataSize) && (deadSize > NATRON_DISKCACHENODE_MIN_COMPACT_SIZE) ) {
+        _imp->compact_locked();
+    }
+
+    return true;
+}
+
+void
+DiskCacheNodeStorage::get(const Natron::ImageKey& key,
+                          unsigned int mipMapLevel,
+                          bool ignoreHash,
+                          std::list<boost::shared_ptr<Natron::Image> >* images) const
+{
+    FrameId id;
+    StoredFrame frame;
+    std::vector<QByteArray> chunks;
+    U64 framesVersion;
+    {
+        QReadLocker k(&_imp->lock);
+        if ( _imp->directory.isEmpty() ) {
+            return;
+        }
+
+        ///Only the level closest to the requested one is needed, the others would be downscaled further
+        id.time = key.getTime();
+        id.view = key._view;
+        FramesMap::const_iterator found = _imp->frames.end();
+        for (unsigned int level = mipMapLevel + 1; level > 0; --level) {
+            id.mipMapLevel = level - 1;
+            FramesMap::const_iterator it = _imp->frames.find(id);
+            if ( ( it != _imp->frames.end() ) && ( ignoreHash || (it->second.hash == key.getTreeVersion()) ) ) {
+                found = it;
+                break;
+            }
+        }
+        if ( found == _imp->frames.end() ) {
+            return;
+        }
+
+        {
+            QMutexLocker d(&_imp->decodedFramesMutex);
+            for (DecodedFramesList::iterator it = _imp->decodedFrames.begin(); it != _imp->decodedFrames.end(); ++it) {
+                if ( (it->id.mipMapLevel == id.mipMapLevel) && (it->key == key) ) {
+                    images->push_back(it->image);
+                    _imp->decodedFrames.splice(_imp->decodedFrames.begin(), _imp->decodedFrames, it);
+
+                    return;
+                }
+            }
+        }
+
+        if ( !_imp->readChunks_locked(found->second, &chunks) ) {
+            return;
+        }
+        frame = found->second;
+        framesVersion = _imp->framesVersion;
+    }
+
+    ///Decompress outside of the lock
+    ImageComponentsEnum components = (ImageComponentsEnum)frame.components;
+    ImageBitDepthEnum bitdepth = (ImageBitDepthEnum)frame.bitdepth;
+    boost::shared_ptr<ImageParams> params = Image::makeParams(0, frame.rod, frame.bounds, frame.par, id.mipMapLevel,
+                                                              frame.isProjectFormat, components, bitdepth,
+                                                              std::map<int, std::vector<RangeD> >() );
+    boost::shared_ptr<Image> image( new Image(key, params) );
+
+    int elementSize = getSizeOfForBitDepth(bitdepth);
+    std::size_t rowElements = image->getRowElements();
+    bool ok = true;
+    int y = frame.bounds.y1;
+    for (U32 i = 0; i < chunks.size() && ok; ++i, y += NATRON_DISKCACHENODE_CHUNK_ROWS) {
+        int rows = std::min(NATRON_DISKCACHENODE_CHUNK_ROWS, frame.bounds.y2 - y);
+        std::size_t elementsCount = rowElements * rows;
+        QByteArray shuffled = qUncompress(chunks[i]);
+        ok = (rows > 0) && ( (std::size_t)shuffled.size() == elementsCount * elementSize );
+        if (ok) {
+            unshuffleBytes( (const unsigned char*)shuffled.constData(), elementsCount, elementSize, image->pixelAt(frame.bounds.x1, y) );
+        }
+    }
+    if ( !ok || (y < frame.bounds.y2) ) {
+        qDebug() << "Corrupted frame" << id.time << "in the DiskCache node storage" << getDirectory();
+
+        return;
+    }
+    images->push_back(image);
+
+    QReadLocker k(&_imp->lock);
+    ///Do not keep it if the frame was replaced while decoding
+    if (_imp->framesVersion == framesVersion) {
+        DecodedFrame decoded;
+        decoded.id = id;
+        decoded.key = key;
+        decoded.image = image;
+        decoded.size = rowElements * frame.bounds.height() * elementSize;
+        _imp->insertDecodedFrame(decoded);
+    }
+}
+
+bool
+DiskCacheNodeStorage::hasFrame(U64 hash,
+                               SequenceTime time,
+                               int view,
+                               unsigned int mipMapLevel,
+                               bool ignoreHash) const
+{
+    FrameId id;
+
+    id.time = time;
+    id.view = view;
+
+    QReadLocker k(&_imp->lock);
+    for (id.mipMapLevel = 0; id.mipMapLevel <= mipMapLevel; ++id.mipMapLevel) {
+        FramesMap::const_iterator it = _imp->frames.find(id);
+        if ( ( it != _imp->frames.end() ) && (ignoreHash || it->second.hash == hash) ) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void
+DiskCacheNodeStorage::clear()
+{
+    QWriteLocker k(&_imp->lock);
+
+    _imp->removeFiles_locked();
+}
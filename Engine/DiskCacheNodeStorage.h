@@ -0,0 +1,123 @@
+//  Natron
+//
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef NATRON_ENGINE_DISKCACHENODESTORAGE_H_
+#define NATRON_ENGINE_DISKCACHENODESTORAGE_H_
+
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+
+#include <list>
+
+#include "Global/Macros.h"
+CLANG_DIAG_OFF(deprecated)
+#include <QtCore/QString>
+CLANG_DIAG_ON(deprecated)
+#if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+#endif
+
+#include "Global/GlobalDefines.h"
+
+namespace Natron {
+class Image;
+class ImageKey;
+}
+
+/**
+ * @brief The frames cached by a DiskCache node, stored in a directory of their own.
+ *
+ * All the frames are appended to a single data file, cut in chunks of rows that are compressed
+ * without loss (the bytes of the pixels are shuffled by significance before zlib compression, which
+ * helps a lot with floating point data). An index file lists where the chunks of each frame are.
+ * Both files are append-only, so a crash can at most lose the frame that was being written.
+ *
+ * A frame is identified by its time, view and mipmap level. The hash of the node that rendered it
+ * is stored with it: frames rendered with another hash are either discarded or kept, depending on
+ * whether the user wants the cache to survive changes made upstream.
+ *
+ * This class is thread-safe.
+ **/
+struct DiskCacheNodeStoragePrivate;
+class DiskCacheNodeStorage
+{
+public:
+
+    DiskCacheNodeStorage();
+
+    ~DiskCacheNodeStorage();
+
+    /**
+     * @brief Set the directory where the frames are stored, the index is read from there if it exists.
+     * This does nothing if the directory did not change.
+     **/
+    void setDirectory(const QString& directory);
+
+    QString getDirectory() const;
+
+    /**
+     * @brief Moves the stored frames to another directory, e.g: when a project that was never saved is saved.
+     * Anything stored in that directory before is removed. If the frames cannot be moved, they are removed.
+     **/
+    void moveToDirectory(const QString& directory);
+
+    /**
+     * @brief Copies the stored frames to another directory and uses it from now on, e.g: when the project is saved
+     * under another name or the node is renamed, so that the project saved under the previous name keeps its frames.
+     * Anything stored in that directory before is removed. If the frames cannot be copied, the storage starts empty.
+     **/
+    void copyToDirectory(const QString& directory);
+
+    /**
+     * @brief Sets how much memory the frames kept decoded by get() may use. The last frame read is always kept.
+     **/
+    void setDecodedFramesMaxSize(std::size_t size);
+
+    /**
+     * @brief Writes the given fully rendered, packed image, rendered with the given node hash. A frame already stored
+     * at the same time, view and mipmap level is replaced. If ignoreHash is false and the storage contains frames
+     * rendered with another hash, they are all removed first.
+     * Returns false if the image could not be written.
+     **/
+    bool store(U64 hash,
+               SequenceTime time,
+               int view,
+               const boost::shared_ptr<Natron::Image>& image,
+               bool ignoreHash);
+
+    /**
+     * @brief Reads back the frame stored for the time and view of the key at mipMapLevel, or else at the closest
+     * level that is larger. If ignoreHash is false, only frames rendered with the hash of the key are returned.
+     * The images are allocated in RAM with the given key, they are not put in the cache: instead the frames read
+     * most recently are kept decoded by the storage and returned again for the same key.
+     **/
+    void get(const Natron::ImageKey& key,
+             unsigned int mipMapLevel,
+             bool ignoreHash,
+             std::list<boost::shared_ptr<Natron::Image> >* images) const;
+
+    /**
+     * @brief Returns true if get() would find the frame, without reading it.
+     **/
+    bool hasFrame(U64 hash,
+                  SequenceTime time,
+                  int view,
+                  unsigned int mipMapLevel,
+                  bool ignoreHash) const WARN_UNUSED_RETURN;
+
+    /**
+     * @brief Removes all frames and deletes the files.
+     **/
+    void clear();
+
+private:
+
+    boost::scoped_ptr<DiskCacheNodeStoragePrivate> _imp;
+};
+
+#endif // NATRON_ENGINE_DISKCACHENODESTORAGE_H_
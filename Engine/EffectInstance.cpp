@@ -38,6 +38,7 @@
 #include "Engine/OfxEffectInstance.h"
 #include "Engine/OfxImageEffectInstance.h"
 #include "Engine/KnobTypes.h"
+#include "Engine/KnobValuesSnapshot.h"
 #include "Engine/PluginMemory.h"
 #include "Engine/Project.h"
 #include "Engine/BlockingBackgroundRender.h"
@@ -48,6 +49,8 @@
 #include "Engine/OutputSchedulerThread.h"
 #include "Engine/Transform.h"
 #include "Engine/DiskCacheNode.h"
+#include "Engine/RenderScheduler.h"
+#include "Engine/NumaTopology.h"
 
 using namespace Natron;
 
@@ -313,6 +316,10 @@ struct EffectInstance::Implementation
     , pluginMemoryChunks()
     , supportsRenderScale(eSupportsMaybe)
     , actionsCache()
+    , knobsSnapshotsMutex()
+    , knobsSnapshots()
+    , knobsSnapshotsTypedKnobs()
+    , knobsSnapshotsKnobsVersion(0)
 #if NATRON_ENABLE_TRIMAP
     , imagesBeingRenderedMutex()
     , imagesBeingRendered()
@@ -358,6 +365,14 @@ struct EffectInstance::Implementation
     /// Mt-Safe actions cache
     ActionsCache actionsCache;
     
+    ///The knobs snapshots of the frames being rendered, so that all threads working on the same frame share them
+    QMutex knobsSnapshotsMutex;
+    std::list<boost::weak_ptr<const KnobValuesSnapshot> > knobsSnapshots;
+    
+    ///The knobs captured in the snapshots, found again only when the knobs of the effect change. Protected by knobsSnapshotsMutex
+    KnobValuesSnapshot::TypedKnobs knobsSnapshotsTypedKnobs;
+    U64 knobsSnapshotsKnobsVersion;
+    
 #if NATRON_ENABLE_TRIMAP
     ///Store all images being rendered to avoid 2 threads rendering the same portion of an image
     struct ImageBeingRendered
@@ -377,6 +392,31 @@ struct EffectInstance::Implementation
     
     void runChangedParamCallback(KnobI* k,bool userEdited,const std::string& callback);
     
+    boost::shared_ptr<const KnobValuesSnapshot> getKnobValuesSnapshot(int time,U64 nodeHash)
+    {
+        QMutexLocker k(&knobsSnapshotsMutex);
+        for (std::list<boost::weak_ptr<const KnobValuesSnapshot> >::iterator it = knobsSnapshots.begin(); it != knobsSnapshots.end();) {
+            boost::shared_ptr<const KnobValuesSnapshot> snapshot = it->lock();
+            if (!snapshot) {
+                ///No thread is rendering that frame anymore
+                it = knobsSnapshots.erase(it);
+                continue;
+            }
+            if (snapshot->getTime() == time && snapshot->getNodeHash() == nodeHash) {
+                return snapshot;
+            }
+            ++it;
+        }
+        U64 knobsVersion = _publicInterface->getKnobsVersion();
+        if (knobsVersion != knobsSnapshotsKnobsVersion) {
+            KnobValuesSnapshot::getTypedKnobs(_publicInterface, &knobsSnapshotsTypedKnobs);
+            knobsSnapshotsKnobsVersion = knobsVersion;
+        }
+        boost::shared_ptr<const KnobValuesSnapshot> ret( new KnobValuesSnapshot(knobsSnapshotsTypedKnobs, time, nodeHash) );
+        knobsSnapshots.push_back(ret);
+        return ret;
+    }
+    
     
     void setDuringInteractAction(bool b)
     {
@@ -415,7 +455,7 @@ struct EffectInstance::Implementation
             ibr = found->second;
         }
         
-        std::list<RectI> restToRender;
+        RenderRectsList restToRender;
         bool isBeingRenderedElseWhere = false;
         img->getRestToRender_trimap(roi,restToRender, &isBeingRenderedElseWhere);
         
@@ -570,9 +610,12 @@ struct EffectInstance::Implementation
         {
             assert( _dst->hasLocalData() );
             args._outputImage.reset();
+            args._regionOfInterestResults.clear();
             args._validArgs = false;
             RenderArgs& tls = _dst->localData();
             tls._outputImage.reset();
+            ///Release the RoIs now so the arena of the frame can be reused
+            tls._regionOfInterestResults.clear();
             tls._validArgs = false;
         }
 
@@ -737,6 +780,9 @@ EffectInstance::setParallelRenderArgs(int time,
                                       const TimeLine* timeline)
 {
     ParallelRenderArgs& args = _imp->frameRenderArgs.localData();
+    
+    ///Reset it first so that the knobs read while building the new snapshot do not use the previous one
+    args.knobsSnapshot.reset();
     args.canSetValue = canSetValue;
     args.time = time;
     args.timeline = timeline;
@@ -751,6 +797,10 @@ EffectInstance::setParallelRenderArgs(int time,
     
     ++args.validArgs;
     
+    ///If the plug-in can call setValue during the render, the values may change while rendering
+    if ( !canSetValue && (QThread::currentThread() != qApp->thread()) ) {
+        args.knobsSnapshot = _imp->getKnobValuesSnapshot(time, nodeHash);
+    }
 }
 
 bool
@@ -759,6 +809,9 @@ EffectInstance::invalidateParallelRenderArgs()
     if (_imp->frameRenderArgs.hasLocalData()) {
         ParallelRenderArgs& args = _imp->frameRenderArgs.localData();
         --args.validArgs;
+        if (!args.validArgs) {
+            args.knobsSnapshot.reset();
+        }
         return args.canSetValue;
     } else {
         qDebug() << "Frame render args thread storage not set, this is probably because the graph changed while rendering.";
@@ -825,7 +878,9 @@ EffectInstance::aborted() const
                     !getNode()->isActivated();
                     return ret;
                 } else {
-                    bool ret = !getNode()->isActivated();
+                    ///Previews are not abortable by the user but they yield to viewer renders
+                    ///and they are dropped when a newer request for the same node is made, @see RenderScheduler
+                    bool ret = !getNode()->isActivated() || appPTR->getRenderScheduler()->isCurrentThreadPreempted();
                     return ret;
                 }
                 
@@ -1205,6 +1260,8 @@ EffectInstance::getImage(int inputNb,
     ///Check that the rendered image contains what we requested.
     assert(inputImg->getComponents() == comp);
     
+    Natron::NUMA::notifyImageAccess(inputImg->getNUMANode());
+    
     if (roiPixel) {
         *roiPixel = pixelRoI;
     }
@@ -1521,6 +1578,14 @@ EffectInstance::getImageFromCacheAndConvertIfNeeded(bool useCache,
         isCached = !useDiskCache ? Natron::getImageFromCache(key,&cachedImages) : Natron::getImageFromDiskCache(key, &cachedImages);
     }
     
+    if (!isCached && useDiskCache) {
+        ///The DiskCache node keeps its images in a storage of its own
+        DiskCacheNode* diskCacheNode = dynamic_cast<DiskCacheNode*>(this);
+        assert(diskCacheNode);
+        diskCacheNode->getImagesFromStorage(key, mipMapLevel, &cachedImages);
+        isCached = !cachedImages.empty();
+    }
+    
     if (isCached) {
         
         ///A ptr to a higher resolution of the image or an image with different comps/bitdepth
@@ -2017,7 +2082,13 @@ EffectInstance::renderRoI(const RenderRoIArgs & args)
     bool createInCache = shouldCacheOutput();
 
     bool isFrameVaryingOrAnimated = isFrameVaryingOrAnimated_Recursive();
-    Natron::ImageKey key = Natron::Image::makeKey(nodeHash, isFrameVaryingOrAnimated, args.time, args.view);
+    
+    ///Images that are the same for all views are cached under the first view so that they are rendered only once
+    int keyView = args.view;
+    if ( (keyView != 0) && isViewInvariant_Recursive() ) {
+        keyView = 0;
+    }
+    Natron::ImageKey key = Natron::Image::makeKey(nodeHash, isFrameVaryingOrAnimated, args.time, keyView);
 
     bool useDiskCacheNode = dynamic_cast<DiskCacheNode*>(this) != NULL;
 
@@ -2169,7 +2240,7 @@ EffectInstance::renderRoI(const RenderRoIArgs & args)
     
     /// If the list is empty then we already rendered it all
     /// Each rect in this list is in pixel coordinate (downscaled)
-    std::list<RectI> rectsToRender;
+    RenderRectsList rectsToRender;
     
     ///In the event where we had the image from the cache, but it wasn't completly rendered over the RoI but the cache was almost full,
     ///we don't hold a pointer to it, allowing the cache to free it.
@@ -2437,7 +2508,7 @@ EffectInstance::renderRoI(const RenderRoIArgs & args)
 # ifdef DEBUG
 
             qDebug() << getNode()->getScriptName_mt_safe().c_str() << ": render view " << args.view << " " << rectsToRender.size() << " rectangles";
-            for (std::list<RectI>::const_iterator it = rectsToRender.begin(); it != rectsToRender.end(); ++it) {
+            for (RenderRectsList::const_iterator it = rectsToRender.begin(); it != rectsToRender.end(); ++it) {
                 qDebug() << "rect: " << "x1= " <<  it->x1 << " , x2= " << it->x2 << " , y1= " << it->y1 << " , y2= " << it->y2;
             }
 # endif
@@ -2513,14 +2584,22 @@ EffectInstance::renderRoI(const RenderRoIArgs & args)
     assert( isSupportedBitDepth(outputDepth) && isSupportedComponent(-1, outputComponents) );
     
     if (imageConversionNeeded && renderRetCode != eRenderRoIStatusRenderFailed) {
-        boost::shared_ptr<Image> tmp( new Image(args.components, rod, downscaledImage->getBounds(), mipMapLevel,downscaledImage->getPixelAspectRatio(), args.bitdepth, false) );
-        
         bool unPremultIfNeeded = getOutputPremultiplication() == eImagePremultiplicationPremultiplied;
-        downscaledImage->convertToFormat(downscaledImage->getBounds(),
-                               getApp()->getDefaultColorSpaceForBitDepth(downscaledImage->getBitDepth()),
-                               getApp()->getDefaultColorSpaceForBitDepth(args.bitdepth),
-                               args.channelForAlpha, false, false, unPremultIfNeeded, tmp.get());
-        downscaledImage = tmp;
+        if (!renderAborted) {
+            ///The conversion is kept with the image, so the next fetch of the same format converts only what is new
+            downscaledImage = downscaledImage->getConvertedCopy(args.roi, args.components, args.bitdepth,
+                                                                getApp()->getDefaultColorSpaceForBitDepth(downscaledImage->getBitDepth()),
+                                                                getApp()->getDefaultColorSpaceForBitDepth(args.bitdepth),
+                                                                args.channelForAlpha, unPremultIfNeeded);
+        } else {
+            boost::shared_ptr<Image> tmp( new Image(args.components, rod, downscaledImage->getBounds(), mipMapLevel,downscaledImage->getPixelAspectRatio(), args.bitdepth, false) );
+            
+            downscaledImage->convertToFormat(downscaledImage->getBounds(),
+                                   getApp()->getDefaultColorSpaceForBitDepth(downscaledImage->getBitDepth()),
+                                   getApp()->getDefaultColorSpaceForBitDepth(args.bitdepth),
+                                   args.channelForAlpha, false, false, unPremultIfNeeded, tmp.get());
+            downscaledImage = tmp;
+        }
     }
 
     if ( renderAborted && renderRetCode != eRenderRoIStatusImageAlreadyRendered) {
@@ -2722,7 +2801,7 @@ EffectInstance::RenderRoIStatusEnum
 EffectInstance::renderRoIInternal(SequenceTime time,
                                   unsigned int mipMapLevel,
                                   int view,
-                                  const std::list<RectI>& rectsToRender,
+                                  const RenderRectsList& rectsToRender,
                                   const RectD & rod, //!< effect rod in canonical coords
                                   const double par,
                                   const boost::shared_ptr<Image> & image,
@@ -2786,7 +2865,7 @@ EffectInstance::renderRoIInternal(SequenceTime time,
         renderingNotifier.reset(new NotifyRenderingStarted_RAII(getNode().get()));
     }
     
-    for (std::list<RectI>::const_iterator it = rectsToRender.begin(); it != rectsToRender.end(); ++it) {
+    for (RenderRectsList::const_iterator it = rectsToRender.begin(); it != rectsToRender.end(); ++it) {
         
         RectI downscaledRectToRender = *it; // please leave it as const, copy it if necessary
 
@@ -2975,6 +3054,7 @@ EffectInstance::renderRoIInternal(SequenceTime time,
             tiledArgs.renderMappedImage = renderMappedImage;
             tiledArgs.par = par;
             tiledArgs.renderFullScaleThenDownscale = renderFullScaleThenDownscale;
+            tiledArgs.numaNode = Natron::NUMA::getCurrentThreadNode();
             
             // the bitmap is checked again at the beginning of EffectInstance::tiledRenderingFunctor()
             QFuture<EffectInstance::RenderingFunctorRetEnum> ret = QtConcurrent::mapped( splitRects,
@@ -3074,7 +3154,7 @@ EffectInstance::renderRoIInternal(SequenceTime time,
         if (renderStatus != eStatusOK) {
             break;
         }
-    } // for (std::list<RectI>::const_iterator it = rectsToRender.begin(); it != rectsToRender.end(); ++it) {
+    } // for (RenderRectsList::const_iterator it = rectsToRender.begin(); it != rectsToRender.end(); ++it) {
     
     
     if (renderStatus != eStatusOK) {
@@ -3090,6 +3170,10 @@ EffectInstance::tiledRenderingFunctor(const TiledRenderingFunctorArgs& args,
                                      bool setThreadLocalStorage,
                                      const RectI & downscaledRectToRender )
 {
+    ///Render tiles on the node of the frame thread, where the images were allocated
+    Natron::NUMA::ThreadBinder numaBinder(args.numaNode, true);
+    RenderArena::FrameScope arenaScope(false);
+    
     return tiledRenderingFunctor(*args.args,
                                  frameArgs,
                                  args.inputImages,
@@ -3841,7 +3925,9 @@ EffectInstance::isIdentity_public(U64 hash,
         
         bool ret = false;
         
-        if (appPTR->isBackground() && dynamic_cast<DiskCacheNode*>(this) != NULL) {
+        DiskCacheNode* isDiskCacheNode = dynamic_cast<DiskCacheNode*>(this);
+        ///In background mode the DiskCache node only reads the frames it already has: caching the others is useless
+        if ( appPTR->isBackground() && isDiskCacheNode && !isDiskCacheNode->isFrameInStorage(hash, time, view, mipMapLevel) ) {
             ret = true;
             *inputNb = 0;
             *inputTime = time;
@@ -4419,6 +4505,18 @@ EffectInstance::getCurrentTime() const
     return getThreadLocalRenderTime();
 }
 
+const KnobValuesSnapshot*
+EffectInstance::getRenderKnobValuesSnapshot() const
+{
+    if (_imp->frameRenderArgs.hasLocalData()) {
+        const ParallelRenderArgs& args = _imp->frameRenderArgs.localData();
+        if (args.validArgs) {
+            return args.knobsSnapshot.get();
+        }
+    }
+    return NULL;
+}
+
 int
 EffectInstance::getCurrentView() const
 {
@@ -4494,6 +4592,28 @@ EffectInstance::isFrameVaryingOrAnimated_Recursive() const
     return ret;
 }
 
+static
+bool isViewInvariant_impl(const Natron::EffectInstance* node)
+{
+    if ( !node->isViewInvariant() ) {
+        return false;
+    }
+    int maxInputs = node->getMaxInputCount();
+    for (int i = 0; i < maxInputs; ++i) {
+        Natron::EffectInstance* input = node->getInput(i);
+        if ( input && !isViewInvariant_impl(input) ) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool
+EffectInstance::isViewInvariant_Recursive() const
+{
+    return isViewInvariant_impl(this);
+}
+
 
 OutputEffectInstance::OutputEffectInstance(boost::shared_ptr<Node> node)
     : Natron::EffectInstance(node)
@@ -4502,6 +4622,7 @@ OutputEffectInstance::OutputEffectInstance(boost::shared_ptr<Node> node)
       , _writerLastFrame(0)
       , _outputEffectDataLock(new QMutex)
       , _renderController(0)
+      , _renderGroup()
       , _engine(0)
 {
 }
@@ -4587,6 +4708,22 @@ OutputEffectInstance::notifyRenderFinished()
     }
 }
 
+void
+OutputEffectInstance::setRenderGroup(const boost::shared_ptr<OutputRenderGroup>& group)
+{
+    QMutexLocker l(_outputEffectDataLock);
+
+    _renderGroup = group;
+}
+
+boost::shared_ptr<OutputRenderGroup>
+OutputEffectInstance::getRenderGroup() const
+{
+    QMutexLocker l(_outputEffectDataLock);
+
+    return _renderGroup;
+}
+
 int
 OutputEffectInstance::getCurrentFrame() const
 {
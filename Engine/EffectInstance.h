@@ -28,6 +28,7 @@
 #include "Engine/Knob.h" // for KnobHolder
 #include "Engine/Rect.h"
 #include "Engine/ImageLocker.h"
+#include "Engine/RenderArena.h"
 
 // Various useful plugin IDs, @see EffectInstance::getPluginID()
 #define PLUGINID_OFX_MERGE        "net.sf.openfx.MergePlugin"
@@ -54,11 +55,13 @@
 class Hash64;
 class Format;
 class TimeLine;
+class KnobValuesSnapshot;
 class OverlaySupport;
 class PluginMemory;
 class BlockingBackgroundRender;
 class NodeSerialization;
 class RenderEngine;
+class OutputRenderGroup;
 class BufferableObject;
 namespace Transform {
 struct Matrix3x3;
@@ -108,6 +111,10 @@ struct ParallelRenderArgs
     ///Can the plug-in call setValue while the action is active
     bool canSetValue;
     
+    ///The values of the knobs of the effect at time, shared by all threads rendering this frame.
+    ///NULL if the plug-in can call setValue or on the main-thread.
+    boost::shared_ptr<const KnobValuesSnapshot> knobsSnapshot;
+    
     ParallelRenderArgs()
     : time(0)
     , timeline(0)
@@ -119,6 +126,7 @@ struct ParallelRenderArgs
     , isSequentialRender(false)
     , canAbort(false)
     , canSetValue(false)
+    , knobsSnapshot()
     {
         
     }
@@ -142,7 +150,8 @@ class EffectInstance
 {
 public:
 
-    typedef std::map<EffectInstance*,RectD> RoIMap; // RoIs are in canonical coordinates
+    ///RoIs are in canonical coordinates. The map only lives for the render of a frame, it is allocated in the arena of the frame.
+    typedef std::map<EffectInstance*,RectD,std::less<EffectInstance*>,Natron::RenderArenaAllocator<std::pair<EffectInstance* const,RectD> > > RoIMap;
     typedef std::map<int, std::vector<RangeD> > FramesNeededMap;
 
     struct RenderRoIArgs
@@ -604,6 +613,8 @@ public:
     virtual SequenceTime getCurrentTime() const OVERRIDE WARN_UNUSED_RETURN;
 
     virtual int getCurrentView() const OVERRIDE WARN_UNUSED_RETURN;
+    
+    virtual const KnobValuesSnapshot* getRenderKnobValuesSnapshot() const OVERRIDE FINAL WARN_UNUSED_RETURN;
 
     virtual bool getCanTransform() const { return false; }
 
@@ -635,6 +646,18 @@ public:
      * It is frame varying/animated if at least one of the node is animated/varying
      **/
     bool isFrameVaryingOrAnimated_Recursive() const;
+    
+    /**
+     * @brief Returns whether the effect produces the same image for all views when its inputs do.
+     * Natron's own effects never look at the view.
+     **/
+    virtual bool isViewInvariant() const { return true; }
+    
+    /**
+     * @brief Returns whether the current node and the tree upstream produce the same image for all views.
+     * In that case the image is rendered and cached once and shared by all views, e.g: a mono plate feeding both eyes.
+     **/
+    bool isViewInvariant_Recursive() const;
 
     
 protected:
@@ -1293,7 +1316,7 @@ private:
     RenderRoIStatusEnum renderRoIInternal(SequenceTime time,
                                           unsigned int mipMapLevel,
                                           int view,
-                                          const std::list<RectI>& rectsToRender,
+                                          const Natron::RenderRectsList& rectsToRender,
                                           const RectD & rod, //!< rod in canonical coordinates
                                           const double par,
                                           const boost::shared_ptr<Image> & image,
@@ -1395,6 +1418,7 @@ private:
         boost::shared_ptr<Natron::Image>  downscaledImage;
         boost::shared_ptr<Natron::Image>  fullScaleImage;
         boost::shared_ptr<Natron::Image>  renderMappedImage;
+        int numaNode; //< the NUMA node of the thread that launched the tiles, -1 if unknown
     };
 
     enum RenderingFunctorRetEnum
@@ -1469,6 +1493,7 @@ class OutputEffectInstance
     SequenceTime _writerLastFrame;
     mutable QMutex* _outputEffectDataLock;
     BlockingBackgroundRender* _renderController; //< pointer to a blocking renderer
+    boost::shared_ptr<OutputRenderGroup> _renderGroup; //< the writers rendered together with this one, protected by _outputEffectDataLock
     
     RenderEngine* _engine;
 public:
@@ -1495,6 +1520,14 @@ public:
 
     void notifyRenderFinished();
 
+    /**
+     * @brief Set the group of writers this one is rendered with, or NULL to render on its own. @see OutputRenderGroup
+     * It must be set before the render starts and reset once it is finished.
+     **/
+    void setRenderGroup(const boost::shared_ptr<OutputRenderGroup>& group);
+
+    boost::shared_ptr<OutputRenderGroup> getRenderGroup() const;
+
     void renderCurrentFrame(bool canAbort);
 
     bool ifInfiniteclipRectToProjectDefault(RectD* rod) const;
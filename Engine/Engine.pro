@@ -61,9 +61,11 @@ SOURCES += \
     AppManager.cpp \
     BackDrop.cpp \
     BlockingBackgroundRender.cpp \
+    CacheIO.cpp \
     Curve.cpp \
     CurveSerialization.cpp \
     DiskCacheNode.cpp \
+    DiskCacheNodeStorage.cpp \
     EffectInstance.cpp \
     FileDownloader.cpp \
     FileSystemModel.cpp \
@@ -73,6 +75,7 @@ SOURCES += \
     Hash64.cpp \
     HistogramCPU.cpp \
     Image.cpp \
+    ImageBufferWrapper.cpp \
     ImageKey.cpp \
     ImageParamsSerialization.cpp \
     Interpolation.cpp \
@@ -81,6 +84,7 @@ SOURCES += \
     KnobFactory.cpp \
     KnobFile.cpp \
     KnobTypes.cpp \
+    KnobValuesSnapshot.cpp \
     LibraryBinary.cpp \
     Log.cpp \
     Lut.cpp \
@@ -94,6 +98,7 @@ SOURCES += \
     NodeSerialization.cpp \
     NodeGroupSerialization.cpp \
     NoOp.cpp \
+    NumaTopology.cpp \
     OfxClipInstance.cpp \
     OfxHost.cpp \
     OfxImageEffectInstance.cpp \
@@ -101,6 +106,7 @@ SOURCES += \
     OfxMemory.cpp \
     OfxOverlayInteract.cpp \
     OfxParamInstance.cpp \
+    OfxPluginRegistry.cpp \
     OutputSchedulerThread.cpp \
     ParameterWrapper.cpp \
     Plugin.cpp \
@@ -109,16 +115,22 @@ SOURCES += \
     Project.cpp \
     ProjectPrivate.cpp \
     ProjectSerialization.cpp \
+    PySequenceConversion.cpp \
     PySideCompat.cpp \
+    RenderArena.cpp \
+    RenderScheduler.cpp \
+    RenderWorker.cpp \
     RotoContext.cpp \
     RotoSerialization.cpp  \
     RotoWrapper.cpp \
     ScriptObject.cpp \
     Settings.cpp \
+    SharedCacheIndex.cpp \
     StandardPaths.cpp \
     StringAnimationManager.cpp \
     TimeLine.cpp \
     Timer.cpp \
+    TrackScheduler.cpp \
     Transform.cpp \
     ViewerInstance.cpp \
     ../libs/SequenceParsing/SequenceParsing.cpp \
@@ -167,12 +179,14 @@ HEADERS += \
     BackDrop.h \
     BlockingBackgroundRender.h \
     Cache.h \
+    CacheIO.h \
     CacheEntry.h \
     Curve.h \
     CurveSerialization.h \
     CurvePrivate.h \
     DockablePanelI.h \
     DiskCacheNode.h \
+    DiskCacheNodeStorage.h \
     EffectInstance.h \
     FileDownloader.h \
     FileSystemModel.h \
@@ -187,6 +201,7 @@ HEADERS += \
     HistogramCPU.h \
     ImageInfo.h \
     Image.h \
+    ImageBufferWrapper.h \
     ImageKey.h \
     ImageLocker.h \
     ImageSerialization.h \
@@ -201,6 +216,7 @@ HEADERS += \
     KnobFactory.h \
     KnobFile.h \
     KnobTypes.h \
+    KnobValuesSnapshot.h \
     LibraryBinary.h \
     Log.h \
     LRUHashTable.h \
@@ -217,6 +233,7 @@ HEADERS += \
     NonKeyParamsSerialization.h \
     NodeSerialization.h \
     NoOp.h \
+    NumaTopology.h \
     OfxClipInstance.h \
     OfxHost.h \
     OfxImageEffectInstance.h \
@@ -224,6 +241,7 @@ HEADERS += \
     OfxOverlayInteract.h \
     OfxMemory.h \
     OfxParamInstance.h \
+    OfxPluginRegistry.h \
     OpenGLViewerI.h \
     OutputSchedulerThread.h \
     OverlaySupport.h \
@@ -234,14 +252,19 @@ HEADERS += \
     Project.h \
     ProjectPrivate.h \
     ProjectSerialization.h \
+    PySequenceConversion.h \
     Pyside_Engine_Python.h \
     Rect.h \
+    RenderArena.h \
+    RenderScheduler.h \
+    RenderWorker.h \
     RotoContext.h \
     RotoContextPrivate.h \
     RotoSerialization.h \
     RotoWrapper.h \
     ScriptObject.h \
     Settings.h \
+    SharedCacheIndex.h \
     Singleton.h \
     StandardPaths.h \
     StringAnimationManager.h \
@@ -250,6 +273,7 @@ HEADERS += \
     ThreadStorage.h \
     TimeLine.h \
     Timer.h \
+    TrackScheduler.h \
     Transform.h \
     Variant.h \
     ViewerInstance.h \
@@ -14,6 +14,8 @@
 #include <QWaitCondition>
 
 #include "Engine/Image.h"
+#include "Engine/AppManager.h"
+#include "Engine/RenderScheduler.h"
 
 
 struct HistogramRequest
@@ -131,7 +133,8 @@ HistogramCPU::computeHistogram(int mode,      //< corresponds to the enum Histog
     _imp->requests.push_back( HistogramRequest(binsCount,mode,image,rect,vmin,vmax,smoothingKernelSize) );
     if (!isRunning() && !_imp->mustQuit) {
         quitLocker.unlock();
-        start(HighestPriority);
+        ///Histograms are analysis of already rendered images, they must not steal CPU from interactive renders
+        start(LowPriority);
     } else {
         quitLocker.unlock();
         _imp->requestCond.wakeOne();
@@ -201,48 +204,54 @@ HistogramCPU::getMostRecentlyProducedHistogram(std::vector<float>* histogram1,
 ///"function has not external linkage"
 struct pix_red
 {
-    static float val(float *pix)
+    static float val(const float* const* planes,
+                     int i)
     {
-        return pix[0];
+        return planes[0][i];
     }
 };
 
 struct pix_green
 {
-    static float val(float *pix)
+    static float val(const float* const* planes,
+                     int i)
     {
-        return pix[1];
+        return planes[1][i];
     }
 };
 
 struct pix_blue
 {
-    static float val(float *pix)
+    static float val(const float* const* planes,
+                     int i)
     {
-        return pix[2];
+        return planes[2][i];
     }
 };
 
 struct pix_alpha
 {
-    static float val(float *pix)
+    static float val(const float* const* planes,
+                     int i)
     {
-        return pix[3];
+        return planes[3][i];
     }
 };
 
 struct pix_lum
 {
-    static float val(float *pix)
+    static float val(const float* const* planes,
+                     int i)
     {
-        return 0.299 * pix[0] + 0.587 * pix[1] + 0.114 * pix[2];
+        return 0.299 * planes[0][i] + 0.587 * planes[1][i] + 0.114 * planes[2][i];
     }
 };
 
 
-template <float pix_func(float*)>
+template <float pix_func(const float* const*, int)>
 void
 computeHisto(const HistogramRequest & request,
+             const Natron::Image & image,
              int upscale,
              std::vector<float> *histo)
 {
@@ -252,12 +261,18 @@ computeHisto(const HistogramRequest & request,
     double binSize = (request.vmax - request.vmin) / histo->size();
 
     ///Images come from the viewer which is in float.
-    assert(request.image->getBitDepth() == Natron::eImageBitDepthFloat);
+    assert(image.getBitDepth() == Natron::eImageBitDepthFloat);
 
+    int nComps = Natron::getElementsCountForComponents( image.getComponents() );
     for (int y = request.rect.bottom(); y < request.rect.top(); ++y) {
-        for (int x = request.rect.left(); x < request.rect.right(); ++x) {
-            float *pix = (float*)request.image->pixelAt(x, y);
-            float v = pix_func(pix);
+        ///Components missing from the image read the last available one
+        const float* pixels = (const float*)image.pixelAt(request.rect.left(), y);
+        const float* planes[4];
+        for (int c = 0; c < 4; ++c) {
+            planes[c] = pixels + std::min(c, nComps - 1);
+        }
+        for (int x = 0; x < request.rect.width(); ++x) {
+            float v = pix_func(planes, x * nComps);
             if ( (request.vmin <= v) && (v < request.vmax) ) {
                 int index = (int)( (v - request.vmin) / binSize );
                 assert( 0 <= index && index < (int)histo->size() );
@@ -405,6 +420,7 @@ iir_1d_filter(SrcIterator src,
 
 static void
 computeHistogramStatic(const HistogramRequest & request,
+                       const Natron::Image & image,
                        boost::shared_ptr<FinishedHistogram> ret,
                        int histogramIndex)
 {
@@ -440,19 +456,19 @@ computeHistogramStatic(const HistogramRequest & request,
     std::vector<float> histo_upscaled;
     switch (mode) {
     case 1:     //< A
-        computeHisto<&pix_alpha::val>(request, upscale, &histo_upscaled);
+        computeHisto<&pix_alpha::val>(request, image, upscale, &histo_upscaled);
         break;
     case 2:     //<Y
-        computeHisto<&pix_lum::val>(request, upscale, &histo_upscaled);
+        computeHisto<&pix_lum::val>(request, image, upscale, &histo_upscaled);
         break;
     case 3:     //< R
-        computeHisto<&pix_red::val>(request, upscale, &histo_upscaled);
+        computeHisto<&pix_red::val>(request, image, upscale, &histo_upscaled);
         break;
     case 4:     //< G
-        computeHisto<&pix_green::val>(request, upscale, &histo_upscaled);
+        computeHisto<&pix_green::val>(request, image, upscale, &histo_upscaled);
         break;
     case 5:     //< B
-        computeHisto<&pix_blue::val>(request, upscale, &histo_upscaled);
+        computeHisto<&pix_blue::val>(request, image, upscale, &histo_upscaled);
         break;
 
     default:
@@ -513,6 +529,29 @@ HistogramCPU::run()
                 return;
             }
         }
+        
+        ///Get out of the way while the viewer or previews are rendering. Meanwhile a newer request
+        ///may have been posted, in which case we compute that one instead.
+        RenderScheduler* scheduler = appPTR->getRenderScheduler();
+        while ( scheduler->hasHigherPriorityWork(Natron::eRenderPriorityAnalysis) ) {
+            scheduler->waitForHigherPriorityWork(Natron::eRenderPriorityAnalysis, 50);
+            {
+                QMutexLocker l(&_imp->requestMutex);
+                if ( !_imp->requests.empty() ) {
+                    request = _imp->requests.back();
+                    _imp->requests.clear();
+                }
+            }
+            ///check for exit after picking the request since quitAnyComputation() posts a fake request
+            QMutexLocker l(&_imp->mustQuitMutex);
+            if (_imp->mustQuit) {
+                _imp->mustQuit = false;
+                _imp->mustQuitCond.wakeOne();
+                
+                return;
+            }
+        }
+        
         boost::shared_ptr<FinishedHistogram> ret(new FinishedHistogram);
         ret->binsCount = request.binsCount;
         ret->mode = request.mode;
@@ -520,19 +559,21 @@ HistogramCPU::run()
         ret->vmax = request.vmax;
         ret->mipMapLevel = request.image->getMipMapLevel();
 
+        ///Each histogram reads the components it needs straight from the image
+        const Natron::Image & image = *request.image;
 
         switch (request.mode) {
         case 0:     //< RGB
-            computeHistogramStatic(request, ret, 1);
-            computeHistogramStatic(request, ret, 2);
-            computeHistogramStatic(request, ret, 3);
+            computeHistogramStatic(request, image, ret, 1);
+            computeHistogramStatic(request, image, ret, 2);
+            computeHistogramStatic(request, image, ret, 3);
             break;
         case 1:
         case 2:
         case 3:
         case 4:
         case 5:
-            computeHistogramStatic(request, ret, 1);
+            computeHistogramStatic(request, image, ret, 1);
             break;
         default:
             assert(false);     //< unknown case.
@@ -15,12 +15,21 @@
 
 #include "Image.h"
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
 #include <QDebug>
+#include <QtConcurrentMap>
+#include <QThreadPool>
 #ifndef Q_MOC_RUN
+#include <boost/bind.hpp>
 #include <boost/math/special_functions/fpclassify.hpp>
+#include <boost/type_traits/is_same.hpp>
 #endif
 #include "Engine/AppManager.h"
 #include "Engine/Lut.h"
+#include "Engine/NumaTopology.h"
 
 using namespace Natron;
 
@@ -28,6 +37,13 @@ using namespace Natron;
 
 #define PIXEL_UNAVAILABLE 2
 
+///convertToFormat() only splits the work when each thread has at least this many rows and pixels to convert
+#define NATRON_IMAGE_CONVERSION_MIN_ROWS_PER_THREAD 16
+#define NATRON_IMAGE_CONVERSION_MIN_PIXELS_PER_THREAD 65536
+
+///Number of converted copies kept with an image, see Image::getConvertedCopy()
+#define NATRON_IMAGE_MAX_CONVERTED_COPIES 2
+
 template <int trimap>
 RectI minimalNonMarkedBbox_internal(const RectI& roi, const RectI& _bounds,const std::vector<char>& _map,
                                     bool* isBeingRenderedElsewhere)
@@ -164,10 +180,10 @@ RectI minimalNonMarkedBbox_internal(const RectI& roi, const RectI& _bounds,const
 }
 
 
-template <int trimap>
+template <int trimap, typename RectsList>
 void
 minimalNonMarkedRects_internal(const RectI & roi,const RectI& _bounds, const std::vector<char>& _map,
-                               std::list<RectI>& ret,bool* isBeingRenderedElsewhere)
+                               RectsList& ret,bool* isBeingRenderedElsewhere)
 {
     RectI bboxM = minimalNonMarkedBbox_internal<trimap>(roi, _bounds, _map, isBeingRenderedElsewhere);
     
@@ -400,6 +416,12 @@ Bitmap::minimalNonMarkedRects(const RectI & roi,std::list<RectI>& ret) const
     minimalNonMarkedRects_internal<0>(roi, _bounds, _map,ret , NULL);
 }
 
+void
+Bitmap::minimalNonMarkedRects(const RectI & roi,RenderRectsList& ret) const
+{
+    minimalNonMarkedRects_internal<0>(roi, _bounds, _map,ret , NULL);
+}
+
 #if NATRON_ENABLE_TRIMAP
 RectI
 Bitmap::minimalNonMarkedBbox_trimap(const RectI & roi,bool* isBeingRenderedElsewhere) const
@@ -413,6 +435,12 @@ Bitmap::minimalNonMarkedRects_trimap(const RectI & roi,std::list<RectI>& ret,boo
 {
     minimalNonMarkedRects_internal<1>(roi, _bounds, _map ,ret , isBeingRenderedElsewhere);
 } 
+
+void
+Bitmap::minimalNonMarkedRects_trimap(const RectI & roi,RenderRectsList& ret,bool* isBeingRenderedElsewhere) const
+{
+    minimalNonMarkedRects_internal<1>(roi, _bounds, _map ,ret , isBeingRenderedElsewhere);
+}
 #endif
 
 void
@@ -473,6 +501,10 @@ Image::Image(const ImageKey & key,
              const std::string & path)
     : CacheEntryHelper<unsigned char, ImageKey,ImageParams>(key, params, cache,storage,path)
     , _useBitmap(true)
+    , _numaNode(-1)
+    , _sparse(false)
+    , _committedPages()
+    , _nCommittedPages(0)
 {
     _components = params->getComponents();
     _bitDepth = params->getBitDepth();
@@ -485,6 +517,10 @@ Image::Image(const ImageKey & key,
              const boost::shared_ptr<Natron::ImageParams>& params)
 : CacheEntryHelper<unsigned char, ImageKey,ImageParams>(key, params, NULL,Natron::eStorageModeRAM,std::string())
 , _useBitmap(false)
+, _numaNode(-1)
+, _sparse(false)
+, _committedPages()
+, _nCommittedPages(0)
 {
     _components = params->getComponents();
     _bitDepth = params->getBitDepth();
@@ -507,6 +543,10 @@ Image::Image(ImageComponentsEnum components,
              bool useBitmap)
     : CacheEntryHelper<unsigned char,ImageKey,ImageParams>()
     , _useBitmap(useBitmap)
+    , _numaNode(-1)
+    , _sparse(false)
+    , _committedPages()
+    , _nCommittedPages(0)
 {
     setCacheEntry(makeKey(0,false,0,0),
                   boost::shared_ptr<ImageParams>( new ImageParams( 0,
@@ -542,15 +582,93 @@ Image::onMemoryAllocated(bool diskRestoration)
         _bitmap.setTo1();
     }
     
+    ///The pages of the buffer are placed on the node of the thread that first writes them: with calloc and lazily
+    ///committed memory that would be whichever tile thread renders them first, so write them now from this thread
+    bool firstTouched = false;
+    if ( !diskRestoration && Natron::NUMA::isBindingEnabled() ) {
+        _numaNode = Natron::NUMA::getCurrentThreadNode();
+        if (_numaNode != -1) {
+            Natron::NUMA::firstTouchPages( _data.writable(), dataSize() );
+            firstTouched = true;
+        }
+    }
+    
 #ifdef DEBUG
+    (void)firstTouched;
     if (!diskRestoration) {
         ///fill with red, to recognize unrendered pixels
+        ///This writes all the pages: the image cannot be sparse
         fill(_bounds,1.,0.,0.,1.);
     }
+#else
+    if (!diskRestoration && !firstTouched && _useBitmap && _data.isLazilyCommitted()) {
+        std::size_t pageSize = Natron::getMemoryPageSize();
+        _sparse = true;
+        _committedPages.assign( (dataSize() + pageSize - 1) / pageSize, false );
+    }
 #endif
     
 }
 
+void
+Image::commitRect(const RectI & roi)
+{
+    if (!_sparse) {
+        return;
+    }
+    RectI rect;
+    if ( !roi.intersect(_bounds, &rect) ) {
+        return;
+    }
+    
+    ///Mark the pages spanned by each row of the rect
+    std::size_t pageSize = Natron::getMemoryPageSize();
+    int pixelSize = getSizeOfForBitDepth( getBitDepth() ) * getElementsCountForComponents( getComponents() );
+    const unsigned char* start = _data.readable();
+    int nNewPages = 0;
+    for (int y = rect.y1; y < rect.y2; ++y) {
+        std::size_t first = ( pixelAt(rect.x1, y) - start ) / pageSize;
+        std::size_t last = ( pixelAt(rect.x2 - 1, y) + pixelSize - 1 - start ) / pageSize;
+        for (std::size_t p = first; p <= last; ++p) {
+            if (!_committedPages[p]) {
+                _committedPages[p] = true;
+                ++nNewPages;
+            }
+        }
+    }
+    if (nNewPages == 0) {
+        return;
+    }
+    
+    std::size_t oldSize = size();
+    _nCommittedPages.fetchAndAddOrdered(nNewPages);
+    if (_cache) {
+        _cache->notifyEntrySizeChanged( oldSize, size() );
+    }
+}
+
+size_t
+Image::committedDataSize() const
+{
+    if (!_sparse) {
+        return dataSize();
+    }
+    
+    return std::min( dataSize(), (std::size_t)_nCommittedPages.fetchAndAddOrdered(0) * Natron::getMemoryPageSize() );
+}
+
+
+bool
+Image::canBeSharedAcrossProcesses() const
+{
+    if (!_useBitmap) {
+        return true;
+    }
+    std::list<RectI> rest;
+    getRestToRender(getBounds(), rest);
+    return rest.empty();
+}
+
 
 ImageKey  
 Image::makeKey(U64 nodeHashKey,
@@ -651,6 +769,7 @@ Image::pasteFromForDepth(const Natron::Image & srcImg,
     if (copyBitmap) {
         copyBitmapPortion(roi, srcImg);
     }
+
     // now we're safe: both images contain the area in roi
     for (int y = roi.y1; y < roi.y2; ++y) {
         const PIX* src = (const PIX*)srcImg.pixelAt(roi.x1, y);
@@ -1735,6 +1854,7 @@ Image::copyBitmapRowPortion(int x1, int x2,int y, const Image& other)
     QWriteLocker k1(&_lock);
     QReadLocker k2(&other._lock);
     _bitmap.copyRowPortion(x1, x2, y, other._bitmap);
+    commitRect( RectI(x1, y, x2, y + 1) );
 }
 
 void
@@ -1757,6 +1877,7 @@ Image::copyBitmapPortion(const RectI& roi, const Image& other)
     QWriteLocker k1(&_lock);
     QReadLocker k2(&other._lock);
     _bitmap.copyBitmapPortion(roi, other._bitmap);
+    commitRect(roi);
 
 }
 
@@ -1787,6 +1908,28 @@ Bitmap::copyBitmapPortion(const RectI& roi, const Bitmap& other)
     }
 }
 
+///Converts the depth of nElements consecutive elements. There is no error to diffuse here, so this is a plain
+///loop without branches that the compiler can vectorize.
+template <typename SRCPIX,typename DSTPIX,int dstMaxValue>
+void
+convertRowDepth(const SRCPIX* src,
+                DSTPIX* dst,
+                int nElements,
+                bool invert)
+{
+    if (invert) {
+        for (int i = 0; i < nElements; ++i) {
+            dst[i] = dstMaxValue - convertPixelDepth<SRCPIX, DSTPIX>(src[i]);
+        }
+    } else if ( boost::is_same<SRCPIX, DSTPIX>::value ) {
+        std::memcpy( dst, src, nElements * sizeof(DSTPIX) );
+    } else {
+        for (int i = 0; i < nElements; ++i) {
+            dst[i] = convertPixelDepth<SRCPIX, DSTPIX>(src[i]);
+        }
+    }
+}
+
 ///Fast version when components are the same
 template <typename SRCPIX,typename DSTPIX,int srcMaxValue,int dstMaxValue>
 void
@@ -1818,6 +1961,21 @@ convertToFormatInternal_sameComps(const RectI & renderWindow,
     if (intersection.isNull()) {
         return;
     }
+    
+    if (!srcLut && !dstLut) {
+        ///Only the depth changes, rows can be converted as a whole
+        for (int y = intersection.y1; y < intersection.y2; ++y) {
+            convertRowDepth<SRCPIX, DSTPIX, dstMaxValue>( (const SRCPIX*)srcImg.pixelAt(intersection.x1, y),
+                                                          (DSTPIX*)dstImg.pixelAt(intersection.x1, y),
+                                                          intersection.width() * nComp, invert );
+        }
+        if (copyBitmap) {
+            dstImg.copyBitmapPortion(intersection, srcImg);
+        }
+
+        return;
+    }
+    
     for (int y = 0; y < intersection.height(); ++y) {
         int start = rand() % intersection.width();
         const SRCPIX* srcPixels = (const SRCPIX*)srcImg.pixelAt(intersection.x1 + start, intersection.y1 + y);
@@ -1893,6 +2051,126 @@ convertToFormatInternal_sameComps(const RectI & renderWindow,
     }
 } // convertToFormatInternal_sameComps
 
+///Converts a pixel to other components. error is the error to diffuse of each channel, it is only used
+///when converting RGB(A) to RGB(A) 8-bit.
+template <typename SRCPIX,typename DSTPIX,int dstMaxValue,int srcNComps,int dstNComps>
+inline void
+convertPixelComps(const SRCPIX* srcPixels,
+                  DSTPIX* dstPixels,
+                  Natron::ImageBitDepthEnum srcDepth,
+                  Natron::ImageBitDepthEnum dstDepth,
+                  const Natron::Color::Lut* srcLut,
+                  const Natron::Color::Lut* dstLut,
+                  int channelForAlpha,
+                  bool invert,
+                  bool unpremultChannel,
+                  unsigned* error)
+{
+    if (dstNComps == 1) {
+        ///If we're converting to alpha, we just have to handle pixel depth conversion
+        DSTPIX pix;
+
+        // convertPixelDepth is optimized when SRCPIX == DSTPIX
+
+        switch (srcNComps) {
+            case 4:
+                pix = convertPixelDepth<SRCPIX, DSTPIX>(srcPixels[channelForAlpha]);
+                break;
+            case 3:
+                // RGB is opaque but the channelForAlpha can be 0-2
+                pix = convertPixelDepth<SRCPIX, DSTPIX>(channelForAlpha == -1 ? 0. : srcPixels[channelForAlpha]);
+                break;
+            case 1:
+            default:
+                pix  = convertPixelDepth<SRCPIX, DSTPIX>(*srcPixels);
+                break;
+        }
+
+        dstPixels[0] = invert ? dstMaxValue - pix: pix;
+    } else if (srcNComps == 1) {
+        ///If we're converting from alpha, R G and B are 0.
+        for (int k = 0; k < std::min(3, dstNComps); ++k) {
+            dstPixels[k] = invert ? dstMaxValue : 0;
+        }
+        if (dstNComps == 4) {
+            DSTPIX pix = convertPixelDepth<SRCPIX, DSTPIX>(srcPixels[0]);
+            dstPixels[dstNComps - 1] = invert ? dstMaxValue - pix: pix;
+        }
+    } else {
+        ///In this case we've RGB or RGBA input and outputs
+        
+        ///This is only set if unpremultChannel is true
+        float alphaForUnPremult;
+        if (unpremultChannel) {
+            alphaForUnPremult = convertPixelDepth<SRCPIX, float>(srcPixels[srcNComps - 1]);
+        } else {
+            alphaForUnPremult = 0.;
+        }
+        
+        for (int k = 0; k < dstNComps; ++k) {
+            if (k == 3) {
+                ///For alpha channel, fill with 1, we reach here only if converting RGB-->RGBA
+                DSTPIX pix = convertPixelDepth<float, DSTPIX>(0.f);
+                dstPixels[k] = invert ? dstMaxValue - pix : pix;
+                
+            } else if (!srcLut && !dstLut) {
+                DSTPIX pix;
+                if (dstDepth == eImageBitDepthByte) {
+                    float pixFloat = convertPixelDepth<SRCPIX, float>(srcPixels[k]);
+                    error[k] = (error[k] & 0xff) + Color::floatToInt<0xff01>(pixFloat);
+                    pix = error[k] >> 8;
+                    
+                } else {
+                    pix = convertPixelDepth<SRCPIX, DSTPIX>(srcPixels[k]);
+                }
+                dstPixels[k] = invert ? dstMaxValue - pix : pix;
+            } else {
+                ///For RGB channels
+                float pixFloat;
+                
+                ///Unpremult before doing colorspace conversion from linear to X
+                if (unpremultChannel) {
+                    pixFloat = convertPixelDepth<SRCPIX, float>(srcPixels[k]);
+                    pixFloat = alphaForUnPremult == 0.f ? 0. : pixFloat / alphaForUnPremult;
+                    if (srcLut) {
+                        pixFloat = srcLut->fromColorSpaceFloatToLinearFloat(pixFloat);
+                    }
+                    
+                } else if (srcLut) {
+                    if (srcDepth == eImageBitDepthByte) {
+                        pixFloat = srcLut->fromColorSpaceUint8ToLinearFloatFast(srcPixels[k]);
+                    } else if (srcDepth == eImageBitDepthShort) {
+                        pixFloat = srcLut->fromColorSpaceUint16ToLinearFloatFast(srcPixels[k]);
+                    } else {
+                        pixFloat = srcLut->fromColorSpaceFloatToLinearFloat(srcPixels[k]);
+                    }
+                } else {
+                    pixFloat = convertPixelDepth<SRCPIX, float>(srcPixels[k]);
+                }
+                
+                ///Apply dst color-space
+                DSTPIX pix;
+                if (dstDepth == eImageBitDepthByte) {
+                    error[k] = (error[k] & 0xff) + ( dstLut ? dstLut->toColorSpaceUint8xxFromLinearFloatFast(pixFloat) :
+                                                    Color::floatToInt<0xff01>(pixFloat) );
+                    pix = error[k] >> 8;
+                    
+                } else if (dstDepth == eImageBitDepthShort) {
+                    pix = dstLut ? dstLut->toColorSpaceUint16FromLinearFloatFast(pixFloat) :
+                    convertPixelDepth<float, DSTPIX>(pixFloat);
+                    
+                } else {
+                    if (dstLut) {
+                        pixFloat = dstLut->toColorSpaceFloatFromLinearFloat(pixFloat);
+                    }
+                    pix = convertPixelDepth<float, DSTPIX>(pixFloat);
+                }
+                dstPixels[k] = invert ? dstMaxValue - pix : pix;
+            }
+        }
+    }
+} // convertPixelComps
+
 template <typename SRCPIX,typename DSTPIX,int srcMaxValue,int dstMaxValue,int srcNComps,int dstNComps>
 void
 convertToFormatInternal(const RectI & renderWindow,
@@ -1938,7 +2216,7 @@ convertToFormatInternal(const RectI & renderWindow,
     }
 
     Natron::ImageBitDepthEnum dstDepth = dstImg.getBitDepth();
-    Natron::ImageBitDepthEnum srcDepth = dstDepth;
+    Natron::ImageBitDepthEnum srcDepth = srcImg.getBitDepth();
 
     ///special case comp == alpha && channelForAlpha = -1 clear out the mask
     if ( dstNComps == 1 && (channelForAlpha == -1) ) {
@@ -1958,8 +2236,28 @@ convertToFormatInternal(const RectI & renderWindow,
     const Natron::Color::Lut* srcLut = lutFromColorspace(srcColorSpace);
     const Natron::Color::Lut* dstLut = lutFromColorspace(dstColorSpace);
     
+    assert(srcNComps == 1 || dstNComps == 1 || srcImg.getComponents() != dstImg.getComponents());
+    bool unpremultChannel = (srcImg.getComponents() == Natron::eImageComponentRGBA &&
+                             dstImg.getComponents() == Natron::eImageComponentRGB &&
+                             requiresUnpremult);
+    
+    ///The error is only diffused when converting colors to 8-bit
+    bool diffuseError = srcNComps > 1 && dstNComps > 1 && dstDepth == eImageBitDepthByte;
+    
     for (int y = 0; y < intersection.height(); ++y) {
         
+        if (!diffuseError) {
+            ///Pixels are independent: convert the row in order
+            const SRCPIX* srcPixels = (const SRCPIX*)srcImg.pixelAt(intersection.x1, intersection.y1 + y);
+            DSTPIX* dstPixels = (DSTPIX*)dstImg.pixelAt(intersection.x1, intersection.y1 + y);
+            for (int x = 0; x < intersection.width(); ++x, srcPixels += srcNComps, dstPixels += dstNComps) {
+                convertPixelComps<SRCPIX, DSTPIX, dstMaxValue, srcNComps, dstNComps>(srcPixels, dstPixels, srcDepth, dstDepth,
+                                                                                     srcLut, dstLut, channelForAlpha, invert,
+                                                                                     unpremultChannel, 0);
+            }
+            continue;
+        }
+        
         ///Start of the line for error diffusion
         int start = rand() % intersection.width();
         
@@ -1982,118 +2280,9 @@ convertToFormatInternal(const RectI & renderWindow,
             };
 
             while ( x != end && x >= 0 && x < intersection.width() ) {
-                if (dstNComps == 1) {
-                    ///If we're converting to alpha, we just have to handle pixel depth conversion
-                    DSTPIX pix;
-
-                    // convertPixelDepth is optimized when SRCPIX == DSTPIX
-
-                    switch (srcNComps) {
-                        case 4:
-                            pix = convertPixelDepth<SRCPIX, DSTPIX>(srcPixels[channelForAlpha]);
-                            break;
-                        case 3:
-                            // RGB is opaque but the channelForAlpha can be 0-2
-                            pix = convertPixelDepth<SRCPIX, DSTPIX>(channelForAlpha == -1 ? 0. : srcPixels[channelForAlpha]);
-                            break;
-                        case 1:
-                            pix  = convertPixelDepth<SRCPIX, DSTPIX>(*srcPixels);
-                            break;
-                    }
-
-                    dstPixels[0] = invert ? dstMaxValue - pix: pix;
-                } else {
-                    
-                    if (srcNComps == 1) {
-                        ///If we're converting from alpha, R G and B are 0.
-                        //assert(dstNComps == 3 || dstNComps == 4);
-                        for (int k = 0; k < std::min(3, dstNComps); ++k) {
-                            dstPixels[k] = invert ? dstMaxValue : 0;
-                        }
-                        if (dstNComps == 4) {
-                            DSTPIX pix = convertPixelDepth<SRCPIX, DSTPIX>(srcPixels[0]);
-                            dstPixels[dstNComps - 1] = invert ? dstMaxValue - pix: pix;
-                        }
-                    } else {
-                        ///In this case we've RGB or RGBA input and outputs
-                        assert(srcImg.getComponents() != dstImg.getComponents());
-                        
-                        bool unpremultChannel = (srcImg.getComponents() == Natron::eImageComponentRGBA &&
-                                                 dstImg.getComponents() == Natron::eImageComponentRGB &&
-                                                 requiresUnpremult);
-                        
-                        ///This is only set if unpremultChannel is true
-                        float alphaForUnPremult;
-                        if (unpremultChannel) {
-                            alphaForUnPremult = convertPixelDepth<SRCPIX, float>(srcPixels[srcNComps - 1]);
-                        } else {
-                            alphaForUnPremult = 0.;
-                        }
-                        
-                        for (int k = 0; k < dstNComps; ++k) {
-                            if (k == 3) {
-                                ///For alpha channel, fill with 1, we reach here only if converting RGB-->RGBA
-                                DSTPIX pix = convertPixelDepth<float, DSTPIX>(0.f);
-                                dstPixels[k] = invert ? dstMaxValue - pix : pix;
-
-                            } else if (!srcLut && !dstLut) {
-                                DSTPIX pix;
-                                if (dstDepth == eImageBitDepthByte) {
-                                    float pixFloat = convertPixelDepth<SRCPIX, float>(srcPixels[k]);
-                                    error[k] = (error[k] & 0xff) + ( dstLut ? dstLut->toColorSpaceUint8xxFromLinearFloatFast(pixFloat) :
-                                                                    Color::floatToInt<0xff01>(pixFloat) );
-                                    pix = error[k] >> 8;
-
-                                } else {
-                                    pix = convertPixelDepth<SRCPIX, DSTPIX>(srcPixels[k]);
-                                }
-                                dstPixels[k] = invert ? dstMaxValue - pix : pix;
-                            } else {
-                                ///For RGB channels
-                                float pixFloat;
-                                
-                                ///Unpremult before doing colorspace conversion from linear to X
-                                if (unpremultChannel) {
-                                    pixFloat = convertPixelDepth<SRCPIX, float>(srcPixels[k]);
-                                    pixFloat = alphaForUnPremult == 0.f ? 0. : pixFloat / alphaForUnPremult;
-                                    if (srcLut) {
-                                        pixFloat = srcLut->fromColorSpaceFloatToLinearFloat(pixFloat);
-                                    }
-
-                                } else if (srcLut) {
-                                    if (srcDepth == eImageBitDepthByte) {
-                                        pixFloat = srcLut->fromColorSpaceUint8ToLinearFloatFast(srcPixels[k]);
-                                    } else if (srcDepth == eImageBitDepthShort) {
-                                        pixFloat = srcLut->fromColorSpaceUint16ToLinearFloatFast(srcPixels[k]);
-                                    } else {
-                                        pixFloat = srcLut->fromColorSpaceFloatToLinearFloat(srcPixels[k]);
-                                    }
-                                } else {
-                                    pixFloat = convertPixelDepth<SRCPIX, float>(srcPixels[k]);
-                                }
-
-                                ///Apply dst color-space
-                                DSTPIX pix;
-                                if (dstDepth == eImageBitDepthByte) {
-                                    error[k] = (error[k] & 0xff) + ( dstLut ? dstLut->toColorSpaceUint8xxFromLinearFloatFast(pixFloat) :
-                                                                    Color::floatToInt<0xff01>(pixFloat) );
-                                    pix = error[k] >> 8;
-
-                                } else if (dstDepth == eImageBitDepthShort) {
-                                    pix = dstLut ? dstLut->toColorSpaceUint16FromLinearFloatFast(pixFloat) :
-                                    convertPixelDepth<float, DSTPIX>(pixFloat);
-
-                                } else {
-                                    if (dstLut) {
-                                        pixFloat = dstLut->toColorSpaceFloatFromLinearFloat(pixFloat);
-                                    }
-                                    pix = convertPixelDepth<float, DSTPIX>(pixFloat);
-                                }
-                                dstPixels[k] = invert ? dstMaxValue - pix : pix;
-                            }
-                        }
-                    }
-                }
+                convertPixelComps<SRCPIX, DSTPIX, dstMaxValue, srcNComps, dstNComps>(srcPixels, dstPixels, srcDepth, dstDepth,
+                                                                                     srcLut, dstLut, channelForAlpha, invert,
+                                                                                     unpremultChannel, error);
 
                 if (backward) {
                     --x;
@@ -2203,7 +2392,7 @@ convertToFormatInternalForDepth(const RectI & renderWindow,
 }
 
 void
-Image::convertToFormat(const RectI & renderWindow,
+Image::convertToFormatCommon(const RectI & renderWindow,
                        Natron::ViewerColorSpaceEnum srcColorSpace,
                        Natron::ViewerColorSpaceEnum dstColorSpace,
                        int channelForAlpha,
@@ -2387,5 +2576,117 @@ Image::convertToFormat(const RectI & renderWindow,
             break;
         } // switch
     }
-} // convertToFormat
+} // convertToFormatCommon
+
+void
+Image::convertToFormat(const RectI & renderWindow,
+                       Natron::ViewerColorSpaceEnum srcColorSpace,
+                       Natron::ViewerColorSpaceEnum dstColorSpace,
+                       int channelForAlpha,
+                       bool invert,
+                       bool copyBitmap,
+                       bool requiresUnpremult,
+                       Natron::Image* dstImg) const
+{
+    assert( getBounds() == dstImg->getBounds() );
+    
+    RectI window;
+    if ( !renderWindow.intersect(_bounds, &window) ) {
+        return;
+    }
+    
+    ///Split large windows in bands of rows converted in parallel, unless the thread pool is already busy
+    int nBands = 1;
+    if ( window.area() >= NATRON_IMAGE_CONVERSION_MIN_PIXELS_PER_THREAD * 2 &&
+         QThreadPool::globalInstance()->activeThreadCount() < QThreadPool::globalInstance()->maxThreadCount() ) {
+        nBands = std::min( appPTR->getHardwareIdealThreadCount(), window.height() / NATRON_IMAGE_CONVERSION_MIN_ROWS_PER_THREAD );
+    }
+    
+    if (nBands <= 1) {
+        convertToFormatCommon(window, srcColorSpace, dstColorSpace, channelForAlpha, invert, copyBitmap, requiresUnpremult, dstImg);
+        
+        return;
+    }
+    
+    std::vector<RectI> bands;
+    int rowsPerBand = (int)std::ceil( (double)window.height() / nBands );
+    for (int y = window.y1; y < window.y2; y += rowsPerBand) {
+        bands.push_back( RectI( window.x1, y, window.x2, std::min(y + rowsPerBand, window.y2) ) );
+    }
+    QtConcurrent::blockingMap( bands, boost::bind(&Image::convertToFormatCommon, this, _1, srcColorSpace, dstColorSpace,
+                                                  channelForAlpha, invert, copyBitmap, requiresUnpremult, dstImg) );
+}
+
+boost::shared_ptr<Image>
+Image::getConvertedCopy(const RectI & roi,
+                        Natron::ImageComponentsEnum components,
+                        Natron::ImageBitDepthEnum bitdepth,
+                        Natron::ViewerColorSpaceEnum srcColorSpace,
+                        Natron::ViewerColorSpaceEnum dstColorSpace,
+                        int channelForAlpha,
+                        bool requiresUnpremult)
+{
+    QMutexLocker k(&_convertedCopiesLock);
+    
+    std::size_t oldCopiesSize = convertedCopiesSize_locked();
+    
+    boost::shared_ptr<Image> copy;
+    for (std::list<ConvertedCopy>::iterator it = _convertedCopies.begin(); it != _convertedCopies.end(); ++it) {
+        if (it->image->getComponents() == components && it->image->getBitDepth() == bitdepth &&
+            it->srcColorSpace == srcColorSpace && it->dstColorSpace == dstColorSpace &&
+            it->channelForAlpha == channelForAlpha && it->requiresUnpremult == requiresUnpremult) {
+            copy = it->image;
+            break;
+        }
+    }
+    
+    if (!copy) {
+        if (_convertedCopies.size() >= NATRON_IMAGE_MAX_CONVERTED_COPIES) {
+            _convertedCopies.pop_front();
+        }
+        ConvertedCopy c;
+        c.image.reset( new Image(components, _rod, _bounds, getMipMapLevel(), _par, bitdepth, true) );
+        c.srcColorSpace = srcColorSpace;
+        c.dstColorSpace = dstColorSpace;
+        c.channelForAlpha = channelForAlpha;
+        c.requiresUnpremult = requiresUnpremult;
+        _convertedCopies.push_back(c);
+        copy = c.image;
+    }
+    
+    ///Only convert what was not converted yet
+    std::list<RectI> rectsToConvert;
+    copy->getRestToRender(roi, rectsToConvert);
+    for (std::list<RectI>::iterator it = rectsToConvert.begin(); it != rectsToConvert.end(); ++it) {
+        convertToFormat(*it, srcColorSpace, dstColorSpace, channelForAlpha, false, false, requiresUnpremult, copy.get());
+        copy->markForRendered(*it);
+    }
+    
+    std::size_t newCopiesSize = convertedCopiesSize_locked();
+    if ( _cache && (newCopiesSize != oldCopiesSize) ) {
+        std::size_t imageSize = committedDataSize() + _bitmap.getBounds().area();
+        _cache->notifyEntrySizeChanged(imageSize + oldCopiesSize, imageSize + newCopiesSize);
+    }
+    
+    return copy;
+}
+
+size_t
+Image::convertedCopiesSize() const
+{
+    QMutexLocker k(&_convertedCopiesLock);
+    
+    return convertedCopiesSize_locked();
+}
+
+size_t
+Image::convertedCopiesSize_locked() const
+{
+    std::size_t ret = 0;
+    for (std::list<ConvertedCopy>::const_iterator it = _convertedCopies.begin(); it != _convertedCopies.end(); ++it) {
+        ret += it->image->size();
+    }
+    
+    return ret;
+}
 
@@ -22,7 +22,9 @@
 #include "Global/GlobalDefines.h"
 
 CLANG_DIAG_OFF(deprecated)
+#include <QtCore/QAtomicInt>
 #include <QtCore/QHash>
+#include <QtCore/QMutex>
 CLANG_DIAG_ON(deprecated)
 #include <QtCore/QReadWriteLock>
 
@@ -30,6 +32,7 @@ CLANG_DIAG_ON(deprecated)
 #include "Engine/ImageParams.h"
 #include "Engine/CacheEntry.h"
 #include "Engine/Rect.h"
+#include "Engine/RenderArena.h"
 #include "Engine/OutputSchedulerThread.h"
 
 
@@ -82,10 +85,12 @@ namespace Natron {
 
 #if NATRON_ENABLE_TRIMAP
         void minimalNonMarkedRects_trimap(const RectI & roi,std::list<RectI>& ret,bool* isBeingRenderedElsewhere) const;
+        void minimalNonMarkedRects_trimap(const RectI & roi,RenderRectsList& ret,bool* isBeingRenderedElsewhere) const;
         RectI minimalNonMarkedBbox_trimap(const RectI & roi,bool* isBeingRenderedElsewhere) const;
 #endif
 
         void minimalNonMarkedRects(const RectI & roi,std::list<RectI>& ret) const;
+        void minimalNonMarkedRects(const RectI & roi,RenderRectsList& ret) const;
         RectI minimalNonMarkedBbox(const RectI & roi) const;
 
 
@@ -156,9 +161,21 @@ namespace Natron {
         }
         
         bool usesBitMap() const { return _useBitmap; }
+        
+        /**
+         * @brief Returns the NUMA node of the thread that allocated the image, or -1 if unknown.
+         * @see Natron::NUMA
+         **/
+        int getNUMANode() const { return _numaNode; }
 
         virtual void onMemoryAllocated(bool diskRestoration) OVERRIDE FINAL;
 
+        /**
+         * @brief The bitmap is not stored in the backing file: only a fully rendered image may be
+         * restored by another process.
+         **/
+        virtual bool canBeSharedAcrossProcesses() const OVERRIDE FINAL WARN_UNUSED_RETURN;
+
         static ImageKey makeKey(U64 nodeHashKey,
                                 bool frameVaryingOrAnimated,
                                 SequenceTime time,
@@ -206,9 +223,22 @@ namespace Natron {
         {
             return _bounds;
         };
+        /**
+         * @brief For sparse images (see isSparse()) only the memory of the rendered portions is counted.
+         **/
         virtual size_t size() const OVERRIDE FINAL
         {
-            return dataSize() + _bitmap.getBounds().area();
+            return committedDataSize() + _bitmap.getBounds().area() + convertedCopiesSize();
+        }
+
+        /**
+         * @brief Returns true if the memory of the image is committed as its portions get rendered: this is the case
+         * of large images with a bitmap held in RAM. Rendering a small part of a large image then uses about the
+         * memory of that part, and only that part is counted in the size of the image.
+         **/
+        bool isSparse() const
+        {
+            return _sparse;
         }
 
 
@@ -282,9 +312,11 @@ namespace Natron {
      * are already rendered in the image. It aims to return the minimal
      * area to render. Since this problem is quite hard to solve,the different portions
      * of image returned may contain already rendered pixels.
+     * The rectangles are appended to a std::list<RectI> or to a RenderRectsList.
      **/
 #if NATRON_ENABLE_TRIMAP
-        void getRestToRender_trimap(const RectI & regionOfInterest,std::list<RectI>& ret,bool* isBeingRenderedElsewhere) const
+        template <typename RectsList>
+        void getRestToRender_trimap(const RectI & regionOfInterest,RectsList& ret,bool* isBeingRenderedElsewhere) const
         {
             if (!_useBitmap) {
                 return;
@@ -293,7 +325,8 @@ namespace Natron {
             _bitmap.minimalNonMarkedRects_trimap(regionOfInterest, ret, isBeingRenderedElsewhere);
         }
 #endif
-        void getRestToRender(const RectI & regionOfInterest,std::list<RectI>& ret) const
+        template <typename RectsList>
+        void getRestToRender(const RectI & regionOfInterest,RectsList& ret) const
         {
             if (!_useBitmap) {
                 return ;
@@ -329,6 +362,7 @@ namespace Natron {
             QWriteLocker locker(&_lock);
 
             _bitmap.markForRendered(roi);
+            commitRect(roi);
         }
         
 #if NATRON_ENABLE_TRIMAP
@@ -341,6 +375,7 @@ namespace Natron {
             QWriteLocker locker(&_lock);
             
             _bitmap.markForRendering(roi);
+            commitRect(roi);
         }
 #endif
 
@@ -352,6 +387,12 @@ namespace Natron {
             QWriteLocker locker(&_lock);
             
             _bitmap.clear(roi);
+            
+            ///The pixels will be rendered again, so must be their conversions
+            QMutexLocker k(&_convertedCopiesLock);
+            for (std::list<ConvertedCopy>::iterator it = _convertedCopies.begin(); it != _convertedCopies.end(); ++it) {
+                it->image->clearBitmap(roi);
+            }
         }
         
         /**
@@ -448,6 +489,8 @@ namespace Natron {
      * RGBA --> Alpha
      * or bit depth conversion
      * Implementation should tend to optimize these cases.
+     *
+     * Large render windows are split in bands of rows converted in parallel.
      **/
         void convertToFormat(const RectI & renderWindow,
                              Natron::ViewerColorSpaceEnum srcColorSpace,
@@ -457,6 +500,20 @@ namespace Natron {
                              bool copyBitMap,
                              bool requiresUnpremult,
                              Natron::Image* dstImg) const;
+        
+        /**
+         * @brief Returns a copy of this image converted by convertToFormat() to the given components and bit depth, in which
+         * at least roi is converted. The copies are kept with the image (and counted in its size), so that fetching the same
+         * conversion again only converts the parts of roi that were not converted yet.
+         * The pixels of roi must have been rendered.
+         **/
+        boost::shared_ptr<Natron::Image> getConvertedCopy(const RectI & roi,
+                                                          Natron::ImageComponentsEnum components,
+                                                          Natron::ImageBitDepthEnum bitdepth,
+                                                          Natron::ViewerColorSpaceEnum srcColorSpace,
+                                                          Natron::ViewerColorSpaceEnum dstColorSpace,
+                                                          int channelForAlpha,
+                                                          bool requiresUnpremult);
 
         /**
          * @brief returns true if image contains NaNs or infinite values, and fix them.
@@ -469,6 +526,27 @@ namespace Natron {
         
     private:
 
+        /**
+         * @brief Accounts for the memory of the pixels of roi, which are being written, in the size of a sparse image.
+         * Must be called with the image lock taken for writing.
+         **/
+        void commitRect(const RectI & roi);
+
+        size_t committedDataSize() const;
+        
+        size_t convertedCopiesSize() const;
+        
+        size_t convertedCopiesSize_locked() const;
+        
+        ///Converts the given band of rows, called by convertToFormat() in parallel
+        void convertToFormatCommon(const RectI & renderWindow,
+                                   Natron::ViewerColorSpaceEnum srcColorSpace,
+                                   Natron::ViewerColorSpaceEnum dstColorSpace,
+                                   int channelForAlpha,
+                                   bool invert,
+                                   bool copyBitMap,
+                                   bool requiresUnpremult,
+                                   Natron::Image* dstImg) const;
         
         /**
      * @brief Given the output buffer,the region of interest and the mip map level, this
@@ -521,6 +599,22 @@ namespace Natron {
         RectI _bounds;
         double _par;
         bool _useBitmap;
+        int _numaNode;
+        bool _sparse;
+        std::vector<bool> _committedPages; //< for sparse images, the memory pages of the buffer that were written to
+        mutable QAtomicInt _nCommittedPages;
+        
+        struct ConvertedCopy
+        {
+            boost::shared_ptr<Natron::Image> image;
+            Natron::ViewerColorSpaceEnum srcColorSpace;
+            Natron::ViewerColorSpaceEnum dstColorSpace;
+            int channelForAlpha;
+            bool requiresUnpremult;
+        };
+        
+        mutable QMutex _convertedCopiesLock;
+        std::list<ConvertedCopy> _convertedCopies; //< protected by _convertedCopiesLock
     };
 
     template <typename SRCPIX,typename DSTPIX>
@@ -0,0 +1,240 @@
+//  Natron
+//
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+
+#include "ImageBufferWrapper.h"
+
+#include <cassert>
+
+#include "Engine/Image.h"
+
+///Shiboken cannot generate the buffer protocol, hence this type is written by hand against the Python C API.
+
+ImageBuffer::ImageBuffer(const boost::shared_ptr<Natron::Image>& image,
+                         const RectI& window)
+: _image(image)
+, _window(window)
+{
+    assert(image);
+    assert( image->getBounds().contains(window) );
+}
+
+ImageBuffer::~ImageBuffer()
+{
+}
+
+int
+ImageBuffer::getComponentsCount() const
+{
+    return (int)_image->getComponentsCount();
+}
+
+int
+ImageBuffer::getBytesPerComponent() const
+{
+    return Natron::getSizeOfForBitDepth( _image->getBitDepth() );
+}
+
+const char*
+ImageBuffer::getFormat() const
+{
+    switch ( _image->getBitDepth() ) {
+    case Natron::eImageBitDepthByte:
+
+        return "B";
+    case Natron::eImageBitDepthShort:
+
+        return "H";
+    case Natron::eImageBitDepthFloat:
+
+        return "f";
+    case Natron::eImageBitDepthNone:
+        break;
+    }
+    assert(false);
+
+    return "B";
+}
+
+const unsigned char*
+ImageBuffer::getData(std::ptrdiff_t* rowStride,
+                     std::ptrdiff_t* pixelStride,
+                     std::ptrdiff_t* componentStride) const
+{
+    const Natron::Image* image = _image.get();
+    int bytes = getBytesPerComponent();
+
+    *componentStride = bytes;
+    *pixelStride = image->getComponentsCount() * bytes;
+    *rowStride = (std::ptrdiff_t)image->getBounds().width() * *pixelStride;
+
+    return image->pixelAt(_window.x1, _window.y1);
+}
+
+namespace {
+
+struct ImageBufferObject
+{
+    PyObject_HEAD
+    ImageBuffer* buffer;
+    ///Referenced by the Py_buffer views handed to the consumers
+    Py_ssize_t shape[3];
+    Py_ssize_t strides[3];
+};
+
+void
+ImageBuffer_dealloc(PyObject* self)
+{
+    delete ( (ImageBufferObject*)self )->buffer;
+    Py_TYPE(self)->tp_free(self);
+}
+
+int
+ImageBuffer_getbuffer(PyObject* self,
+                      Py_buffer* view,
+                      int flags)
+{
+    ImageBufferObject* obj = (ImageBufferObject*)self;
+
+    view->obj = NULL;
+    if ( (flags & PyBUF_WRITABLE) == PyBUF_WRITABLE ) {
+        PyErr_SetString(PyExc_BufferError, "NatronEngine.ImageBuffer is read-only");
+
+        return -1;
+    }
+    Py_ssize_t itemSize = obj->buffer->getBytesPerComponent();
+    bool contiguous = obj->strides[2] == itemSize &&
+                      obj->strides[1] == obj->shape[2] * itemSize &&
+                      obj->strides[0] == obj->shape[1] * obj->shape[2] * itemSize;
+    if ( !contiguous && ( (flags & PyBUF_STRIDES) != PyBUF_STRIDES ) ) {
+        ///Planar images and windows narrower than the image are not contiguous
+        PyErr_SetString(PyExc_BufferError, "NatronEngine.ImageBuffer is not contiguous, a strided buffer must be requested");
+
+        return -1;
+    }
+    std::ptrdiff_t rowStride, pixelStride, componentStride;
+    view->buf = (void*)obj->buffer->getData(&rowStride, &pixelStride, &componentStride);
+    view->len = obj->shape[0] * obj->shape[1] * obj->shape[2] * itemSize;
+    view->readonly = 1;
+    view->itemsize = itemSize;
+    view->format = (flags & PyBUF_FORMAT) ? (char*)obj->buffer->getFormat() : NULL;
+    view->ndim = 3;
+    view->shape = ( (flags & PyBUF_ND) == PyBUF_ND ) ? obj->shape : NULL;
+    view->strides = ( (flags & PyBUF_STRIDES) == PyBUF_STRIDES ) ? obj->strides : NULL;
+    view->suboffsets = NULL;
+    view->internal = NULL;
+    view->obj = self;
+    Py_INCREF(self);
+
+    return 0;
+}
+
+PyObject*
+ImageBuffer_getBounds(PyObject* self)
+{
+    const RectI& window = ( (ImageBufferObject*)self )->buffer->getWindow();
+
+    return Py_BuildValue("(iiii)", window.x1, window.y1, window.x2, window.y2);
+}
+
+PyObject*
+ImageBuffer_getComponentsCount(PyObject* self)
+{
+    return PyLong_FromLong( ( (ImageBufferObject*)self )->buffer->getComponentsCount() );
+}
+
+PyObject*
+ImageBuffer_getScale(PyObject* self)
+{
+    return PyFloat_FromDouble( ( (ImageBufferObject*)self )->buffer->getImage()->getScale() );
+}
+
+PyMethodDef ImageBuffer_methods[] = {
+    {"getBounds", (PyCFunction)ImageBuffer_getBounds, METH_NOARGS,
+     "Returns the (x1, y1, x2, y2) rectangle of the buffer in pixel coordinates at the scale of the image."},
+    {"getComponentsCount", (PyCFunction)ImageBuffer_getComponentsCount, METH_NOARGS,
+     "Returns the number of components of each pixel."},
+    {"getScale", (PyCFunction)ImageBuffer_getScale, METH_NOARGS,
+     "Returns the scale at which the image was rendered."},
+    {0, 0, 0, 0} // Sentinel
+};
+
+PyBufferProcs ImageBuffer_bufferProcs = {
+    ImageBuffer_getbuffer, // bf_getbuffer
+    0 // bf_releasebuffer
+};
+
+PyTypeObject ImageBuffer_Type = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "NatronEngine.ImageBuffer", // tp_name
+    sizeof(ImageBufferObject), // tp_basicsize
+    0, // tp_itemsize
+    ImageBuffer_dealloc, // tp_dealloc
+    0, // tp_print
+    0, // tp_getattr
+    0, // tp_setattr
+    0, // tp_reserved
+    0, // tp_repr
+    0, // tp_as_number
+    0, // tp_as_sequence
+    0, // tp_as_mapping
+    0, // tp_hash
+    0, // tp_call
+    0, // tp_str
+    0, // tp_getattro
+    0, // tp_setattro
+    &ImageBuffer_bufferProcs, // tp_as_buffer
+    Py_TPFLAGS_DEFAULT, // tp_flags
+    "Read-only view over the pixels of an image rendered by Effect.renderImage(), "
+    "the image stays in the cache for as long as this object is referenced.", // tp_doc
+    0, // tp_traverse
+    0, // tp_clear
+    0, // tp_richcompare
+    0, // tp_weaklistoffset
+    0, // tp_iter
+    0, // tp_iternext
+    ImageBuffer_methods, // tp_methods
+};
+} // anon namespace
+
+PyObject*
+ImageBuffer_toPython(ImageBuffer* buffer)
+{
+    ImageBufferObject* obj = PyObject_New(ImageBufferObject, &ImageBuffer_Type);
+
+    if (!obj) {
+        delete buffer;
+
+        return NULL;
+    }
+    obj->buffer = buffer;
+
+    const RectI& window = buffer->getWindow();
+    std::ptrdiff_t rowStride, pixelStride, componentStride;
+    (void)buffer->getData(&rowStride, &pixelStride, &componentStride);
+    obj->shape[0] = window.height();
+    obj->shape[1] = window.width();
+    obj->shape[2] = buffer->getComponentsCount();
+    obj->strides[0] = rowStride;
+    obj->strides[1] = pixelStride;
+    obj->strides[2] = componentStride;
+
+    return (PyObject*)obj;
+}
+
+bool
+ImageBuffer_addToModule(PyObject* module)
+{
+    if (PyType_Ready(&ImageBuffer_Type) < 0) {
+        return false;
+    }
+    Py_INCREF(&ImageBuffer_Type);
+
+    return PyModule_AddObject(module, "ImageBuffer", (PyObject*)&ImageBuffer_Type) == 0;
+}
@@ -0,0 +1,87 @@
+//  Natron
+//
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef IMAGEBUFFERWRAPPER_H
+#define IMAGEBUFFERWRAPPER_H
+
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+
+#include <cstddef>
+
+#if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
+#include <boost/shared_ptr.hpp>
+#endif
+
+#include "Engine/Rect.h"
+
+namespace Natron {
+class Image;
+}
+
+/**
+ * @brief A window of an image rendered by Effect::renderImage(). The image is referenced for as long as the
+ * ImageBuffer lives, which keeps it locked in the cache: its pixels are never copied.
+ *
+ * In Python this is the NatronEngine.ImageBuffer type which implements the buffer protocol, e.g:
+ * numpy.asarray(buffer) gives a read-only array of shape (height, width, components) over the image memory.
+ * Row 0 is the bottom row of the image.
+ **/
+class ImageBuffer
+{
+public:
+
+    ImageBuffer(const boost::shared_ptr<Natron::Image>& image,
+                const RectI& window);
+
+    ~ImageBuffer();
+
+    ///The window in pixel coordinates, at the scale of the image
+    const RectI& getWindow() const
+    {
+        return _window;
+    }
+
+    const boost::shared_ptr<Natron::Image>& getImage() const
+    {
+        return _image;
+    }
+
+    int getComponentsCount() const;
+
+    ///Size of a component in bytes: 1, 2 or 4 for 8 bit, 16 bit and 32 bit float images
+    int getBytesPerComponent() const;
+
+    ///The struct module format of a component: "B", "H" or "f"
+    const char* getFormat() const;
+
+    /**
+     * @brief Returns the first component of the bottom left pixel of the window. The strides are in bytes,
+     * they depend on the layout of the image in the cache.
+     **/
+    const unsigned char* getData(std::ptrdiff_t* rowStride,
+                                 std::ptrdiff_t* pixelStride,
+                                 std::ptrdiff_t* componentStride) const;
+
+private:
+
+    boost::shared_ptr<Natron::Image> _image;
+    RectI _window;
+};
+
+/**
+ * @brief Returns a new reference to a NatronEngine.ImageBuffer which takes ownership of the given buffer.
+ * Must be called with the GIL held.
+ **/
+PyObject* ImageBuffer_toPython(ImageBuffer* buffer);
+
+/**
+ * @brief Adds the NatronEngine.ImageBuffer type to the given module, called when NatronEngine is initialized.
+ **/
+bool ImageBuffer_addToModule(PyObject* module);
+
+#endif // IMAGEBUFFERWRAPPER_H
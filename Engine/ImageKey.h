@@ -48,6 +48,11 @@ public:
         return _nodeHashKey;
     }
 
+    bool isFrameVaryingOrAnimated() const
+    {
+        return _frameVaryingOrAnimated;
+    }
+
     bool operator==(const ImageKey & other) const;
 
     SequenceTime getTime() const
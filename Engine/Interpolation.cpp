@@ -326,39 +326,35 @@ Natron::solveQuartic(double c0,
 } // solveQuartic
 
 /**
- * @brief Interpolates using the control points P0(t0,v0) , P3(t3,v3)
- * and the derivatives P1(t1,v1) (being the derivative at P0 with respect to
- * t \in [t1,t2]) and P2(t2,v2) (being the derivative at P3 with respect to
- * t \in [t1,t2]) the value at 'currentTime' using the
- * interpolation method "interp".
- * Note that for CATMULL-ROM you must use the function interpolate_catmullRom
- * which will compute the derivatives for you.
+ * @brief Computes the cubic coefficients of the segment [tcur,tnext], with respect to x \in [0,1].
+ * tcur and tnext are modified for the virtual keyframes before the first / after the last keyframe.
  **/
-double
-Natron::interpolate(double tcur,
-                    const double vcur,                     //start control point
-                    const double vcurDerivRight,        //being the derivative dv/dt at tcur
-                    const double vnextDerivLeft,        //being the derivative dv/dt at tnext
-                    double tnext,
-                    const double vnext,                      //end control point
-                    double currentTime,
-                    Natron::KeyframeTypeEnum interp,
-                    Natron::KeyframeTypeEnum interpNext)
+static void
+segmentCubicCoeffs(double *tcur,
+                   const double vcur,                     //start control point
+                   const double vcurDerivRight,        //being the derivative dv/dt at tcur
+                   const double vnextDerivLeft,        //being the derivative dv/dt at tnext
+                   double *tnext,
+                   const double vnext,                      //end control point
+                   Natron::KeyframeTypeEnum interp,
+                   Natron::KeyframeTypeEnum interpNext,
+                   double *c0,
+                   double *c1,
+                   double *c2,
+                   double *c3)
 {
     double P0 = vcur;
     double P3 = vnext;
     // Hermite coefficients P0' and P3' are the derivatives with respect to x \in [0,1]
-    double P0pr = vcurDerivRight * (tnext - tcur); // normalize for x \in [0,1]
-    double P3pl = vnextDerivLeft * (tnext - tcur); // normalize for x \in [0,1]
+    double P0pr = vcurDerivRight * (*tnext - *tcur); // normalize for x \in [0,1]
+    double P3pl = vnextDerivLeft * (*tnext - *tcur); // normalize for x \in [0,1]
 
-    // if the following is true, this makes the special case for eKeyframeTypeConstant at tnext useless, and we can always use a cubic - the strict "currentTime < tnext" is the key
-    assert( ( (interp == eKeyframeTypeNone) || (tcur <= currentTime) ) && ( (currentTime < tnext) || (interpNext == eKeyframeTypeNone) ) );
     // after the last / before the first keyframe, derivatives are wrt currentTime (i.e. non-normalized)
     if (interp == eKeyframeTypeNone) {
         // virtual previous frame at t-1
         P0 = P3 - P3pl;
         P0pr = P3pl;
-        tcur = tnext - 1.;
+        *tcur = *tnext - 1.;
     } else if (interp == eKeyframeTypeConstant) {
         P0pr = 0.;
         P3pl = 0.;
@@ -368,10 +364,35 @@ Natron::interpolate(double tcur,
         // virtual next frame at t+1
         P3pl = P0pr;
         P3 = P0 + P0pr;
-        tnext = tcur + 1;
+        *tnext = *tcur + 1;
     }
+    hermiteToCubicCoeffs(P0, P0pr, P3pl, P3, c0, c1, c2, c3);
+}
+
+/**
+ * @brief Interpolates using the control points P0(t0,v0) , P3(t3,v3)
+ * and the derivatives P1(t1,v1) (being the derivative at P0 with respect to
+ * t \in [t1,t2]) and P2(t2,v2) (being the derivative at P3 with respect to
+ * t \in [t1,t2]) the value at 'currentTime' using the
+ * interpolation method "interp".
+ * Note that for CATMULL-ROM you must use the function interpolate_catmullRom
+ * which will compute the derivatives for you.
+ **/
+double
+Natron::interpolate(double tcur,
+                    const double vcur,                     //start control point
+                    const double vcurDerivRight,        //being the derivative dv/dt at tcur
+                    const double vnextDerivLeft,        //being the derivative dv/dt at tnext
+                    double tnext,
+                    const double vnext,                      //end control point
+                    double currentTime,
+                    Natron::KeyframeTypeEnum interp,
+                    Natron::KeyframeTypeEnum interpNext)
+{
+    // if the following is true, this makes the special case for eKeyframeTypeConstant at tnext useless, and we can always use a cubic - the strict "currentTime < tnext" is the key
+    assert( ( (interp == eKeyframeTypeNone) || (tcur <= currentTime) ) && ( (currentTime < tnext) || (interpNext == eKeyframeTypeNone) ) );
     double c0, c1, c2, c3;
-    hermiteToCubicCoeffs(P0, P0pr, P3pl, P3, &c0, &c1, &c2, &c3);
+    segmentCubicCoeffs(&tcur, vcur, vcurDerivRight, vnextDerivLeft, &tnext, vnext, interp, interpNext, &c0, &c1, &c2, &c3);
 
     const double t = (currentTime - tcur) / (tnext - tcur);
     double ret = cubicEval(c0, c1, c2, c3, t);
@@ -382,6 +403,37 @@ Natron::interpolate(double tcur,
     return ret;
 }
 
+void
+Natron::interpolate_array(double tcur,
+                          const double vcur,                     //start control point
+                          const double vcurDerivRight,        //being the derivative dv/dt at tcur
+                          const double vnextDerivLeft,        //being the derivative dv/dt at tnext
+                          double tnext,
+                          const double vnext,                      //end control point
+                          const double* times,
+                          int count,
+                          Natron::KeyframeTypeEnum interp,
+                          Natron::KeyframeTypeEnum interpNext,
+                          double* values)
+{
+    if (count <= 0) {
+        return;
+    }
+    assert( ( (interp == eKeyframeTypeNone) || (tcur <= times[0]) ) && ( (times[count - 1] < tnext) || (interpNext == eKeyframeTypeNone) ) );
+    double c0, c1, c2, c3;
+    segmentCubicCoeffs(&tcur, vcur, vcurDerivRight, vnextDerivLeft, &tnext, vnext, interp, interpNext, &c0, &c1, &c2, &c3);
+
+    // the loop has no branch and no dependency between iterations, so that the compiler vectorizes it.
+    // It computes exactly what cubicEval() computes, so that the results are the same as interpolate().
+    const double dt = tnext - tcur;
+    for (int i = 0; i < count; ++i) {
+        const double t = (times[i] - tcur) / dt;
+        const double t2 = t * t;
+        const double t3 = t2 * t;
+        values[i] = c0 + c1 * t + c2 * t2 + c3 * t3;
+    }
+}
+
 /// derive at currentTime. The derivative is with respect to currentTime
 double
 Natron::derive(double tcur,
@@ -33,6 +33,21 @@ double interpolate(double tcur, const double vcur, //start control point
                    KeyframeTypeEnum interp,
                    KeyframeTypeEnum interpNext) WARN_UNUSED_RETURN;
 
+/**
+ * @brief Same as interpolate() for the 'count' times in 'times', which must all be in the same segment
+ * [tcur,tnext[ (or before the first / after the last keyframe), and stores the results in 'values'.
+ * The cubic is computed once for the whole segment.
+ **/
+void interpolate_array(double tcur, const double vcur, //start control point
+                       const double vcurDerivRight, //being the derivative dv/dt at tcur
+                       const double vnextDerivLeft, //being the derivative dv/dt at tnext
+                       double tnext, const double vnext, //end control point
+                       const double* times,
+                       int count,
+                       KeyframeTypeEnum interp,
+                       KeyframeTypeEnum interpNext,
+                       double* values);
+
 /// derive at currentTime. The derivative is with respect to currentTime
 double derive(double tcur, const double vcur, //start control point
               const double vcurDerivRight, //being the derivative dv/dt at tcur
@@ -87,6 +87,17 @@ KnobSignalSlotHandler::onMasterKeyFrameSet(SequenceTime time,int dimension,int r
     Q_EMIT keyFrameSet(time, dimension, reason, added);
 }
 
+void
+KnobSignalSlotHandler::onMasterMultipleKeyFramesSet(std::list<SequenceTime> times,int dimension,int reason)
+{
+    KnobSignalSlotHandler* handler = qobject_cast<KnobSignalSlotHandler*>( sender() );
+    assert(handler);
+    boost::shared_ptr<KnobI> master = handler->getKnob();
+    
+    k->clone(master.get(), dimension);
+    Q_EMIT multipleKeyFramesSet(times, dimension, reason);
+}
+
 void
 KnobSignalSlotHandler::onMasterKeyFrameRemoved(SequenceTime time,int dimension,int reason)
 {
@@ -1968,6 +1979,8 @@ KnobHelper::slaveTo(int dimension,
         QObject::connect( helper->_signalSlotHandler.get(), SIGNAL( updateSlaves(int) ), _signalSlotHandler.get(), SLOT( onMasterChanged(int) ) );
         QObject::connect( helper->_signalSlotHandler.get(), SIGNAL( keyFrameSet(SequenceTime,int,int,bool) ),
                          _signalSlotHandler.get(), SLOT( onMasterKeyFrameSet(SequenceTime,int,int,bool) ) );
+        QObject::connect( helper->_signalSlotHandler.get(), SIGNAL( multipleKeyFramesSet(std::list<SequenceTime>,int,int) ),
+                         _signalSlotHandler.get(), SLOT( onMasterMultipleKeyFramesSet(std::list<SequenceTime>,int,int) ) );
         QObject::connect( helper->_signalSlotHandler.get(), SIGNAL( keyFrameRemoved(SequenceTime,int,int) ),
                          _signalSlotHandler.get(), SLOT( onMasterKeyFrameRemoved(SequenceTime,int,int)) );
         
@@ -2383,6 +2396,7 @@ struct KnobHolder::KnobHolderPrivate
     
     QMutex knobsMutex;
     std::vector< boost::shared_ptr<KnobI> > knobs;
+    U64 knobsVersion; //< protected by knobsMutex
     bool knobsInitialized;
     bool isSlave;
     
@@ -2443,6 +2457,7 @@ struct KnobHolder::KnobHolderPrivate
     : app(appInstance_)
     , knobsMutex()
     , knobs()
+    , knobsVersion(0)
     , knobsInitialized(false)
     , isSlave(false)
     , actionsRecursionLevel()
@@ -2495,6 +2510,7 @@ KnobHolder::addKnob(boost::shared_ptr<KnobI> k)
     assert(QThread::currentThread() == qApp->thread());
     QMutexLocker kk(&_imp->knobsMutex);
     _imp->knobs.push_back(k);
+    ++_imp->knobsVersion;
 }
 
 void
@@ -2512,6 +2528,7 @@ KnobHolder::insertKnob(int index, const boost::shared_ptr<KnobI>& k)
         std::advance(it, index);
         _imp->knobs.insert(it, k);
     }
+    ++_imp->knobsVersion;
 }
 
 void
@@ -2557,6 +2574,7 @@ KnobHolder::removeDynamicKnob(KnobI* knob)
         for (std::vector<boost::shared_ptr<KnobI> >::iterator it2 = _imp->knobs.begin(); it2 != _imp->knobs.end(); ++it2) {
             if (it2->get() == knob && (*it2)->isDynamicallyCreated()) {
                 _imp->knobs.erase(it2);
+                ++_imp->knobsVersion;
                 return;
             }
         }
@@ -3056,6 +3074,13 @@ KnobHolder::getKnobs_mt_safe() const
     return _imp->knobs;
 }
 
+U64
+KnobHolder::getKnobsVersion() const
+{
+    QMutexLocker k(&_imp->knobsMutex);
+    return _imp->knobsVersion;
+}
+
 void
 KnobHolder::slaveAllKnobs(KnobHolder* other)
 {
@@ -3168,7 +3193,12 @@ KnobHolder::evaluate_public(KnobI* knob,
         ///Don't trigger autosaves for buttons
         Button_Knob* isButton = dynamic_cast<Button_Knob*>(knob);
         if (!isButton) {
-            getApp()->triggerAutoSave();
+            Natron::EffectInstance* isEffect = dynamic_cast<Natron::EffectInstance*>(this);
+            if (isEffect) {
+                getApp()->triggerAutoSave( isEffect->getNode() );
+            } else {
+                getApp()->triggerAutoSave();
+            }
         }
     }
     
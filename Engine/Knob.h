@@ -17,6 +17,7 @@
 #include <Python.h>
 
 #include <vector>
+#include <list>
 #include <string>
 #include <set>
 #include <map>
@@ -38,6 +39,7 @@ class KnobHolder;
 class AppInstance;
 class KnobSerialization;
 class StringAnimationManager;
+class KnobValuesSnapshot;
 
 namespace Natron {
 class OfxParamOverlayInteract;
@@ -91,6 +93,13 @@ public:
         Q_EMIT keyFrameSet(time,dimension,reason,added);
     }
     
+    void s_multipleKeyFramesSet(const std::list<SequenceTime> & times,
+                                int dimension,
+                                int reason)
+    {
+        Q_EMIT multipleKeyFramesSet(times,dimension,reason);
+    }
+    
     void s_keyFrameRemoved(SequenceTime time,
                            int dimension,
                            int reason)
@@ -201,6 +210,8 @@ public Q_SLOTS:
 
     void onMasterKeyFrameSet(SequenceTime time,int dimension,int reason,bool added);
     
+    void onMasterMultipleKeyFramesSet(std::list<SequenceTime> times,int dimension,int reason);
+    
     void onMasterKeyFrameRemoved(SequenceTime time,int dimension,int reason);
     
     void onMasterKeyFrameMoved(int dimension,int oldTime,int newTime);
@@ -233,6 +244,9 @@ Q_SIGNALS:
     ///@param added True if this is the first time that the keyframe was set
     void keyFrameSet(SequenceTime time,int dimension,int reason,bool added);
     
+    ///Emitted instead of keyFrameSet when several keyframes are set at once, with the times of the keyframes that were added
+    void multipleKeyFramesSet(std::list<SequenceTime> times,int dimension,int reason);
+    
     
     ///Emitted whenever a keyframe is removed with a reason different of eValueChangedReasonUserEdited
     void keyFrameRemoved(SequenceTime,int dimension,int reason);
@@ -1303,6 +1317,12 @@ private:
      * @returns True if a keyframe was successfully added, false otherwise.
      **/
     bool setValueAtTime(int time,const T & v,int dimension,Natron::ValueChangedReasonEnum reason,KeyFrame* newKey) WARN_UNUSED_RETURN;
+    
+    /**
+     * @brief Reads the value from the snapshot taken by the holder when the current frame render started, if any.
+     * If useCurrentTime is true, the time parameter is ignored and the current time of the holder is used instead.
+     **/
+    bool getValueFromRenderSnapshot(bool useCurrentTime,double time,int dimension,bool clamp,T* value) const WARN_UNUSED_RETURN;
 
 public:
 
@@ -1348,6 +1368,18 @@ public:
      **/
     void setValueAtTime(int time,const T & v,int dimension);
     
+    /**
+     * @brief Sets a keyframe with the corresponding value at each of the given times in one go: the curve is locked and its
+     * derivatives are refreshed once and the change is evaluated once, instead of once per keyframe with setValueAtTime.
+     **/
+    void setValuesAtTimes(const std::vector<int> & times,const std::vector<T> & values,int dimension,Natron::ValueChangedReasonEnum reason);
+    
+    /**
+     * @brief Same as calling getValueAtTime for each time, but the curve is locked once for all the times.
+     * The times may be in any order and contain duplicates, values[i] is the value at times[i].
+     **/
+    void getValuesAtTimes(const std::vector<int> & times,int dimension,std::vector<T>* values) const;
+    
     /**
      * @brief Calls setValueAtTime with a reason of Natron::eValueChangedReasonPluginEdited.
      **/
@@ -1671,6 +1703,12 @@ public:
     const std::vector< boost::shared_ptr<KnobI> > & getKnobs() const WARN_UNUSED_RETURN;
     
     std::vector< boost::shared_ptr<KnobI> >  getKnobs_mt_safe() const WARN_UNUSED_RETURN;
+    
+    /**
+     * @brief Incremented each time a knob is added to or removed from the holder, so that lists derived
+     * from the knobs can be cached until the knobs change.
+     **/
+    U64 getKnobsVersion() const WARN_UNUSED_RETURN;
 
     void onGuiFrozenChange(bool frozen);
     
@@ -1922,6 +1960,13 @@ public:
         return 0;
     }
     
+    /**
+     * @brief Returns the values of the knobs captured for the frame being rendered by the calling thread, if any.
+     **/
+    virtual const KnobValuesSnapshot* getRenderKnobValuesSnapshot() const {
+        return NULL;
+    }
+    
 protected:
 
 
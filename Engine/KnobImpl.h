@@ -18,9 +18,11 @@
 
 #include "Knob.h"
 
+#include <algorithm>
 #include <cfloat>
 #include <stdexcept>
 #include <string>
+#include <utility>
 
 #if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
 #include <boost/math/special_functions/fpclassify.hpp>
@@ -42,6 +44,7 @@ GCC_DIAG_ON(unused-parameter)
 #include "Engine/TimeLine.h"
 #include "Engine/EffectInstance.h"
 #include "Engine/KnobTypes.h"
+#include "Engine/KnobValuesSnapshot.h"
 
 
 ///template specializations
@@ -347,6 +350,41 @@ T Knob<T>::evaluateExpression(int dimension) const
     return val;
 }
 
+template <>
+bool
+Knob<std::string>::getValueFromRenderSnapshot(bool /*useCurrentTime*/,double /*time*/,int /*dimension*/,bool /*clamp*/,std::string* /*value*/) const
+{
+    ///Strings are not captured in the snapshots
+    return false;
+}
+
+template <typename T>
+bool
+Knob<T>::getValueFromRenderSnapshot(bool useCurrentTime,
+                                    double time,
+                                    int dimension,
+                                    bool clamp,
+                                    T* value) const
+{
+    KnobHolder* holder = getHolder();
+    if (!holder) {
+        return false;
+    }
+    const KnobValuesSnapshot* snapshot = holder->getRenderKnobValuesSnapshot();
+    if (!snapshot) {
+        return false;
+    }
+    if (useCurrentTime) {
+        time = getCurrentTime();
+    }
+    double v;
+    if ( !snapshot->getValue(this, time, dimension, clamp, &v) ) {
+        return false;
+    }
+    *value = (T)v;
+    return true;
+}
+
 //Declare the specialization before defining it to avoid the following
 //error: explicit specialization of 'getValueAtTime' after instantiation
 template<>
@@ -416,6 +454,11 @@ template <typename T>
 T
 Knob<T>::getValue(int dimension,bool clamp) const
 {
+    T snapshotValue;
+    if ( getValueFromRenderSnapshot(true, 0, dimension, clamp, &snapshotValue) ) {
+        return snapshotValue;
+    }
+    
     std::string hasExpr = getExpression(dimension);
     if (!hasExpr.empty()) {
         
@@ -565,6 +608,11 @@ Knob<T>::getValueAtTime(double time,
         throw std::invalid_argument("Knob::getValueAtTime(): Dimension out of range");
     }
     
+    T snapshotValue;
+    if ( !byPassMaster && getValueFromRenderSnapshot(false, time, dimension, clamp, &snapshotValue) ) {
+        return snapshotValue;
+    }
+    
     std::string hasExpr = getExpression(dimension);
     if (!hasExpr.empty()) {
         
@@ -1040,6 +1088,8 @@ Knob<T>::unSlave(int dimension,
                              SLOT( onMasterChanged(int) ) );
         QObject::disconnect( helper->getSignalSlotHandler().get(), SIGNAL( keyFrameSet(SequenceTime,int,int,bool) ),
                          _signalSlotHandler.get(), SLOT( onMasterKeyFrameSet(SequenceTime,int,int,bool) ) );
+        QObject::disconnect( helper->getSignalSlotHandler().get(), SIGNAL( multipleKeyFramesSet(std::list<SequenceTime>,int,int) ),
+                         _signalSlotHandler.get(), SLOT( onMasterMultipleKeyFramesSet(std::list<SequenceTime>,int,int) ) );
         QObject::disconnect( helper->getSignalSlotHandler().get(), SIGNAL( keyFrameRemoved(SequenceTime,int,int) ),
                          _signalSlotHandler.get(), SLOT( onMasterKeyFrameRemoved(SequenceTime,int,int)) );
         
@@ -1105,6 +1155,10 @@ Knob<std::string>::unSlave(int dimension,
                             SIGNAL( keyFrameSet(SequenceTime,int,int,bool) ),
                             _signalSlotHandler.get(),
                             SLOT( onMasterKeyFrameSet(SequenceTime,int,int,bool) ) );
+        QObject::disconnect( helper->getSignalSlotHandler().get(),
+                            SIGNAL( multipleKeyFramesSet(std::list<SequenceTime>,int,int) ),
+                            _signalSlotHandler.get(),
+                            SLOT( onMasterMultipleKeyFramesSet(std::list<SequenceTime>,int,int) ) );
         QObject::disconnect( helper->getSignalSlotHandler().get(),
                             SIGNAL( keyFrameRemoved(SequenceTime,int,int) ),
                             _signalSlotHandler.get(),
@@ -1178,6 +1232,114 @@ Knob<T>::setValueAtTime(int time,
     ignore_result(setValueAtTime(time,v,dimension,Natron::eValueChangedReasonNatronInternalEdited,&k));
 }
 
+template<typename T>
+void
+Knob<T>::setValuesAtTimes(const std::vector<int> & times,
+                          const std::vector<T> & values,
+                          int dimension,
+                          Natron::ValueChangedReasonEnum reason)
+{
+    if ( ( dimension >= getDimension() ) || (dimension < 0) ) {
+        throw std::invalid_argument("Knob::setValuesAtTimes(): Dimension out of range");
+    }
+    if ( times.size() != values.size() ) {
+        throw std::invalid_argument("Knob::setValuesAtTimes(): there must be as many values as times");
+    }
+    if ( times.empty() ) {
+        return;
+    }
+
+    Natron::EffectInstance* holder = dynamic_cast<Natron::EffectInstance*>( getHolder() );
+    if ( holder && ( !holder->canSetValue() || ( (reason == Natron::eValueChangedReasonPluginEdited) && getKnobGuiPointer() ) ) ) {
+        ///The values must be queued or go through the undo stack, which is done key by key
+        for (U32 i = 0; i < times.size(); ++i) {
+            KeyFrame k;
+            ignore_result( setValueAtTime(times[i], values[i], dimension, reason, &k) );
+        }
+
+        return;
+    }
+
+    ///There might be stuff in the queue that must be processed first
+    dequeueValuesSet(true);
+
+    boost::shared_ptr<Curve> curve = getCurve(dimension,true);
+    assert(curve);
+    std::vector<KeyFrame> keys( times.size() );
+    for (U32 i = 0; i < times.size(); ++i) {
+        makeKeyFrame(curve.get(), times[i], values[i], &keys[i]);
+    }
+    std::list<double> addedTimes;
+    curve->addKeyFrames(keys, &addedTimes);
+    if (holder) {
+        holder->setHasAnimation(true);
+    }
+    guiCurveCloneInternalCurve(dimension);
+
+    if ( _signalSlotHandler && !addedTimes.empty() ) {
+        std::list<SequenceTime> added;
+        for (std::list<double>::iterator it = addedTimes.begin(); it != addedTimes.end(); ++it) {
+            added.push_back( (SequenceTime)*it );
+        }
+        _signalSlotHandler->s_multipleKeyFramesSet(added,dimension,(int)reason);
+    }
+    evaluateValueChange(dimension, reason);
+}
+
+template<typename T>
+void
+Knob<T>::getValuesAtTimes(const std::vector<int> & times,
+                          int dimension,
+                          std::vector<T>* values) const
+{
+    values->resize( times.size() );
+    if ( times.empty() ) {
+        return;
+    }
+
+    boost::shared_ptr<Curve> curve = getCurve(dimension);
+    T snapshotValue;
+    if ( !curve || (curve->getKeyFramesCount() == 0) || !getExpression(dimension).empty() || getMaster(dimension).second ||
+         getValueFromRenderSnapshot(false, times[0], dimension, true, &snapshotValue) ) {
+        for (U32 i = 0; i < times.size(); ++i) {
+            (*values)[i] = getValueAtTime(times[i], dimension);
+        }
+
+        return;
+    }
+
+    ///Curve::getValuesAt walks the keyframes once and needs increasing times: sort the (time, index) pairs
+    ///and scatter the values back at the index of each time, so the caller may pass any order and duplicates
+    std::vector<std::pair<int,U32> > sortedTimes( times.size() );
+    for (U32 i = 0; i < times.size(); ++i) {
+        sortedTimes[i] = std::make_pair(times[i], i);
+    }
+    std::sort( sortedTimes.begin(), sortedTimes.end() );
+
+    std::vector<double> curveTimes( times.size() );
+    for (U32 i = 0; i < sortedTimes.size(); ++i) {
+        curveTimes[i] = sortedTimes[i].first;
+    }
+    std::vector<double> curveValues( times.size() );
+    curve->getValuesAt(&curveTimes[0], (int)curveTimes.size(), &curveValues[0]);
+    for (U32 i = 0; i < curveValues.size(); ++i) {
+        (*values)[sortedTimes[i].second] = (T)curveValues[i];
+    }
+}
+
+template<>
+void
+Knob<std::string>::getValuesAtTimes(const std::vector<int> & times,
+                                    int dimension,
+                                    std::vector<std::string>* values) const
+{
+    ///Strings may have a custom interpolation
+    values->resize( times.size() );
+    for (U32 i = 0; i < times.size(); ++i) {
+        (*values)[i] = getValueAtTime(times[i], dimension);
+    }
+}
+
 template<typename T>
 void
 Knob<T>::setValueAtTimeFromPlugin(int time,const T & v,int dimension)
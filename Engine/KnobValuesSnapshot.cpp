@@ -0,0 +1,159 @@
+//  Natron
+//
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+
+#include "KnobValuesSnapshot.h"
+
+#include <algorithm>
+#include <cassert>
+
+#include "Engine/Knob.h"
+
+namespace {
+
+struct KnobEntryCompare_less
+{
+    template <typename ENTRY>
+    bool operator() (const ENTRY & lhs,
+                     const KnobI* rhs) const
+    {
+        return lhs.knob < rhs;
+    }
+
+    template <typename ENTRY>
+    bool operator() (const ENTRY & lhs,
+                     const ENTRY & rhs) const
+    {
+        return lhs.knob < rhs.knob;
+    }
+};
+
+template <typename T>
+void
+captureKnobValues(const Knob<T>* knob,
+                  int time,
+                  std::vector<double>* values,
+                  std::vector<double>* clampedValues,
+                  std::vector<bool>* captured)
+{
+    int dims = knob->getDimension();
+    for (int i = 0; i < dims; ++i) {
+        if ( !knob->getExpression(i).empty() ) {
+            values->push_back(0.);
+            clampedValues->push_back(0.);
+            captured->push_back(false);
+        } else {
+            values->push_back( (double)knob->getValueAtTime(time, i, false) );
+            clampedValues->push_back( (double)knob->getValueAtTime(time, i, true) );
+            captured->push_back(true);
+        }
+    }
+}
+
+}
+
+void
+KnobValuesSnapshot::getTypedKnobs(const KnobHolder* holder,
+                                  TypedKnobs* knobs)
+{
+    std::vector<boost::shared_ptr<KnobI> > allKnobs = holder->getKnobs_mt_safe();
+
+    knobs->clear();
+    for (U32 i = 0; i < allKnobs.size(); ++i) {
+        TypedKnob k;
+        k.knob = allKnobs[i].get();
+        k.isInt = dynamic_cast<const Knob<int>*>(k.knob);
+        k.isBool = dynamic_cast<const Knob<bool>*>(k.knob);
+        k.isDouble = dynamic_cast<const Knob<double>*>(k.knob);
+        if (k.isInt || k.isBool || k.isDouble) {
+            knobs->push_back(k);
+        }
+    }
+    std::sort( knobs->begin(), knobs->end(), KnobEntryCompare_less() );
+}
+
+KnobValuesSnapshot::KnobValuesSnapshot(const KnobHolder* holder,
+                                       int time,
+                                       U64 nodeHash)
+: _time(time)
+, _nodeHash(nodeHash)
+, _knobs()
+, _values()
+{
+    TypedKnobs knobs;
+    getTypedKnobs(holder, &knobs);
+    captureValues(knobs);
+}
+
+KnobValuesSnapshot::KnobValuesSnapshot(const TypedKnobs & knobs,
+                                       int time,
+                                       U64 nodeHash)
+: _time(time)
+, _nodeHash(nodeHash)
+, _knobs()
+, _values()
+{
+    captureValues(knobs);
+}
+
+void
+KnobValuesSnapshot::captureValues(const TypedKnobs & knobs)
+{
+    std::vector<double> values,clampedValues;
+    std::vector<bool> captured;
+    _knobs.reserve( knobs.size() );
+    for (U32 i = 0; i < knobs.size(); ++i) {
+        const TypedKnob & k = knobs[i];
+
+        KnobEntry e;
+        e.knob = k.knob;
+        e.firstDimension = (int)values.size();
+        if (k.isInt) {
+            captureKnobValues(k.isInt, _time, &values, &clampedValues, &captured);
+        } else if (k.isBool) {
+            captureKnobValues(k.isBool, _time, &values, &clampedValues, &captured);
+        } else {
+            assert(k.isDouble);
+            captureKnobValues(k.isDouble, _time, &values, &clampedValues, &captured);
+        }
+        e.nDims = (int)values.size() - e.firstDimension;
+        ///The typed knobs are sorted, so are the entries
+        _knobs.push_back(e);
+    }
+
+    _values.resize( values.size() );
+    for (U32 i = 0; i < values.size(); ++i) {
+        _values[i].value = values[i];
+        _values[i].clampedValue = clampedValues[i];
+        _values[i].captured = captured[i];
+    }
+}
+
+bool
+KnobValuesSnapshot::getValue(const KnobI* knob,
+                             double time,
+                             int dimension,
+                             bool clamp,
+                             double* value) const
+{
+    if (time != _time) {
+        return false;
+    }
+    std::vector<KnobEntry>::const_iterator found = std::lower_bound( _knobs.begin(), _knobs.end(), knob, KnobEntryCompare_less() );
+    if ( (found == _knobs.end()) || (found->knob != knob) || (dimension < 0) || (dimension >= found->nDims) ) {
+        return false;
+    }
+    const DimensionValue & v = _values[found->firstDimension + dimension];
+    if (!v.captured) {
+        return false;
+    }
+    *value = clamp ? v.clampedValue : v.value;
+
+    return true;
+}
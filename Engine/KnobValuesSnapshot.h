@@ -0,0 +1,119 @@
+//  Natron
+//
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef NATRON_ENGINE_KNOBVALUESSNAPSHOT_H_
+#define NATRON_ENGINE_KNOBVALUESSNAPSHOT_H_
+
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+
+#include <vector>
+
+#include "Global/Macros.h"
+#if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
+#include <boost/noncopyable.hpp>
+#endif
+#include "Global/GlobalDefines.h"
+
+class KnobI;
+class KnobHolder;
+template <typename T>
+class Knob;
+
+/**
+ * @brief The values of all the int, bool and double knobs of a holder at a given time, resolved
+ * once (through animation curves and masters) when a frame render starts.
+ *
+ * The snapshot is immutable once built, so render threads read it without any lock nor allocation:
+ * see Knob<T>::getValue and Knob<T>::getValueAtTime which use the snapshot of the holder whenever
+ * the requested time is the snapshot time. Dimensions driven by an expression are not captured since
+ * their value may depend on the thread-local render time, they keep going through the knob.
+ **/
+class KnobValuesSnapshot
+    : boost::noncopyable
+{
+    struct DimensionValue
+    {
+        double value;
+        double clampedValue;
+        bool captured;
+    };
+
+    struct KnobEntry
+    {
+        const KnobI* knob;
+        int firstDimension; //< index in _values
+        int nDims;
+    };
+
+public:
+
+    struct TypedKnob
+    {
+        const KnobI* knob;
+        const Knob<int>* isInt;
+        const Knob<bool>* isBool;
+        const Knob<double>* isDouble;
+    };
+
+    ///The knobs captured in a snapshot, sorted by knob pointer
+    typedef std::vector<TypedKnob> TypedKnobs;
+
+    /**
+     * @brief Returns the int, bool and double knobs of the holder. Finding them takes a dynamic_cast per knob:
+     * the list should be kept until the knobs of the holder change (see KnobHolder::getKnobsVersion()).
+     **/
+    static void getTypedKnobs(const KnobHolder* holder,TypedKnobs* knobs);
+
+    /**
+     * @brief Resolves the values of the knobs of the holder at the given time.
+     * The knobs must not be read through the snapshot being built.
+     **/
+    KnobValuesSnapshot(const KnobHolder* holder,
+                       int time,
+                       U64 nodeHash);
+
+    /**
+     * @brief Same as above with the knobs returned by getTypedKnobs().
+     **/
+    KnobValuesSnapshot(const TypedKnobs & knobs,
+                       int time,
+                       U64 nodeHash);
+
+    int getTime() const
+    {
+        return _time;
+    }
+
+    U64 getNodeHash() const
+    {
+        return _nodeHash;
+    }
+
+    /**
+     * @brief Returns true and the value of the given dimension of the knob if it was captured
+     * in the snapshot and the time matches the snapshot time.
+     **/
+    bool getValue(const KnobI* knob,
+                  double time,
+                  int dimension,
+                  bool clamp,
+                  double* value) const;
+
+private:
+
+    void captureValues(const TypedKnobs & knobs);
+
+    int _time;
+    U64 _nodeHash;
+
+    ///Sorted by knob pointer so lookups are a binary search
+    std::vector<KnobEntry> _knobs;
+    std::vector<DimensionValue> _values;
+};
+
+#endif // NATRON_ENGINE_KNOBVALUESSNAPSHOT_H_
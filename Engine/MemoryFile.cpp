@@ -28,8 +28,12 @@
 #include <cstring>
 #include <cerrno>
 #include <cstdio>
+#ifndef MAP_ANONYMOUS
+#define MAP_ANONYMOUS MAP_ANON // OS X < 10.11
+#endif
 #endif
 #include <iostream>
+#include <new>
 #include <stdexcept>
 
 #include "Global/Macros.h"
@@ -176,6 +180,8 @@ MemoryFilePrivate::openInternal(MemoryFile::FileOpenModeEnum open_mode)
             throw std::runtime_error(str);
         } else {
             size = sbuf.st_size;
+            ///Existing files are mapped to be read back, mostly from start to end
+            ::madvise(data, size, MADV_SEQUENTIAL);
         }
     }
 #elif defined(__NATRON_WIN32__)
@@ -320,6 +326,11 @@ MemoryFilePrivate::closeMapping()
         str.append( std::strerror(errno) );
         throw std::runtime_error(str);
     }
+#if defined(POSIX_FADV_DONTNEED)
+    ///The file is closed when its entry leaves the memory portion of the cache: drop its pages from the
+    ///system cache as well (this also starts writing back those that are still dirty)
+    ::posix_fadvise(file_handle, 0, 0, POSIX_FADV_DONTNEED);
+#endif
     ::close(file_handle);
 #elif defined(__NATRON_WIN32__)
     if (::UnmapViewOfFile(data) == 0) {
@@ -369,3 +380,59 @@ MemoryFile::remove()
     }
 }
 
+void*
+Natron::allocateLazilyCommittedMemory(std::size_t size)
+{
+    if (size == 0) {
+        return 0;
+    }
+#if defined(__NATRON_UNIX__)
+    ///Anonymous mappings are backed by the zero page until written to
+    void* ret = ::mmap(0, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ret == MAP_FAILED) {
+        throw std::bad_alloc();
+    }
+#elif defined(__NATRON_WIN32__)
+    ///Committed pages are not given physical memory before they are accessed
+    void* ret = ::VirtualAlloc(0, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    if (!ret) {
+        throw std::bad_alloc();
+    }
+#endif
+
+    return ret;
+}
+
+void
+Natron::freeLazilyCommittedMemory(void* data,
+                                  std::size_t size)
+{
+    if (!data) {
+        return;
+    }
+#if defined(__NATRON_UNIX__)
+    ::munmap(data, size);
+#elif defined(__NATRON_WIN32__)
+    (void)size;
+    ::VirtualFree(data, 0, MEM_RELEASE);
+#endif
+}
+
+std::size_t
+Natron::getMemoryPageSize()
+{
+    static std::size_t pageSize = 0;
+
+    if (pageSize == 0) {
+#if defined(__NATRON_UNIX__)
+        long sz = ::sysconf(_SC_PAGESIZE);
+        pageSize = sz > 0 ? (std::size_t)sz : MIN_FILE_SIZE;
+#elif defined(__NATRON_WIN32__)
+        SYSTEM_INFO info;
+        ::GetSystemInfo(&info);
+        pageSize = info.dwPageSize;
+#endif
+    }
+
+    return pageSize;
+}
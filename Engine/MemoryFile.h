@@ -16,6 +16,7 @@
 // "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
 #include <Python.h>
 
+#include <cstddef>
 #include <string>
 
 #include "Global/GlobalDefines.h"
@@ -139,5 +140,24 @@ private:
     MemoryFilePrivate* _imp;
 };
 
+namespace Natron {
+/**
+ * @brief Allocates size bytes of zero-initialized memory directly from the system. The pages are only
+ * committed when they are first written to: a large buffer of which only a part is ever written only
+ * uses the memory of that part.
+ * This function throws a std::bad_alloc if the allocation fails.
+ **/
+void* allocateLazilyCommittedMemory(std::size_t size);
+
+/**
+ * @brief Frees memory allocated with allocateLazilyCommittedMemory(size).
+ **/
+void freeLazilyCommittedMemory(void* data,std::size_t size);
+
+/**
+ * @brief The granularity at which the system commits memory.
+ **/
+std::size_t getMemoryPageSize();
+}
 
 #endif /* defined(NATRON_ENGINE_MEMORYFILE_H_) */
@@ -16,6 +16,7 @@ GCC_DIAG_OFF(missing-field-initializers)
 
 // Extra includes
 #include <ParameterWrapper.h>
+#include <PySequenceConversion.h>
 
 
 // Native ---------------------------------------------------------
@@ -637,6 +638,95 @@ static PyObject* Sbk_ColorParamFunc_getValueAtTime(PyObject* self, PyObject* arg
         return 0;
 }
 
+static PyObject* Sbk_ColorParamFunc_getValuesAtTimes(PyObject* self, PyObject* args, PyObject* kwds)
+{
+    ColorParamWrapper* cppSelf = 0;
+    SBK_UNUSED(cppSelf)
+    if (!Shiboken::Object::isValid(self))
+        return 0;
+    cppSelf = (ColorParamWrapper*)((::ColorParam*)Shiboken::Conversions::cppPointer(SbkNatronEngineTypes[SBK_COLORPARAM_IDX], (SbkObject*)self));
+    PyObject* pyResult = 0;
+    int overloadId = -1;
+    PythonToCppFunc pythonToCpp[] = { 0, 0 };
+    SBK_UNUSED(pythonToCpp)
+    int numNamedArgs = (kwds ? PyDict_Size(kwds) : 0);
+    int numArgs = PyTuple_GET_SIZE(args);
+    PyObject* pyArgs[] = {0, 0};
+
+    // invalid argument lengths
+    if (numArgs + numNamedArgs > 2) {
+        PyErr_SetString(PyExc_TypeError, "NatronEngine.ColorParam.getValuesAtTimes(): too many arguments");
+        return 0;
+    } else if (numArgs < 1) {
+        PyErr_SetString(PyExc_TypeError, "NatronEngine.ColorParam.getValuesAtTimes(): not enough arguments");
+        return 0;
+    }
+
+    if (!PyArg_ParseTuple(args, "|OO:getValuesAtTimes", &(pyArgs[0]), &(pyArgs[1])))
+        return 0;
+
+
+    // Overloaded function decisor
+    // 0: getValuesAtTimes(std::vector<int>,int)const
+    if (numArgs >= 1
+        && true) {
+        if (numArgs == 1) {
+            overloadId = 0; // getValuesAtTimes(std::vector<int>,int)const
+        } else if ((pythonToCpp[1] = Shiboken::Conversions::isPythonToCppConvertible(Shiboken::Conversions::PrimitiveTypeConverter<int>(), (pyArgs[1])))) {
+            overloadId = 0; // getValuesAtTimes(std::vector<int>,int)const
+        }
+    }
+
+    // Function signature not found.
+    if (overloadId == -1) goto Sbk_ColorParamFunc_getValuesAtTimes_TypeError;
+
+    // Call function/method
+    {
+        if (kwds) {
+            PyObject* value = PyDict_GetItemString(kwds, "dimension");
+            if (value && pyArgs[1]) {
+                PyErr_SetString(PyExc_TypeError, "NatronEngine.ColorParam.getValuesAtTimes(): got multiple values for keyword argument 'dimension'.");
+                return 0;
+            } else if (value) {
+                pyArgs[1] = value;
+                if (!(pythonToCpp[1] = Shiboken::Conversions::isPythonToCppConvertible(Shiboken::Conversions::PrimitiveTypeConverter<int>(), (pyArgs[1]))))
+                    goto Sbk_ColorParamFunc_getValuesAtTimes_TypeError;
+            }
+        }
+        int cppArg1 = 0;
+        if (pythonToCpp[1]) pythonToCpp[1](pyArgs[1], &cppArg1);
+
+        if (!PyErr_Occurred()) {
+            // getValuesAtTimes(std::vector<int>,int)const
+            // Begin code injection
+
+            std::vector<int> times;
+            if (sequenceToVector(pyArgs[1-1], &times)) {
+                if (cppArg1 < 0 || cppArg1 >= cppSelf->getNumDimensions()) {
+                    PyErr_SetString(PyExc_IndexError, "NatronEngine.ColorParam.getValuesAtTimes(): dimension out of range");
+                } else {
+                    pyResult = vectorToList(const_cast<const ::ColorParam*>(cppSelf)->getValuesAtTimes(times,cppArg1));
+                }
+            }
+
+            // End of code injection
+
+
+        }
+    }
+
+    if (PyErr_Occurred() || !pyResult) {
+        Py_XDECREF(pyResult);
+        return 0;
+    }
+    return pyResult;
+
+    Sbk_ColorParamFunc_getValuesAtTimes_TypeError:
+        const char* overloads[] = {"PyObject, int = 0", 0};
+        Shiboken::setErrorAboutWrongArguments(args, "NatronEngine.ColorParam.getValuesAtTimes", overloads);
+        return 0;
+}
+
 static PyObject* Sbk_ColorParamFunc_restoreDefaultValue(PyObject* self, PyObject* args, PyObject* kwds)
 {
     ColorParamWrapper* cppSelf = 0;
@@ -1388,6 +1478,97 @@ static PyObject* Sbk_ColorParamFunc_setValueAtTime(PyObject* self, PyObject* arg
         return 0;
 }
 
+static PyObject* Sbk_ColorParamFunc_setValuesAtTimes(PyObject* self, PyObject* args, PyObject* kwds)
+{
+    ColorParamWrapper* cppSelf = 0;
+    SBK_UNUSED(cppSelf)
+    if (!Shiboken::Object::isValid(self))
+        return 0;
+    cppSelf = (ColorParamWrapper*)((::ColorParam*)Shiboken::Conversions::cppPointer(SbkNatronEngineTypes[SBK_COLORPARAM_IDX], (SbkObject*)self));
+    int overloadId = -1;
+    PythonToCppFunc pythonToCpp[] = { 0, 0, 0 };
+    SBK_UNUSED(pythonToCpp)
+    int numNamedArgs = (kwds ? PyDict_Size(kwds) : 0);
+    int numArgs = PyTuple_GET_SIZE(args);
+    PyObject* pyArgs[] = {0, 0, 0};
+
+    // invalid argument lengths
+    if (numArgs + numNamedArgs > 3) {
+        PyErr_SetString(PyExc_TypeError, "NatronEngine.ColorParam.setValuesAtTimes(): too many arguments");
+        return 0;
+    } else if (numArgs < 2) {
+        PyErr_SetString(PyExc_TypeError, "NatronEngine.ColorParam.setValuesAtTimes(): not enough arguments");
+        return 0;
+    }
+
+    if (!PyArg_ParseTuple(args, "|OOO:setValuesAtTimes", &(pyArgs[0]), &(pyArgs[1]), &(pyArgs[2])))
+        return 0;
+
+
+    // Overloaded function decisor
+    // 0: setValuesAtTimes(std::vector<int>,std::vector<double>,int)
+    if (numArgs >= 2
+        && true
+        && true) {
+        if (numArgs == 2) {
+            overloadId = 0; // setValuesAtTimes(std::vector<int>,std::vector<double>,int)
+        } else if ((pythonToCpp[2] = Shiboken::Conversions::isPythonToCppConvertible(Shiboken::Conversions::PrimitiveTypeConverter<int>(), (pyArgs[2])))) {
+            overloadId = 0; // setValuesAtTimes(std::vector<int>,std::vector<double>,int)
+        }
+    }
+
+    // Function signature not found.
+    if (overloadId == -1) goto Sbk_ColorParamFunc_setValuesAtTimes_TypeError;
+
+    // Call function/method
+    {
+        if (kwds) {
+            PyObject* value = PyDict_GetItemString(kwds, "dimension");
+            if (value && pyArgs[2]) {
+                PyErr_SetString(PyExc_TypeError, "NatronEngine.ColorParam.setValuesAtTimes(): got multiple values for keyword argument 'dimension'.");
+                return 0;
+            } else if (value) {
+                pyArgs[2] = value;
+                if (!(pythonToCpp[2] = Shiboken::Conversions::isPythonToCppConvertible(Shiboken::Conversions::PrimitiveTypeConverter<int>(), (pyArgs[2]))))
+                    goto Sbk_ColorParamFunc_setValuesAtTimes_TypeError;
+            }
+        }
+        int cppArg2 = 0;
+        if (pythonToCpp[2]) pythonToCpp[2](pyArgs[2], &cppArg2);
+
+        if (!PyErr_Occurred()) {
+            // setValuesAtTimes(std::vector<int>,std::vector<double>,int)
+            // Begin code injection
+
+            std::vector<int> times;
+            std::vector<double> values;
+            if (sequenceToVector(pyArgs[1-1], &times) && sequenceToVector(pyArgs[2-1], &values)) {
+                if (times.size() != values.size()) {
+                    PyErr_SetString(PyExc_ValueError, "NatronEngine.ColorParam.setValuesAtTimes(): there must be as many values as times");
+                } else if (cppArg2 < 0 || cppArg2 >= cppSelf->getNumDimensions()) {
+                    PyErr_SetString(PyExc_IndexError, "NatronEngine.ColorParam.setValuesAtTimes(): dimension out of range");
+                } else {
+                    cppSelf->setValuesAtTimes(times,values,cppArg2);
+                }
+            }
+
+            // End of code injection
+
+
+        }
+    }
+
+    if (PyErr_Occurred()) {
+        return 0;
+    }
+    Py_RETURN_NONE;
+
+    Sbk_ColorParamFunc_setValuesAtTimes_TypeError:
+        const char* overloads[] = {"PyObject, PyObject, int = 0", 0};
+        Shiboken::setErrorAboutWrongArguments(args, "NatronEngine.ColorParam.setValuesAtTimes", overloads);
+        return 0;
+}
+
 static PyMethodDef Sbk_ColorParam_methods[] = {
     {"addAsDependencyOf", (PyCFunction)Sbk_ColorParamFunc_addAsDependencyOf, METH_VARARGS},
     {"get", (PyCFunction)Sbk_ColorParamFunc_get, METH_VARARGS},
@@ -1398,6 +1579,7 @@ static PyMethodDef Sbk_ColorParam_methods[] = {
     {"getMinimum", (PyCFunction)Sbk_ColorParamFunc_getMinimum, METH_VARARGS|METH_KEYWORDS},
     {"getValue", (PyCFunction)Sbk_ColorParamFunc_getValue, METH_VARARGS|METH_KEYWORDS},
     {"getValueAtTime", (PyCFunction)Sbk_ColorParamFunc_getValueAtTime, METH_VARARGS|METH_KEYWORDS},
+    {"getValuesAtTimes", (PyCFunction)Sbk_ColorParamFunc_getValuesAtTimes, METH_VARARGS|METH_KEYWORDS},
     {"restoreDefaultValue", (PyCFunction)Sbk_ColorParamFunc_restoreDefaultValue, METH_VARARGS|METH_KEYWORDS},
     {"set", (PyCFunction)Sbk_ColorParamFunc_set, METH_VARARGS},
     {"setDefaultValue", (PyCFunction)Sbk_ColorParamFunc_setDefaultValue, METH_VARARGS|METH_KEYWORDS},
@@ -1407,6 +1589,7 @@ static PyMethodDef Sbk_ColorParam_methods[] = {
     {"setMinimum", (PyCFunction)Sbk_ColorParamFunc_setMinimum, METH_VARARGS|METH_KEYWORDS},
     {"setValue", (PyCFunction)Sbk_ColorParamFunc_setValue, METH_VARARGS|METH_KEYWORDS},
     {"setValueAtTime", (PyCFunction)Sbk_ColorParamFunc_setValueAtTime, METH_VARARGS|METH_KEYWORDS},
+    {"setValuesAtTimes", (PyCFunction)Sbk_ColorParamFunc_setValuesAtTimes, METH_VARARGS|METH_KEYWORDS},
 
     {0} // Sentinel
 };
@@ -16,6 +16,7 @@ GCC_DIAG_OFF(missing-field-initializers)
 
 // Extra includes
 #include <ParameterWrapper.h>
+#include <PySequenceConversion.h>
 
 
 // Native ---------------------------------------------------------
@@ -637,6 +638,95 @@ static PyObject* Sbk_DoubleParamFunc_getValueAtTime(PyObject* self, PyObject* ar
         return 0;
 }
 
+static PyObject* Sbk_DoubleParamFunc_getValuesAtTimes(PyObject* self, PyObject* args, PyObject* kwds)
+{
+    DoubleParamWrapper* cppSelf = 0;
+    SBK_UNUSED(cppSelf)
+    if (!Shiboken::Object::isValid(self))
+        return 0;
+    cppSelf = (DoubleParamWrapper*)((::DoubleParam*)Shiboken::Conversions::cppPointer(SbkNatronEngineTypes[SBK_DOUBLEPARAM_IDX], (SbkObject*)self));
+    PyObject* pyResult = 0;
+    int overloadId = -1;
+    PythonToCppFunc pythonToCpp[] = { 0, 0 };
+    SBK_UNUSED(pythonToCpp)
+    int numNamedArgs = (kwds ? PyDict_Size(kwds) : 0);
+    int numArgs = PyTuple_GET_SIZE(args);
+    PyObject* pyArgs[] = {0, 0};
+
+    // invalid argument lengths
+    if (numArgs + numNamedArgs > 2) {
+        PyErr_SetString(PyExc_TypeError, "NatronEngine.DoubleParam.getValuesAtTimes(): too many arguments");
+        return 0;
+    } else if (numArgs < 1) {
+        PyErr_SetString(PyExc_TypeError, "NatronEngine.DoubleParam.getValuesAtTimes(): not enough arguments");
+        return 0;
+    }
+
+    if (!PyArg_ParseTuple(args, "|OO:getValuesAtTimes", &(pyArgs[0]), &(pyArgs[1])))
+        return 0;
+
+
+    // Overloaded function decisor
+    // 0: getValuesAtTimes(std::vector<int>,int)const
+    if (numArgs >= 1
+        && true) {
+        if (numArgs == 1) {
+            overloadId = 0; // getValuesAtTimes(std::vector<int>,int)const
+        } else if ((pythonToCpp[1] = Shiboken::Conversions::isPythonToCppConvertible(Shiboken::Conversions::PrimitiveTypeConverter<int>(), (pyArgs[1])))) {
+            overloadId = 0; // getValuesAtTimes(std::vector<int>,int)const
+        }
+    }
+
+    // Function signature not found.
+    if (overloadId == -1) goto Sbk_DoubleParamFunc_getValuesAtTimes_TypeError;
+
+    // Call function/method
+    {
+        if (kwds) {
+            PyObject* value = PyDict_GetItemString(kwds, "dimension");
+            if (value && pyArgs[1]) {
+                PyErr_SetString(PyExc_TypeError, "NatronEngine.DoubleParam.getValuesAtTimes(): got multiple values for keyword argument 'dimension'.");
+                return 0;
+            } else if (value) {
+                pyArgs[1] = value;
+                if (!(pythonToCpp[1] = Shiboken::Conversions::isPythonToCppConvertible(Shiboken::Conversions::PrimitiveTypeConverter<int>(), (pyArgs[1]))))
+                    goto Sbk_DoubleParamFunc_getValuesAtTimes_TypeError;
+            }
+        }
+        int cppArg1 = 0;
+        if (pythonToCpp[1]) pythonToCpp[1](pyArgs[1], &cppArg1);
+
+        if (!PyErr_Occurred()) {
+            // getValuesAtTimes(std::vector<int>,int)const
+            // Begin code injection
+
+            std::vector<int> times;
+            if (sequenceToVector(pyArgs[1-1], &times)) {
+                if (cppArg1 < 0 || cppArg1 >= cppSelf->getNumDimensions()) {
+                    PyErr_SetString(PyExc_IndexError, "NatronEngine.DoubleParam.getValuesAtTimes(): dimension out of range");
+                } else {
+                    pyResult = vectorToList(const_cast<const ::DoubleParam*>(cppSelf)->getValuesAtTimes(times,cppArg1));
+                }
+            }
+
+            // End of code injection
+
+
+        }
+    }
+
+    if (PyErr_Occurred() || !pyResult) {
+        Py_XDECREF(pyResult);
+        return 0;
+    }
+    return pyResult;
+
+    Sbk_DoubleParamFunc_getValuesAtTimes_TypeError:
+        const char* overloads[] = {"PyObject, int = 0", 0};
+        Shiboken::setErrorAboutWrongArguments(args, "NatronEngine.DoubleParam.getValuesAtTimes", overloads);
+        return 0;
+}
+
 static PyObject* Sbk_DoubleParamFunc_restoreDefaultValue(PyObject* self, PyObject* args, PyObject* kwds)
 {
     DoubleParamWrapper* cppSelf = 0;
@@ -1328,6 +1418,97 @@ static PyObject* Sbk_DoubleParamFunc_setValueAtTime(PyObject* self, PyObject* ar
         return 0;
 }
 
+static PyObject* Sbk_DoubleParamFunc_setValuesAtTimes(PyObject* self, PyObject* args, PyObject* kwds)
+{
+    DoubleParamWrapper* cppSelf = 0;
+    SBK_UNUSED(cppSelf)
+    if (!Shiboken::Object::isValid(self))
+        return 0;
+    cppSelf = (DoubleParamWrapper*)((::DoubleParam*)Shiboken::Conversions::cppPointer(SbkNatronEngineTypes[SBK_DOUBLEPARAM_IDX], (SbkObject*)self));
+    int overloadId = -1;
+    PythonToCppFunc pythonToCpp[] = { 0, 0, 0 };
+    SBK_UNUSED(pythonToCpp)
+    int numNamedArgs = (kwds ? PyDict_Size(kwds) : 0);
+    int numArgs = PyTuple_GET_SIZE(args);
+    PyObject* pyArgs[] = {0, 0, 0};
+
+    // invalid argument lengths
+    if (numArgs + numNamedArgs > 3) {
+        PyErr_SetString(PyExc_TypeError, "NatronEngine.DoubleParam.setValuesAtTimes(): too many arguments");
+        return 0;
+    } else if (numArgs < 2) {
+        PyErr_SetString(PyExc_TypeError, "NatronEngine.DoubleParam.setValuesAtTimes(): not enough arguments");
+        return 0;
+    }
+
+    if (!PyArg_ParseTuple(args, "|OOO:setValuesAtTimes", &(pyArgs[0]), &(pyArgs[1]), &(pyArgs[2])))
+        return 0;
+
+
+    // Overloaded function decisor
+    // 0: setValuesAtTimes(std::vector<int>,std::vector<double>,int)
+    if (numArgs >= 2
+        && true
+        && true) {
+        if (numArgs == 2) {
+            overloadId = 0; // setValuesAtTimes(std::vector<int>,std::vector<double>,int)
+        } else if ((pythonToCpp[2] = Shiboken::Conversions::isPythonToCppConvertible(Shiboken::Conversions::PrimitiveTypeConverter<int>(), (pyArgs[2])))) {
+            overloadId = 0; // setValuesAtTimes(std::vector<int>,std::vector<double>,int)
+        }
+    }
+
+    // Function signature not found.
+    if (overloadId == -1) goto Sbk_DoubleParamFunc_setValuesAtTimes_TypeError;
+
+    // Call function/method
+    {
+        if (kwds) {
+            PyObject* value = PyDict_GetItemString(kwds, "dimension");
+            if (value && pyArgs[2]) {
+                PyErr_SetString(PyExc_TypeError, "NatronEngine.DoubleParam.setValuesAtTimes(): got multiple values for keyword argument 'dimension'.");
+                return 0;
+            } else if (value) {
+                pyArgs[2] = value;
+                if (!(pythonToCpp[2] = Shiboken::Conversions::isPythonToCppConvertible(Shiboken::Conversions::PrimitiveTypeConverter<int>(), (pyArgs[2]))))
+                    goto Sbk_DoubleParamFunc_setValuesAtTimes_TypeError;
+            }
+        }
+        int cppArg2 = 0;
+        if (pythonToCpp[2]) pythonToCpp[2](pyArgs[2], &cppArg2);
+
+        if (!PyErr_Occurred()) {
+            // setValuesAtTimes(std::vector<int>,std::vector<double>,int)
+            // Begin code injection
+
+            std::vector<int> times;
+            std::vector<double> values;
+            if (sequenceToVector(pyArgs[1-1], &times) && sequenceToVector(pyArgs[2-1], &values)) {
+                if (times.size() != values.size()) {
+                    PyErr_SetString(PyExc_ValueError, "NatronEngine.DoubleParam.setValuesAtTimes(): there must be as many values as times");
+                } else if (cppArg2 < 0 || cppArg2 >= cppSelf->getNumDimensions()) {
+                    PyErr_SetString(PyExc_IndexError, "NatronEngine.DoubleParam.setValuesAtTimes(): dimension out of range");
+                } else {
+                    cppSelf->setValuesAtTimes(times,values,cppArg2);
+                }
+            }
+
+            // End of code injection
+
+
+        }
+    }
+
+    if (PyErr_Occurred()) {
+        return 0;
+    }
+    Py_RETURN_NONE;
+
+    Sbk_DoubleParamFunc_setValuesAtTimes_TypeError:
+        const char* overloads[] = {"PyObject, PyObject, int = 0", 0};
+        Shiboken::setErrorAboutWrongArguments(args, "NatronEngine.DoubleParam.setValuesAtTimes", overloads);
+        return 0;
+}
+
 static PyMethodDef Sbk_DoubleParam_methods[] = {
     {"addAsDependencyOf", (PyCFunction)Sbk_DoubleParamFunc_addAsDependencyOf, METH_VARARGS},
     {"get", (PyCFunction)Sbk_DoubleParamFunc_get, METH_VARARGS},
@@ -1338,6 +1519,7 @@ static PyMethodDef Sbk_DoubleParam_methods[] = {
     {"getMinimum", (PyCFunction)Sbk_DoubleParamFunc_getMinimum, METH_VARARGS|METH_KEYWORDS},
     {"getValue", (PyCFunction)Sbk_DoubleParamFunc_getValue, METH_VARARGS|METH_KEYWORDS},
     {"getValueAtTime", (PyCFunction)Sbk_DoubleParamFunc_getValueAtTime, METH_VARARGS|METH_KEYWORDS},
+    {"getValuesAtTimes", (PyCFunction)Sbk_DoubleParamFunc_getValuesAtTimes, METH_VARARGS|METH_KEYWORDS},
     {"restoreDefaultValue", (PyCFunction)Sbk_DoubleParamFunc_restoreDefaultValue, METH_VARARGS|METH_KEYWORDS},
     {"set", (PyCFunction)Sbk_DoubleParamFunc_set, METH_VARARGS},
     {"setDefaultValue", (PyCFunction)Sbk_DoubleParamFunc_setDefaultValue, METH_VARARGS|METH_KEYWORDS},
@@ -1347,6 +1529,7 @@ static PyMethodDef Sbk_DoubleParam_methods[] = {
     {"setMinimum", (PyCFunction)Sbk_DoubleParamFunc_setMinimum, METH_VARARGS|METH_KEYWORDS},
     {"setValue", (PyCFunction)Sbk_DoubleParamFunc_setValue, METH_VARARGS|METH_KEYWORDS},
     {"setValueAtTime", (PyCFunction)Sbk_DoubleParamFunc_setValueAtTime, METH_VARARGS|METH_KEYWORDS},
+    {"setValuesAtTimes", (PyCFunction)Sbk_DoubleParamFunc_setValuesAtTimes, METH_VARARGS|METH_KEYWORDS},
 
     {0} // Sentinel
 };
@@ -870,6 +870,109 @@ static PyObject* Sbk_EffectFunc_getUserPageParam(PyObject* self)
     return pyResult;
 }
 
+static PyObject* Sbk_EffectFunc_renderImage(PyObject* self, PyObject* args)
+{
+    ::Effect* cppSelf = 0;
+    SBK_UNUSED(cppSelf)
+    if (!Shiboken::Object::isValid(self))
+        return 0;
+    cppSelf = ((::Effect*)Shiboken::Conversions::cppPointer(SbkNatronEngineTypes[SBK_EFFECT_IDX], (SbkObject*)self));
+    PyObject* pyResult = 0;
+    int overloadId = -1;
+    PythonToCppFunc pythonToCpp[] = { 0, 0, 0, 0, 0, 0 };
+    SBK_UNUSED(pythonToCpp)
+    int numArgs = PyTuple_GET_SIZE(args);
+    PyObject* pyArgs[] = {0, 0, 0, 0, 0, 0};
+
+    // invalid argument lengths
+    if (numArgs > 2 && numArgs < 6)
+        goto Sbk_EffectFunc_renderImage_TypeError;
+
+    if (!PyArg_UnpackTuple(args, "renderImage", 2, 6, &(pyArgs[0]), &(pyArgs[1]), &(pyArgs[2]), &(pyArgs[3]), &(pyArgs[4]), &(pyArgs[5])))
+        return 0;
+
+
+    // Overloaded function decisor
+    // 0: renderImage(int,double)
+    // 1: renderImage(int,double,int,int,int,int)
+    if ((pythonToCpp[0] = Shiboken::Conversions::isPythonToCppConvertible(Shiboken::Conversions::PrimitiveTypeConverter<int>(), (pyArgs[0])))
+        && (pythonToCpp[1] = Shiboken::Conversions::isPythonToCppConvertible(Shiboken::Conversions::PrimitiveTypeConverter<double>(), (pyArgs[1])))) {
+        if (numArgs == 2) {
+            overloadId = 0; // renderImage(int,double)
+        } else if (numArgs == 6
+            && (pythonToCpp[2] = Shiboken::Conversions::isPythonToCppConvertible(Shiboken::Conversions::PrimitiveTypeConverter<int>(), (pyArgs[2])))
+            && (pythonToCpp[3] = Shiboken::Conversions::isPythonToCppConvertible(Shiboken::Conversions::PrimitiveTypeConverter<int>(), (pyArgs[3])))
+            && (pythonToCpp[4] = Shiboken::Conversions::isPythonToCppConvertible(Shiboken::Conversions::PrimitiveTypeConverter<int>(), (pyArgs[4])))
+            && (pythonToCpp[5] = Shiboken::Conversions::isPythonToCppConvertible(Shiboken::Conversions::PrimitiveTypeConverter<int>(), (pyArgs[5])))) {
+            overloadId = 1; // renderImage(int,double,int,int,int,int)
+        }
+    }
+
+    // Function signature not found.
+    if (overloadId == -1) goto Sbk_EffectFunc_renderImage_TypeError;
+
+    // Call function/method
+    switch (overloadId) {
+        case 0: // renderImage(int time, double scale)
+        {
+            int cppArg0;
+            pythonToCpp[0](pyArgs[0], &cppArg0);
+            double cppArg1;
+            pythonToCpp[1](pyArgs[1], &cppArg1);
+
+            if (!PyErr_Occurred()) {
+                // renderImage(int,double)
+                // Begin code injection
+
+                pyResult = cppSelf->renderImage(cppArg0,cppArg1);
+
+                // End of code injection
+
+
+            }
+            break;
+        }
+        case 1: // renderImage(int time, double scale, int x1, int y1, int x2, int y2)
+        {
+            int cppArg0;
+            pythonToCpp[0](pyArgs[0], &cppArg0);
+            double cppArg1;
+            pythonToCpp[1](pyArgs[1], &cppArg1);
+            int cppArg2;
+            pythonToCpp[2](pyArgs[2], &cppArg2);
+            int cppArg3;
+            pythonToCpp[3](pyArgs[3], &cppArg3);
+            int cppArg4;
+            pythonToCpp[4](pyArgs[4], &cppArg4);
+            int cppArg5;
+            pythonToCpp[5](pyArgs[5], &cppArg5);
+
+            if (!PyErr_Occurred()) {
+                // renderImage(int,double,int,int,int,int)
+                // Begin code injection
+
+                pyResult = cppSelf->renderImage(cppArg0,cppArg1,cppArg2,cppArg3,cppArg4,cppArg5);
+
+                // End of code injection
+
+
+            }
+            break;
+        }
+    }
+
+    if (PyErr_Occurred() || !pyResult) {
+        Py_XDECREF(pyResult);
+        return 0;
+    }
+    return pyResult;
+
+    Sbk_EffectFunc_renderImage_TypeError:
+        const char* overloads[] = {"int, float", "int, float, int, int, int, int", 0};
+        Shiboken::setErrorAboutWrongArguments(args, "NatronEngine.Effect.renderImage", overloads);
+        return 0;
+}
+
 static PyObject* Sbk_EffectFunc_setColor(PyObject* self, PyObject* args)
 {
     ::Effect* cppSelf = 0;
@@ -1143,6 +1246,66 @@ static PyObject* Sbk_EffectFunc_setSize(PyObject* self, PyObject* args)
         return 0;
 }
 
+static PyObject* Sbk_EffectFunc_track(PyObject* self, PyObject* args)
+{
+    ::Effect* cppSelf = 0;
+    SBK_UNUSED(cppSelf)
+    if (!Shiboken::Object::isValid(self))
+        return 0;
+    cppSelf = ((::Effect*)Shiboken::Conversions::cppPointer(SbkNatronEngineTypes[SBK_EFFECT_IDX], (SbkObject*)self));
+    PyObject* pyResult = 0;
+    int overloadId = -1;
+    PythonToCppFunc pythonToCpp[] = { 0, 0 };
+    SBK_UNUSED(pythonToCpp)
+    int numArgs = PyTuple_GET_SIZE(args);
+    PyObject* pyArgs[] = {0, 0};
+
+    // invalid argument lengths
+
+
+    if (!PyArg_UnpackTuple(args, "track", 2, 2, &(pyArgs[0]), &(pyArgs[1])))
+        return 0;
+
+
+    // Overloaded function decisor
+    // 0: track(int,int)
+    if (numArgs == 2
+        && (pythonToCpp[0] = Shiboken::Conversions::isPythonToCppConvertible(Shiboken::Conversions::PrimitiveTypeConverter<int>(), (pyArgs[0])))
+        && (pythonToCpp[1] = Shiboken::Conversions::isPythonToCppConvertible(Shiboken::Conversions::PrimitiveTypeConverter<int>(), (pyArgs[1])))) {
+        overloadId = 0; // track(int,int)
+    }
+
+    // Function signature not found.
+    if (overloadId == -1) goto Sbk_EffectFunc_track_TypeError;
+
+    // Call function/method
+    {
+        int cppArg0;
+        pythonToCpp[0](pyArgs[0], &cppArg0);
+        int cppArg1;
+        pythonToCpp[1](pyArgs[1], &cppArg1);
+
+        if (!PyErr_Occurred()) {
+            // track(int,int)
+            PyThreadState* _save = PyEval_SaveThread(); // Py_BEGIN_ALLOW_THREADS
+            bool cppResult = cppSelf->track(cppArg0, cppArg1);
+            PyEval_RestoreThread(_save); // Py_END_ALLOW_THREADS
+            pyResult = Shiboken::Conversions::copyToPython(Shiboken::Conversions::PrimitiveTypeConverter<bool>(), &cppResult);
+        }
+    }
+
+    if (PyErr_Occurred() || !pyResult) {
+        Py_XDECREF(pyResult);
+        return 0;
+    }
+    return pyResult;
+
+    Sbk_EffectFunc_track_TypeError:
+        const char* overloads[] = {"int, int", 0};
+        Shiboken::setErrorAboutWrongArguments(args, "NatronEngine.Effect.track", overloads);
+        return 0;
+}
+
 static PyMethodDef Sbk_Effect_methods[] = {
     {"beginChanges", (PyCFunction)Sbk_EffectFunc_beginChanges, METH_NOARGS},
     {"canConnectInput", (PyCFunction)Sbk_EffectFunc_canConnectInput, METH_VARARGS},
@@ -1165,11 +1328,13 @@ static PyMethodDef Sbk_Effect_methods[] = {
     {"getScriptName", (PyCFunction)Sbk_EffectFunc_getScriptName, METH_NOARGS},
     {"getSize", (PyCFunction)Sbk_EffectFunc_getSize, METH_NOARGS},
     {"getUserPageParam", (PyCFunction)Sbk_EffectFunc_getUserPageParam, METH_NOARGS},
+    {"renderImage", (PyCFunction)Sbk_EffectFunc_renderImage, METH_VARARGS},
     {"setColor", (PyCFunction)Sbk_EffectFunc_setColor, METH_VARARGS},
     {"setLabel", (PyCFunction)Sbk_EffectFunc_setLabel, METH_O},
     {"setPosition", (PyCFunction)Sbk_EffectFunc_setPosition, METH_VARARGS},
     {"setScriptName", (PyCFunction)Sbk_EffectFunc_setScriptName, METH_O},
     {"setSize", (PyCFunction)Sbk_EffectFunc_setSize, METH_VARARGS},
+    {"track", (PyCFunction)Sbk_EffectFunc_track, METH_VARARGS},
 
     {0} // Sentinel
 };
@@ -8,6 +8,7 @@ GCC_DIAG_OFF(missing-field-initializers)
 #include <algorithm>
 #include <pyside.h>
 #include "natronengine_python.h"
+#include <ImageBufferWrapper.h>
 
 
 
@@ -556,6 +557,10 @@ SBK_MODULE_INIT_FUNCTION_BEGIN(NatronEngine)
     init_ColorTuple(module);
     init_Natron(module);
 
+    // Hand-written types
+    if (!ImageBuffer_addToModule(module))
+        return SBK_MODULE_INIT_ERROR;
+
     // Register converter for type 'NatronEngine.std::size_t'.
     SbkNatronEngineTypeConverters[SBK_STD_SIZE_T_IDX] = Shiboken::Conversions::createConverter(&PyLong_Type, std_size_t_CppToPython_std_size_t);
     Shiboken::Conversions::registerConverterName(SbkNatronEngineTypeConverters[SBK_STD_SIZE_T_IDX], "std::size_t");
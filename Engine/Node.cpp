@@ -15,7 +15,9 @@
 
 #include "Node.h"
 
+#include <functional>
 #include <limits>
+#include <map>
 #include <locale>
 
 #include <QtCore/QDebug>
@@ -37,6 +39,7 @@
 #include "Engine/Image.h"
 #include "Engine/Project.h"
 #include "Engine/EffectInstance.h"
+#include "Engine/DiskCacheNode.h"
 #include "Engine/Log.h"
 #include "Engine/NodeSerialization.h"
 #include "Engine/Plugin.h"
@@ -52,6 +55,8 @@
 #include "Engine/NodeGuiI.h"
 #include "Engine/NodeGroup.h"
 #include "Engine/BackDrop.h"
+#include "Engine/RenderScheduler.h"
+#include "Engine/TrackScheduler.h"
 ///The flickering of edges/nodes in the nodegraph will be refreshed
 ///at most every...
 #define NATRON_RENDER_GRAPHS_HINTS_REFRESH_RATE_SECONDS 0.5
@@ -155,6 +160,7 @@ struct Node::Implementation
     , multiInstanceParent()
     , childrenMutex()
     , children()
+    , trackScheduler()
     , multiInstanceParentName()
     , duringInputChangedAction(false)
     , keyframesDisplayedOnTimeline(false)
@@ -170,6 +176,8 @@ struct Node::Implementation
     , nodeIsRenderingMutex()
     , mustQuitProcessing(false)
     , mustQuitProcessingMutex()
+    , outputSingleUse(false)
+    , outputSingleUseMutex()
     , persistentMessage()
     , persistentMessageType(0)
     , persistentMessageMutex()
@@ -303,6 +311,7 @@ struct Node::Implementation
     boost::weak_ptr<Natron::Node> multiInstanceParent;
     mutable QMutex childrenMutex;
     std::list<boost::weak_ptr<Natron::Node> > children;
+    boost::scoped_ptr<TrackScheduler> trackScheduler; //< valid for the main instance of trackers
     
     ///the name of the parent at the time this node was created
     std::string multiInstanceParentName;
@@ -330,6 +339,9 @@ struct Node::Implementation
     bool mustQuitProcessing;
     mutable QMutex mustQuitProcessingMutex;
     
+    bool outputSingleUse; //< set during streaming renders, see setOutputSingleUse
+    mutable QMutex outputSingleUseMutex;
+    
     QString persistentMessage;
     int persistentMessageType;
     mutable QMutex persistentMessageMutex;
@@ -475,6 +487,9 @@ Node::load(const std::string & parentMultiInstanceName,
     ///Special case for trackers: set as multi instance
     if ( isTrackerNode() ) {
         _imp->isMultiInstance = true;
+        if (!isMultiInstanceChild) {
+            _imp->trackScheduler.reset( new TrackScheduler(this) );
+        }
         ///declare knob that are instance specific
         boost::shared_ptr<KnobI> subLabelKnob = getKnobByName(kOfxParamStringSublabelName);
         if (subLabelKnob) {
@@ -568,18 +583,14 @@ Node::Implementation::appendChild(const boost::shared_ptr<Natron::Node>& child)
 void
 Node::fetchParentMultiInstancePointer()
 {
-    NodeList nodes = _imp->group.lock()->getNodes();
+    NodePtr parent = _imp->group.lock()->getNodeByName(_imp->multiInstanceParentName);
     
-    NodePtr thisShared = shared_from_this();
-    for (NodeList::iterator it = nodes.begin(); it != nodes.end(); ++it) {
-        if ((*it)->getScriptName() == _imp->multiInstanceParentName) {
-            ///no need to store the boost pointer because the main instance lives the same time
-            ///as the child
-            _imp->multiInstanceParent = *it;
-            (*it)->_imp->appendChild(thisShared);
-            QObject::connect(it->get(), SIGNAL(inputChanged(int)), this, SLOT(onParentMultiInstanceInputChanged(int)));
-            break;
-        }
+    if (parent) {
+        ///no need to store the boost pointer because the main instance lives the same time
+        ///as the child
+        _imp->multiInstanceParent = parent;
+        parent->_imp->appendChild( shared_from_this() );
+        QObject::connect(parent.get(), SIGNAL(inputChanged(int)), this, SLOT(onParentMultiInstanceInputChanged(int)));
     }
     
 }
@@ -603,6 +614,12 @@ Node::getParentMultiInstanceName() const
     return _imp->multiInstanceParentName;
 }
 
+TrackScheduler*
+Node::getTrackScheduler() const
+{
+    return _imp->trackScheduler.get();
+}
+
 void
 Node::getChildrenMultiInstance(std::list<boost::shared_ptr<Natron::Node> >* children) const
 {
@@ -693,6 +710,9 @@ Node::computeHashInternal(std::list<Natron::Node*>& marked)
     
     _imp->liveInstance->onNodeHashChanged(getHashValue());
     
+    ///Drop any pending preview render made with the old hash
+    appPTR->getRenderScheduler()->cancelStaleRequests(this, getHashValue());
+    
     ///If the node is a group, call it on all nodes in the group
     ///Also force a change to their hash
     NodeGroup* group = dynamic_cast<NodeGroup*>(getLiveInstance());
@@ -1120,6 +1140,11 @@ Node::abortAnyProcessing()
     if (isOutput) {
         isOutput->getRenderEngine()->abortRendering(true);
     }
+    appPTR->getRenderScheduler()->cancelAllRequests(this);
+    DiskCacheNode* isDiskCache = dynamic_cast<DiskCacheNode*>( getLiveInstance() );
+    if (isDiskCache) {
+        isDiskCache->abortPreCaching();
+    }
     _imp->abortPreview();
 }
 
@@ -1142,12 +1167,23 @@ Node::quitAnyProcessing()
     if (isOutput) {
         isOutput->getRenderEngine()->quitEngine();
     }
+    if (_imp->trackScheduler) {
+        _imp->trackScheduler->quitThread();
+    }
+    appPTR->getRenderScheduler()->cancelAllRequests(this);
+    DiskCacheNode* isDiskCache = dynamic_cast<DiskCacheNode*>( getLiveInstance() );
+    if (isDiskCache) {
+        isDiskCache->abortPreCaching();
+    }
     _imp->abortPreview();
     
 }
 
 Node::~Node()
 {
+    if (_imp->trackScheduler) {
+        _imp->trackScheduler->quitThread();
+    }
     _imp->liveInstance.reset();
 }
 
@@ -1430,6 +1466,8 @@ Node::setNameInternal(const std::string& name)
     }
     
     if (collection) {
+        collection->notifyNodeNameChanged(shared_from_this(), oldName, newName);
+        
         std::string fullySpecifiedName = getFullyQualifiedName();
         if (!oldName.empty()) {
             
@@ -1470,6 +1508,13 @@ Node::setNameInternal(const std::string& name)
         }
     }
     
+    ///The storage of DiskCache nodes is named after their fully qualified name, which includes the names of their groups
+    if ( !oldName.empty() && (oldName != newName) ) {
+        std::list<boost::shared_ptr<Node> > renamed;
+        renamed.push_back( shared_from_this() );
+        DiskCacheNode::refreshStorageDirectories(renamed);
+    }
+    
     QString qnewName(newName.c_str());
     Q_EMIT scriptNameChanged(qnewName);
     Q_EMIT labelChanged(qnewName);
@@ -3074,6 +3119,42 @@ Node::makePreviewImage(SequenceTime time,
     RectI renderWindow;
     rod.toPixelEnclosing(mipMapLevel, par, &renderWindow);
     
+    ///If the node cache already holds a fully rendered image of this node (e.g: rendered by the viewer) at a scale
+    ///at least as large as the one needed by the preview, just sample it instead of rendering again.
+    ///The image stays locked until the preview is sampled from it.
+    {
+        ImageLocker cachedImageLocker(_imp->liveInstance.get());
+        Natron::ImageKey key = Natron::Image::makeKey(nodeHash, _imp->liveInstance->isFrameVaryingOrAnimated_Recursive(), time, 0);
+        std::list<boost::shared_ptr<Image> > cachedImages;
+        if (Natron::getImageFromCache(key, &cachedImages)) {
+            ///prefer the smallest images that are still large enough
+            std::multimap<unsigned int,boost::shared_ptr<Image>,std::greater<unsigned int> > candidates;
+            for (std::list<boost::shared_ptr<Image> >::iterator it = cachedImages.begin(); it != cachedImages.end(); ++it) {
+                unsigned int imgLevel = (*it)->getMipMapLevel();
+                if (imgLevel <= mipMapLevel && getElementsCountForComponents((*it)->getComponents()) >= 3) {
+                    candidates.insert( std::make_pair(imgLevel, *it) );
+                }
+            }
+            for (std::multimap<unsigned int,boost::shared_ptr<Image>,std::greater<unsigned int> >::iterator it = candidates.begin();
+                 it != candidates.end(); ++it) {
+                RectI levelBounds;
+                rod.toPixelEnclosing(it->first, par, &levelBounds);
+                cachedImageLocker.lock(it->second);
+                std::list<RectI> restToRender;
+                it->second->getRestToRender(levelBounds, restToRender);
+                if (it->second->getBounds().contains(levelBounds) && restToRender.empty()) {
+                    img = it->second;
+                    break;
+                }
+                cachedImageLocker.unlock();
+            }
+        }
+        
+        if (img) {
+            return renderPreviewFromImage(*img, width, height, buf);
+        }
+    }
+    
     ParallelRenderArgsSetter frameRenderArgs(this,
                                              time,
                                              0, //< preview only renders view 0 (left)
@@ -3105,32 +3186,41 @@ Node::makePreviewImage(SequenceTime time,
         return false;
     }
     
-    ImageComponentsEnum components = img->getComponents();
+    return renderPreviewFromImage(*img, width, height, buf);
+    
+} // makePreviewImage
+
+bool
+Node::renderPreviewFromImage(const Natron::Image& img,
+                             int *width,
+                             int *height,
+                             unsigned int* buf)
+{
+    ImageComponentsEnum components = img.getComponents();
     int elemCount = getElementsCountForComponents(components);
     
     ///we convert only when input is Linear.
     //Rec709 and srGB is acceptable for preview
-    bool convertToSrgb = getApp()->getDefaultColorSpaceForBitDepth( img->getBitDepth() ) == Natron::eViewerColorSpaceLinear;
+    bool convertToSrgb = getApp()->getDefaultColorSpaceForBitDepth( img.getBitDepth() ) == Natron::eViewerColorSpaceLinear;
     
-    switch ( img->getBitDepth() ) {
+    switch ( img.getBitDepth() ) {
         case Natron::eImageBitDepthByte: {
-            renderPreview<unsigned char, 255>(*img, elemCount, width, height,convertToSrgb, buf);
+            renderPreview<unsigned char, 255>(img, elemCount, width, height,convertToSrgb, buf);
             break;
         }
         case Natron::eImageBitDepthShort: {
-            renderPreview<unsigned short, 65535>(*img, elemCount, width, height,convertToSrgb, buf);
+            renderPreview<unsigned short, 65535>(img, elemCount, width, height,convertToSrgb, buf);
             break;
         }
         case Natron::eImageBitDepthFloat: {
-            renderPreview<float, 1>(*img, elemCount, width, height,convertToSrgb, buf);
+            renderPreview<float, 1>(img, elemCount, width, height,convertToSrgb, buf);
             break;
         }
         case Natron::eImageBitDepthNone:
             break;
     }
     return true;
-    
-} // makePreviewImage
+}
 
 bool
 Node::isInputNode() const
@@ -4451,6 +4541,11 @@ Node::shouldCacheOutput() const
         //If true then we're in analysis, so we cache the input of the analysis effect
 
         
+        ///During a streaming render, each image of this node is used by a single frame: caching it would only hold memory
+        if ( isOutputSingleUse() && (_imp->liveInstance->getRecursionLevel() == 0) ) {
+            return false;
+        }
+        
         QMutexLocker k(&_imp->outputsMutex);
         std::size_t sz = _imp->outputs.size();
         if (sz > 1) {
@@ -4488,6 +4583,20 @@ Node::shouldCacheOutput() const
     
 }
 
+void
+Node::setOutputSingleUse(bool singleUse)
+{
+    QMutexLocker k(&_imp->outputSingleUseMutex);
+    _imp->outputSingleUse = singleUse;
+}
+
+bool
+Node::isOutputSingleUse() const
+{
+    QMutexLocker k(&_imp->outputSingleUseMutex);
+    return _imp->outputSingleUse;
+}
+
 void
 Node::setPosition(double x,double y)
 {
@@ -33,6 +33,7 @@ CLANG_DIAG_ON(deprecated)
 #include <boost/enable_shared_from_this.hpp>
 #endif
 #include "Engine/AppManager.h"
+#include "Engine/RenderArena.h"
 #include "Global/KeySymbols.h"
 
 #define NATRON_EXTRA_PARAMETER_PAGE_NAME "Node"
@@ -56,6 +57,7 @@ class Double_Knob;
 class NodeGuiI;
 class RotoContext;
 class NodeCollection;
+class TrackScheduler;
 namespace Natron {
 class Plugin;
 class OutputEffectInstance;
@@ -174,6 +176,12 @@ public:
     std::string getParentMultiInstanceName() const;
     
     void getChildrenMultiInstance(std::list<boost::shared_ptr<Natron::Node> >* children) const;
+    
+    /**
+     * @brief Returns the scheduler tracking the children of this node if this is the main instance of a tracker,
+     * NULL otherwise.
+     **/
+    TrackScheduler* getTrackScheduler() const;
 
     /**
      * @brief Returns the hash value of the node, or 0 if it has never been computed.
@@ -424,6 +432,13 @@ public:
     bool isSettingsPanelOpened() const;
     
     bool shouldCacheOutput() const;
+    
+    /**
+     * @brief Set by the scheduler of a streaming render on disk (see AppManager::isStreamingRenderEnabled()) when each image of
+     * this node is needed by a single frame of the render: the output of the node is then never cached, even if caching is forced.
+     **/
+    void setOutputSingleUse(bool singleUse);
+    bool isOutputSingleUse() const;
 
     /**
      * @brief If the session is a GUI session, then this function sets the position of the node on the nodegraph.
@@ -973,6 +988,11 @@ private:
 
     
     std::string makeInfoForInput(int inputNumber) const;
+    
+    /**
+     * @brief Downscales the given image into the preview buffer, @see makePreviewImage
+     **/
+    bool renderPreviewFromImage(const Natron::Image& img,int *width,int *height,unsigned int* buf);
 
     void invalidateParallelRenderArgsInternal(std::list<Natron::Node*>& markedNodes);
     
@@ -1052,6 +1072,9 @@ public:
 
 class ParallelRenderArgsSetter
 {
+    ///The transient data of the render of the frame is allocated in the arena of the thread, it is reset
+    ///once the render args are invalidated
+    Natron::RenderArena::FrameScope frameArena;
     Natron::Node* node;
 public:
     
@@ -1064,7 +1087,8 @@ public:
                              U64 nodeHash,
                              bool canSetValue,
                              const TimeLine* timeline)
-    : node(n)
+    : frameArena()
+    , node(n)
     {
         node->setParallelRenderArgs(time,view,isRenderUserInteraction,isSequential,canAbort,nodeHash,canSetValue,timeline);
     }
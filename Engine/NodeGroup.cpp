@@ -22,6 +22,8 @@
 #include <QCoreApplication>
 #include <QTextStream>
 
+#include <boost/unordered_map.hpp>
+
 #include "Engine/AppInstance.h"
 #include "Engine/Node.h"
 #include "Engine/OutputSchedulerThread.h"
@@ -48,18 +50,54 @@ struct NodeCollectionPrivate
     mutable QMutex nodesMutex;
     NodeList nodes;
     
+    ///The nodes by script name, protected by nodesMutex.
+    ///If several nodes have the same name, only one of them is indexed.
+    boost::unordered_map<std::string,NodePtr> nodesByName;
+    
     NodeCollectionPrivate(AppInstance* app)
     : app(app)
     , graph(0)
     , nodesMutex()
     , nodes()
+    , nodesByName()
     {
         
     }
     
     NodePtr findNodeInternal(const std::string& name,const std::string& recurseName) const;
+    
+    ///Must be called with nodesMutex locked
+    void indexNode(const NodePtr& node,const std::string& name);
+    void unindexNode(const NodePtr& node,const std::string& name);
 };
 
+void
+NodeCollectionPrivate::indexNode(const NodePtr& node,const std::string& name)
+{
+    if (!name.empty()) {
+        ///Does not replace a node that already has this name
+        nodesByName.insert( std::make_pair(name, node) );
+    }
+}
+
+void
+NodeCollectionPrivate::unindexNode(const NodePtr& node,const std::string& name)
+{
+    boost::unordered_map<std::string,NodePtr>::iterator found = nodesByName.find(name);
+    if ( ( found == nodesByName.end() ) || (found->second != node) ) {
+        return;
+    }
+    nodesByName.erase(found);
+    
+    ///Index another node with the same name, if any
+    for (NodeList::iterator it = nodes.begin(); it != nodes.end(); ++it) {
+        if ( (*it != node) && ( (*it)->getScriptName_mt_safe() == name ) ) {
+            nodesByName.insert( std::make_pair(name, *it) );
+            break;
+        }
+    }
+}
+
 NodeCollection::NodeCollection(AppInstance* app)
 : _imp(new NodeCollectionPrivate(app))
 {
@@ -108,6 +146,7 @@ NodeCollection::addNode(const NodePtr& node)
     {
         QMutexLocker k(&_imp->nodesMutex);
         _imp->nodes.push_back(node);
+        _imp->indexNode( node, node->getScriptName_mt_safe() );
     }
 }
 
@@ -119,9 +158,18 @@ NodeCollection::removeNode(const NodePtr& node)
     NodeList::iterator found = std::find(_imp->nodes.begin(), _imp->nodes.end(), node);
     if (found != _imp->nodes.end()) {
         _imp->nodes.erase(found);
+        _imp->unindexNode( node, node->getScriptName_mt_safe() );
     }
 }
 
+void
+NodeCollection::notifyNodeNameChanged(const NodePtr& node,const std::string& oldName,const std::string& newName)
+{
+    QMutexLocker k(&_imp->nodesMutex);
+    _imp->unindexNode(node, oldName);
+    _imp->indexNode(node, newName);
+}
+
 NodePtr
 NodeCollection::getLastNode(const std::string& pluginID) const
 {
@@ -356,6 +404,7 @@ NodeCollection::clearNodes(bool emitSignal)
     {
         QMutexLocker l(&_imp->nodesMutex);
         _imp->nodes.clear();
+        _imp->nodesByName.clear();
     }
     
     nodesToDelete.clear();
@@ -386,14 +435,8 @@ NodeCollection::setNodeName(const std::string& baseName,bool appendDigit,bool er
         *nodeName = ss.str();
     }
     do {
-        foundNodeWithName = false;
         QMutexLocker l(&_imp->nodesMutex);
-        for (NodeList::iterator it = _imp->nodes.begin(); it != _imp->nodes.end(); ++it) {
-            if ((*it)->getScriptName_mt_safe() == *nodeName) {
-                foundNodeWithName = true;
-                break;
-            }
-        }
+        foundNodeWithName = _imp->nodesByName.find(*nodeName) != _imp->nodesByName.end();
         if (foundNodeWithName) {
             if (errorIfExists || !appendDigit) {
                 return false;
@@ -457,16 +500,13 @@ NodeCollection::connectNodes(int inputNumber,const NodePtr& input,Natron::Node*
 bool
 NodeCollection::connectNodes(int inputNumber,const std::string & inputName,Natron::Node* output)
 {
-    NodeList nodes = getNodes();
+    NodePtr input = getNodeByName(inputName);
     
-    for (NodeList::iterator it = nodes.begin(); it != nodes.end(); ++it) {
-        assert(*it);
-        if ((*it)->getScriptName() == inputName) {
-            return connectNodes(inputNumber,*it, output);
-        }
+    if (!input) {
+        return false;
     }
     
-    return false;
+    return connectNodes(inputNumber,input, output);
 }
 
 
@@ -611,25 +651,29 @@ NodeCollection::autoConnectNodes(const NodePtr& selected,const NodePtr& created)
 NodePtr
 NodeCollectionPrivate::findNodeInternal(const std::string& name,const std::string& recurseName) const
 {
-    QMutexLocker k(&nodesMutex);
-    for (NodeList::const_iterator it = nodes.begin(); it != nodes.end(); ++it) {
-        if ((*it)->getScriptName_mt_safe() == name) {
-            if (!recurseName.empty()) {
-                NodeGroup* isGrp = dynamic_cast<NodeGroup*>((*it)->getLiveInstance());
-                if (isGrp) {
-                    return isGrp->getNodeByFullySpecifiedName(recurseName);
-                } else {
-                    std::list<NodePtr> children;
-                    (*it)->getChildrenMultiInstance(&children);
-                    for (std::list<NodePtr>::iterator it2 = children.begin(); it2 != children.end(); ++it2) {
-                        if ((*it2)->getScriptName_mt_safe() == recurseName) {
-                            return *it2;
-                        }
-                    }
-                }
-            } else {
-                return *it;
-            }
+    NodePtr node;
+    {
+        QMutexLocker k(&nodesMutex);
+        boost::unordered_map<std::string,NodePtr>::const_iterator found = nodesByName.find(name);
+        if ( found == nodesByName.end() ) {
+            return NodePtr();
+        }
+        node = found->second;
+    }
+    if ( recurseName.empty() ) {
+        return node;
+    }
+    
+    ///Each level of a fully qualified name is looked-up in the index of its group
+    NodeGroup* isGrp = dynamic_cast<NodeGroup*>( node->getLiveInstance() );
+    if (isGrp) {
+        return isGrp->getNodeByFullySpecifiedName(recurseName);
+    }
+    std::list<NodePtr> children;
+    node->getChildrenMultiInstance(&children);
+    for (std::list<NodePtr>::iterator it = children.begin(); it != children.end(); ++it) {
+        if ( (*it)->getScriptName_mt_safe() == recurseName ) {
+            return *it;
         }
     }
     return NodePtr();
@@ -786,6 +830,15 @@ bool
 NodeCollection::checkIfNodeNameExists(const std::string & n,const Natron::Node* caller) const
 {
     QMutexLocker k(&_imp->nodesMutex);
+    boost::unordered_map<std::string,NodePtr>::const_iterator found = _imp->nodesByName.find(n);
+    if ( found == _imp->nodesByName.end() ) {
+        return false;
+    }
+    if (found->second.get() != caller) {
+        return true;
+    }
+    
+    ///The caller has this name: look for another node with the same name
     for (NodeList::const_iterator it = _imp->nodes.begin(); it != _imp->nodes.end(); ++it) {
         if ( (it->get() != caller) && ( (*it)->getScriptName_mt_safe() == n ) ) {
             return true;
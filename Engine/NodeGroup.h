@@ -67,6 +67,11 @@ public:
      **/
     void removeNode(const NodePtr& node);
     
+    /**
+     * @brief Called by the node when its script name changed, to keep the lookup of nodes by name up to date. MT-safe.
+     **/
+    void notifyNodeNameChanged(const NodePtr& node,const std::string& oldName,const std::string& newName);
+    
     /**
      * @brief Get the last node added with the given id
      **/
@@ -35,6 +35,18 @@ NodeCollectionSerialization::initialize(const NodeCollection& group)
     }
 }
 
+void
+NodeCollectionSerialization::replaceNodeSerialization(const boost::shared_ptr<NodeSerialization>& s)
+{
+    for (std::list< boost::shared_ptr<NodeSerialization> >::iterator it = _serializedNodes.begin(); it != _serializedNodes.end(); ++it) {
+        if ( (*it)->getNodeScriptName() == s->getNodeScriptName() ) {
+            *it = s;
+            return;
+        }
+    }
+    _serializedNodes.push_back(s);
+}
+
 bool
 NodeCollectionSerialization::restoreFromSerialization(const std::list< boost::shared_ptr<NodeSerialization> > & serializedNodes,
                                                       const boost::shared_ptr<NodeCollection>& group,
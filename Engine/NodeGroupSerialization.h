@@ -65,6 +65,11 @@ public:
         _serializedNodes.push_back(s);
     }
     
+    /**
+     * @brief Replaces the serialization of the node with the same script name, or adds it if there is none.
+     **/
+    void replaceNodeSerialization(const boost::shared_ptr<NodeSerialization>& s);
+    
     static bool restoreFromSerialization(const std::list< boost::shared_ptr<NodeSerialization> > & serializedNodes,
                                          const boost::shared_ptr<NodeCollection>& group,
                                          bool* hasProjectAWriter);
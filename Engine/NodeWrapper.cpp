@@ -14,6 +14,8 @@
 
 #include "NodeWrapper.h"
 
+#include <QtCore/QDebug>
+
 #include "Engine/Node.h"
 #include "Engine/KnobTypes.h"
 #include "Engine/KnobFile.h"
@@ -21,6 +23,10 @@
 #include "Engine/EffectInstance.h"
 #include "Engine/NodeGroup.h"
 #include "Engine/RotoWrapper.h"
+#include "Engine/AppManager.h"
+#include "Engine/TrackScheduler.h"
+#include "Engine/Image.h"
+#include "Engine/ImageBufferWrapper.h"
 
 Effect::Effect(const boost::shared_ptr<Natron::Node>& node)
 : Group()
@@ -539,4 +545,143 @@ Effect::getRotoContext() const
         return new Roto(roto);
     }
     return 0;
-}
\ No newline at end of file
+}
+
+bool
+Effect::track(int firstFrame, int lastFrame)
+{
+    std::list<NodePtr> tracks;
+    NodePtr tracker = _node->getParentMultiInstance();
+    if (tracker) {
+        tracks.push_back(_node);
+    } else if ( _node->getTrackScheduler() ) {
+        tracker = _node;
+        _node->getChildrenMultiInstance(&tracks);
+    }
+    if (!tracker || !tracker->getTrackScheduler()) {
+        return false;
+    }
+    
+    bool forward = lastFrame >= firstFrame;
+    std::list<Button_Knob*> buttons;
+    for (std::list<NodePtr>::iterator it = tracks.begin(); it != tracks.end(); ++it) {
+        if ( !*it || (*it)->isNodeDisabled() ) {
+            continue;
+        }
+        Button_Knob* button = dynamic_cast<Button_Knob*>( (*it)->getKnobByName(forward ? kTrackNextButtonName : kTrackPreviousButtonName).get() );
+        if (button) {
+            buttons.push_back(button);
+        }
+    }
+    if ( buttons.empty() ) {
+        return false;
+    }
+    
+    ///Each step tracks from a frame to the next one, so the step at the frame before lastFrame computes lastFrame
+    TrackScheduler* scheduler = tracker->getTrackScheduler();
+    scheduler->track(firstFrame, lastFrame, forward, buttons);
+    if ( appPTR->isBackground() ) {
+        scheduler->waitForTrackingFinished();
+    }
+    return true;
+}
+
+namespace {
+///Renders the node in the cache, the window is in pixel coordinates at the given mipmap level and is clipped to the RoD
+boost::shared_ptr<Natron::Image>
+renderNodeImage(const NodePtr& node,
+                int time,
+                unsigned int mipMapLevel,
+                const RectI* window,
+                RectI* renderWindow)
+{
+    Natron::EffectInstance* effect = node->getLiveInstance();
+    if (!effect) {
+        return boost::shared_ptr<Natron::Image>();
+    }
+    U64 nodeHash = node->getHashValue();
+    ParallelRenderArgsSetter frameRenderArgs(node.get(),
+                                             time,
+                                             0, //< only the main view is rendered
+                                             false,
+                                             false,
+                                             true,
+                                             nodeHash,
+                                             false,
+                                             node->getApp()->getTimeLine().get());
+    RenderScale scale;
+    scale.x = scale.y = Natron::Image::getScaleFromMipMapLevel(mipMapLevel);
+    RectD rod;
+    bool isProjectFormat;
+    Natron::StatusEnum stat = effect->getRegionOfDefinition_public(nodeHash, time, scale, 0, &rod, &isProjectFormat);
+    if ( (stat == Natron::eStatusFailed) || rod.isNull() ) {
+        return boost::shared_ptr<Natron::Image>();
+    }
+    rod.toPixelEnclosing(mipMapLevel, effect->getPreferredAspectRatio(), renderWindow);
+    if ( window && !window->intersect(*renderWindow, renderWindow) ) {
+        return boost::shared_ptr<Natron::Image>();
+    }
+
+    Natron::ImageComponentsEnum components;
+    Natron::ImageBitDepthEnum depth;
+    effect->getPreferredDepthAndComponents(-1, &components, &depth);
+
+    boost::shared_ptr<Natron::Image> image;
+    try {
+        image = effect->renderRoI( Natron::EffectInstance::RenderRoIArgs( time,
+                                                                          scale,
+                                                                          mipMapLevel,
+                                                                          0,
+                                                                          false,
+                                                                          *renderWindow,
+                                                                          rod,
+                                                                          components,
+                                                                          depth ) );
+    } catch (const std::exception & e) {
+        qDebug() << "Effect.renderImage: rendering" << node->getScriptName().c_str() << "failed:" << e.what();
+
+        return boost::shared_ptr<Natron::Image>();
+    }
+    if ( image && !image->getBounds().contains(*renderWindow) ) {
+        ///The render was aborted before completion
+        return boost::shared_ptr<Natron::Image>();
+    }
+
+    return image;
+}
+}
+
+PyObject*
+Effect::renderImage(int time, double scale)
+{
+    return renderImageInternal(time, scale, 0);
+}
+
+PyObject*
+Effect::renderImage(int time, double scale, int x1, int y1, int x2, int y2)
+{
+    RectI window(x1, y1, x2, y2);
+    return renderImageInternal(time, scale, &window);
+}
+
+PyObject*
+Effect::renderImageInternal(int time, double scale, const RectI* window)
+{
+    if ( (scale <= 0.) || (scale > 1.) ) {
+        PyErr_SetString(PyExc_ValueError, "Effect.renderImage: the scale must be in ]0, 1]");
+        return NULL;
+    }
+    unsigned int mipMapLevel = Natron::Image::getLevelFromScale(scale);
+    boost::shared_ptr<Natron::Image> image;
+    RectI renderWindow;
+    
+    ///Other Python threads may run while this one waits for the render
+    Py_BEGIN_ALLOW_THREADS
+    image = renderNodeImage(_node, time, mipMapLevel, window, &renderWindow);
+    Py_END_ALLOW_THREADS
+    
+    if (!image) {
+        Py_RETURN_NONE;
+    }
+    return ImageBuffer_toPython( new ImageBuffer(image, renderWindow) );
+}
@@ -52,6 +52,7 @@ class GroupParam;
 class PageParam;
 class ParametricParam;
 class KnobHolder;
+class RectI;
 
 class UserParamHolder
 {
@@ -318,7 +319,28 @@ public:
      **/
     Roto* getRotoContext() const;
     
+    /**
+     * @brief Track from the position at firstFrame up to lastFrame included (backward if lastFrame < firstFrame).
+     * If this is a tracker node, all its enabled tracks are tracked in parallel, if this is a track only this track is tracked.
+     * In background mode this function returns once the tracking is done, otherwise it runs asynchronously.
+     * @returns False if this is not a tracker or there is nothing to track.
+     **/
+    bool track(int firstFrame, int lastFrame);
+    
+    /**
+     * @brief Renders this node at the given time and scale (rounded to the closest mipmap level) and returns a
+     * NatronEngine.ImageBuffer over the pixels of the image in the cache, or None if the render failed.
+     * The second version only renders the given window, in pixel coordinates at the rendered scale.
+     * The GIL is released while rendering.
+     **/
+    PyObject* renderImage(int time, double scale);
+    PyObject* renderImage(int time, double scale, int x1, int y1, int x2, int y2);
+    
     static Param* createParamWrapperForKnob(const boost::shared_ptr<KnobI>& knob);
+    
+private:
+    
+    PyObject* renderImageInternal(int time, double scale, const RectI* window);
 };
 
 #endif // NODEWRAPPER_H
@@ -0,0 +1,331 @@
+//  Natron
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+
+#include "NumaTopology.h"
+
+#include <cassert>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#if defined(__linux__) || defined(__linux) || defined(linux) || defined(__gnu_linux__)
+#define NATRON_NUMA_LINUX
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include <QtCore/QAtomicInt>
+#include <QtCore/QMutex>
+
+#include "Engine/MemoryFile.h"
+#include "Engine/ThreadStorage.h"
+
+///The access counters are folded in 64-bit totals past this count so that the 32-bit atomics never wrap
+#define NATRON_NUMA_ACCESS_COUNTER_FOLD (1 << 30)
+
+namespace {
+
+struct NumaTopologyPrivate
+{
+    std::vector<std::vector<int> > nodesCPUs;
+    std::vector<int> cpuToNode;
+
+    NumaTopologyPrivate()
+    : nodesCPUs()
+    , cpuToNode()
+    {
+    }
+};
+
+static QAtomicInt bindingEnabled;
+static QAtomicInt nextNode;
+static QAtomicInt localAccesses;
+static QAtomicInt remoteAccesses;
+static QMutex accessTotalsMutex;
+static U64 localAccessesTotal = 0; //< protected by accessTotalsMutex
+static U64 remoteAccessesTotal = 0; //< protected by accessTotalsMutex
+
+static void
+countAccess(QAtomicInt& counter,
+            U64* total)
+{
+    if (counter.fetchAndAddRelaxed(1) + 1 >= NATRON_NUMA_ACCESS_COUNTER_FOLD) {
+        QMutexLocker k(&accessTotalsMutex);
+        *total += (unsigned int)counter.fetchAndStoreRelaxed(0);
+    }
+}
+
+///The node the thread was bound to by bindCurrentThreadToNode(), -1 if none
+///Stored shifted by 1 so that the default-constructed value (0) means "not bound"
+static Natron::ThreadStorage<int> boundNode;
+
+#ifdef NATRON_NUMA_LINUX
+///Parses a cpulist as found in /sys/devices/system/node/nodeN/cpulist, e.g "0-7,16-23"
+static void
+parseCPUList(const std::string& str,
+             std::vector<int>* cpus)
+{
+    std::stringstream ss(str);
+    std::string range;
+    while ( std::getline(ss, range, ',') ) {
+        if ( range.empty() ) {
+            continue;
+        }
+        std::size_t dash = range.find('-');
+        int first,last;
+        if (dash == std::string::npos) {
+            first = last = std::atoi( range.c_str() );
+        } else {
+            first = std::atoi( range.substr(0,dash).c_str() );
+            last = std::atoi( range.substr(dash + 1).c_str() );
+        }
+        for (int i = first; i <= last; ++i) {
+            cpus->push_back(i);
+        }
+    }
+}
+#endif
+
+static NumaTopologyPrivate
+readTopology()
+{
+    NumaTopologyPrivate topology;
+
+#ifdef NATRON_NUMA_LINUX
+    for (int node = 0;; ++node) {
+        std::stringstream path;
+        path << "/sys/devices/system/node/node" << node << "/cpulist";
+        std::ifstream f( path.str().c_str() );
+        if ( !f.good() ) {
+            break;
+        }
+        std::string line;
+        std::getline(f, line);
+        std::vector<int> cpus;
+        parseCPUList(line, &cpus);
+        topology.nodesCPUs.push_back(cpus);
+        for (std::size_t i = 0; i < cpus.size(); ++i) {
+            if ( (int)topology.cpuToNode.size() <= cpus[i] ) {
+                topology.cpuToNode.resize(cpus[i] + 1, -1);
+            }
+            topology.cpuToNode[cpus[i]] = node;
+        }
+    }
+#endif
+    if ( topology.nodesCPUs.empty() ) {
+        ///Unknown topology: behave as a single node machine
+        topology.nodesCPUs.push_back( std::vector<int>() );
+    }
+    return topology;
+}
+
+///The topology does not change while the process runs: it is read once when the library is loaded so that
+///the render threads can query it without locking
+static const NumaTopologyPrivate topology = readTopology();
+
+static const NumaTopologyPrivate&
+getTopology()
+{
+    return topology;
+}
+
+} // anon namespace
+
+namespace Natron {
+namespace NUMA {
+
+int
+getNodesCount()
+{
+    return (int)getTopology().nodesCPUs.size();
+}
+
+const std::vector<int>&
+getNodeCPUs(int node)
+{
+    const NumaTopologyPrivate& t = getTopology();
+    assert( node >= 0 && node < (int)t.nodesCPUs.size() );
+    return t.nodesCPUs[node];
+}
+
+void
+setBindingEnabled(bool enabled)
+{
+    bindingEnabled = enabled ? 1 : 0;
+}
+
+bool
+isBindingEnabled()
+{
+    return (int)bindingEnabled && getNodesCount() > 1;
+}
+
+bool
+bindCurrentThreadToNode(int node)
+{
+    if ( !isBindingEnabled() ) {
+        return false;
+    }
+#ifdef NATRON_NUMA_LINUX
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (node == -1) {
+        ///Allow all CPUs again
+        const NumaTopologyPrivate& t = getTopology();
+        for (std::size_t i = 0; i < t.cpuToNode.size(); ++i) {
+            if (t.cpuToNode[i] != -1) {
+                CPU_SET(i, &set);
+            }
+        }
+    } else {
+        const std::vector<int>& cpus = getNodeCPUs(node);
+        if ( cpus.empty() ) {
+            return false;
+        }
+        for (std::size_t i = 0; i < cpus.size(); ++i) {
+            CPU_SET(cpus[i], &set);
+        }
+    }
+    if (pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &set) != 0) {
+        return false;
+    }
+    boundNode.setLocalData(node + 1);
+    return true;
+#else
+    (void)node;
+    return false;
+#endif
+}
+
+int
+getCurrentThreadNode()
+{
+    if ( boundNode.hasLocalData() ) {
+        int node = boundNode.localData() - 1;
+        if (node != -1) {
+            return node;
+        }
+    }
+#ifdef NATRON_NUMA_LINUX
+    int cpu = sched_getcpu();
+    const NumaTopologyPrivate& t = getTopology();
+    if ( cpu >= 0 && cpu < (int)t.cpuToNode.size() ) {
+        return t.cpuToNode[cpu];
+    }
+#endif
+    return -1;
+}
+
+int
+pickNodeForNewRenderThread()
+{
+    int nNodes = getNodesCount();
+    int n = nextNode.fetchAndAddRelaxed(1);
+    return n % nNodes;
+}
+
+void
+firstTouchPages(void* data,
+                std::size_t size)
+{
+    std::size_t pageSize = Natron::getMemoryPageSize();
+    volatile unsigned char* bytes = (volatile unsigned char*)data;
+
+    for (std::size_t i = 0; i < size; i += pageSize) {
+        bytes[i] = 0;
+    }
+}
+
+void
+notifyImageAccess(int imageNode)
+{
+    if (imageNode == -1 || !isBindingEnabled()) {
+        return;
+    }
+    int node = getCurrentThreadNode();
+    if (node == -1) {
+        return;
+    }
+    if (node == imageNode) {
+        countAccess(localAccesses, &localAccessesTotal);
+    } else {
+        countAccess(remoteAccesses, &remoteAccessesTotal);
+    }
+}
+
+void
+getAccessCounters(U64* local,
+                  U64* remote)
+{
+    QMutexLocker k(&accessTotalsMutex);
+
+    *local = localAccessesTotal + (unsigned int)(int)localAccesses;
+    *remote = remoteAccessesTotal + (unsigned int)(int)remoteAccesses;
+}
+
+void
+resetAccessCounters()
+{
+    QMutexLocker k(&accessTotalsMutex);
+
+    localAccesses = 0;
+    remoteAccesses = 0;
+    localAccessesTotal = 0;
+    remoteAccessesTotal = 0;
+}
+
+struct ThreadBinder::SavedAffinity
+{
+#ifdef NATRON_NUMA_LINUX
+    cpu_set_t mask;
+#endif
+};
+
+ThreadBinder::ThreadBinder(int node,
+                           bool onlyIfRemote)
+: _previousNode(-1)
+, _savedAffinity(0)
+{
+    if (node == -1 || !isBindingEnabled()) {
+        return;
+    }
+    if ( boundNode.hasLocalData() ) {
+        _previousNode = boundNode.localData() - 1;
+    }
+    if (_previousNode == node) {
+        return;
+    }
+    if ( onlyIfRemote && (_previousNode == -1) && (getCurrentThreadNode() == node) ) {
+        return;
+    }
+#ifdef NATRON_NUMA_LINUX
+    SavedAffinity* saved = new SavedAffinity;
+    if ( (pthread_getaffinity_np(pthread_self(), sizeof(cpu_set_t), &saved->mask) == 0) && bindCurrentThreadToNode(node) ) {
+        _savedAffinity = saved;
+    } else {
+        delete saved;
+    }
+#endif
+}
+
+ThreadBinder::~ThreadBinder()
+{
+    if (!_savedAffinity) {
+        return;
+    }
+#ifdef NATRON_NUMA_LINUX
+    pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &_savedAffinity->mask);
+#endif
+    boundNode.setLocalData(_previousNode + 1);
+    delete _savedAffinity;
+}
+
+} // namespace NUMA
+} // namespace Natron
@@ -0,0 +1,120 @@
+//  Natron
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef NATRON_ENGINE_NUMATOPOLOGY_H_
+#define NATRON_ENGINE_NUMATOPOLOGY_H_
+
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+
+#include <cstddef>
+#include <vector>
+
+#if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
+#include <boost/noncopyable.hpp>
+#endif
+
+#include "Global/Macros.h"
+#include "Global/GlobalDefines.h"
+
+/**
+ * @brief Helpers to place render threads and their images on the NUMA nodes of multi-socket machines.
+ *
+ * When the binding is enabled (see the "Bind render threads to NUMA nodes" preference), each frame render thread
+ * (RenderThreadTask) is bound to a NUMA node, round-robin. Thread-pool threads rendering tiles or running the
+ * multi-thread suite on behalf of a frame are bound to the node of the frame thread for the duration of the work.
+ * The pages of an image are written by the thread that creates it (@see firstTouchPages()), so with the kernel's
+ * first-touch policy they end up in the memory of that node.
+ *
+ * The topology is only detected on Linux (from /sys/devices/system/node). On other systems, or on machines
+ * with a single node, all functions are no-ops.
+ **/
+namespace Natron {
+namespace NUMA {
+
+/**
+ * @brief Returns the number of NUMA nodes of the machine, 1 if unknown.
+ **/
+int getNodesCount();
+
+/**
+ * @brief Returns the CPUs that belong to the given node.
+ **/
+const std::vector<int>& getNodeCPUs(int node);
+
+/**
+ * @brief Enable/disable the binding of render threads. Called by the Settings.
+ **/
+void setBindingEnabled(bool enabled);
+
+/**
+ * @brief Returns true if the binding is enabled and the machine has more than 1 node.
+ **/
+bool isBindingEnabled();
+
+/**
+ * @brief Binds the calling thread to the CPUs of the given node. Returns false on failure or
+ * if binding is disabled. Passing -1 removes any binding previously set by this function.
+ **/
+bool bindCurrentThreadToNode(int node);
+
+/**
+ * @brief Returns the node the calling thread was bound to with bindCurrentThreadToNode, or the node
+ * of the CPU it is currently running on, or -1 if unknown.
+ **/
+int getCurrentThreadNode();
+
+/**
+ * @brief Returns a node for a new frame render thread, distributing threads round-robin across nodes.
+ **/
+int pickNodeForNewRenderThread();
+
+/**
+ * @brief Writes the first byte of each page of the given zero-filled memory, so that the pages are placed on the node
+ * of the calling thread right away instead of on the node of the first thread that happens to write them.
+ **/
+void firstTouchPages(void* data,std::size_t size);
+
+/**
+ * @brief Counts an access to an image allocated on imageNode by the calling thread.
+ * This is what the remote access ratio reported by getAccessCounters is made of.
+ **/
+void notifyImageAccess(int imageNode);
+
+/**
+ * @brief Returns the number of local and remote image accesses counted since the process started or since the last
+ * call to resetAccessCounters(). Renders do not reset them: to measure a render, take the difference of the counters
+ * read before and after it.
+ **/
+void getAccessCounters(U64* localAccesses,U64* remoteAccesses);
+
+void resetAccessCounters();
+
+/**
+ * @brief Binds the calling thread to a node for the lifetime of the object and restores the CPU affinity the
+ * thread had before afterwards. Does nothing if binding is disabled or node is -1.
+ * If onlyIfRemote is true, the thread is not bound when it already runs on a CPU of the node: this spares 3 system
+ * calls per tile to the short-lived work of thread-pool threads, which the system rarely moves while it runs.
+ **/
+class ThreadBinder
+    : boost::noncopyable
+{
+    struct SavedAffinity;
+
+    int _previousNode;
+    SavedAffinity* _savedAffinity; //< non NULL if the thread was bound
+
+public:
+
+    ThreadBinder(int node,bool onlyIfRemote = false);
+
+    ~ThreadBinder();
+};
+
+} // namespace NUMA
+} // namespace Natron
+
+#endif // NATRON_ENGINE_NUMATOPOLOGY_H_
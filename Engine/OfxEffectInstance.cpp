@@ -2886,6 +2886,13 @@ OfxEffectInstance::isFrameVarying() const
     return effectInstance()->isFrameVarying();
 }
 
+bool
+OfxEffectInstance::isViewInvariant() const
+{
+    ///The view is passed to the actions of plug-ins, only readers are known to ignore it: their file name does not depend on the view
+    return isReader();
+}
+
 bool
 OfxEffectInstance::doesTemporalClipAccess() const
 {
@@ -274,6 +274,8 @@ public:
 
     virtual bool isFrameVarying() const OVERRIDE FINAL WARN_UNUSED_RETURN;
 
+    virtual bool isViewInvariant() const OVERRIDE FINAL WARN_UNUSED_RETURN;
+
     /********OVERRIDEN FROM EFFECT INSTANCE: END*************/
 
     OfxClipInstance* getClipCorrespondingToInput(int inputNo) const;
@@ -57,6 +57,7 @@ CLANG_DIAG_ON(deprecated-register)
 
 #include "Engine/AppManager.h"
 #include "Engine/OfxMemory.h"
+#include "Engine/OfxPluginRegistry.h"
 #include "Engine/LibraryBinary.h"
 #include "Engine/OfxEffectInstance.h"
 #include "Engine/OfxImageEffectInstance.h"
@@ -65,12 +66,16 @@ CLANG_DIAG_ON(deprecated-register)
 #include "Engine/StandardPaths.h"
 #include "Engine/Settings.h"
 #include "Engine/Node.h"
+#include "Engine/NumaTopology.h"
 
 using namespace Natron;
 
 
 Natron::OfxHost::OfxHost()
     : _imageEffectPluginCache( new OFX::Host::ImageEffect::PluginCache(*this) )
+    , _ofxCacheLoadedMutex(new QMutex)
+    , _ofxCacheLoaded(false)
+    , _loadedFromRegistry(false)
 #ifdef MULTI_THREAD_SUITE_USES_THREAD_SAFE_MUTEX_ALLOCATION
     , _pluginsMutexes()
     , _pluginsMutexesLock(new QMutex)
@@ -84,6 +89,7 @@ Natron::OfxHost::~OfxHost()
     OFX::Host::PluginCache::clearPluginCache();
 
     delete _imageEffectPluginCache;
+    delete _ofxCacheLoadedMutex;
 #ifdef MULTI_THREAD_SUITE_USES_THREAD_SAFE_MUTEX_ALLOCATION
     delete _pluginsMutexesLock;
 #endif
@@ -264,7 +270,9 @@ Natron::OfxHost::getPluginAndContextByID(const std::string & pluginID,
                                          OFX::Host::ImageEffect::ImageEffectPlugin** plugin,
                                          std::string & context)
 {
-    _imageEffectPluginCache->getPluginsByIDMajor();
+    ///When the plugins were registered from the registry, their descriptors are only known once the cache is read
+    ensureOFXCacheLoaded();
+
     // throws out_of_range if the plugin does not exist
     // Note: std::map.at() is C++11
     const std::map<OFX::Host::ImageEffect::MajorPlugin,OFX::Host::ImageEffect::ImageEffectPlugin *> & ofxPlugins =
@@ -448,6 +456,76 @@ Natron::OfxHost::loadOFXPlugins(std::map<std::string,std::vector< std::pair<std:
         // ignore
     }
 
+    QByteArray fingerprint = OfxPluginRegistry::computeFingerprint( OFX::Host::PluginCache::getPluginCache()->getPluginPath() );
+    std::list<OfxPluginRegistryEntry> entries;
+    _loadedFromRegistry = OfxPluginRegistry::read(fingerprint, &entries);
+    if (!_loadedFromRegistry) {
+        ensureOFXCacheLoaded();
+        makeRegistryEntries(&entries);
+        OfxPluginRegistry::write(fingerprint, entries);
+    }
+
+    for (std::list<OfxPluginRegistryEntry>::iterator it = entries.begin(); it != entries.end(); ++it) {
+        appPTR->registerPlugin( it->groups,
+                                it->openfxId.c_str(),
+                                it->label.c_str(),
+                                it->iconFilePath,
+                                it->groupIconFilePath,
+                                it->openfxId.c_str(),
+                                it->isReader,
+                                it->isWriter,
+                                new Natron::LibraryBinary(Natron::LibraryBinary::eLibraryTypeBuiltin),
+                                it->renderUnsafe,
+                                it->versionMajor, it->versionMinor );
+
+        if ( it->isReader && !it->formats.empty() && readersMap ) {
+            ///we're safe to assume that this plugin is a reader
+            for (U32 k = 0; k < it->formats.size(); ++k) {
+                std::map<std::string,std::vector< std::pair<std::string,double> > >::iterator found;
+                found = readersMap->find(it->formats[k]);
+
+                if ( found != readersMap->end() ) {
+                    found->second.push_back(std::make_pair(it->openfxId, it->evaluation));
+                } else {
+                    std::vector<std::pair<std::string,double> > newVec(1);
+                    newVec[0] = std::make_pair(it->openfxId,it->evaluation);
+                    readersMap->insert( std::make_pair(it->formats[k], newVec) );
+                }
+            }
+        } else if ( it->isWriter && !it->formats.empty() && writersMap ) {
+            ///we're safe to assume that this plugin is a writer.
+            for (U32 k = 0; k < it->formats.size(); ++k) {
+                std::map<std::string,std::vector< std::pair<std::string,double> > >::iterator found;
+                found = writersMap->find(it->formats[k]);
+
+                if ( found != writersMap->end() ) {
+                    found->second.push_back(std::make_pair(it->openfxId, it->evaluation));
+                } else {
+                    std::vector<std::pair<std::string,double> > newVec(1);
+                    newVec[0] = std::make_pair(it->openfxId,it->evaluation);
+                    writersMap->insert( std::make_pair(it->formats[k], newVec) );
+                }
+            }
+        }
+    }
+} // loadOFXPlugins
+
+bool
+Natron::OfxHost::wasLoadedFromRegistry() const
+{
+    return _loadedFromRegistry;
+}
+
+void
+Natron::OfxHost::ensureOFXCacheLoaded()
+{
+    QMutexLocker k(_ofxCacheLoadedMutex);
+
+    if (_ofxCacheLoaded) {
+        return;
+    }
+    _ofxCacheLoaded = true;
+
     /// now read an old cache
     // The cache location depends on the OS.
     // On OSX, it will be ~/Library/Caches/<organization>/<application>/OFXCache.xml
@@ -464,7 +542,11 @@ Natron::OfxHost::loadOFXPlugins(std::map<std::string,std::vector< std::pair<std:
     // write the cache NOW (it won't change anyway)
     /// flush out the current cache
     writeOFXCache();
+}
 
+void
+Natron::OfxHost::makeRegistryEntries(std::list<OfxPluginRegistryEntry>* entries)
+{
     /*Filling node name list and plugin grouping*/
     typedef std::map<OFX::Host::ImageEffect::MajorPlugin,OFX::Host::ImageEffect::ImageEffectPlugin *> PMap;
     const PMap& ofxPlugins =
@@ -479,19 +561,20 @@ Natron::OfxHost::loadOFXPlugins(std::map<std::string,std::vector< std::pair<std:
             continue;
         }
 
-        std::string openfxId = p->getIdentifier();
+        OfxPluginRegistryEntry e;
+        e.openfxId = p->getIdentifier();
         const std::string & grouping = p->getDescriptor().getPluginGrouping();
         const std::string & bundlePath = p->getBinary()->getBundlePath();
-        std::string pluginLabel = OfxEffectInstance::makePluginLabel( p->getDescriptor().getShortLabel(),
-                                                                      p->getDescriptor().getLabel(),
-                                                                      p->getDescriptor().getLongLabel() );
+        e.label = OfxEffectInstance::makePluginLabel( p->getDescriptor().getShortLabel(),
+                                                      p->getDescriptor().getLabel(),
+                                                      p->getDescriptor().getLongLabel() );
         
-        QStringList groups = OfxEffectInstance::makePluginGrouping(p->getIdentifier(),
-                                                                   p->getVersionMajor(), p->getVersionMinor(),
-                                                                   pluginLabel, grouping);
+        e.groups = OfxEffectInstance::makePluginGrouping(p->getIdentifier(),
+                                                         p->getVersionMajor(), p->getVersionMinor(),
+                                                         e.label, grouping);
 
         assert( p->getBinary() );
-        QString iconFilename = QString( bundlePath.c_str() ) + "/Contents/Resources/";
+        e.iconFilePath = QString( bundlePath.c_str() ) + "/Contents/Resources/";
         std::string pngIcon;
         try {
             // kOfxPropIcon is normally only defined for parameter desctriptors
@@ -502,83 +585,41 @@ Natron::OfxHost::loadOFXPlugins(std::map<std::string,std::vector< std::pair<std:
         }
         if (pngIcon.empty()) {
             // no icon defined by kOfxPropIcon, use the default value
-            pngIcon = openfxId + ".png";
+            pngIcon = e.openfxId + ".png";
         }
-        iconFilename.append( pngIcon.c_str() );
-        QString groupIconFilename;
-        if (groups.size() > 0) {
-            groupIconFilename = QString( p->getBinary()->getBundlePath().c_str() ) + "/Contents/Resources/";
+        e.iconFilePath.append( pngIcon.c_str() );
+        if (e.groups.size() > 0) {
+            e.groupIconFilePath = QString( p->getBinary()->getBundlePath().c_str() ) + "/Contents/Resources/";
             // the plugin grouping has no descriptor, just try the default filename.
-            groupIconFilename.append(groups[0]);
-            groupIconFilename.append(".png");
+            e.groupIconFilePath.append(e.groups[0]);
+            e.groupIconFilePath.append(".png");
         } else {
             //Use default Misc group when the plug-in doesn't belong to a group
-            groups.push_back(PLUGIN_GROUP_DEFAULT);
+            e.groups.push_back(PLUGIN_GROUP_DEFAULT);
         }
 
         
         const std::set<std::string> & contexts = p->getContexts();
-        std::set<std::string>::const_iterator foundReader = contexts.find(kOfxImageEffectContextReader);
-        std::set<std::string>::const_iterator foundWriter = contexts.find(kOfxImageEffectContextWriter);
-        
-        appPTR->registerPlugin( groups,
-                                openfxId.c_str(),
-                                pluginLabel.c_str(),
-                                iconFilename,
-                                groupIconFilename,
-                                p->getIdentifier().c_str(),
-                                foundReader != contexts.end(),
-                                foundWriter != contexts.end(),
-                                new Natron::LibraryBinary(Natron::LibraryBinary::eLibraryTypeBuiltin),
-                                p->getDescriptor().getRenderThreadSafety() == kOfxImageEffectRenderUnsafe,
-                                p->getVersionMajor(), p->getVersionMinor() );
-
+        e.isReader = contexts.find(kOfxImageEffectContextReader) != contexts.end();
+        e.isWriter = contexts.find(kOfxImageEffectContextWriter) != contexts.end();
+        e.renderUnsafe = p->getDescriptor().getRenderThreadSafety() == kOfxImageEffectRenderUnsafe;
+        e.versionMajor = p->getVersionMajor();
+        e.versionMinor = p->getVersionMinor();
 
         ///if this plugin's descriptor has the kTuttleOfxImageEffectPropSupportedExtensions property,
         ///use it to fill the readersMap and writersMap
         int formatsCount = p->getDescriptor().getProps().getDimension(kTuttleOfxImageEffectPropSupportedExtensions);
-        std::vector<std::string> formats(formatsCount);
+        e.formats.resize(formatsCount);
         for (int k = 0; k < formatsCount; ++k) {
-            formats[k] = p->getDescriptor().getProps().getStringProperty(kTuttleOfxImageEffectPropSupportedExtensions,k);
-            std::transform(formats[k].begin(), formats[k].end(), formats[k].begin(), ::tolower);
+            e.formats[k] = p->getDescriptor().getProps().getStringProperty(kTuttleOfxImageEffectPropSupportedExtensions,k);
+            std::transform(e.formats[k].begin(), e.formats[k].end(), e.formats[k].begin(), ::tolower);
         }
 
-        double evaluation = p->getDescriptor().getProps().getDoubleProperty(kTuttleOfxImageEffectPropEvaluation);
-        
-        
-
-
-        if ( ( foundReader != contexts.end() ) && (formatsCount > 0) && readersMap ) {
-            ///we're safe to assume that this plugin is a reader
-            for (U32 k = 0; k < formats.size(); ++k) {
-                std::map<std::string,std::vector< std::pair<std::string,double> > >::iterator it;
-                it = readersMap->find(formats[k]);
-
-                if ( it != readersMap->end() ) {
-                    it->second.push_back(std::make_pair(openfxId, evaluation));
-                } else {
-                    std::vector<std::pair<std::string,double> > newVec(1);
-                    newVec[0] = std::make_pair(openfxId,evaluation);
-                    readersMap->insert( std::make_pair(formats[k], newVec) );
-                }
-            }
-        } else if ( ( foundWriter != contexts.end() ) && (formatsCount > 0) && writersMap ) {
-            ///we're safe to assume that this plugin is a writer.
-            for (U32 k = 0; k < formats.size(); ++k) {
-                std::map<std::string,std::vector< std::pair<std::string,double> > >::iterator it;
-                it = writersMap->find(formats[k]);
+        e.evaluation = p->getDescriptor().getProps().getDoubleProperty(kTuttleOfxImageEffectPropEvaluation);
 
-                if ( it != writersMap->end() ) {
-                    it->second.push_back(std::make_pair(openfxId, evaluation));
-                } else {
-                    std::vector<std::pair<std::string,double> > newVec(1);
-                    newVec[0] = std::make_pair(openfxId,evaluation);
-                    writersMap->insert( std::make_pair(formats[k], newVec) );
-                }
-            }
-        }
+        entries->push_back(e);
     }
-} // loadOFXPlugins
+} // makeRegistryEntries
 
 void
 Natron::OfxHost::writeOFXCache()
@@ -608,6 +649,7 @@ Natron::OfxHost::clearPluginsLoadedCache()
     if ( QFile::exists(ofxcachename) ) {
         QFile::remove(ofxcachename);
     }
+    OfxPluginRegistry::remove();
 }
 
 void
@@ -694,9 +736,14 @@ static OfxStatus
 threadFunctionWrapper(OfxThreadFunctionV1 func,
                       unsigned int threadIndex,
                       unsigned int threadMax,
+                      int numaNode,
                       void *customArg)
 {
     assert(threadIndex < threadMax);
+    
+    ///Run on the NUMA node of the thread that called multiThread, where its images live
+    Natron::NUMA::ThreadBinder numaBinder(numaNode, true);
+    
     std::list<int>& localData = gThreadIndex.localData();
     localData.push_back((int)threadIndex);
 
@@ -725,11 +772,13 @@ public:
     OfxThread(OfxThreadFunctionV1 func,
               unsigned int threadIndex,
               unsigned int threadMax,
+              int numaNode,
               void *customArg,
               OfxStatus *stat)
         : _func(func)
           , _threadIndex(threadIndex)
           , _threadMax(threadMax)
+          , _numaNode(numaNode)
           , _customArg(customArg)
           , _stat(stat)
     {
@@ -738,6 +787,7 @@ public:
     void run() OVERRIDE
     {
         assert(_threadIndex < _threadMax);
+        Natron::NUMA::ThreadBinder numaBinder(_numaNode);
         std::list<int>& localData = gThreadIndex.localData();
         localData.push_back((int)_threadIndex);
         
@@ -758,6 +808,7 @@ private:
     OfxThreadFunctionV1 *_func;
     unsigned int _threadIndex;
     unsigned int _threadMax;
+    int _numaNode;
     void *_customArg;
     OfxStatus *_stat;
 };
@@ -805,6 +856,7 @@ Natron::OfxHost::multiThread(OfxThreadFunctionV1 func,
     }
 
     bool useThreadPool = appPTR->getUseThreadPool();
+    int numaNode = Natron::NUMA::getCurrentThreadNode();
     
     if (useThreadPool) {
         
@@ -815,7 +867,7 @@ Natron::OfxHost::multiThread(OfxThreadFunctionV1 func,
         
         /// DON'T set the maximum thread count, this is a global application setting, and see the documentation excerpt above
         //QThreadPool::globalInstance()->setMaxThreadCount(nThreads);
-        QFuture<OfxStatus> future = QtConcurrent::mapped( threadIndexes, boost::bind(::threadFunctionWrapper,func, _1, nThreads, customArg) );
+        QFuture<OfxStatus> future = QtConcurrent::mapped( threadIndexes, boost::bind(::threadFunctionWrapper,func, _1, nThreads, numaNode, customArg) );
         future.waitForFinished();
         ///DON'T reset back to the original value the maximum thread count
         //QThreadPool::globalInstance()->setMaxThreadCount(QThread::idealThreadCount());
@@ -834,7 +886,7 @@ Natron::OfxHost::multiThread(OfxThreadFunctionV1 func,
             // at most maxConcurrentThread should be running at the same time
             QVector<OfxThread*> threads(nThreads);
             for (unsigned int i = 0; i < nThreads; ++i) {
-                threads[i] = new OfxThread(func, i, nThreads, customArg, &status[i]);
+                threads[i] = new OfxThread(func, i, nThreads, numaNode, customArg, &status[i]);
             }
             unsigned int i = 0; // index of next thread to launch
             unsigned int running = 0; // number of running threads
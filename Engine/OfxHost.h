@@ -30,6 +30,7 @@ class AbstractOfxEffectInstance;
 class AppInstance;
 class QMutex;
 class NodeSerialization;
+struct OfxPluginRegistryEntry;
 class KnobSerialization;
 namespace Natron {
 class Node;
@@ -111,11 +112,24 @@ public:
 
     void addPathToLoadOFXPlugins(const std::string path);
 
-    /*Reads OFX plugin cache and scan plugins directories
+    /*Registers the plugins listed in the OFX plugin registry if it is up to date,
+       otherwise reads OFX plugin cache and scan plugins directories
        to load them all.*/
     void loadOFXPlugins(std::map<std::string,std::vector< std::pair<std::string,double> > >* readersMap,
                         std::map<std::string,std::vector< std::pair<std::string,double> > >* writersMap);
 
+    /**
+     * @brief Returns true if the plugins were registered from the OFX plugin registry by loadOFXPlugins,
+     * in which case the OFX plugin cache is only read when a plugin is instantiated for the first time.
+     **/
+    bool wasLoadedFromRegistry() const;
+
+    /**
+     * @brief Reads the OFX plugin cache and scans the plugins directories if it was not done yet.
+     * This is thread-safe.
+     **/
+    void ensureOFXCacheLoaded();
+
     void clearPluginsLoadedCache();
 
     void setThreadAsActionCaller(bool actionCaller);
@@ -128,7 +142,12 @@ private:
        the OFX plugin cache. (called by the destructor) */
     void writeOFXCache();
 
+    void makeRegistryEntries(std::list<OfxPluginRegistryEntry>* entries);
+
     OFX::Host::ImageEffect::PluginCache* _imageEffectPluginCache;
+    QMutex* _ofxCacheLoadedMutex;
+    bool _ofxCacheLoaded; //< protected by _ofxCacheLoadedMutex
+    bool _loadedFromRegistry;
 
 
     /*plugin name -> pair< plugin id , plugin grouping >
@@ -0,0 +1,192 @@
+//  Natron
+//
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+
+#include "OfxPluginRegistry.h"
+
+CLANG_DIAG_OFF(deprecated)
+#include <QtCore/QCryptographicHash>
+#include <QtCore/QDataStream>
+#include <QtCore/QDateTime>
+#include <QtCore/QDir>
+#include <QtCore/QDirIterator>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QDebug>
+CLANG_DIAG_ON(deprecated)
+
+#include "Global/GlobalDefines.h"
+
+#include "Engine/StandardPaths.h"
+
+#define NATRON_OFX_REGISTRY_MAGIC 0x4e4f4652 // "NOFR"
+#define NATRON_OFX_REGISTRY_VERSION 1
+
+namespace {
+
+void
+writeString(QDataStream & out,
+            const std::string & str)
+{
+    out << QByteArray( str.c_str(), (int)str.size() );
+}
+
+std::string
+readString(QDataStream & in)
+{
+    QByteArray str;
+
+    in >> str;
+
+    return std::string( str.constData(), str.size() );
+}
+
+}
+
+QString
+OfxPluginRegistry::getRegistryFilePath()
+{
+    return Natron::StandardPaths::writableLocation(Natron::StandardPaths::eStandardLocationCache) + QDir::separator() + "OFXRegistry.bin";
+}
+
+QByteArray
+OfxPluginRegistry::computeFingerprint(const std::list<std::string>& searchPaths)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+
+    hash.addData(NATRON_VERSION_STRING);
+    for (std::list<std::string>::const_iterator it = searchPaths.begin(); it != searchPaths.end(); ++it) {
+        hash.addData( it->c_str(), (int)it->size() );
+        hash.addData("\n", 1);
+
+        ///Only stat the files: the binaries are <bundle>.ofx.bundle/Contents/<arch>/<bundle>.ofx
+        QStringList binaries;
+        QDirIterator dirIt(QString( it->c_str() ), QDir::Files | QDir::NoDotAndDotDot,
+                           QDirIterator::Subdirectories | QDirIterator::FollowSymlinks);
+        while ( dirIt.hasNext() ) {
+            QString filePath = dirIt.next();
+            if ( !filePath.endsWith(".ofx") || !filePath.contains(".ofx.bundle/Contents/") ) {
+                continue;
+            }
+            QFileInfo info = dirIt.fileInfo();
+            binaries.push_back( filePath + '|' + QString::number( info.size() ) + '|' + QString::number( info.lastModified().toTime_t() ) );
+        }
+        binaries.sort();
+        for (int i = 0; i < binaries.size(); ++i) {
+            hash.addData( binaries[i].toUtf8() );
+            hash.addData("\n", 1);
+        }
+    }
+
+    return hash.result();
+}
+
+bool
+OfxPluginRegistry::read(const QByteArray& fingerprint,
+                        std::list<OfxPluginRegistryEntry>* entries)
+{
+    QFile file( getRegistryFilePath() );
+
+    if ( !file.open(QIODevice::ReadOnly) || (file.size() == 0) ) {
+        return false;
+    }
+
+    ///The registry is read in one go from the mapping, without copying it
+    uchar* data = file.map( 0, file.size() );
+    if (!data) {
+        return false;
+    }
+    QByteArray raw = QByteArray::fromRawData( (const char*)data, (int)file.size() );
+    QDataStream in(raw);
+    in.setVersion(QDataStream::Qt_4_8);
+
+    bool ok = false;
+    quint32 magic,version;
+    QByteArray storedFingerprint;
+    in >> magic >> version >> storedFingerprint;
+    if ( (in.status() == QDataStream::Ok) && (magic == NATRON_OFX_REGISTRY_MAGIC) && (version == NATRON_OFX_REGISTRY_VERSION) &&
+         (storedFingerprint == fingerprint) ) {
+        quint32 count;
+        in >> count;
+        for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+            OfxPluginRegistryEntry e;
+            e.openfxId = readString(in);
+            e.label = readString(in);
+            qint32 major,minor;
+            quint32 nFormats;
+            in >> e.groups >> e.iconFilePath >> e.groupIconFilePath >> e.isReader >> e.isWriter >> e.renderUnsafe
+               >> major >> minor >> e.evaluation >> nFormats;
+            e.versionMajor = major;
+            e.versionMinor = minor;
+            for (quint32 k = 0; k < nFormats && in.status() == QDataStream::Ok; ++k) {
+                e.formats.push_back( readString(in) );
+            }
+            entries->push_back(e);
+        }
+        ok = in.status() == QDataStream::Ok;
+    }
+
+    file.unmap(data);
+    if (!ok) {
+        entries->clear();
+    }
+
+    return ok;
+}
+
+bool
+OfxPluginRegistry::write(const QByteArray& fingerprint,
+                         const std::list<OfxPluginRegistryEntry>& entries)
+{
+    QString filePath = getRegistryFilePath();
+
+    QDir().mkpath( QFileInfo(filePath).absolutePath() );
+
+    ///Write next to the registry and then replace it, so a concurrent startup never reads a partial registry
+    QString tmpFilePath = filePath + ".tmp";
+    {
+        QFile file(tmpFilePath);
+        if ( !file.open(QIODevice::WriteOnly | QIODevice::Truncate) ) {
+            qDebug() << "Failed to write the OpenFX plug-ins registry to" << tmpFilePath;
+
+            return false;
+        }
+        QDataStream out(&file);
+        out.setVersion(QDataStream::Qt_4_8);
+        out << (quint32)NATRON_OFX_REGISTRY_MAGIC << (quint32)NATRON_OFX_REGISTRY_VERSION << fingerprint << (quint32)entries.size();
+        for (std::list<OfxPluginRegistryEntry>::const_iterator it = entries.begin(); it != entries.end(); ++it) {
+            writeString(out, it->openfxId);
+            writeString(out, it->label);
+            out << it->groups << it->iconFilePath << it->groupIconFilePath << it->isReader << it->isWriter << it->renderUnsafe
+                << (qint32)it->versionMajor << (qint32)it->versionMinor << it->evaluation << (quint32)it->formats.size();
+            for (U32 k = 0; k < it->formats.size(); ++k) {
+                writeString(out, it->formats[k]);
+            }
+        }
+        if (out.status() != QDataStream::Ok) {
+            file.close();
+            QFile::remove(tmpFilePath);
+
+            return false;
+        }
+    }
+    QFile::remove(filePath);
+
+    return QFile::rename(tmpFilePath, filePath);
+}
+
+void
+OfxPluginRegistry::remove()
+{
+    QString filePath = getRegistryFilePath();
+
+    if ( QFile::exists(filePath) ) {
+        QFile::remove(filePath);
+    }
+}
@@ -0,0 +1,98 @@
+//  Natron
+//
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef NATRON_ENGINE_OFXPLUGINREGISTRY_H_
+#define NATRON_ENGINE_OFXPLUGINREGISTRY_H_
+
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+
+#include <list>
+#include <string>
+#include <vector>
+
+#include "Global/Macros.h"
+CLANG_DIAG_OFF(deprecated)
+#include <QtCore/QByteArray>
+#include <QtCore/QString>
+#include <QtCore/QStringList>
+CLANG_DIAG_ON(deprecated)
+
+/**
+ * @brief Everything Natron needs to know about an OpenFX plug-in to list it in the application
+ * (node menus, readers/writers per file extension) without loading the OFX plug-in cache.
+ **/
+struct OfxPluginRegistryEntry
+{
+    std::string openfxId;
+    std::string label;
+    QStringList groups;
+    QString iconFilePath;
+    QString groupIconFilePath;
+    bool isReader;
+    bool isWriter;
+    bool renderUnsafe;
+    int versionMajor;
+    int versionMinor;
+    std::vector<std::string> formats; //< lower case file extensions, for readers and writers
+    double evaluation; //< how good the reader/writer is for these formats
+
+    OfxPluginRegistryEntry()
+    : openfxId()
+    , label()
+    , groups()
+    , iconFilePath()
+    , groupIconFilePath()
+    , isReader(false)
+    , isWriter(false)
+    , renderUnsafe(false)
+    , versionMajor(0)
+    , versionMinor(0)
+    , formats()
+    , evaluation(0.)
+    {
+    }
+};
+
+/**
+ * @brief A compact binary file (OFXRegistry.bin, next to OFXCache.xml) listing the OpenFX plug-ins
+ * found by the last full scan.
+ *
+ * Reading OFXCache.xml means parsing the descriptors of every parameter of every plug-in, which
+ * dominates the startup time when many plug-ins are installed. The registry only holds what is
+ * needed to register the plug-ins, so the XML cache can be read later, the first time a plug-in
+ * is actually instantiated.
+ *
+ * The registry is only valid for the fingerprint it was written with: the Natron version, the
+ * plug-ins search paths and the path, size and modification date of every plug-in binary.
+ **/
+class OfxPluginRegistry
+{
+public:
+
+    static QString getRegistryFilePath();
+
+    /**
+     * @brief Scans the search paths (without loading anything) for plug-in bundles and returns
+     * a fingerprint of what was found.
+     **/
+    static QByteArray computeFingerprint(const std::list<std::string>& searchPaths);
+
+    /**
+     * @brief Reads the registry. Returns false if it does not exist, is corrupted or was written
+     * with another fingerprint, in which case a full scan must be done.
+     **/
+    static bool read(const QByteArray& fingerprint,
+                     std::list<OfxPluginRegistryEntry>* entries) WARN_UNUSED_RETURN;
+
+    static bool write(const QByteArray& fingerprint,
+                      const std::list<OfxPluginRegistryEntry>& entries);
+
+    static void remove();
+};
+
+#endif // NATRON_ENGINE_OFXPLUGINREGISTRY_H_
@@ -15,9 +15,15 @@
 
 #include "OutputSchedulerThread.h"
 
+#include <algorithm>
 #include <iostream>
 #include <set>
 #include <list>
+#include <map>
+#include <vector>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
 #include <QMetaType>
 #include <QMutex>
 #include <QWaitCondition>
@@ -30,15 +36,22 @@
 #include <QFutureWatcher>
 #include <QRunnable>
 
+#if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
+#include <boost/bind.hpp>
+#endif
+
 #include "Global/MemoryInfo.h"
 
 #include "Engine/AppManager.h"
 #include "Engine/AppInstance.h"
+#include "Engine/CacheIO.h"
 #include "Engine/EffectInstance.h"
 #include "Engine/Image.h"
 #include "Engine/Node.h"
+#include "Engine/NumaTopology.h"
 #include "Engine/OpenGLViewerI.h"
 #include "Engine/Project.h"
+#include "Engine/RenderScheduler.h"
 #include "Engine/Settings.h"
 #include "Engine/Timer.h"
 #include "Engine/TimeLine.h"
@@ -47,6 +60,19 @@
 
 #define NATRON_FPS_REFRESH_RATE_SECONDS 1.5
 
+///A frame displayed later than this fraction of the frame duration after it was due is counted as late in the playback statistics
+#define NATRON_PLAYBACK_LATE_FRAME_THRESHOLD 0.5
+
+///Maximum number of (node,time) pairs visited to find out which frames of the tree a frame needs
+#define NATRON_FRAMES_NEEDED_MAX_VISITS 1000
+
+///Interval at which the render threads waiting for the other writers of their render group check whether they must quit
+#define NATRON_RENDER_GROUP_WAIT_TIMEOUT_MS 50
+
+///Streaming renders remove the images no longer needed from the node cache every few frames, so that on average
+///no more than this number of cache entries are scanned per frame rendered
+#define NATRON_STREAMING_EVICTION_ENTRIES_PER_FRAME 256
+
 
 using namespace Natron;
 
@@ -170,6 +196,15 @@ struct OutputSchedulerThreadPrivate
     
     boost::scoped_ptr<Timer> timer; // Timer regulating the engine execution. It is controlled by the GUI and MT-safe.
     
+    ///Statistics of the current playback session, reset by startRender()
+    PlaybackStatistics stats;
+    TimeLapse statsSessionTime; //< time since startRender() was called
+    
+    ///The cache I/O of the current render, and of the last one once stopped
+    boost::scoped_ptr<Natron::CacheIO::StatsRecorder> cacheIOStatsRecorder;
+    Natron::CacheIO::Stats cacheIOStats;
+    mutable QMutex statsMutex; // protects stats & statsSessionTime & cacheIOStatsRecorder & cacheIOStats
+    
     
     ///The idea here is that the render() function will set the requestedRunArgs, and once the scheduler has finished
     ///the previous render it will copy them to the livingRunArgs to fullfil the new render request
@@ -180,7 +215,11 @@ struct OutputSchedulerThreadPrivate
     U64 nFramesRendered;
     bool renderFinished; //< set to true when nFramesRendered = livingRunArgs.lastFrame - livingRunArgs.firstFrame + 1
     
-    QMutex runArgsMutex; // protects requestedRunArgs & livingRunArgs & nFramesRendered
+    ///Set by notifyRenderFailure, reset when a new render is requested
+    bool renderFailed;
+    std::string renderFailure; //< the message of the first failure
+    
+    QMutex runArgsMutex; // protects requestedRunArgs & livingRunArgs & nFramesRendered & renderFailed & renderFailure
     
 
     ///Worker threads
@@ -193,6 +232,10 @@ struct OutputSchedulerThreadPrivate
     QMutex framesToRenderMutex; // protects framesToRender & currentFrameRequests
     std::list<int> framesToRender;
     
+    ///framesToRender sorted by frame, to find quickly the frames close to a given one. Protected by framesToRenderMutex
+    typedef std::multimap<int,std::list<int>::iterator> FramesToRenderIndex;
+    FramesToRenderIndex framesToRenderIndex;
+    
     ///index of the last frame pushed (framesToRender.back())
     ///we store this because when we call pushFramesToRender we need to know what was the last frame that was queued
     ///Protected by framesToRenderMutex
@@ -200,6 +243,32 @@ struct OutputSchedulerThreadPrivate
     
     ///Render threads wait in this condition and the scheduler wake them when it needs to render some frames
     QWaitCondition framesToRenderNotEmptyCond;
+    
+    ///For cache-aware frame ordering, the count of upstream frames that 2 output frames d frames apart both need,
+    ///indexed by d. Empty if distinct frames never share upstream frames or if cache-aware ordering is disabled.
+    ///When not empty, render threads pick the frame sharing the most upstream frames with the frames being rendered
+    ///instead of the next one in the sequence, so that the upstream frames they need are still in the cache.
+    ///Protected by framesToRenderMutex
+    std::vector<int> framesNeededOverlap;
+    
+    ///The last frame picked by each render thread. Protected by framesToRenderMutex
+    std::map<RenderThreadTask*,int> lastFramePicked;
+    
+    ///Streaming renders on disk (see AppManager::isStreamingRenderEnabled()): images are removed from the node cache
+    ///as soon as all the frames that may need them are rendered.
+    ///streamingOffsets is, for the hash of each node of the tree, the offsets [min,max] between the times of the node
+    ///needed by an output frame and that output frame.
+    ///All the streaming members are protected by streamingMutex
+    bool streaming;
+    int streamingDirection; //< 1 when rendering forward, -1 otherwise
+    std::map<U64,std::pair<int,int> > streamingOffsets;
+    U64 streamingTreeVersion; //< the hash of the output effect when streamingOffsets were computed
+    std::list<boost::shared_ptr<Natron::Node> > streamingSingleUseNodes; //< nodes flagged with Node::setOutputSingleUse
+    int streamingNextFrame; //< the first frame, in the render direction, that is not rendered yet
+    std::set<int> streamingRenderedFrames; //< the frames rendered past streamingNextFrame
+    int streamingLastEvictionFrame; //< streamingNextFrame when images were last removed from the cache
+    int streamingEvictionInterval; //< how many frames must be rendered before removing images from the cache again
+    QMutex streamingMutex;
 
     
     Natron::OutputEffectInstance* outputEffect; //< The effect used as output device
@@ -233,10 +302,17 @@ struct OutputSchedulerThreadPrivate
     , processMutex()
     , mode(mode)
     , timer(new Timer)
+    , stats()
+    , statsSessionTime()
+    , cacheIOStatsRecorder()
+    , cacheIOStats()
+    , statsMutex()
     , requestedRunArgs()
     , livingRunArgs()
     , nFramesRendered(0)
     , renderFinished(false)
+    , renderFailed(false)
+    , renderFailure()
     , runArgsMutex()
     , renderThreadsMutex()
     , renderThreads()
@@ -244,8 +320,21 @@ struct OutputSchedulerThreadPrivate
     , allRenderThreadsQuitCond()
     , framesToRenderMutex()
     , framesToRender()
+    , framesToRenderIndex()
     , lastFramePushedIndex(0)
     , framesToRenderNotEmptyCond()
+    , framesNeededOverlap()
+    , lastFramePicked()
+    , streaming(false)
+    , streamingDirection(1)
+    , streamingOffsets()
+    , streamingTreeVersion(0)
+    , streamingSingleUseNodes()
+    , streamingNextFrame(0)
+    , streamingRenderedFrames()
+    , streamingLastEvictionFrame(0)
+    , streamingEvictionInterval(1)
+    , streamingMutex()
     , outputEffect(effect)
     , engine(engine)
     , runningCallback(false)
@@ -288,6 +377,19 @@ struct OutputSchedulerThreadPrivate
         buf = newBuf;
     }
     
+    bool isFrameBuffered(int time) const
+    {
+        ///Private, shouldn't lock
+        assert(!bufMutex.tryLock());
+        
+        for (FrameBuffer::const_iterator it = buf.begin(); it != buf.end(); ++it) {
+            if (it->time == time && it->frame) {
+                return true;
+            }
+        }
+        return false;
+    }
+    
     void clearBuffer()
     {
         ///Private, shouldn't lock
@@ -338,6 +440,58 @@ struct OutputSchedulerThreadPrivate
                                      int lastFrame,
                                      int* nextFrame);
     
+    /**
+     * @brief Walks the tree upstream of the output effect using the frames needed by each node to render
+     * the given time, and returns for each effect visited the first and the last of its frames needed.
+     **/
+    void computeFramesNeededRanges(int time,std::map<Natron::EffectInstance*,std::pair<int,int> >* ranges);
+    
+    /**
+     * @brief Computes framesNeededOverlap from the frames needed in the whole tree to render the given time:
+     * a node needed on [time + first, time + last] by each output frame has last - first + 1 - d of its frames
+     * needed by 2 output frames d frames apart.
+     **/
+    void computeFramesNeededOverlap(int time,std::vector<int>* overlap);
+    
+    /**
+     * @brief Sets up a streaming render (see AppManager::isStreamingRenderEnabled()) of the frame range, rendered from firstFrame
+     * in the given direction: computes how long each node images are needed and flags the nodes whose images are
+     * used by a single frame.
+     **/
+    void startStreaming(int firstFrame,OutputSchedulerThread::RenderDirectionEnum direction);
+    
+    /**
+     * @brief Called when all views of a frame are rendered. When all frames before it are rendered too, removes from the
+     * node cache the images that no frame left to render needs.
+     **/
+    void onStreamingFrameRendered(int frame);
+    
+    /**
+     * @brief Sets streamingOffsets and the single-use nodes from the ranges of frames needed to render the given time.
+     * Must be called with streamingMutex held.
+     **/
+    void setStreamingOffsets_locked(int time,const std::map<Natron::EffectInstance*,std::pair<int,int> > & ranges);
+    
+    void clearStreamingSingleUseNodes_locked();
+    
+    void stopStreaming();
+    
+    /**
+     * @brief Removes from framesToRender the frame that shares the most upstream frames with the frames the render threads
+     * are rendering (or have just rendered), preferring on ties the one following the last frame of the given thread.
+     * Only the maxLead first frames of the sequence are considered so that the frames waiting to be written do not
+     * fill the buffer while the next frame to write is not rendered. If no frame shares upstream frames, the first one
+     * is picked.
+     * Must be called with framesToRenderMutex held and framesToRender not empty.
+     **/
+    int pickFrameSharingInputs_locked(RenderThreadTask* thread,int maxLead);
+    
+    ///framesToRender must only be modified with these so that framesToRenderIndex stays in sync.
+    ///Must be called with framesToRenderMutex held
+    void appendFrameToRender_locked(int frame);
+    int takeFrameToRender_locked(std::list<int>::iterator it);
+    void clearFramesToRender_locked();
+    
     /**
      * @brief Checks if mustQuit has been set to true, if so then it will return true and the scheduler thread should stop
      **/
@@ -424,13 +578,310 @@ struct OutputSchedulerThreadPrivate
     
 };
 
+void
+OutputSchedulerThreadPrivate::computeFramesNeededRanges(int time,
+                                                        std::map<Natron::EffectInstance*,std::pair<int,int> >* ranges)
+{
+    typedef std::pair<Natron::EffectInstance*,int> NodeTime;
+    std::set<NodeTime> visited;
+    std::list<NodeTime> toVisit;
+    toVisit.push_back( std::make_pair(outputEffect, time) );
+    (*ranges)[outputEffect] = std::make_pair(time, time);
+    
+    while ( !toVisit.empty() && (int)visited.size() < NATRON_FRAMES_NEEDED_MAX_VISITS ) {
+        NodeTime current = toVisit.front();
+        toVisit.pop_front();
+        if ( !visited.insert(current).second ) {
+            continue;
+        }
+        
+        EffectInstance::FramesNeededMap framesNeeded = current.first->getFramesNeeded_public(current.second);
+        for (EffectInstance::FramesNeededMap::iterator it = framesNeeded.begin(); it != framesNeeded.end(); ++it) {
+            Natron::EffectInstance* input = current.first->getInput(it->first);
+            if (!input) {
+                continue;
+            }
+            int inputFirst = INT_MAX;
+            int inputLast = INT_MIN;
+            for (U32 i = 0; i < it->second.size(); ++i) {
+                inputFirst = std::min( inputFirst, (int)std::floor(it->second[i].min) );
+                inputLast = std::max( inputLast, (int)std::ceil(it->second[i].max) );
+            }
+            if (inputFirst > inputLast) {
+                continue;
+            }
+            std::map<Natron::EffectInstance*,std::pair<int,int> >::iterator found = ranges->find(input);
+            if ( found == ranges->end() ) {
+                (*ranges)[input] = std::make_pair(inputFirst, inputLast);
+            } else {
+                found->second.first = std::min(found->second.first, inputFirst);
+                found->second.second = std::max(found->second.second, inputLast);
+            }
+            
+            ///Offsets accumulate along the tree, so following the extremes is enough to find the ranges
+            toVisit.push_back( std::make_pair(input, inputFirst) );
+            if (inputLast != inputFirst) {
+                toVisit.push_back( std::make_pair(input, inputLast) );
+            }
+        }
+    }
+}
+
+void
+OutputSchedulerThreadPrivate::computeFramesNeededOverlap(int time,
+                                                         std::vector<int>* overlap)
+{
+    std::map<Natron::EffectInstance*,std::pair<int,int> > ranges;
+    computeFramesNeededRanges(time, &ranges);
+    
+    overlap->clear();
+    for (std::map<Natron::EffectInstance*,std::pair<int,int> >::iterator it = ranges.begin(); it != ranges.end(); ++it) {
+        ///Only the width of the window matters: a window offset from the output time is shared all the same
+        int width = it->second.second - it->second.first + 1;
+        if ( width > (int)overlap->size() ) {
+            overlap->resize(width, 0);
+        }
+        for (int d = 0; d < width; ++d) {
+            (*overlap)[d] += width - d;
+        }
+    }
+    if (overlap->size() <= 1) {
+        ///Distinct output frames never need the same upstream frames
+        overlap->clear();
+    }
+}
+
+void
+OutputSchedulerThreadPrivate::startStreaming(int firstFrame,
+                                             OutputSchedulerThread::RenderDirectionEnum direction)
+{
+    std::map<Natron::EffectInstance*,std::pair<int,int> > ranges;
+    computeFramesNeededRanges(firstFrame, &ranges);
+    
+    QMutexLocker l(&streamingMutex);
+    streaming = true;
+    streamingDirection = direction == OutputSchedulerThread::eRenderDirectionForward ? 1 : -1;
+    streamingNextFrame = firstFrame;
+    streamingRenderedFrames.clear();
+    streamingLastEvictionFrame = firstFrame;
+    streamingEvictionInterval = 1;
+    setStreamingOffsets_locked(firstFrame, ranges);
+}
+
+void
+OutputSchedulerThreadPrivate::setStreamingOffsets_locked(int time,
+                                                         const std::map<Natron::EffectInstance*,std::pair<int,int> > & ranges)
+{
+    assert( !streamingMutex.tryLock() );
+    clearStreamingSingleUseNodes_locked();
+    streamingOffsets.clear();
+    streamingTreeVersion = outputEffect->getHash();
+    for (std::map<Natron::EffectInstance*,std::pair<int,int> >::const_iterator it = ranges.begin(); it != ranges.end(); ++it) {
+        std::pair<int,int> offsets(it->second.first - time, it->second.second - time);
+        streamingOffsets[it->first->getHash()] = offsets;
+        
+        ///An image is used by a single output frame if the node is needed at a single offset through a single output
+        boost::shared_ptr<Natron::Node> node = it->first->getNode();
+        std::list<Natron::Node*> outputs;
+        node->getOutputs_mt_safe(outputs);
+        if ( (offsets.first == offsets.second) && (outputs.size() <= 1) ) {
+            node->setOutputSingleUse(true);
+            streamingSingleUseNodes.push_back(node);
+        }
+    }
+}
+
+void
+OutputSchedulerThreadPrivate::clearStreamingSingleUseNodes_locked()
+{
+    assert( !streamingMutex.tryLock() );
+    for (std::list<boost::shared_ptr<Natron::Node> >::iterator it = streamingSingleUseNodes.begin(); it != streamingSingleUseNodes.end(); ++it) {
+        (*it)->setOutputSingleUse(false);
+    }
+    streamingSingleUseNodes.clear();
+}
+
+void
+OutputSchedulerThreadPrivate::onStreamingFrameRendered(int frame)
+{
+    int nextFrame;
+    bool treeChanged;
+    {
+        QMutexLocker l(&streamingMutex);
+        if (!streaming) {
+            return;
+        }
+        if ( (frame - streamingNextFrame) * streamingDirection < 0 ) {
+            ///Already accounted for
+            return;
+        }
+        streamingRenderedFrames.insert(frame);
+        nextFrame = streamingNextFrame;
+        while ( streamingRenderedFrames.erase(nextFrame) ) {
+            nextFrame += streamingDirection;
+        }
+        if (nextFrame == streamingNextFrame) {
+            return;
+        }
+        streamingNextFrame = nextFrame;
+        
+        ///Removing images scans the whole node cache: only do it every streamingEvictionInterval frames
+        if ( (nextFrame - streamingLastEvictionFrame) * streamingDirection < streamingEvictionInterval ) {
+            return;
+        }
+        streamingLastEvictionFrame = nextFrame;
+        
+        ///If a parameter changed, the images of the tree have other hashes and may need other frames
+        treeChanged = outputEffect->getHash() != streamingTreeVersion;
+    }
+    
+    if (treeChanged) {
+        std::map<Natron::EffectInstance*,std::pair<int,int> > ranges;
+        computeFramesNeededRanges(nextFrame, &ranges);
+        
+        QMutexLocker l(&streamingMutex);
+        if (!streaming) {
+            return;
+        }
+        setStreamingOffsets_locked(nextFrame, ranges);
+    }
+    
+    ///The other writers of the render group may share images with this one: keep what the slowest needs
+    boost::shared_ptr<OutputRenderGroup> renderGroup = outputEffect->getRenderGroup();
+    
+    std::map<U64,std::pair<SequenceTime,SequenceTime> > rangesToKeep;
+    {
+        QMutexLocker l(&streamingMutex);
+        if (renderGroup && streamingDirection > 0) {
+            nextFrame = std::min( nextFrame, renderGroup->getSlowestNextFrame() );
+        }
+        
+        ///Only the frames from nextFrame onwards are left to render: keep what they need
+        for (std::map<U64,std::pair<int,int> >::iterator it = streamingOffsets.begin(); it != streamingOffsets.end(); ++it) {
+            if (streamingDirection > 0) {
+                rangesToKeep[it->first] = std::make_pair(nextFrame + it->second.first, INT_MAX);
+            } else {
+                rangesToKeep[it->first] = std::make_pair(INT_MIN, nextFrame + it->second.second);
+            }
+        }
+    }
+    std::size_t entriesScanned = appPTR->removeAllImagesFromCacheWithMatchingKeyOutsideTimeRange(rangesToKeep);
+    
+    QMutexLocker l(&streamingMutex);
+    streamingEvictionInterval = std::max( 1, (int)(entriesScanned / NATRON_STREAMING_EVICTION_ENTRIES_PER_FRAME) );
+}
+
+void
+OutputSchedulerThreadPrivate::stopStreaming()
+{
+    QMutexLocker l(&streamingMutex);
+    if (!streaming) {
+        return;
+    }
+    clearStreamingSingleUseNodes_locked();
+    streamingOffsets.clear();
+    streamingRenderedFrames.clear();
+    streaming = false;
+}
+
+int
+OutputSchedulerThreadPrivate::pickFrameSharingInputs_locked(RenderThreadTask* thread,
+                                                            int maxLead)
+{
+    assert( !framesToRenderMutex.tryLock() );
+    assert( !framesToRender.empty() );
+    assert( !framesNeededOverlap.empty() );
+    
+    int directionSign;
+    {
+        QMutexLocker l(&runArgsMutex);
+        directionSign = livingRunArgs.timelineDirection == OutputSchedulerThread::eRenderDirectionForward ? 1 : -1;
+    }
+    
+    ///Frames are pushed in the sequence order, so the first one is the next frame to write
+    int first = framesToRender.front();
+    int leadLimit = first + (std::max(1, maxLead) - 1) * directionSign;
+    int maxDistance = (int)framesNeededOverlap.size() - 1;
+    std::map<RenderThreadTask*,int>::iterator last = lastFramePicked.find(thread);
+    
+    std::list<int>::iterator picked = framesToRender.begin();
+    int bestScore = 0;
+    int bestCost = INT_MAX;
+    for (std::map<RenderThreadTask*,int>::iterator running = lastFramePicked.begin(); running != lastFramePicked.end(); ++running) {
+        ///Only the frames less than maxDistance frames apart from a running frame share upstream frames with it
+        int rangeFirst = std::max( running->second - maxDistance, std::min(first, leadLimit) );
+        int rangeLast = std::min( running->second + maxDistance, std::max(first, leadLimit) );
+        if (rangeFirst > rangeLast) {
+            continue;
+        }
+        FramesToRenderIndex::iterator end = framesToRenderIndex.upper_bound(rangeLast);
+        for (FramesToRenderIndex::iterator it = framesToRenderIndex.lower_bound(rangeFirst); it != end; ++it) {
+            int score = 0;
+            for (std::map<RenderThreadTask*,int>::iterator other = lastFramePicked.begin(); other != lastFramePicked.end(); ++other) {
+                int distance = std::abs(it->first - other->second);
+                if (distance <= maxDistance) {
+                    score += framesNeededOverlap[distance];
+                }
+            }
+            ///On ties, prefer the frame closest to the last frame of the thread, following it in the render direction
+            int cost = 0;
+            if ( last != lastFramePicked.end() ) {
+                int offset = (it->first - last->second) * directionSign;
+                cost = offset > 0 ? 2 * offset - 1 : -2 * offset;
+            }
+            if ( (score > bestScore) || ( (score == bestScore) && (cost < bestCost) ) ) {
+                bestScore = score;
+                bestCost = cost;
+                picked = it->second;
+            }
+        }
+    }
+    
+    int ret = takeFrameToRender_locked(picked);
+    lastFramePicked[thread] = ret;
+    
+    return ret;
+}
+
+void
+OutputSchedulerThreadPrivate::appendFrameToRender_locked(int frame)
+{
+    assert( !framesToRenderMutex.tryLock() );
+    framesToRender.push_back(frame);
+    framesToRenderIndex.insert( std::make_pair( frame, --framesToRender.end() ) );
+}
+
+int
+OutputSchedulerThreadPrivate::takeFrameToRender_locked(std::list<int>::iterator it)
+{
+    assert( !framesToRenderMutex.tryLock() );
+    int frame = *it;
+    std::pair<FramesToRenderIndex::iterator,FramesToRenderIndex::iterator> range = framesToRenderIndex.equal_range(frame);
+    for (FramesToRenderIndex::iterator found = range.first; found != range.second; ++found) {
+        if (found->second == it) {
+            framesToRenderIndex.erase(found);
+            break;
+        }
+    }
+    framesToRender.erase(it);
+    
+    return frame;
+}
+
+void
+OutputSchedulerThreadPrivate::clearFramesToRender_locked()
+{
+    assert( !framesToRenderMutex.tryLock() );
+    framesToRender.clear();
+    framesToRenderIndex.clear();
+}
 
 OutputSchedulerThread::OutputSchedulerThread(RenderEngine* engine,Natron::OutputEffectInstance* effect,ProcessFrameModeEnum mode)
 : QThread()
 , _imp(new OutputSchedulerThreadPrivate(engine,effect,mode))
 {
-    QObject::connect(this, SIGNAL(s_doProcessOnMainThread(BufferedFrames,bool,int)), this,
-                     SLOT(doProcessFrameMainThread(BufferedFrames,bool,int)));
+    QObject::connect(this, SIGNAL(s_doProcessOnMainThread(BufferedFrames,bool,bool,int)), this,
+                     SLOT(doProcessFrameMainThread(BufferedFrames,bool,bool,int)));
     
     QObject::connect(_imp->timer.get(), SIGNAL(fpsChanged(double,double)), _imp->engine, SIGNAL(fpsChanged(double,double)));
     
@@ -589,12 +1040,12 @@ OutputSchedulerThread::pushFramesToRenderInternal(int startingFrame,int nThreads
     
     
     if (firstFrame == lastFrame) {
-        _imp->framesToRender.push_back(startingFrame);
+        _imp->appendFrameToRender_locked(startingFrame);
         _imp->lastFramePushedIndex = startingFrame;
     } else {
         ///Push 2x the count of threads to be sure no one will be waiting
         while ((int)_imp->framesToRender.size() < nThreads * 2) {
-            _imp->framesToRender.push_back(startingFrame);
+            _imp->appendFrameToRender_locked(startingFrame);
             
             _imp->lastFramePushedIndex = startingFrame;
             
@@ -625,11 +1076,11 @@ OutputSchedulerThread::pushAllFrameRange()
     
     if (direction == eRenderDirectionForward) {
         for (int i = firstFrame; i <= lastFrame; ++i) {
-            _imp->framesToRender.push_back(i);
+            _imp->appendFrameToRender_locked(i);
         }
     } else {
         for (int i = lastFrame; i >= firstFrame; --i) {
-            _imp->framesToRender.push_back(i);
+            _imp->appendFrameToRender_locked(i);
         }
     }
     ///Wake up render threads to notify them theres work to do
@@ -689,10 +1140,20 @@ OutputSchedulerThread::pickFrameToRender(RenderThreadTask* thread)
     ///We can end up in this situation for very simple graphs where the rendering of the output node (the writer or viewer)
     ///is much slower than things upstream, hence the buffer grows quickly, and fills up the RAM.
     int nbThreadsHardware = appPTR->getHardwareIdealThreadCount();
+    int maxBufferedFrames = nbThreadsHardware * 3;
+    bool streaming;
+    {
+        QMutexLocker k(&_imp->streamingMutex);
+        streaming = _imp->streaming;
+    }
+    if (streaming) {
+        ///A frame waiting to be written holds the images it needs: only let each render thread get ahead by a frame
+        maxBufferedFrames = std::max(1, getNRenderThreads());
+    }
     bool bufferFull;
     {
         QMutexLocker k(&_imp->bufMutex);
-        bufferFull = (int)_imp->buf.size() >= nbThreadsHardware * 3;
+        bufferFull = (int)_imp->buf.size() >= maxBufferedFrames;
     }
     
     QMutexLocker l(&_imp->framesToRenderMutex);
@@ -706,7 +1167,7 @@ OutputSchedulerThread::pickFrameToRender(RenderThreadTask* thread)
         
         {
             QMutexLocker k(&_imp->bufMutex);
-            bufferFull = (int)_imp->buf.size() >= nbThreadsHardware * 3;
+            bufferFull = (int)_imp->buf.size() >= maxBufferedFrames;
         }
     }
     
@@ -717,8 +1178,16 @@ OutputSchedulerThread::pickFrameToRender(RenderThreadTask* thread)
         thread->notifyIsRunning(true);
         
         
-        int ret = _imp->framesToRender.front();
-        _imp->framesToRender.pop_front();
+        int ret;
+        if ( !_imp->framesNeededOverlap.empty() ) {
+            ///A streaming render only releases images once all the frames before are rendered, and writers of a render group
+            ///wait for each other frame by frame, so threads must not spread out
+            bool ordered = streaming || _imp->outputEffect->getRenderGroup() || getSchedulingPolicy() == Natron::eSchedulingPolicyOrdered;
+            int maxLead = ordered ? std::max( 1, getNRenderThreads() ) : maxBufferedFrames;
+            ret = _imp->pickFrameSharingInputs_locked(thread, maxLead);
+        } else {
+            ret = _imp->takeFrameToRender_locked( _imp->framesToRender.begin() );
+        }
         
         ///Flag the thread as active
         {
@@ -741,6 +1210,11 @@ OutputSchedulerThread::pickFrameToRender(RenderThreadTask* thread)
 void
 OutputSchedulerThread::notifyThreadAboutToQuit(RenderThreadTask* thread)
 {
+    ///The frame of a thread that quit is no longer being rendered
+    {
+        QMutexLocker k(&_imp->framesToRenderMutex);
+        _imp->lastFramePicked.erase(thread);
+    }
     QMutexLocker l(&_imp->renderThreadsMutex);
     RenderThreads::iterator found = _imp->getRunnableIterator(thread);
     if (found != _imp->renderThreads.end()) {
@@ -756,8 +1230,18 @@ OutputSchedulerThread::startRender()
     
     if ( isFPSRegulationNeeded() ) {
         _imp->timer->playState = ePlayStateRunning;
+        _imp->timer->resetTiming();
     }
     
+    ///Start a new playback session
+    {
+        QMutexLocker l(&_imp->statsMutex);
+        _imp->stats = PlaybackStatistics();
+        _imp->statsSessionTime = TimeLapse();
+        _imp->cacheIOStatsRecorder.reset(new Natron::CacheIO::StatsRecorder);
+    }
+    _imp->engine->s_playbackStatisticsChanged(0, 0);
+    
     ///We will push frame to renders starting at startingFrame.
     ///They will be in the range determined by firstFrame-lastFrame
     int startingFrame;
@@ -787,6 +1271,41 @@ OutputSchedulerThread::startRender()
         nThreads = (int)_imp->renderThreads.size();
     }
     
+    ///Only disk renders can take frames out of order: playback must stay sequential
+    std::vector<int> framesNeededOverlap;
+    if ( (_imp->mode == eProcessFrameBySchedulerThread) && (firstFrame != lastFrame) &&
+         appPTR->getCurrentSettings()->isCacheAwareFrameOrderingEnabled() ) {
+        _imp->computeFramesNeededOverlap(startingFrame, &framesNeededOverlap);
+    }
+    {
+        QMutexLocker l(&_imp->framesToRenderMutex);
+        _imp->framesNeededOverlap.swap(framesNeededOverlap);
+        _imp->lastFramePicked.clear();
+    }
+    
+    if ( (_imp->mode == eProcessFrameBySchedulerThread) && (firstFrame != lastFrame) &&
+         appPTR->isBackground() && appPTR->isStreamingRenderEnabled() ) {
+        RenderDirectionEnum direction;
+        {
+            QMutexLocker l(&_imp->runArgsMutex);
+            direction = _imp->livingRunArgs.timelineDirection;
+        }
+        _imp->startStreaming(direction == eRenderDirectionForward ? firstFrame : lastFrame, direction);
+    }
+    
+    ///Writers rendered together render the frames in lockstep, see OutputRenderGroup
+    boost::shared_ptr<OutputRenderGroup> renderGroup = _imp->outputEffect->getRenderGroup();
+    if (renderGroup) {
+        RenderDirectionEnum direction;
+        {
+            QMutexLocker l(&_imp->runArgsMutex);
+            direction = _imp->livingRunArgs.timelineDirection;
+        }
+        if (direction == eRenderDirectionForward) {
+            renderGroup->addMember(_imp->outputEffect, firstFrame, lastFrame);
+        }
+    }
+    
     ///Start with one thread if it doesn't exist
     if (nThreads == 0) {
         adjustNumberOfThreads(&nThreads);
@@ -835,6 +1354,12 @@ OutputSchedulerThread::stopRender()
 {
     _imp->timer->playState = ePlayStatePause;
     
+    ///Do not make the other writers of the render group wait for us anymore
+    boost::shared_ptr<OutputRenderGroup> renderGroup = _imp->outputEffect->getRenderGroup();
+    if (renderGroup) {
+        renderGroup->removeMember(_imp->outputEffect);
+    }
+    
     ///Wait for all render threads to be done
     {
         QMutexLocker l(&_imp->renderThreadsMutex);
@@ -895,6 +1420,16 @@ OutputSchedulerThread::stopRender()
             _imp->clearBuffer();
         }
         
+        _imp->stopStreaming();
+        
+        {
+            QMutexLocker l(&_imp->statsMutex);
+            if (_imp->cacheIOStatsRecorder) {
+                _imp->cacheIOStatsRecorder->getStats(&_imp->cacheIOStats);
+                _imp->cacheIOStatsRecorder.reset();
+            }
+        }
+        
         ///Notify everyone that the render is finished
         _imp->engine->s_renderFinished(wasAborted ? 1 : 0);
         
@@ -1029,63 +1564,91 @@ OutputSchedulerThread::run()
                     }
                 }
                 
-                if (_imp->timer->playState == ePlayStateRunning) {
-                    _imp->timer->waitUntilNextFrameIsDue(); // timer synchronizing with the requested fps
+                int timeToSeek = 0;
+                if (!renderFinished) {
+                    ///Timeline might have changed if another thread moved the playhead
+                    int timelineCurrentTime = timelineGetTime();
+                    if (timelineCurrentTime != expectedTimeToRender) {
+                        timeToSeek = timelineCurrentTime;
+                    } else {
+                        timeToSeek = nextFrameToRender;
+                    }
                 }
                 
+                bool isPlaying = _imp->timer->playState == ePlayStateRunning;
+                double spf = 1. / _imp->timer->getDesiredFrameRate();
                 
+                ///If we are more than a frame late and the next frame is already rendered, skip this one instead of
+                ///slowing the whole playback down so that the timeline keeps up with the wall clock
+                bool dropFrame = false;
+                if ( isPlaying && !renderFinished && canDropFrames() && (_imp->timer->getTimeUntilNextFrameIsDue() < -spf) ) {
+                    QMutexLocker l(&_imp->bufMutex);
+                    dropFrame = _imp->isFrameBuffered(timeToSeek);
+                }
                 
-                if (_imp->mode == eProcessFrameBySchedulerThread) {
+                bool lateFrame = false;
+                if (dropFrame) {
+                    _imp->timer->skipFrame();
+                    if (_imp->mode == eProcessFrameBySchedulerThread) {
+                        timelineGoTo(timeToSeek);
+                    } else if ( !processFrameOnMainThread(BufferedFrames(), false, true, timeToSeek) ) {
+                        ///Do not wait in the buf wait condition and go directly into the stopRender()
+                        renderFinished = true;
+                        break;
+                    }
+                } else if (_imp->mode == eProcessFrameBySchedulerThread) {
+                    if (isPlaying) {
+                        lateFrame = _imp->timer->getTimeUntilNextFrameIsDue() < -spf * NATRON_PLAYBACK_LATE_FRAME_THRESHOLD;
+                        _imp->timer->waitUntilNextFrameIsDue(); // timer synchronizing with the requested fps
+                    }
+                    
                     processFrame(framesToRender);
+                    displayFrame();
                     
                     if (!renderFinished) {
-                        ///Timeline might have changed if another thread moved the playhead
-                        int timelineCurrentTime = timelineGetTime();
-                        if (timelineCurrentTime != expectedTimeToRender) {
-                            timelineGoTo(timelineCurrentTime);
-                        } else {
-                            timelineGoTo(nextFrameToRender);
-                        }
-                        
+                        timelineGoTo(timeToSeek);
                     }
                 } else {
-                    ///Process on main-thread
-                                    
-                    QMutexLocker processLocker (&_imp->processMutex);
-                    
-                    ///Check for abortion while under processMutex to be sure the main thread is not deadlock in abortRendering
-                    {
-                        QMutexLocker locker(&_imp->abortedRequestedMutex);
-                        if (_imp->abortRequested > 0) {
-                            
-                            ///Do not wait in the buf wait condition and go directly into the stopRender()
-                            renderFinished = true;
-                            
-                            break;
-                        }
+                    ///Process on main-thread: the frame is processed (e.g: the texture is uploaded) before it is due,
+                    ///only displaying it is left once the timer wakes us up
+                    if ( !processFrameOnMainThread(framesToRender, false, false, 0) ) {
+                        ///Do not wait in the buf wait condition and go directly into the stopRender()
+                        renderFinished = true;
+                        break;
                     }
                     
-                    _imp->processRunning = true;
-                    
-                    int timeToSeek = 0;
-                    if (!renderFinished) {
-                        ///Timeline might have changed if another thread moved the playhead
-                        int timelineCurrentTime = timelineGetTime();
-                        if (timelineCurrentTime != expectedTimeToRender) {
-                            timeToSeek = timelineCurrentTime;
-                        } else {
-                            timeToSeek = nextFrameToRender;
-                        }
-                        
+                    if (isPlaying) {
+                        lateFrame = _imp->timer->getTimeUntilNextFrameIsDue() < -spf * NATRON_PLAYBACK_LATE_FRAME_THRESHOLD;
+                        _imp->timer->waitUntilNextFrameIsDue(); // timer synchronizing with the requested fps
                     }
-
-                    Q_EMIT s_doProcessOnMainThread(framesToRender,!renderFinished, timeToSeek);
                     
-                    while (_imp->processRunning) {
-                        _imp->processCondition.wait(&_imp->processMutex);
+                    if ( !processFrameOnMainThread(BufferedFrames(), true, !renderFinished, timeToSeek) ) {
+                        renderFinished = true;
+                        break;
                     }
                 }
                 
+                ///Update the statistics of the playback session
+                int droppedFrames,lateFrames;
+                {
+                    QMutexLocker l(&_imp->statsMutex);
+                    if (dropFrame) {
+                        ++_imp->stats.droppedFrames;
+                    } else {
+                        ++_imp->stats.displayedFrames;
+                        if (lateFrame) {
+                            ++_imp->stats.lateFrames;
+                        }
+                    }
+                    double elapsed = _imp->statsSessionTime.getTimeSinceCreation();
+                    _imp->stats.achievedFps = elapsed > 0 ? _imp->stats.displayedFrames / elapsed : 0.;
+                    droppedFrames = _imp->stats.droppedFrames;
+                    lateFrames = _imp->stats.lateFrames;
+                }
+                if (dropFrame || lateFrame) {
+                    _imp->engine->s_playbackStatisticsChanged(droppedFrames, lateFrames);
+                }
+                
                 
                 ////////////
                 /////At this point the frame has been processed by the output device
@@ -1183,6 +1746,7 @@ OutputSchedulerThread::notifyFrameRendered(int frame,
 {
     if (viewIndex == viewsCount -1) {
         _imp->engine->s_frameRendered(frame);
+        _imp->onStreamingFrameRendered(frame);
     }
     double percentage;
     if (policy == eSchedulingPolicyFFA) {
@@ -1243,6 +1807,7 @@ OutputSchedulerThread::appendToBuffer_internal(double time,int view,const boost:
             BufferedFrames frames;
             frames.push_back(b);
             processFrame(frames);
+            displayFrame();
         }
     } else {
         
@@ -1283,8 +1848,31 @@ OutputSchedulerThread::appendToBuffer(double time,int view,const BufferableObjec
 }
 
 
+bool
+OutputSchedulerThread::processFrameOnMainThread(const BufferedFrames& frames,bool mustDisplay,bool mustSeekTimeline,int time)
+{
+    QMutexLocker processLocker (&_imp->processMutex);
+    
+    ///Check for abortion while under processMutex to be sure the main thread is not deadlock in abortRendering
+    {
+        QMutexLocker locker(&_imp->abortedRequestedMutex);
+        if (_imp->abortRequested > 0) {
+            return false;
+        }
+    }
+    
+    _imp->processRunning = true;
+    
+    Q_EMIT s_doProcessOnMainThread(frames, mustDisplay, mustSeekTimeline, time);
+    
+    while (_imp->processRunning) {
+        _imp->processCondition.wait(&_imp->processMutex);
+    }
+    return true;
+}
+
 void
-OutputSchedulerThread::doProcessFrameMainThread(const BufferedFrames& frames,bool mustSeekTimeline,int time)
+OutputSchedulerThread::doProcessFrameMainThread(const BufferedFrames& frames,bool mustDisplay,bool mustSeekTimeline,int time)
 {
     assert(QThread::currentThread() == qApp->thread());
     {
@@ -1296,7 +1884,13 @@ OutputSchedulerThread::doProcessFrameMainThread(const BufferedFrames& frames,boo
     }
     
     
-    processFrame(frames);
+    if (!frames.empty()) {
+        processFrame(frames);
+    }
+    
+    if (mustDisplay) {
+        displayFrame();
+    }
     
     if (mustSeekTimeline) {
         timelineGoTo(time);
@@ -1348,10 +1942,16 @@ OutputSchedulerThread::abortRendering(bool blocking)
                 ++_imp->abortRequested;
             }
             
+            ///The other writers of the render group must not wait for the frames we will not render
+            boost::shared_ptr<OutputRenderGroup> renderGroup = _imp->outputEffect->getRenderGroup();
+            if (renderGroup) {
+                renderGroup->removeMember(_imp->outputEffect);
+            }
+            
             ///Clear the work queue
             {
                 QMutexLocker framesLocker (&_imp->framesToRenderMutex);
-                _imp->framesToRender.clear();
+                _imp->clearFramesToRender_locked();
             }
             
             
@@ -1448,6 +2048,37 @@ OutputSchedulerThread::getDesiredFPS() const
     return _imp->timer->getDesiredFrameRate();
 }
 
+void
+OutputSchedulerThread::getPlaybackStatistics(PlaybackStatistics* stats) const
+{
+    {
+        QMutexLocker l(&_imp->statsMutex);
+        *stats = _imp->stats;
+    }
+    stats->desiredFps = _imp->timer->getDesiredFrameRate();
+}
+
+void
+OutputSchedulerThread::getCacheIOStatistics(Natron::CacheIO::Stats* stats) const
+{
+    QMutexLocker l(&_imp->statsMutex);
+    if (_imp->cacheIOStatsRecorder) {
+        _imp->cacheIOStatsRecorder->getStats(stats);
+    } else {
+        *stats = _imp->cacheIOStats;
+    }
+}
+
+bool
+OutputSchedulerThread::getRenderFailure(std::string* errorMessage) const
+{
+    QMutexLocker l(&_imp->runArgsMutex);
+    if (_imp->renderFailed) {
+        *errorMessage = _imp->renderFailure;
+    }
+    return _imp->renderFailed;
+}
+
 void
 OutputSchedulerThread::renderFrameRange(int firstFrame,int lastFrame,RenderDirectionEnum direction)
 {
@@ -1465,6 +2096,8 @@ OutputSchedulerThread::renderFrameRange(int firstFrame,int lastFrame,RenderDirec
         
         _imp->nFramesRendered = 0;
         _imp->renderFinished = false;
+        _imp->renderFailed = false;
+        _imp->renderFailure.clear();
         
         ///Start with picking direction being the same as the timeline direction.
         ///Once the render threads are a few frames ahead the picking direction might be different than the
@@ -1496,6 +2129,8 @@ OutputSchedulerThread::renderFromCurrentFrame(RenderDirectionEnum timelineDirect
         _imp->requestedRunArgs.firstFrame = firstFrame;
         _imp->requestedRunArgs.lastFrame = lastFrame;
         _imp->requestedRunArgs.timelineDirection = timelineDirection;
+        _imp->renderFailed = false;
+        _imp->renderFailure.clear();
     }
     renderInternal();
 }
@@ -1528,6 +2163,15 @@ OutputSchedulerThread::renderInternal()
 void
 OutputSchedulerThread::notifyRenderFailure(const std::string& errorMessage)
 {
+    ///Record the failure before aborting: whoever waits for the end of the render must see it
+    {
+        QMutexLocker l(&_imp->runArgsMutex);
+        if (!_imp->renderFailed) {
+            _imp->renderFailed = true;
+            _imp->renderFailure = errorMessage;
+        }
+    }
+    
     ///Abort all ongoing rendering
     doAbortRenderingOnMainThread(false);
     
@@ -1718,6 +2362,10 @@ RenderThreadTask::run()
     
     notifyIsRunning(true);
     
+    ///On NUMA machines, spread the frame render threads across nodes so that each frame's
+    ///images stay in the memory of the node rendering it
+    Natron::NUMA::ThreadBinder numaBinder(Natron::NUMA::isBindingEnabled() ? Natron::NUMA::pickNodeForNewRenderThread() : -1);
+    
     for (;;) {
         
         int time = _imp->scheduler->pickFrameToRender(this);
@@ -1726,8 +2374,18 @@ RenderThreadTask::run()
             break;
         }
         
+        boost::shared_ptr<OutputRenderGroup> renderGroup = _imp->output->getRenderGroup();
+        if (renderGroup) {
+            ///The frame was picked: render it even if the thread must quit, the other writers may be waiting for it
+            renderGroup->waitForFrame(_imp->output, this, time);
+        }
+        
         renderFrame(time);
         
+        if (renderGroup) {
+            renderGroup->notifyFrameRendered(_imp->output, time);
+        }
+        
         if ( mustQuit() ) {
             break;
         }
@@ -1787,6 +2445,9 @@ RenderThreadTask::notifyIsRunning(bool running)
 DefaultScheduler::DefaultScheduler(RenderEngine* engine,Natron::OutputEffectInstance* effect)
 : OutputSchedulerThread(engine,effect,eProcessFrameBySchedulerThread)
 , _effect(effect)
+, _numaLocalAccessesAtStart(0)
+, _numaRemoteAccessesAtStart(0)
+, _arenaStatsAtStart()
 {
     engine->setPlaybackMode(ePlaybackModeOnce);
 }
@@ -1814,13 +2475,25 @@ public:
     
 private:
     
+    ///What renderView() needs to render a view of a frame, shared by all the views
+    struct ViewRenderArgs
+    {
+        int time;
+        int viewsCount;
+        EffectInstance* activeInputToRender;
+        U64 activeInputToRenderHash;
+        double par;
+        bool renderDirectly;
+        bool canOnlyHandleOneView;
+    };
     
-    virtual void
-    renderFrame(int time) {
-        
-        std::string beforeFrameRender = _imp->output->getNode()->getBeforeFrameRenderCallback();
-        _imp->scheduler->runCallbackWithVariables(beforeFrameRender.c_str());
-        
+    /**
+     * @brief Renders one view of the frame. Returns false if the render failed, in which case the following views
+     * should not be rendered.
+     **/
+    bool
+    renderView(const ViewRenderArgs& args,int view)
+    {
         try {
             ////Writers always render at scale 1.
             int mipMapLevel = 0;
@@ -1829,99 +2502,123 @@ private:
             
             RectD rod;
             bool isProjectFormat;
-            int viewsCount = _imp->output->getApp()->getProject()->getProjectViewsCount();
-            
-            
-            int mainView = 0;
+            StatusEnum stat = args.activeInputToRender->getRegionOfDefinition_public(args.activeInputToRenderHash,args.time, scale, view, &rod, &isProjectFormat);
+            if (stat == eStatusFailed) {
+                return false;
+            }
+            ImageComponentsEnum components;
+            ImageBitDepthEnum imageDepth;
+            args.activeInputToRender->getPreferredDepthAndComponents(-1, &components, &imageDepth);
+            RectI renderWindow;
+            rod.toPixelEnclosing(scale, args.par, &renderWindow);
             
-            Natron::SequentialPreferenceEnum sequentiallity = _imp->output->getSequentialPreference();
+            ///The render args are thread-local: each view sets them in the thread rendering it
+            ParallelRenderArgsSetter frameRenderARgs(args.activeInputToRender->getNode().get(),
+                                                     args.time,
+                                                     view,
+                                                     false,  // is this render due to user interaction ?
+                                                     args.canOnlyHandleOneView, // is this sequential ?
+                                                     true,
+                                                     args.activeInputToRenderHash,
+                                                     false,
+                                                     _imp->output->getApp()->getTimeLine().get());
             
-            ///The effect is sequential (e.g: WriteFFMPEG), and thus cannot render multiple views, we have to choose one
-            ///We pick the user defined main view in the project settings
+            boost::shared_ptr<Natron::Image> img =
+            args.activeInputToRender->renderRoI( EffectInstance::RenderRoIArgs(args.time, //< the time at which to render
+                                                                               scale, //< the scale at which to render
+                                                                               mipMapLevel, //< the mipmap level (redundant with the scale)
+                                                                               view, //< the view to render
+                                                                               false,
+                                                                               renderWindow, //< the region of interest (in pixel coordinates)
+                                                                               rod, // < any precomputed rod ? in canonical coordinates
+                                                                               components,
+                                                                               imageDepth));
             
-            bool canOnlyHandleOneView = sequentiallity == Natron::eSequentialPreferenceOnlySequential || sequentiallity == Natron::eSequentialPreferencePreferSequential;
-            if (canOnlyHandleOneView) {
-                mainView = _imp->output->getApp()->getMainView();
+            ///If we need sequential rendering, pass the image to the output scheduler that will ensure the sequential ordering
+            if (!args.renderDirectly) {
+                _imp->scheduler->appendToBuffer(args.time, view, boost::dynamic_pointer_cast<BufferableObject>(img));
             }
-       
-            
-            /// If the writer dosn't need to render the frames in any sequential order (such as image sequences for instance), then
-            /// we just render the frames directly in this thread, no need to use the scheduler thread for maximum efficiency.
+        } catch (const std::exception& e) {
+            _imp->scheduler->notifyRenderFailure(std::string("Error while rendering: ") + e.what());
+            return false;
+        }
+        return true;
+    }
+    
+    virtual void
+    renderFrame(int time) {
         
-            bool renderDirectly = sequentiallity == Natron::eSequentialPreferenceNotSequential;
-            
-            
-            // Do not catch exceptions: if an exception occurs here it is probably fatal, since
-            // it comes from Natron itself. All exceptions from plugins are already caught
-            // by the HostSupport library.
-            EffectInstance* activeInputToRender;
-            if (renderDirectly) {
-                activeInputToRender = _imp->output;
+        std::string beforeFrameRender = _imp->output->getNode()->getBeforeFrameRenderCallback();
+        _imp->scheduler->runCallbackWithVariables(beforeFrameRender.c_str());
+        
+        ViewRenderArgs args;
+        args.time = time;
+        args.viewsCount = _imp->output->getApp()->getProject()->getProjectViewsCount();
+        
+        int mainView = 0;
+        
+        Natron::SequentialPreferenceEnum sequentiallity = _imp->output->getSequentialPreference();
+        
+        ///The effect is sequential (e.g: WriteFFMPEG), and thus cannot render multiple views, we have to choose one
+        ///We pick the user defined main view in the project settings
+        
+        args.canOnlyHandleOneView = sequentiallity == Natron::eSequentialPreferenceOnlySequential || sequentiallity == Natron::eSequentialPreferencePreferSequential;
+        if (args.canOnlyHandleOneView) {
+            mainView = _imp->output->getApp()->getMainView();
+        }
+        
+        
+        /// If the writer dosn't need to render the frames in any sequential order (such as image sequences for instance), then
+        /// we just render the frames directly in this thread, no need to use the scheduler thread for maximum efficiency.
+        
+        args.renderDirectly = sequentiallity == Natron::eSequentialPreferenceNotSequential;
+        
+        
+        // Do not catch exceptions: if an exception occurs here it is probably fatal, since
+        // it comes from Natron itself. All exceptions from plugins are already caught
+        // by the HostSupport library.
+        if (args.renderDirectly) {
+            args.activeInputToRender = _imp->output;
+        } else {
+            args.activeInputToRender = _imp->output->getInput(0);
+            if (args.activeInputToRender) {
+                args.activeInputToRender = args.activeInputToRender->getNearestNonDisabled();
             } else {
-                activeInputToRender = _imp->output->getInput(0);
-                if (activeInputToRender) {
-                    activeInputToRender = activeInputToRender->getNearestNonDisabled();
-                } else {
-                    _imp->scheduler->notifyRenderFailure("No input to render");
-                    return;
-                }
-                
+                _imp->scheduler->notifyRenderFailure("No input to render");
+                return;
             }
             
-            assert(activeInputToRender);
-            U64 activeInputToRenderHash = activeInputToRender->getHash();
-            
-            const double par = activeInputToRender->getPreferredAspectRatio();
-            
-            for (int i = 0; i < viewsCount; ++i) {
-                if ( canOnlyHandleOneView && (i != mainView) ) {
-                    ///@see the warning in EffectInstance::evaluate
-                    continue;
-                }
-                
-                StatusEnum stat = activeInputToRender->getRegionOfDefinition_public(activeInputToRenderHash,time, scale, i, &rod, &isProjectFormat);
-                if (stat != eStatusFailed) {
-                    ImageComponentsEnum components;
-                    ImageBitDepthEnum imageDepth;
-                    activeInputToRender->getPreferredDepthAndComponents(-1, &components, &imageDepth);
-                    RectI renderWindow;
-                    rod.toPixelEnclosing(scale, par, &renderWindow);
-                    
-                    ParallelRenderArgsSetter frameRenderARgs(activeInputToRender->getNode().get(),
-                                                                   time,
-                                                                   i,
-                                                                   false,  // is this render due to user interaction ?
-                                                                   canOnlyHandleOneView, // is this sequential ?
-                                                                   true,
-                                                                   activeInputToRenderHash,
-                                                                   false,
-                                                                   _imp->output->getApp()->getTimeLine().get());
-                    
-                    boost::shared_ptr<Natron::Image> img =
-                    activeInputToRender->renderRoI( EffectInstance::RenderRoIArgs(time, //< the time at which to render
-                                                                                  scale, //< the scale at which to render
-                                                                                  mipMapLevel, //< the mipmap level (redundant with the scale)
-                                                                                  i, //< the view to render
-                                                                                  false,
-                                                                                  renderWindow, //< the region of interest (in pixel coordinates)
-                                                                                  rod, // < any precomputed rod ? in canonical coordinates
-                                                                                  components,
-                                                                                  imageDepth));
-                    
-                    ///If we need sequential rendering, pass the image to the output scheduler that will ensure the sequential ordering
-                    if (!renderDirectly) {
-                        _imp->scheduler->appendToBuffer(time, i, boost::dynamic_pointer_cast<BufferableObject>(img));
-                    } else {
-                        _imp->scheduler->notifyFrameRendered(time,i,viewsCount,eSchedulingPolicyFFA);
-                    }
-                    
-                } else {
-                    break;
-                }
+        }
+        
+        assert(args.activeInputToRender);
+        args.activeInputToRenderHash = args.activeInputToRender->getHash();
+        args.par = args.activeInputToRender->getPreferredAspectRatio();
+        
+        if (args.canOnlyHandleOneView) {
+            ///@see the warning in EffectInstance::evaluate
+            if ( renderView(args, mainView) && args.renderDirectly ) {
+                _imp->scheduler->notifyFrameRendered(time,mainView,args.viewsCount,eSchedulingPolicyFFA);
+            }
+            return;
+        }
+        
+        ///The views are independent: render the other views in the global thread pool while this thread renders the
+        ///first one. The parts of the tree that are the same for all views are rendered once, @see isViewInvariant_Recursive()
+        std::vector<QFuture<bool> > otherViews;
+        for (int i = 1; i < args.viewsCount; ++i) {
+            otherViews.push_back( QtConcurrent::run(this, &DefaultRenderFrameRunnable::renderView, args, i) );
+        }
+        bool ok = renderView(args, 0);
+        
+        ///Notify the views in order once they are all rendered, the frame is complete when the last one is notified
+        for (int i = 1; i < args.viewsCount; ++i) {
+            otherViews[i - 1].waitForFinished();
+            ok = ok && otherViews[i - 1].result();
+        }
+        if (ok && args.renderDirectly) {
+            for (int i = 0; i < args.viewsCount; ++i) {
+                _imp->scheduler->notifyFrameRendered(time,i,args.viewsCount,eSchedulingPolicyFFA);
             }
-            
-        } catch (const std::exception& e) {
-            _imp->scheduler->notifyRenderFailure(std::string("Error while rendering: ") + e.what());
         }
     }
 };
@@ -2077,6 +2774,8 @@ DefaultScheduler::aboutToStartRender()
     } else {
         appPTR->writeToOutputPipe(kRenderingStartedLong, kRenderingStartedShort);
     }
+    Natron::NUMA::getAccessCounters(&_numaLocalAccessesAtStart, &_numaRemoteAccessesAtStart);
+    Natron::RenderArena::getStats(&_arenaStatsAtStart);
     
     std::string beforeRender = _effect->getNode()->getBeforeRenderCallback();
     runCallbackWithVariables(beforeRender.c_str());
@@ -2089,6 +2788,42 @@ DefaultScheduler::onRenderStopped(bool aborted)
     if (!isBackGround) {
         _effect->setKnobsFrozen(false);
     } else {
+        if ( Natron::NUMA::isBindingEnabled() ) {
+            ///The counters are shared by all the renders running at the same time
+            U64 local,remote;
+            Natron::NUMA::getAccessCounters(&local, &remote);
+            local -= _numaLocalAccessesAtStart;
+            remote -= _numaRemoteAccessesAtStart;
+            if (local + remote > 0) {
+                std::cout << QObject::tr("NUMA: %1% of the %2 input image accesses were on another node")
+                    .arg(100. * remote / (local + remote), 0, 'f', 1).arg( (qulonglong)(local + remote) ).toStdString() << std::endl;
+            }
+        }
+        
+        Natron::CacheIO::Stats io;
+        getCacheIOStatistics(&io);
+        if (io.writes + io.failedWrites + io.reads > 0) {
+            std::cout << QObject::tr("Cache I/O: %1 writes (%2 MiB, %3 failed, %4 reclaimed, %5 throttled, %6 ms on average), "
+                                     "%7 reads (%8 MiB, %9 ms on average)")
+                .arg( (qulonglong)io.writes ).arg(io.bytesWritten / (1024. * 1024.), 0, 'f', 1).arg( (qulonglong)io.failedWrites )
+                .arg( (qulonglong)io.reclaimedWrites ).arg( (qulonglong)io.throttledWrites )
+                .arg(io.writes > 0 ? 1000. * io.writeLatency / io.writes : 0., 0, 'f', 2)
+                .arg( (qulonglong)io.reads ).arg(io.bytesRead / (1024. * 1024.), 0, 'f', 1)
+                .arg(io.reads > 0 ? 1000. * io.readLatency / io.reads : 0., 0, 'f', 2).toStdString() << std::endl;
+        }
+        
+        ///The counters are shared by all the renders running at the same time
+        Natron::RenderArena::Stats arena;
+        Natron::RenderArena::getStats(&arena);
+        U64 arenaFrames = arena.frames - _arenaStatsAtStart.frames;
+        if (arenaFrames > 0) {
+            U64 allocations = arena.allocations - _arenaStatsAtStart.allocations;
+            std::cout << QObject::tr("Render arena: %1 allocations per frame (%2 KiB), %3 of them on the heap")
+                .arg( (qulonglong)(allocations / arenaFrames) )
+                .arg( (arena.bytes - _arenaStatsAtStart.bytes) / (1024. * arenaFrames), 0, 'f', 1 )
+                .arg( (qulonglong)( (arena.heapAllocations - _arenaStatsAtStart.heapAllocations) / arenaFrames ) ).toStdString() << std::endl;
+        }
+        
         _effect->notifyRenderFinished();
     }
     
@@ -2104,6 +2839,207 @@ DefaultScheduler::onRenderStopped(bool aborted)
 
 }
 
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+//////////////////////// OutputRenderGroup ////////////
+
+namespace {
+struct RenderGroupMember
+{
+    Natron::OutputEffectInstance* output;
+    int rank; //< the index of the writer in the group
+    int firstFrame,lastFrame;
+    int nextFrame; //< the first frame not rendered yet
+    std::set<int> renderedFrames; //< the frames rendered past nextFrame
+    
+    bool isFrameRendered(int time) const
+    {
+        return time < firstFrame || time > lastFrame || time < nextFrame || renderedFrames.find(time) != renderedFrames.end();
+    }
+    
+    bool isFinished() const
+    {
+        return nextFrame > lastFrame;
+    }
+};
+}
+
+struct OutputRenderGroupPrivate
+{
+    mutable QMutex membersMutex;
+    std::vector<Natron::OutputEffectInstance*> writers; //< in the order they were registered
+    std::list<RenderGroupMember> members; //< sorted by rank
+    QWaitCondition membersCond; //< woken up whenever a frame is rendered or a member leaves
+    int maxFramesAhead;
+    
+    OutputRenderGroupPrivate()
+    : membersMutex()
+    , writers()
+    , members()
+    , membersCond()
+    , maxFramesAhead( std::max(1, appPTR->getHardwareIdealThreadCount()) )
+    {
+    }
+    
+    std::list<RenderGroupMember>::iterator findMember(Natron::OutputEffectInstance* output)
+    {
+        for (std::list<RenderGroupMember>::iterator it = members.begin(); it != members.end(); ++it) {
+            if (it->output == output) {
+                return it;
+            }
+        }
+        return members.end();
+    }
+    
+    int getRank_locked(Natron::OutputEffectInstance* output) const
+    {
+        for (U32 i = 0; i < writers.size(); ++i) {
+            if (writers[i] == output) {
+                return (int)i;
+            }
+        }
+        ///Writers that were not registered come last
+        return (int)writers.size();
+    }
+    
+    int getSlowestNextFrame_locked() const
+    {
+        int ret = INT_MAX;
+        for (std::list<RenderGroupMember>::const_iterator it = members.begin(); it != members.end(); ++it) {
+            if ( !it->isFinished() ) {
+                ret = std::min(ret, it->nextFrame);
+            }
+        }
+        return ret;
+    }
+};
+
+OutputRenderGroup::OutputRenderGroup()
+: _imp(new OutputRenderGroupPrivate)
+{
+    
+}
+
+OutputRenderGroup::~OutputRenderGroup()
+{
+    
+}
+
+void
+OutputRenderGroup::registerWriter(Natron::OutputEffectInstance* output)
+{
+    QMutexLocker l(&_imp->membersMutex);
+    if ( std::find(_imp->writers.begin(), _imp->writers.end(), output) == _imp->writers.end() ) {
+        _imp->writers.push_back(output);
+    }
+}
+
+void
+OutputRenderGroup::addMember(Natron::OutputEffectInstance* output,
+                             int firstFrame,
+                             int lastFrame)
+{
+    QMutexLocker l(&_imp->membersMutex);
+    std::list<RenderGroupMember>::iterator found = _imp->findMember(output);
+    if ( found != _imp->members.end() ) {
+        _imp->members.erase(found);
+    }
+    RenderGroupMember m;
+    m.output = output;
+    m.rank = _imp->getRank_locked(output);
+    m.firstFrame = firstFrame;
+    m.lastFrame = lastFrame;
+    m.nextFrame = firstFrame;
+    
+    ///The order does not depend on which scheduler thread started first
+    std::list<RenderGroupMember>::iterator pos = _imp->members.begin();
+    while ( pos != _imp->members.end() && pos->rank <= m.rank ) {
+        ++pos;
+    }
+    _imp->members.insert(pos, m);
+    _imp->membersCond.wakeAll();
+}
+
+void
+OutputRenderGroup::removeMember(Natron::OutputEffectInstance* output)
+{
+    QMutexLocker l(&_imp->membersMutex);
+    std::list<RenderGroupMember>::iterator found = _imp->findMember(output);
+    if ( found != _imp->members.end() ) {
+        _imp->members.erase(found);
+        _imp->membersCond.wakeAll();
+    }
+}
+
+void
+OutputRenderGroup::waitForFrame(Natron::OutputEffectInstance* output,
+                                RenderThreadTask* thread,
+                                int time)
+{
+    QMutexLocker l(&_imp->membersMutex);
+    for (;;) {
+        std::list<RenderGroupMember>::iterator self = _imp->findMember(output);
+        if ( self == _imp->members.end() ) {
+            return;
+        }
+        
+        bool canRender = true;
+        
+        ///Let the writers that started before render the frame first, the images we have in common will be in the cache
+        for (std::list<RenderGroupMember>::iterator it = _imp->members.begin(); it != self; ++it) {
+            if ( !it->isFrameRendered(time) ) {
+                canRender = false;
+                break;
+            }
+        }
+        
+        ///Do not run too far ahead of the slowest writer, or the images it needs would be out of the cache
+        ///by the time it gets there. The slowest writer itself can always render its next frame.
+        if ( canRender && (time - _imp->getSlowestNextFrame_locked() >= _imp->maxFramesAhead) ) {
+            canRender = false;
+        }
+        
+        if ( canRender || thread->mustQuit() ) {
+            return;
+        }
+        
+        ///The timeout is there to check regularly whether the thread must quit
+        _imp->membersCond.wait(&_imp->membersMutex, NATRON_RENDER_GROUP_WAIT_TIMEOUT_MS);
+    }
+}
+
+void
+OutputRenderGroup::notifyFrameRendered(Natron::OutputEffectInstance* output,
+                                       int time)
+{
+    QMutexLocker l(&_imp->membersMutex);
+    std::list<RenderGroupMember>::iterator found = _imp->findMember(output);
+    if ( found == _imp->members.end() ) {
+        return;
+    }
+    if ( (time < found->nextFrame) || (time > found->lastFrame) ) {
+        return;
+    }
+    found->renderedFrames.insert(time);
+    while ( found->renderedFrames.erase(found->nextFrame) ) {
+        ++found->nextFrame;
+    }
+    _imp->membersCond.wakeAll();
+}
+
+int
+OutputRenderGroup::getSlowestNextFrame() const
+{
+    QMutexLocker l(&_imp->membersMutex);
+    return _imp->getSlowestNextFrame_locked();
+}
+
+int
+OutputRenderGroup::getMaxFramesAhead() const
+{
+    return _imp->maxFramesAhead;
+}
+
 ////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////
 //////////////////////// ViewerDisplayScheduler ////////////
@@ -2140,8 +3076,12 @@ ViewerDisplayScheduler::processFrame(const BufferedFrames& frames)
             _viewer->updateViewer(params);
         }
     }
+}
+
+void
+ViewerDisplayScheduler::displayFrame()
+{
     _viewer->redrawViewer();
-    
 }
 
 void
@@ -2486,6 +3426,32 @@ RenderEngine::getDesiredFPS() const
     return _imp->scheduler ? _imp->scheduler->getDesiredFPS() : 24;
 }
 
+void
+RenderEngine::getPlaybackStatistics(PlaybackStatistics* stats) const
+{
+    if (_imp->scheduler) {
+        _imp->scheduler->getPlaybackStatistics(stats);
+    } else {
+        *stats = PlaybackStatistics();
+    }
+}
+
+void
+RenderEngine::getCacheIOStatistics(Natron::CacheIO::Stats* stats) const
+{
+    if (_imp->scheduler) {
+        _imp->scheduler->getCacheIOStatistics(stats);
+    } else {
+        *stats = Natron::CacheIO::Stats();
+    }
+}
+
+bool
+RenderEngine::getRenderFailure(std::string* errorMessage) const
+{
+    return _imp->scheduler ? _imp->scheduler->getRenderFailure(errorMessage) : false;
+}
+
 
 OutputSchedulerThread*
 ViewerRenderEngine::createScheduler(Natron::OutputEffectInstance* effect) 
@@ -2886,7 +3852,9 @@ ViewerCurrentFrameRequestScheduler::renderCurrentFrame(bool canAbort)
                 }
             }
             functorArgs.request = request;
-            QtConcurrent::run(renderCurrentFrameFunctor,functorArgs);
+            ///Viewer renders have the highest priority: previews and analysis are held back (and preempted) while it runs
+            appPTR->getRenderScheduler()->schedule(Natron::eRenderPriorityViewer, NULL, 0, false,
+                                                   boost::bind(renderCurrentFrameFunctor,functorArgs));
         }
     }
 }
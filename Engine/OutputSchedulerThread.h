@@ -23,6 +23,8 @@
 #include <QThread>
 
 #include "Global/GlobalDefines.h"
+#include "Engine/CacheIO.h"
+#include "Engine/RenderArena.h"
 
 
 ///Natron
@@ -80,6 +82,28 @@ struct BufferedFrame
 
 typedef std::list<BufferedFrame> BufferedFrames;
 
+/**
+ * @brief Statistics of a playback session, i.e: from the start of a render of the scheduler until it stops.
+ **/
+struct PlaybackStatistics
+{
+    int displayedFrames;
+    int droppedFrames; //< frames skipped because the playback was more than a frame late and the next one was ready
+    int lateFrames; //< frames displayed more than half a frame after they were due
+    double achievedFps; //< displayed frames per second since the start of the session
+    double desiredFps;
+    
+    PlaybackStatistics()
+    : displayedFrames(0)
+    , droppedFrames(0)
+    , lateFrames(0)
+    , achievedFps(0)
+    , desiredFps(0)
+    {
+        
+    }
+};
+
 class OutputSchedulerThread;
 
 struct RenderThreadTaskPrivate;
@@ -249,6 +273,22 @@ public:
      **/
     double getDesiredFPS() const;
     
+    /**
+     * @brief Returns the statistics of the current playback session, or of the last one if the scheduler is stopped.
+     **/
+    void getPlaybackStatistics(PlaybackStatistics* stats) const;
+    
+    /**
+     * @brief Returns the stats of the cache I/O done during the current render, or during the last one if the scheduler is stopped.
+     **/
+    void getCacheIOStatistics(Natron::CacheIO::Stats* stats) const;
+    
+    /**
+     * @brief Returns true if notifyRenderFailure was called during the current render, or during the last one if the
+     * scheduler is stopped. errorMessage is set to the message of the first failure.
+     **/
+    bool getRenderFailure(std::string* errorMessage) const;
+    
     /**
      * @brief Returns the frame range of the output node, as given by the getFrameRange action
      **/
@@ -259,7 +299,7 @@ public:
 
 public Q_SLOTS:
     
-    void doProcessFrameMainThread(const BufferedFrames& frames,bool mustSeekTimeline,int time);
+    void doProcessFrameMainThread(const BufferedFrames& frames,bool mustDisplay,bool mustSeekTimeline,int time);
     
     /**
      @brief Aborts all computations. This turns on the flag abortRequested and will inform the engine that it needs to stop.
@@ -281,7 +321,7 @@ public Q_SLOTS:
     
 Q_SIGNALS:
     
-    void s_doProcessOnMainThread(const BufferedFrames& frames,bool mustSeekTimeline,int time);
+    void s_doProcessOnMainThread(const BufferedFrames& frames,bool mustDisplay,bool mustSeekTimeline,int time);
     
     void s_abortRenderingOnMainThread(bool blocking);
     
@@ -299,6 +339,19 @@ protected:
      **/
     virtual void processFrame(const BufferedFrames& frames) = 0;
     
+    /**
+     * @brief Called after processFrame() once the frame is due, in the same thread. When regulating the fps, processFrame()
+     * is called before waiting for the frame to be due so that the expensive part of the processing (e.g: uploading
+     * the texture) does not delay it: this should only do what makes the processed frame visible.
+     **/
+    virtual void displayFrame() {}
+    
+    /**
+     * @brief Should the scheduler skip frames when the playback is more than a frame late, to keep up with the desired fps?
+     * This only makes sense with isFPSRegulationNeeded().
+     **/
+    virtual bool canDropFrames() const { return false; }
+    
     /**
      * @brief Must be implemented to increment/decrement the timeline by one frame.
      * @param forward If true, must increment otherwise must decrement
@@ -412,6 +465,12 @@ private:
     
     void renderInternal();
     
+    /**
+     * @brief Calls doProcessFrameMainThread() on the main-thread and waits for it to return.
+     * Returns false if the render was aborted in the meantime.
+     **/
+    bool processFrameOnMainThread(const BufferedFrames& frames,bool mustDisplay,bool mustSeekTimeline,int time);
+    
     boost::scoped_ptr<OutputSchedulerThreadPrivate> _imp;
     
 };
@@ -453,6 +512,71 @@ private:
 
     
     Natron::OutputEffectInstance* _effect;
+    
+    ///The NUMA image access counters when the render started, @see Natron::NUMA::getAccessCounters
+    U64 _numaLocalAccessesAtStart,_numaRemoteAccessesAtStart;
+    
+    ///The render arena counters when the render started, @see Natron::RenderArena::getStats
+    Natron::RenderArena::Stats _arenaStatsAtStart;
+};
+
+/**
+ * @brief Writers rendered together (e.g: all the writers of a background render) share one render group, so that
+ * their schedulers render the frames in lockstep: the images of the nodes they have in common are rendered by the
+ * first writer that needs them and are still in the cache when the other writers render the same frame.
+ *
+ * The writers are ordered by registerWriter(): a render thread of a writer only starts a frame once all the writers
+ * registered before it that are rendering, and whose frame range contains that frame, have rendered it.
+ * No writer can render a frame more than getMaxFramesAhead() frames ahead of the slowest writer.
+ *
+ * Only forward renders are grouped. This class is thread-safe.
+ **/
+struct OutputRenderGroupPrivate;
+class OutputRenderGroup
+{
+public:
+
+    OutputRenderGroup();
+
+    ~OutputRenderGroup();
+
+    /**
+     * @brief Adds a writer to the group before the renders start. The writers render each frame in the order
+     * they were registered, whatever the order in which their renders actually start.
+     **/
+    void registerWriter(Natron::OutputEffectInstance* output);
+
+    /**
+     * @brief Called by the scheduler of the writer when it starts rendering.
+     **/
+    void addMember(Natron::OutputEffectInstance* output,int firstFrame,int lastFrame);
+
+    /**
+     * @brief Called by the scheduler of the writer when its render is finished or aborted, threads waiting on it are woken up.
+     **/
+    void removeMember(Natron::OutputEffectInstance* output);
+
+    /**
+     * @brief Called by a render thread of the writer before rendering the frame: blocks until the frame can be rendered
+     * or the thread must quit. Returns immediately if the writer is not rendering in the group.
+     **/
+    void waitForFrame(Natron::OutputEffectInstance* output,RenderThreadTask* thread,int time);
+
+    /**
+     * @brief Called by a render thread of the writer once the frame is rendered (or failed to render).
+     **/
+    void notifyFrameRendered(Natron::OutputEffectInstance* output,int time);
+
+    /**
+     * @brief Returns the first frame not rendered yet by the slowest writer still rendering, or INT_MAX if none.
+     **/
+    int getSlowestNextFrame() const WARN_UNUSED_RETURN;
+
+    int getMaxFramesAhead() const WARN_UNUSED_RETURN;
+
+private:
+
+    boost::scoped_ptr<OutputRenderGroupPrivate> _imp;
 };
 
 
@@ -471,6 +595,8 @@ private:
 
     virtual void processFrame(const BufferedFrames& frames) OVERRIDE FINAL;
     
+    virtual void displayFrame() OVERRIDE FINAL;
+    
     virtual void timelineStepOne(RenderDirectionEnum direction) OVERRIDE FINAL;
     
     virtual void timelineGoTo(int time) OVERRIDE FINAL;
@@ -479,6 +605,8 @@ private:
         
     virtual bool isFPSRegulationNeeded() const OVERRIDE FINAL WARN_UNUSED_RETURN { return true; }
     
+    virtual bool canDropFrames() const OVERRIDE FINAL WARN_UNUSED_RETURN { return true; }
+    
     virtual void getFrameRangeToRender(int& first,int& last) const OVERRIDE FINAL;
     
     virtual RenderThreadTask* createRunnable() OVERRIDE FINAL WARN_UNUSED_RETURN;
@@ -589,6 +717,21 @@ public:
      **/
     double getDesiredFPS() const;
     
+    /**
+     * @brief Returns the dropped/late frames and the achieved fps of the current or last playback
+     **/
+    void getPlaybackStatistics(PlaybackStatistics* stats) const;
+    
+    /**
+     * @brief Returns the stats of the cache I/O done during the current or last render
+     **/
+    void getCacheIOStatistics(Natron::CacheIO::Stats* stats) const;
+    
+    /**
+     * @brief Returns true if the current or last render failed, @see OutputSchedulerThread::getRenderFailure
+     **/
+    bool getRenderFailure(std::string* errorMessage) const;
+    
     /**
      * @brief Quit all processing, making sure all threads are finished.
      **/
@@ -635,6 +778,13 @@ Q_SIGNALS:
      **/
     void fpsChanged(double actualFps,double desiredFps);
     
+    /**
+     * @brief Emitted during playback when a frame was dropped or displayed late
+     * @param droppedFrames The number of frames dropped since the playback started
+     * @param lateFrames The number of frames displayed late since the playback started
+     **/
+    void playbackStatisticsChanged(int droppedFrames,int lateFrames);
+    
     /**
      * @brief Emitted after a frame is rendered.
      * This will not be emitted after calling renderCurrentFrame
@@ -667,6 +817,7 @@ private:
      * The following functions are called by the OutputThreadScheduler to Q_EMIT the corresponding signals
      **/
     void s_fpsChanged(double actual,double desired) { Q_EMIT fpsChanged(actual, desired); }
+    void s_playbackStatisticsChanged(int dropped,int late) { Q_EMIT playbackStatisticsChanged(dropped, late); }
     void s_frameRendered(int time) { Q_EMIT frameRendered(time); }
     void s_renderFinished(int retCode) { Q_EMIT renderFinished(retCode); }
     void s_refreshAllKnobs() { Q_EMIT refreshAllKnobs(); }
@@ -411,6 +411,20 @@ IntParam::setValueAtTime(int value,int time,int dimension)
     _intKnob->setValueAtTime(time, value, dimension);
 }
 
+void
+IntParam::setValuesAtTimes(const std::vector<int>& times,const std::vector<int>& values,int dimension)
+{
+    _intKnob->setValuesAtTimes(times, values, dimension, Natron::eValueChangedReasonNatronInternalEdited);
+}
+
+std::vector<int>
+IntParam::getValuesAtTimes(const std::vector<int>& times,int dimension) const
+{
+    std::vector<int> ret;
+    _intKnob->getValuesAtTimes(times, dimension, &ret);
+    return ret;
+}
+
 void
 IntParam::setDefaultValue(int value,int dimension)
 {
@@ -630,6 +644,20 @@ DoubleParam::setValueAtTime(double value,int time,int dimension)
     _doubleKnob->setValueAtTime(time, value, dimension);
 }
 
+void
+DoubleParam::setValuesAtTimes(const std::vector<int>& times,const std::vector<double>& values,int dimension)
+{
+    _doubleKnob->setValuesAtTimes(times, values, dimension, Natron::eValueChangedReasonNatronInternalEdited);
+}
+
+std::vector<double>
+DoubleParam::getValuesAtTimes(const std::vector<int>& times,int dimension) const
+{
+    std::vector<double> ret;
+    _doubleKnob->getValuesAtTimes(times, dimension, &ret);
+    return ret;
+}
+
 void
 DoubleParam::setDefaultValue(double value,int dimension)
 {
@@ -813,6 +841,20 @@ ColorParam::setValueAtTime(double value,int time,int dimension)
     _colorKnob->setValueAtTime(time, value, dimension);
 }
 
+void
+ColorParam::setValuesAtTimes(const std::vector<int>& times,const std::vector<double>& values,int dimension)
+{
+    _colorKnob->setValuesAtTimes(times, values, dimension, Natron::eValueChangedReasonNatronInternalEdited);
+}
+
+std::vector<double>
+ColorParam::getValuesAtTimes(const std::vector<int>& times,int dimension) const
+{
+    std::vector<double> ret;
+    _colorKnob->getValuesAtTimes(times, dimension, &ret);
+    return ret;
+}
+
 void
 ColorParam::setDefaultValue(double value,int dimension)
 {
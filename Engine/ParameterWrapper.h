@@ -293,6 +293,17 @@ public:
      **/
     void setValueAtTime(int value,int time,int dimension = 0);
     
+    /**
+     * @brief Set a keyframe with the corresponding value at each of the given times in one go. This is much faster than
+     * calling setValueAtTime for each keyframe: the animation curve is refreshed and the change notified only once.
+     **/
+    void setValuesAtTimes(const std::vector<int>& times,const std::vector<int>& values,int dimension = 0);
+    
+    /**
+     * @brief Same as calling getValueAtTime for each of the given times.
+     **/
+    std::vector<int> getValuesAtTimes(const std::vector<int>& times,int dimension = 0) const;
+    
     /**
      * @brief Set the default value for the given dimension
      **/
@@ -438,6 +449,17 @@ public:
      **/
     void setValueAtTime(double value,int time,int dimension = 0);
     
+    /**
+     * @brief Set a keyframe with the corresponding value at each of the given times in one go. This is much faster than
+     * calling setValueAtTime for each keyframe: the animation curve is refreshed and the change notified only once.
+     **/
+    void setValuesAtTimes(const std::vector<int>& times,const std::vector<double>& values,int dimension = 0);
+    
+    /**
+     * @brief Same as calling getValueAtTime for each of the given times.
+     **/
+    std::vector<double> getValuesAtTimes(const std::vector<int>& times,int dimension = 0) const;
+    
     /**
      * @brief Set the default value for the given dimension
      **/
@@ -585,6 +607,17 @@ public:
      **/
     void setValueAtTime(double value,int time,int dimension = 0);
     
+    /**
+     * @brief Set a keyframe with the corresponding value at each of the given times in one go. This is much faster than
+     * calling setValueAtTime for each keyframe: the animation curve is refreshed and the change notified only once.
+     **/
+    void setValuesAtTimes(const std::vector<int>& times,const std::vector<double>& values,int dimension = 0);
+    
+    /**
+     * @brief Same as calling getValueAtTime for each of the given times.
+     **/
+    std::vector<double> getValuesAtTimes(const std::vector<int>& times,int dimension = 0) const;
+    
     /**
      * @brief Set the default value for the given dimension
      **/
@@ -28,6 +28,7 @@
 #include "Engine/AppManager.h"
 #include "Engine/Node.h"
 #include "Engine/EffectInstance.h"
+#include "Engine/RenderWorker.h"
 
 ProcessHandler::ProcessHandler(AppInstance* app,
                                const QString & projectPath,
@@ -225,6 +226,11 @@ ProcessInputChannel::ProcessInputChannel(const QString & mainProcessServerName)
       , _mustQuit(false)
       , _mustQuitCond(new QWaitCondition)
       , _mustQuitMutex(new QMutex)
+      , _renderWorker(0)
+      , _pendingMessages()
+      , _inputChannelClosed(false)
+      , _pendingMessagesCond(new QWaitCondition)
+      , _pendingMessagesMutex(new QMutex)
 {
     initialize();
     _backgroundIPCServer->moveToThread(this);
@@ -245,6 +251,8 @@ ProcessInputChannel::~ProcessInputChannel()
     delete _backgroundOutputPipe;
     delete _mustQuitCond;
     delete _mustQuitMutex;
+    delete _pendingMessagesCond;
+    delete _pendingMessagesMutex;
 }
 
 void
@@ -257,6 +265,37 @@ ProcessInputChannel::writeToOutputChannel(const QString & message)
     }
 }
 
+void
+ProcessInputChannel::setRenderWorker(RenderWorker* worker)
+{
+    QMutexLocker k(_pendingMessagesMutex);
+    _renderWorker = worker;
+}
+
+bool
+ProcessInputChannel::waitForMessage(QString* message)
+{
+    QMutexLocker k(_pendingMessagesMutex);
+    while (_pendingMessages.empty() && !_inputChannelClosed) {
+        _pendingMessagesCond->wait(_pendingMessagesMutex);
+    }
+    if ( _pendingMessages.empty() ) {
+        return false;
+    }
+    *message = _pendingMessages.front();
+    _pendingMessages.pop_front();
+
+    return true;
+}
+
+void
+ProcessInputChannel::notifyInputChannelClosed()
+{
+    QMutexLocker k(_pendingMessagesMutex);
+    _inputChannelClosed = true;
+    _pendingMessagesCond->wakeAll();
+}
+
 void
 ProcessInputChannel::onNewConnectionPending()
 {
@@ -277,10 +316,25 @@ ProcessInputChannel::onInputChannelMessageReceived()
         str.chop(1);
     }
     if ( str.startsWith(kAbortRenderingStringShort) ) {
+        {
+            QMutexLocker k(_pendingMessagesMutex);
+            if (_renderWorker) {
+                ///A render worker only aborts the request it is rendering and keeps listening to the coordinator
+                _renderWorker->abortCurrentRequest();
+
+                return false;
+            }
+        }
         qDebug() << "Aborting render!";
         appPTR->abortAnyProcessing();
 
         return true;
+    } else if ( str.startsWith(kRenderWorkerRequestShort) || str.startsWith(kRenderWorkerQuitShort) ) {
+        QMutexLocker k(_pendingMessagesMutex);
+        _pendingMessages.push_back(str);
+        _pendingMessagesCond->wakeOne();
+
+        return str.startsWith(kRenderWorkerQuitShort);
     } else {
         std::cerr << "Error: Unable to interpret message: " << str.toStdString() << std::endl;
         throw std::runtime_error("ProcessInputChannel::onInputChannelMessageReceived() received erroneous message");
@@ -293,18 +347,30 @@ void
 ProcessInputChannel::run()
 {
     for (;; ) {
-        if ( _backgroundInputPipe->waitForReadyRead(100) ) {
-            if ( onInputChannelMessageReceived() ) {
+        if ( _backgroundInputPipe->canReadLine() || _backgroundInputPipe->waitForReadyRead(100) ) {
+            ///Several messages may have been received at once
+            bool mustClose = false;
+            while ( !mustClose && _backgroundInputPipe->canReadLine() ) {
+                mustClose = onInputChannelMessageReceived();
+            }
+            if (mustClose) {
                 qDebug() << "Background process now closing the input channel...";
+                notifyInputChannelClosed();
 
                 return;
             }
+        } else if (_backgroundInputPipe->state() != QLocalSocket::ConnectedState) {
+            ///The main process closed the channel or died
+            notifyInputChannelClosed();
+
+            return;
         }
 
         QMutexLocker l(_mustQuitMutex);
         if (_mustQuit) {
             _mustQuit = false;
             _mustQuitCond->wakeOne();
+            notifyInputChannelClosed();
 
             return;
         }
@@ -22,10 +22,12 @@ CLANG_DIAG_OFF(deprecated)
 #include <QStringList>
 #include <QString>
 CLANG_DIAG_ON(deprecated)
+#include <list>
 #include "Global/GlobalDefines.h"
 
 //natron
 class AppInstance;
+class RenderWorker;
 namespace Natron {
 class OutputEffectInstance;
 }
@@ -205,6 +207,18 @@ public:
      **/
     void writeToOutputChannel(const QString & message);
 
+    /**
+     * @brief When the process is a render worker, abort messages only abort the request being rendered by the worker
+     * instead of all processing, and the requests of the coordinator are queued for waitForMessage().
+     **/
+    void setRenderWorker(RenderWorker* worker);
+
+    /**
+     * @brief Blocks until the main process sends a message for the render worker, @see RenderWorker.
+     * Returns false once the input channel is closed and all the messages were read.
+     **/
+    bool waitForMessage(QString* message);
+
 public Q_SLOTS:
 
     /**
@@ -238,6 +252,11 @@ private:
      **/
     void initialize();
 
+    /**
+     * @brief Wakes up waitForMessage() when the input channel closes
+     **/
+    void notifyInputChannelClosed();
+
     QString _mainProcessServerName;
     QMutex* _backgroundOutputPipeMutex;
     QLocalSocket* _backgroundOutputPipe; //< if the process is background but managed by a gui process then this
@@ -248,6 +267,12 @@ private:
     bool _mustQuit;
     QWaitCondition* _mustQuitCond;
     QMutex* _mustQuitMutex;
+
+    RenderWorker* _renderWorker; //< set if the process is a render worker
+    std::list<QString> _pendingMessages; //< the messages for the render worker not read yet by waitForMessage()
+    bool _inputChannelClosed;
+    QWaitCondition* _pendingMessagesCond;
+    QMutex* _pendingMessagesMutex; //< protects _renderWorker, _pendingMessages and _inputChannelClosed
 };
 
 #endif // PROCESSHANDLER_H
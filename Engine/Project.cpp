@@ -15,6 +15,7 @@
 #include "Project.h"
 
 #include <fstream>
+#include <sstream>
 #include <algorithm>
 #include <ios>
 #include <cstdlib> // strtoul
@@ -37,10 +38,12 @@
 #include <QTemporaryFile>
 #include <QHostInfo>
 #include <QFileInfo>
+#include <QFile>
 
 
 #include "Engine/AppManager.h"
 #include "Engine/AppInstance.h"
+#include "Engine/DiskCacheNode.h"
 #include "Engine/ProjectPrivate.h"
 #include "Engine/EffectInstance.h"
 #include "Engine/Hash64.h"
@@ -130,6 +133,40 @@ public:
     }
 };
 
+///Sets the isSavingProject flag for the lifetime of the object, unless another save already set it
+class SavingProjectFlag_RAII
+{
+    QMutex* mutex;
+    bool* isSaving;
+    bool acquired;
+public:
+    
+    SavingProjectFlag_RAII(QMutex* mutex,bool* isSaving)
+    : mutex(mutex)
+    , isSaving(isSaving)
+    , acquired(false)
+    {
+        QMutexLocker l(mutex);
+        if (!*isSaving) {
+            *isSaving = true;
+            acquired = true;
+        }
+    }
+    
+    ~SavingProjectFlag_RAII()
+    {
+        if (acquired) {
+            QMutexLocker l(mutex);
+            *isSaving = false;
+        }
+    }
+    
+    bool isAcquired() const
+    {
+        return acquired;
+    }
+};
+
   
 bool
 Project::loadProject(const QString & path,
@@ -264,8 +301,15 @@ Project::loadProjectInternal(const QString & path,
         ProjectSerialization projectSerializationObj( getApp() );
         iArchive >> boost::serialization::make_nvp("Project", projectSerializationObj);
         
+        if (isAutoSave) {
+            projectSerializationObj.replayJournal(filePath + NATRON_AUTOSAVE_JOURNAL_EXT);
+        }
+        
         ret = load(projectSerializationObj,name,path,isAutoSave,realFilePath);
         
+        ///The loaded nodes are in no auto-save snapshot yet
+        _imp->resetAutoSaveJournal();
+        
         {
             QMutexLocker k(&_imp->isLoadingProjectMutex);
             _imp->isLoadingProjectInternal = false;
@@ -311,6 +355,9 @@ Project::loadProjectInternal(const QString & path,
     _imp->natronVersion->setValue(generateUserFriendlyNatronVersionName(),0);
     Q_EMIT projectNameChanged(name);
     
+    ///The storage of DiskCache nodes is named after the project
+    DiskCacheNode::refreshStorageDirectories( getNodes() );
+    
     std::string onProjectLoad = getOnProjectLoadCB();
     if (!onProjectLoad.empty()) {
         std::string err,output;
@@ -357,6 +404,7 @@ Project::saveProject(const QString & path,
             
             ///We just saved, any auto-save left is then worthless
             removeAutoSaves();
+            _imp->resetAutoSaveJournal();
 
             //}
         } else {
@@ -530,6 +578,7 @@ Project::saveProjectInternal(const QString & path,
         _imp->natronVersion->setValue(generateUserFriendlyNatronVersionName(),0);
     }
     
+    std::set<std::string> snapshotNodes;
     try {
         boost::archive::xml_oarchive oArchive(ofile);
         bool bgProject = appPTR->isBackground();
@@ -537,6 +586,10 @@ Project::saveProjectInternal(const QString & path,
         ProjectSerialization projectSerializationObj( getApp() );
         save(&projectSerializationObj);
         oArchive << boost::serialization::make_nvp("Project",projectSerializationObj);
+        const std::list< boost::shared_ptr<NodeSerialization> > & nodes = projectSerializationObj.getNodesSerialization().getNodesSerialization();
+        for (std::list< boost::shared_ptr<NodeSerialization> >::const_iterator it = nodes.begin(); it != nodes.end(); ++it) {
+            snapshotNodes.insert( (*it)->getNodeScriptName() );
+        }
         if (!bgProject) {
             getApp()->saveProjectGui(oArchive);
         }
@@ -566,9 +619,18 @@ Project::saveProjectInternal(const QString & path,
         _imp->projectPath = path;
         _imp->hasProjectBeenSavedByUser = true;
         _imp->ageSinceLastSave = time;
+        
+        ///The storage of DiskCache nodes is named after the project
+        DiskCacheNode::refreshStorageDirectories( getNodes() );
     } else {
         if (!isRenderSave) {
             Q_EMIT projectNameChanged(_imp->projectName + " (*)");
+
+            ///Next auto-saves are journaled against this snapshot
+            QMutexLocker l(&_imp->autoSaveJournalMutex);
+            _imp->autoSaveJournalPath = filePath + NATRON_AUTOSAVE_JOURNAL_EXT;
+            _imp->autoSaveJournalEntries = 0;
+            _imp->autoSaveSnapshotNodes = snapshotNodes;
         }
     }
     _imp->lastAutoSave = time;
@@ -584,11 +646,97 @@ Project::autoSave()
         return;
     }
 
-    saveProject(_imp->projectPath, _imp->projectName, true);
+    ///Take the changes to save, the changes made while saving are for the next auto-save
+    bool needsSnapshot;
+    std::list<NodePtr> changedNodes;
+    {
+        QMutexLocker l(&_imp->autoSaveJournalMutex);
+        needsSnapshot = _imp->autoSaveNeedsSnapshot || _imp->autoSaveJournalPath.isEmpty() ||
+                        _imp->autoSaveJournalEntries >= NATRON_AUTOSAVE_JOURNAL_MAX_ENTRIES;
+        for (std::map<Natron::Node*,boost::weak_ptr<Natron::Node> >::iterator it = _imp->autoSaveChangedNodes.begin();
+             it != _imp->autoSaveChangedNodes.end(); ++it) {
+            NodePtr node = it->second.lock();
+            if ( node && node->isActivated() ) {
+                changedNodes.push_back(node);
+            }
+        }
+        _imp->autoSaveChangedNodes.clear();
+        _imp->autoSaveNeedsSnapshot = false;
+    }
+
+    if (!needsSnapshot) {
+        needsSnapshot = !appendToAutoSaveJournal(changedNodes);
+    }
+    if (needsSnapshot) {
+        if ( saveProject(_imp->projectPath, _imp->projectName, true).isEmpty() ) {
+            ///Nothing was saved, the next auto-save must write the snapshot
+            QMutexLocker l(&_imp->autoSaveJournalMutex);
+            _imp->autoSaveNeedsSnapshot = true;
+        }
+    }
 }
 
+bool
+Project::appendToAutoSaveJournal(const std::list<NodePtr> & changedNodes)
+{
+    {
+        QMutexLocker l(&_imp->isLoadingProjectMutex);
+        if (_imp->isLoadingProject) {
+            return false;
+        }
+    }
+
+    ///Do not append to the journal while a save writes or removes its snapshot
+    SavingProjectFlag_RAII savingFlag(&_imp->isSavingProjectMutex, &_imp->isSavingProject);
+    if ( !savingFlag.isAcquired() ) {
+        return false;
+    }
+
+    QString journalPath;
+    {
+        QMutexLocker l(&_imp->autoSaveJournalMutex);
+        journalPath = _imp->autoSaveJournalPath;
+        for (std::list<NodePtr>::const_iterator it = changedNodes.begin(); it != changedNodes.end(); ++it) {
+            ///A node created or renamed since the snapshot cannot be replayed over it
+            if ( _imp->autoSaveSnapshotNodes.find( (*it)->getScriptName_mt_safe() ) == _imp->autoSaveSnapshotNodes.end() ) {
+                return false;
+            }
+        }
+    }
+
+    ///The snapshot is gone if the project was saved or loaded in the meantime
+    QString snapshotPath = journalPath.left( journalPath.size() - QString(NATRON_AUTOSAVE_JOURNAL_EXT).size() );
+    if ( !QFile::exists(snapshotPath) ) {
+        return false;
+    }
+    if ( changedNodes.empty() ) {
+        return true;
+    }
+
+    ProjectJournalEntrySerialization entry;
+    entry.initialize(changedNodes, this);
+    if ( !entry.appendToJournal(journalPath) ) {
+        return false;
+    }
+
+    {
+        QMutexLocker l(&_imp->autoSaveJournalMutex);
+        ++_imp->autoSaveJournalEntries;
+    }
+    Q_EMIT projectNameChanged(_imp->projectName + " (*)");
+    _imp->lastAutoSave = QDateTime::currentDateTime();
+
+    return true;
+} // appendToAutoSaveJournal
+
 void
 Project::triggerAutoSave()
+{
+    triggerAutoSave( NodePtr() );
+}
+
+void
+Project::triggerAutoSave(const NodePtr & changedNode)
 {
     ///Should only be called in the main-thread, that is upon user interaction.
     assert( QThread::currentThread() == qApp->thread() );
@@ -603,6 +751,30 @@ Project::triggerAutoSave()
         }
     }
 
+    {
+        QMutexLocker l(&_imp->autoSaveJournalMutex);
+        if (changedNode) {
+            ///Journal the top-level node: the nodes of groups and the children of multi-instances are serialized with it
+            NodePtr node = changedNode;
+            for (;;) {
+                NodePtr parent = node->getParentMultiInstance();
+                if (!parent) {
+                    NodeGroup* isGroup = dynamic_cast<NodeGroup*>( node->getGroup().get() );
+                    if (isGroup) {
+                        parent = isGroup->getNode();
+                    }
+                }
+                if (!parent) {
+                    break;
+                }
+                node = parent;
+            }
+            _imp->autoSaveChangedNodes.insert( std::make_pair( node.get(), boost::weak_ptr<Natron::Node>(node) ) );
+        } else {
+            _imp->autoSaveNeedsSnapshot = true;
+        }
+    }
+
     _imp->autoSaveTimer->start( appPTR->getCurrentSettings()->getAutoSaveDelayMS() );
 }
 
@@ -655,7 +827,7 @@ Project::findAndTryLoadAutoSave()
         searchStr.append(NATRON_PROJECT_FILE_EXT);
         searchStr.append('.');
         int suffixPos = entry.indexOf(searchStr);
-        if (suffixPos != -1 && !entry.contains("RENDER_SAVE")) {
+        if ( (suffixPos != -1) && !entry.contains("RENDER_SAVE") && !entry.endsWith(NATRON_AUTOSAVE_JOURNAL_EXT) ) {
             QString filename = entry.left(suffixPos + searchStr.size() - 1);
             bool exists = false;
 
@@ -763,6 +935,9 @@ Project::findAndTryLoadAutoSave()
                 _imp->ageSinceLastSave = QDateTime();
 
                 Q_EMIT projectNameChanged(_imp->projectName + " (*)");
+                
+                ///The storage of DiskCache nodes is named after the project
+                DiskCacheNode::refreshStorageDirectories( getNodes() );
 
                 refreshViewersAndPreviews();
 
@@ -1440,6 +1615,7 @@ Project::reset()
         _imp->autoSaveTimer->stop();
         _imp->additionalFormats.clear();
     }
+    _imp->resetAutoSaveJournal();
     _imp->timeline->removeAllKeyframesIndicators();
     const std::vector<boost::shared_ptr<KnobI> > & knobs = getKnobs();
 
@@ -74,14 +74,24 @@ public:
     /**
      * @brief Same as saveProject except that it will save the project in a temporary file
      * so it doesn't overwrite the project.
+     * If only the nodes given to triggerAutoSave(const NodePtr&) changed since the last auto-save, only those are
+     * appended to the journal of the last auto-save snapshot. Otherwise, or once the journal has
+     * NATRON_AUTOSAVE_JOURNAL_MAX_ENTRIES entries, a new snapshot of the whole project is written.
      **/
     void autoSave();
 
     /**
      * @brief Same as autoSave() but the auto-save is run in a separate thread instead.
+     * The next auto-save will write a snapshot of the whole project.
      **/
     void triggerAutoSave();
 
+    /**
+     * @brief Same as triggerAutoSave() for a change that only affects the parameters, the connections
+     * or the content (e.g: roto shapes) of the given node: the next auto-save may just journal the node.
+     **/
+    void triggerAutoSave(const NodePtr & changedNode);
+
     /**
      * @brief Returns the path to where the auto save files are stored on disk.
      **/
@@ -291,6 +301,12 @@ private:
 
     QString saveProjectInternal(const QString & path,const QString & name,bool autosave = false);
 
+    /**
+     * @brief Appends the state of the given top-level nodes to the journal of the last auto-save snapshot.
+     * Returns false if the journal cannot describe the change and a snapshot must be written instead.
+     **/
+    bool appendToAutoSaveJournal(const std::list<NodePtr> & changedNodes);
+
     
     
 
@@ -70,6 +70,13 @@ ProjectPrivate::ProjectPrivate(Natron::Project* project)
     , isSavingProjectMutex()
     , isSavingProject(false)
     , autoSaveTimer( new QTimer() )
+    , autoSaveFutures()
+    , autoSaveJournalMutex()
+    , autoSaveJournalPath()
+    , autoSaveJournalEntries(0)
+    , autoSaveSnapshotNodes()
+    , autoSaveChangedNodes()
+    , autoSaveNeedsSnapshot(true)
     , projectClosing(false)
     
 {
@@ -289,6 +296,17 @@ ProjectPrivate::autoSetProjectDirectory(const QString& path)
         envVars->setValue(newEnv, 0);
     }
 }
+
+void
+ProjectPrivate::resetAutoSaveJournal()
+{
+    QMutexLocker l(&autoSaveJournalMutex);
+    autoSaveJournalPath.clear();
+    autoSaveJournalEntries = 0;
+    autoSaveSnapshotNodes.clear();
+    autoSaveChangedNodes.clear();
+    autoSaveNeedsSnapshot = true;
+}
     
 
     
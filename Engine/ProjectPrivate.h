@@ -16,6 +16,7 @@
 #include <Python.h>
 
 #include <map>
+#include <set>
 #include <list>
 #include "Global/Macros.h"
 CLANG_DIAG_OFF(deprecated)
@@ -27,6 +28,9 @@ CLANG_DIAG_OFF(uninitialized)
 #include <QMutex>
 CLANG_DIAG_ON(deprecated)
 CLANG_DIAG_ON(uninitialized)
+#if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
+#include <boost/weak_ptr.hpp>
+#endif
 
 
 #include "Engine/Format.h"
@@ -34,6 +38,12 @@ CLANG_DIAG_ON(uninitialized)
 #include "Engine/KnobFile.h"
 #include "Engine/KnobFactory.h"
 
+///Extension appended to the file path of an auto-save snapshot to name its journal
+#define NATRON_AUTOSAVE_JOURNAL_EXT ".journal"
+
+///After this many journal entries the next auto-save folds them into a new snapshot
+#define NATRON_AUTOSAVE_JOURNAL_MAX_ENTRIES 50
+
 class QTimer;
 class TimeLine;
 class NodeSerialization;
@@ -112,6 +122,14 @@ struct ProjectPrivate
     bool isSavingProject; //< true when the project is saving
     boost::shared_ptr<QTimer> autoSaveTimer;
     std::list<boost::shared_ptr<QFutureWatcher<void> > > autoSaveFutures;
+
+    ///The auto-save journal, @see Project::autoSave()
+    mutable QMutex autoSaveJournalMutex; //< protects all the fields below
+    QString autoSaveJournalPath; //< journal of the last auto-save snapshot, empty if there is none
+    int autoSaveJournalEntries; //< number of entries appended to the journal since the snapshot
+    std::set<std::string> autoSaveSnapshotNodes; //< script names of the top-level nodes in the snapshot
+    std::map<Natron::Node*,boost::weak_ptr<Natron::Node> > autoSaveChangedNodes; //< top-level nodes changed since the last auto-save
+    bool autoSaveNeedsSnapshot; //< true if a change that cannot be journaled happened since the last auto-save
     bool projectClosing;
     
     ProjectPrivate(Natron::Project* project);
@@ -124,6 +142,11 @@ struct ProjectPrivate
      * @brief Auto fills the project directory parameter given the project file path
      **/
     void autoSetProjectDirectory(const QString& path);
+
+    /**
+     * @brief Discards the journal: the next auto-save writes a snapshot.
+     **/
+    void resetAutoSaveJournal();
 };
 }
 
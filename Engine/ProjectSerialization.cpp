@@ -15,6 +15,11 @@
 
 #include "ProjectSerialization.h"
 
+#include <sstream>
+
+#include <QFile>
+#include <QDebug>
+
 #include "Engine/TimeLine.h"
 #include "Engine/Project.h"
 #include "Engine/AppManager.h"
@@ -45,3 +50,94 @@ ProjectSerialization::initialize(const Natron::Project* project)
     _creationDate = project->getProjectCreationTime();
 }
 
+void
+ProjectSerialization::applyJournalEntry(const ProjectJournalEntrySerialization & entry)
+{
+    const std::list< boost::shared_ptr<NodeSerialization> > & nodes = entry.getNodesSerialization();
+
+    for (std::list< boost::shared_ptr<NodeSerialization> >::const_iterator it = nodes.begin(); it != nodes.end(); ++it) {
+        _nodes.replaceNodeSerialization(*it);
+    }
+    _timelineCurrent = entry.getCurrentTime();
+}
+
+int
+ProjectSerialization::replayJournal(const QString & journalPath)
+{
+    QFile journal(journalPath);
+
+    if ( !journal.open(QIODevice::ReadOnly) ) {
+        return 0;
+    }
+    QByteArray data = journal.readAll();
+    journal.close();
+
+    int applied = 0;
+    int pos = 0;
+    while ( pos < data.size() ) {
+        int endOfSize = data.indexOf('\n', pos);
+        if (endOfSize == -1) {
+            break;
+        }
+        bool ok;
+        int size = data.mid(pos, endOfSize - pos).toInt(&ok);
+        pos = endOfSize + 1;
+        if ( !ok || (size < 0) || ( size > data.size() - pos ) ) {
+            break;
+        }
+        std::istringstream ss( std::string(data.constData() + pos, size) );
+        pos += size;
+
+        ProjectJournalEntrySerialization entry;
+        try {
+            boost::archive::xml_iarchive iArchive(ss);
+            iArchive >> boost::serialization::make_nvp("Journal_entry", entry);
+        } catch (const std::exception & e) {
+            qDebug() << "Failed to read the auto-save journal: " << e.what();
+            break;
+        }
+        applyJournalEntry(entry);
+        ++applied;
+    }
+
+    return applied;
+} // replayJournal
+
+void
+ProjectJournalEntrySerialization::initialize(const std::list< boost::shared_ptr<Natron::Node> > & nodes,
+                                             const Natron::Project* project)
+{
+    _nodes.clear();
+    for (std::list< boost::shared_ptr<Natron::Node> >::const_iterator it = nodes.begin(); it != nodes.end(); ++it) {
+        boost::shared_ptr<NodeSerialization> state( new NodeSerialization(*it) );
+        _nodes.push_back(state);
+    }
+    _timelineCurrent = project->currentFrame();
+}
+
+bool
+ProjectJournalEntrySerialization::appendToJournal(const QString & journalPath) const
+{
+    std::ostringstream ss;
+    try {
+        boost::archive::xml_oarchive oArchive(ss);
+        oArchive << boost::serialization::make_nvp("Journal_entry", *this);
+    } catch (const std::exception & e) {
+        qDebug() << "Failed to journal the auto-save: " << e.what();
+
+        return false;
+    }
+    std::string data = ss.str();
+
+    QByteArray size = QByteArray::number( (qulonglong)data.size() );
+    size.append('\n');
+
+    QFile journal(journalPath);
+    if ( !journal.open(QIODevice::WriteOnly | QIODevice::Append) ) {
+        return false;
+    }
+    bool ok = journal.write(size) == size.size() && journal.write( data.c_str(), (qint64)data.size() ) == (qint64)data.size();
+    journal.close();
+
+    return ok;
+}
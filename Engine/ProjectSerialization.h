@@ -48,7 +48,79 @@ CLANG_DIAG_ON(unused-parameter)
 #define PROJECT_SERIALIZATION_INTRODUCES_GROUPS 5
 #define PROJECT_SERIALIZATION_VERSION PROJECT_SERIALIZATION_INTRODUCES_GROUPS
 
+#define PROJECT_JOURNAL_ENTRY_SERIALIZATION_VERSION 1
+
 class AppInstance;
+
+/**
+ * @brief An entry of the auto-save journal: the top-level nodes that changed since the previous auto-save.
+ * Entries are appended to the journal of the last auto-save snapshot and replayed over it on recovery.
+ * @see Project::autoSave()
+ **/
+class ProjectJournalEntrySerialization
+{
+    std::list< boost::shared_ptr<NodeSerialization> > _nodes;
+    SequenceTime _timelineCurrent;
+
+public:
+
+    ProjectJournalEntrySerialization()
+        : _timelineCurrent(0)
+    {
+    }
+
+    void initialize(const std::list< boost::shared_ptr<Natron::Node> > & nodes,
+                    const Natron::Project* project);
+
+    /**
+     * @brief Appends the entry to the given journal. The entry is prefixed by its size in bytes
+     * so that an entry truncated by a crash is ignored by ProjectSerialization::replayJournal.
+     * Returns false if the entry could not be written.
+     **/
+    bool appendToJournal(const QString & journalPath) const;
+
+    const std::list< boost::shared_ptr<NodeSerialization> > & getNodesSerialization() const
+    {
+        return _nodes;
+    }
+
+    SequenceTime getCurrentTime() const
+    {
+        return _timelineCurrent;
+    }
+
+    friend class boost::serialization::access;
+    template<class Archive>
+    void save(Archive & ar,
+              const unsigned int /*version*/) const
+    {
+        int nodesCount = (int)_nodes.size();
+        ar & boost::serialization::make_nvp("NodesCount",nodesCount);
+        for (std::list< boost::shared_ptr<NodeSerialization> >::const_iterator it = _nodes.begin(); it != _nodes.end(); ++it) {
+            ar & boost::serialization::make_nvp("item",**it);
+        }
+        ar & boost::serialization::make_nvp("Timeline_current_time", _timelineCurrent);
+    }
+
+    template<class Archive>
+    void load(Archive & ar,
+              const unsigned int /*version*/)
+    {
+        int nodesCount;
+        ar & boost::serialization::make_nvp("NodesCount",nodesCount);
+        for (int i = 0; i < nodesCount; ++i) {
+            boost::shared_ptr<NodeSerialization> ns(new NodeSerialization);
+            ar & boost::serialization::make_nvp("item",*ns);
+            _nodes.push_back(ns);
+        }
+        ar & boost::serialization::make_nvp("Timeline_current_time", _timelineCurrent);
+    }
+
+    BOOST_SERIALIZATION_SPLIT_MEMBER()
+};
+
+BOOST_CLASS_VERSION(ProjectJournalEntrySerialization,PROJECT_JOURNAL_ENTRY_SERIALIZATION_VERSION)
+
 class ProjectSerialization
 {
     NodeCollectionSerialization _nodes;
@@ -106,6 +178,18 @@ public:
         return _creationDate;
     }
 
+    /**
+     * @brief Replaces the nodes of the snapshot by their state in the given journal entry.
+     **/
+    void applyJournalEntry(const ProjectJournalEntrySerialization & entry);
+
+    /**
+     * @brief Applies the entries of the given journal, in order, over the snapshot.
+     * The replay stops at the first truncated or unreadable entry.
+     * @returns The number of entries applied
+     **/
+    int replayJournal(const QString & journalPath);
+
 
     friend class boost::serialization::access;
     template<class Archive>
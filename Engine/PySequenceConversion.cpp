@@ -0,0 +1,199 @@
+//  Natron
+//
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+
+#include "PySequenceConversion.h"
+
+namespace {
+
+template <typename SRC,typename DST>
+void
+readBufferItems(const Py_buffer & view,
+                std::vector<DST>* values)
+{
+    Py_ssize_t count = view.shape[0];
+    Py_ssize_t stride = view.strides ? view.strides[0] : view.itemsize;
+    const char* p = (const char*)view.buf;
+
+    values->resize(count);
+    for (Py_ssize_t i = 0; i < count; ++i, p += stride) {
+        (*values)[i] = (DST)*(const SRC*)p;
+    }
+}
+
+/**
+ * @brief Reads a one-dimensional buffer of native numbers. Returns false if the buffer cannot be read directly,
+ * in which case the object is converted as a sequence. Floating point buffers are not read into integers,
+ * the same way Python refuses to convert a float to an int implicitly.
+ **/
+template <typename DST>
+bool
+readBuffer(PyObject* obj,
+           bool acceptFloats,
+           std::vector<DST>* values)
+{
+    if ( !PyObject_CheckBuffer(obj) ) {
+        return false;
+    }
+    Py_buffer view;
+    if (PyObject_GetBuffer(obj, &view, PyBUF_RECORDS_RO) != 0) {
+        PyErr_Clear();
+
+        return false;
+    }
+    const char* format = view.format ? view.format : "B";
+    if ( (*format == '@') || (*format == '=') ) {
+        ++format;
+    }
+    bool ok = (view.ndim == 1) && format[0] && !format[1];
+    if (ok) {
+        switch (format[0]) {
+        case 'b':
+            readBufferItems<signed char>(view, values);
+            break;
+        case 'B':
+            readBufferItems<unsigned char>(view, values);
+            break;
+        case 'h':
+            readBufferItems<short>(view, values);
+            break;
+        case 'H':
+            readBufferItems<unsigned short>(view, values);
+            break;
+        case 'i':
+            readBufferItems<int>(view, values);
+            break;
+        case 'I':
+            readBufferItems<unsigned int>(view, values);
+            break;
+        case 'l':
+            readBufferItems<long>(view, values);
+            break;
+        case 'L':
+            readBufferItems<unsigned long>(view, values);
+            break;
+        case 'q':
+            readBufferItems<long long>(view, values);
+            break;
+        case 'Q':
+            readBufferItems<unsigned long long>(view, values);
+            break;
+        case 'f':
+            ok = acceptFloats;
+            if (ok) {
+                readBufferItems<float>(view, values);
+            }
+            break;
+        case 'd':
+            ok = acceptFloats;
+            if (ok) {
+                readBufferItems<double>(view, values);
+            }
+            break;
+        default:
+            ok = false;
+            break;
+        }
+    }
+    PyBuffer_Release(&view);
+
+    return ok;
+}
+
+template <typename DST>
+bool
+readSequence(PyObject* obj,
+             DST (*convert)(PyObject*),
+             std::vector<DST>* values)
+{
+    PyObject* seq = PySequence_Fast(obj, "expected a sequence of numbers");
+
+    if (!seq) {
+        return false;
+    }
+    Py_ssize_t count = PySequence_Fast_GET_SIZE(seq);
+    PyObject** items = PySequence_Fast_ITEMS(seq);
+    values->resize(count);
+    for (Py_ssize_t i = 0; i < count; ++i) {
+        (*values)[i] = convert(items[i]);
+        if ( PyErr_Occurred() ) {
+            Py_DECREF(seq);
+
+            return false;
+        }
+    }
+    Py_DECREF(seq);
+
+    return true;
+}
+
+int
+toInt(PyObject* item)
+{
+    return (int)PyLong_AsLong(item);
+}
+
+double
+toDouble(PyObject* item)
+{
+    return PyFloat_AsDouble(item);
+}
+} // anon namespace
+
+bool
+sequenceToVector(PyObject* obj,
+                 std::vector<int>* values)
+{
+    if ( readBuffer(obj, false, values) ) {
+        return true;
+    }
+
+    return readSequence(obj, toInt, values);
+}
+
+bool
+sequenceToVector(PyObject* obj,
+                 std::vector<double>* values)
+{
+    if ( readBuffer(obj, true, values) ) {
+        return true;
+    }
+
+    return readSequence(obj, toDouble, values);
+}
+
+PyObject*
+vectorToList(const std::vector<int>& values)
+{
+    PyObject* ret = PyList_New( (Py_ssize_t)values.size() );
+
+    if (!ret) {
+        return NULL;
+    }
+    for (std::size_t i = 0; i < values.size(); ++i) {
+        PyList_SET_ITEM( ret, (Py_ssize_t)i, PyLong_FromLong(values[i]) );
+    }
+
+    return ret;
+}
+
+PyObject*
+vectorToList(const std::vector<double>& values)
+{
+    PyObject* ret = PyList_New( (Py_ssize_t)values.size() );
+
+    if (!ret) {
+        return NULL;
+    }
+    for (std::size_t i = 0; i < values.size(); ++i) {
+        PyList_SET_ITEM( ret, (Py_ssize_t)i, PyFloat_FromDouble(values[i]) );
+    }
+
+    return ret;
+}
@@ -0,0 +1,30 @@
+//  Natron
+//
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef PYSEQUENCECONVERSION_H
+#define PYSEQUENCECONVERSION_H
+
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+
+#include <vector>
+
+/**
+ * @brief Converts a Python object to a vector of numbers. One-dimensional objects implementing the buffer protocol
+ * (e.g: numpy arrays or array.array) are read directly, any other sequence of numbers is converted item by item.
+ * On failure a Python exception is set and false is returned. Must be called with the GIL held.
+ **/
+bool sequenceToVector(PyObject* obj,std::vector<int>* values);
+bool sequenceToVector(PyObject* obj,std::vector<double>* values);
+
+/**
+ * @brief Returns a new reference to a Python list holding the values. Must be called with the GIL held.
+ **/
+PyObject* vectorToList(const std::vector<int>& values);
+PyObject* vectorToList(const std::vector<double>& values);
+
+#endif // PYSEQUENCECONVERSION_H
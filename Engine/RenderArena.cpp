@@ -0,0 +1,241 @@
+//  Natron
+//
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+
+#include "RenderArena.h"
+
+#include <cassert>
+#include <cstdlib>
+#include <vector>
+
+CLANG_DIAG_OFF(deprecated)
+#include <QtCore/QAtomicInt>
+#include <QtCore/QMutex>
+#include <QtCore/QThreadStorage>
+CLANG_DIAG_ON(deprecated)
+
+///Size of the blocks allocated on the heap by the arenas
+#define NATRON_RENDER_ARENA_BLOCK_SIZE (64 * 1024)
+
+///Number of blocks an arena keeps between frames, the others are given back to the system
+#define NATRON_RENDER_ARENA_MAX_KEPT_BLOCKS 16
+
+///Every allocation is preceded by a header pointing to the generation it belongs to.
+///It is also the alignment of all allocations.
+#define NATRON_RENDER_ARENA_HEADER_SIZE 16
+
+using namespace Natron;
+
+namespace {
+
+/**
+ * @brief The blocks in which the allocations of a frame are made.
+ * The generation is referenced once by its thread and once by each live allocation, it is deleted
+ * by whoever releases the last reference.
+ **/
+struct ArenaGeneration
+{
+    QAtomicInt refCount;
+    std::vector<char*> blocks;
+    std::size_t currentBlock;
+    std::size_t used; //< bytes used in the current block
+
+    ArenaGeneration()
+    : refCount(1)
+    , blocks()
+    , currentBlock(0)
+    , used(0)
+    {
+    }
+
+    ~ArenaGeneration()
+    {
+        for (U32 i = 0; i < blocks.size(); ++i) {
+            std::free(blocks[i]);
+        }
+    }
+};
+
+struct ArenaThreadData
+{
+    int frameDepth;
+    ArenaGeneration* generation;
+    RenderArena::Stats stats; //< counters of the frame being rendered on the thread
+
+    ArenaThreadData()
+    : frameDepth(0)
+    , generation(0)
+    , stats()
+    {
+    }
+
+    ~ArenaThreadData()
+    {
+        if ( generation && !generation->refCount.deref() ) {
+            delete generation;
+        }
+    }
+};
+
+///Deleted by Qt when the thread exits
+QThreadStorage<ArenaThreadData*> threadArenas;
+QMutex statsMutex;
+RenderArena::Stats totalStats;
+
+ArenaThreadData &
+getThreadData()
+{
+    if ( !threadArenas.hasLocalData() ) {
+        threadArenas.setLocalData(new ArenaThreadData);
+    }
+
+    return *threadArenas.localData();
+}
+
+char*
+allocateOnHeap(std::size_t size)
+{
+    char* block = (char*)std::malloc(size);
+
+    if (!block) {
+        throw std::bad_alloc();
+    }
+
+    return block;
+}
+
+///Called when the outermost frame of the thread ends
+void
+endFrame(ArenaThreadData & data,
+         bool countFrame)
+{
+    ArenaGeneration* gen = data.generation;
+
+    assert(gen);
+    if (gen->refCount.fetchAndAddOrdered(0) == 1) {
+        ///Everything was freed: reuse the blocks
+        while (gen->blocks.size() > NATRON_RENDER_ARENA_MAX_KEPT_BLOCKS) {
+            std::free( gen->blocks.back() );
+            gen->blocks.pop_back();
+        }
+        gen->currentBlock = 0;
+        gen->used = 0;
+    } else {
+        ///Some allocations outlive the frame: leave the generation to them
+        if ( !gen->refCount.deref() ) {
+            delete gen;
+        }
+        data.generation = 0;
+    }
+
+    if (countFrame) {
+        ++data.stats.frames;
+    }
+    {
+        QMutexLocker k(&statsMutex);
+        totalStats.frames += data.stats.frames;
+        totalStats.allocations += data.stats.allocations;
+        totalStats.bytes += data.stats.bytes;
+        totalStats.heapAllocations += data.stats.heapAllocations;
+    }
+    data.stats = RenderArena::Stats();
+}
+}
+
+RenderArena::FrameScope::FrameScope(bool countFrame)
+: _countFrame(countFrame)
+{
+    ArenaThreadData & data = getThreadData();
+
+    if (data.frameDepth == 0) {
+        if (!data.generation) {
+            data.generation = new ArenaGeneration;
+        }
+    }
+    ++data.frameDepth;
+}
+
+RenderArena::FrameScope::~FrameScope()
+{
+    ArenaThreadData & data = getThreadData();
+
+    assert(data.frameDepth > 0);
+    --data.frameDepth;
+    if (data.frameDepth == 0) {
+        endFrame(data, _countFrame);
+    }
+}
+
+void*
+RenderArena::allocate(std::size_t size)
+{
+    std::size_t total = ( (size + NATRON_RENDER_ARENA_HEADER_SIZE + NATRON_RENDER_ARENA_HEADER_SIZE - 1) / NATRON_RENDER_ARENA_HEADER_SIZE ) * NATRON_RENDER_ARENA_HEADER_SIZE;
+    ArenaThreadData & data = getThreadData();
+    ArenaGeneration* gen = data.frameDepth > 0 ? data.generation : 0;
+    char* ret;
+
+    if ( !gen || (total > NATRON_RENDER_ARENA_BLOCK_SIZE / 4) ) {
+        ///Outside of a frame or too large for the arena
+        ret = allocateOnHeap(total);
+        gen = 0;
+        if (data.frameDepth > 0) {
+            ++data.stats.heapAllocations;
+        }
+    } else {
+        if ( gen->blocks.empty() || (gen->used + total > NATRON_RENDER_ARENA_BLOCK_SIZE) ) {
+            if ( !gen->blocks.empty() ) {
+                ++gen->currentBlock;
+            }
+            if ( gen->currentBlock >= gen->blocks.size() ) {
+                gen->blocks.push_back( allocateOnHeap(NATRON_RENDER_ARENA_BLOCK_SIZE) );
+                ++data.stats.heapAllocations;
+            }
+            gen->used = 0;
+        }
+        ret = gen->blocks[gen->currentBlock] + gen->used;
+        gen->used += total;
+        gen->refCount.ref();
+        ++data.stats.allocations;
+        data.stats.bytes += size;
+    }
+    *(ArenaGeneration**)ret = gen;
+
+    return ret + NATRON_RENDER_ARENA_HEADER_SIZE;
+}
+
+void
+RenderArena::deallocate(void* p)
+{
+    if (!p) {
+        return;
+    }
+    char* allocation = (char*)p - NATRON_RENDER_ARENA_HEADER_SIZE;
+    ArenaGeneration* gen = *(ArenaGeneration**)allocation;
+    if (!gen) {
+        std::free(allocation);
+    } else if ( !gen->refCount.deref() ) {
+        delete gen;
+    }
+}
+
+void
+RenderArena::getStats(Stats* stats)
+{
+    QMutexLocker k(&statsMutex);
+
+    *stats = totalStats;
+}
+
+void
+RenderArena::resetStats()
+{
+    QMutexLocker k(&statsMutex);
+
+    totalStats = Stats();
+}
@@ -0,0 +1,175 @@
+//  Natron
+//
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef NATRON_ENGINE_RENDERARENA_H_
+#define NATRON_ENGINE_RENDERARENA_H_
+
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+
+#include <cstddef>
+#include <list>
+#include <new>
+
+#include "Global/GlobalDefines.h"
+#include "Engine/Rect.h"
+
+namespace Natron {
+
+/**
+ * @brief Memory of the short-lived containers used while rendering a frame (rectangles left to render,
+ * regions of interest of the inputs...).
+ *
+ * Each thread has its own arena: while a frame is being rendered on the thread (i.e: a FrameScope exists),
+ * allocations are carved out of big blocks without any lock, and freeing them does nothing but decrement a counter.
+ * When the outermost FrameScope of the thread is destroyed, the blocks are reused for the next frame.
+ * Outside of a frame, allocations go to the heap.
+ *
+ * Memory that is still referenced when the frame ends (e.g: a container copied to a structure that outlives
+ * the render) is never reused: the blocks of that frame are released when the last allocation is freed.
+ **/
+class RenderArena
+{
+public:
+
+    struct Stats
+    {
+        U64 frames; //< number of frames whose rendering ended
+        U64 allocations; //< number of allocations served by the arenas
+        U64 bytes; //< bytes served by the arenas
+        U64 heapAllocations; //< allocations made on the heap by the arenas (blocks and allocations too large for a block)
+
+        Stats()
+        : frames(0)
+        , allocations(0)
+        , bytes(0)
+        , heapAllocations(0)
+        {
+        }
+    };
+
+    /**
+     * @brief Marks the rendering of a frame on the calling thread. They can be nested, the arena of the
+     * thread is reset when the outermost one is destroyed.
+     * Threads rendering tiles of a frame rendered by another thread should not count it as a frame in the stats.
+     **/
+    class FrameScope
+    {
+        bool _countFrame;
+
+    public:
+
+        explicit FrameScope(bool countFrame = true);
+
+        ~FrameScope();
+    };
+
+    static void* allocate(std::size_t size);
+
+    static void deallocate(void* p);
+
+    /**
+     * @brief The counters of all the frames rendered since the last call to resetStats(), summed over all threads.
+     * Divide by frames to get the counts per frame.
+     **/
+    static void getStats(Stats* stats);
+
+    static void resetStats();
+};
+
+/**
+ * @brief A STL allocator using the arena of the calling thread. It is stateless: memory allocated
+ * by any instance may be freed by any other instance, on any thread.
+ **/
+template <typename T>
+class RenderArenaAllocator
+{
+public:
+
+    typedef T value_type;
+    typedef T* pointer;
+    typedef const T* const_pointer;
+    typedef T& reference;
+    typedef const T& const_reference;
+    typedef std::size_t size_type;
+    typedef std::ptrdiff_t difference_type;
+
+    template <typename U>
+    struct rebind
+    {
+        typedef RenderArenaAllocator<U> other;
+    };
+
+    RenderArenaAllocator()
+    {
+    }
+
+    template <typename U>
+    RenderArenaAllocator(const RenderArenaAllocator<U> &)
+    {
+    }
+
+    pointer address(reference x) const
+    {
+        return &x;
+    }
+
+    const_pointer address(const_reference x) const
+    {
+        return &x;
+    }
+
+    pointer allocate(size_type n,
+                     const void* /*hint*/ = 0)
+    {
+        return static_cast<pointer>( RenderArena::allocate( n * sizeof(T) ) );
+    }
+
+    void deallocate(pointer p,
+                    size_type /*n*/)
+    {
+        RenderArena::deallocate(p);
+    }
+
+    size_type max_size() const
+    {
+        return std::size_t(-1) / sizeof(T);
+    }
+
+    void construct(pointer p,
+                   const T & val)
+    {
+        new ( (void*)p )T(val);
+    }
+
+    void destroy(pointer p)
+    {
+        p->~T();
+    }
+};
+
+template <typename T, typename U>
+inline bool
+operator==(const RenderArenaAllocator<T> &,
+           const RenderArenaAllocator<U> &)
+{
+    return true;
+}
+
+template <typename T, typename U>
+inline bool
+operator!=(const RenderArenaAllocator<T> &,
+           const RenderArenaAllocator<U> &)
+{
+    return false;
+}
+
+///The rectangles of an image left to render
+typedef std::list<RectI, RenderArenaAllocator<RectI> > RenderRectsList;
+} // namespace Natron
+
+#endif // NATRON_ENGINE_RENDERARENA_H_
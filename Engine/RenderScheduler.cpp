@@ -0,0 +1,373 @@
+//  Natron
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+
+#include "RenderScheduler.h"
+
+#include <list>
+#include <algorithm>
+#include <cassert>
+
+#include <QtCore/QMutex>
+#include <QtCore/QWaitCondition>
+#include <QtCore/QAtomicInt>
+#include <QtCore/QRunnable>
+#include <QtCore/QThreadPool>
+
+#if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
+#include <boost/shared_ptr.hpp>
+#endif
+
+#include "Engine/ThreadStorage.h"
+
+using namespace Natron;
+
+namespace {
+
+struct RenderRequest
+{
+    Natron::RenderPriorityEnum priority;
+    const void* owner;
+    U64 ownerHash;
+    RenderScheduler::Functor functor;
+
+    ///Set when the request is no longer wanted. Read from isCurrentThreadPreempted() without holding the scheduler lock.
+    QAtomicInt cancelled;
+
+    ///Set by the thread running the request when it observed that it should yield to higher priority work.
+    QAtomicInt preempted;
+
+    RenderRequest(Natron::RenderPriorityEnum priority,
+                  const void* owner,
+                  U64 ownerHash,
+                  const RenderScheduler::Functor& functor)
+    : priority(priority)
+    , owner(owner)
+    , ownerHash(ownerHash)
+    , functor(functor)
+    , cancelled()
+    , preempted()
+    {
+        cancelled = 0;
+        preempted = 0;
+    }
+};
+
+typedef boost::shared_ptr<RenderRequest> RenderRequestPtr;
+typedef std::list<RenderRequestPtr> RenderRequestQueue;
+
+}
+
+struct RenderSchedulerPrivate
+{
+    mutable QMutex queuesMutex;
+    RenderRequestQueue queues[eRenderPriorityCount];
+    std::list<RenderRequestPtr> running;
+    int nRunning[eRenderPriorityCount];
+    bool mustQuit;
+
+    ///Signaled whenever a request finishes
+    QWaitCondition requestFinishedCond;
+
+    ///Number of requests queued + running per priority, readable without taking queuesMutex
+    QAtomicInt activeCount[eRenderPriorityCount];
+
+    ///The request run by the current thread, if any
+    mutable Natron::ThreadStorage<RenderRequestPtr> currentRequest;
+
+    RenderSchedulerPrivate()
+    : queuesMutex()
+    , queues()
+    , running()
+    , nRunning()
+    , mustQuit(false)
+    , requestFinishedCond()
+    , activeCount()
+    , currentRequest()
+    {
+        for (int i = 0; i < eRenderPriorityCount; ++i) {
+            nRunning[i] = 0;
+            activeCount[i] = 0;
+        }
+    }
+
+    bool hasHigherPriorityWork(int priority) const
+    {
+        for (int i = priority + 1; i < eRenderPriorityCount; ++i) {
+            if ((int)activeCount[i] > 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * @brief Starts as many queued requests as allowed. Must be called with queuesMutex held.
+     **/
+    void dispatchPending_locked();
+
+    void runRequest(const RenderRequestPtr& request);
+
+    void cancelRequests_locked(const void* owner,bool checkHash,U64 currentHash);
+};
+
+namespace {
+
+class RenderRequestRunnable
+    : public QRunnable
+{
+    RenderSchedulerPrivate* _imp;
+    RenderRequestPtr _request;
+
+public:
+
+    RenderRequestRunnable(RenderSchedulerPrivate* imp,
+                          const RenderRequestPtr& request)
+    : QRunnable()
+    , _imp(imp)
+    , _request(request)
+    {
+        setAutoDelete(true);
+    }
+
+    virtual ~RenderRequestRunnable()
+    {
+    }
+
+    virtual void run() OVERRIDE FINAL
+    {
+        _imp->runRequest(_request);
+    }
+};
+
+}
+
+void
+RenderSchedulerPrivate::dispatchPending_locked()
+{
+    if (mustQuit) {
+        return;
+    }
+
+    ///Lower priority work never takes more than half of the pool so that an interactive request
+    ///always finds a free thread quickly.
+    int maxThreads = QThreadPool::globalInstance()->maxThreadCount();
+    int maxLowPriorityThreads = std::max(1, maxThreads / 2);
+
+    int nLowPriorityRunning = 0;
+    for (int i = 0; i < eRenderPriorityViewer; ++i) {
+        nLowPriorityRunning += nRunning[i];
+    }
+
+    for (int p = eRenderPriorityCount - 1; p >= 0; --p) {
+
+        if (p != eRenderPriorityViewer) {
+            ///Don't start anything while higher priority work is pending or running
+            bool higherWork = false;
+            for (int i = p + 1; i < eRenderPriorityCount; ++i) {
+                if (!queues[i].empty() || nRunning[i] > 0) {
+                    higherWork = true;
+                    break;
+                }
+            }
+            if (higherWork) {
+                return;
+            }
+        }
+
+        while (!queues[p].empty()) {
+            if (p != eRenderPriorityViewer) {
+                if (nLowPriorityRunning >= maxLowPriorityThreads) {
+                    return;
+                }
+                ++nLowPriorityRunning;
+            }
+            RenderRequestPtr request = queues[p].front();
+            queues[p].pop_front();
+            running.push_back(request);
+            ++nRunning[p];
+            QThreadPool::globalInstance()->start(new RenderRequestRunnable(this, request), p);
+        }
+    }
+}
+
+void
+RenderSchedulerPrivate::runRequest(const RenderRequestPtr& request)
+{
+    if (!(int)request->cancelled) {
+        currentRequest.setLocalData(request);
+        request->functor();
+        currentRequest.setLocalData(RenderRequestPtr());
+    }
+
+    QMutexLocker k(&queuesMutex);
+    std::list<RenderRequestPtr>::iterator found = std::find(running.begin(), running.end(), request);
+    assert(found != running.end());
+    if (found != running.end()) {
+        running.erase(found);
+    }
+    --nRunning[request->priority];
+
+    if ((int)request->preempted && !(int)request->cancelled && !mustQuit) {
+        ///The request yielded to higher priority work, resume it later on
+        request->preempted = 0;
+        queues[request->priority].push_front(request);
+    } else {
+        activeCount[request->priority].fetchAndAddRelaxed(-1);
+    }
+    dispatchPending_locked();
+    requestFinishedCond.wakeAll();
+}
+
+void
+RenderSchedulerPrivate::cancelRequests_locked(const void* owner,
+                                              bool checkHash,
+                                              U64 currentHash)
+{
+    for (int p = 0; p < eRenderPriorityCount; ++p) {
+        for (RenderRequestQueue::iterator it = queues[p].begin(); it != queues[p].end();) {
+            if ((*it)->owner == owner && (!checkHash || (*it)->ownerHash != currentHash)) {
+                (*it)->cancelled = 1;
+                activeCount[p].fetchAndAddRelaxed(-1);
+                it = queues[p].erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+    for (std::list<RenderRequestPtr>::iterator it = running.begin(); it != running.end(); ++it) {
+        if ((*it)->owner == owner && (!checkHash || (*it)->ownerHash != currentHash)) {
+            (*it)->cancelled = 1;
+        }
+    }
+}
+
+RenderScheduler::RenderScheduler()
+: _imp(new RenderSchedulerPrivate())
+{
+}
+
+RenderScheduler::~RenderScheduler()
+{
+    quitAndWaitForDone();
+}
+
+void
+RenderScheduler::schedule(Natron::RenderPriorityEnum priority,
+                          const void* owner,
+                          U64 ownerHash,
+                          bool replacePending,
+                          const Functor& functor)
+{
+    assert(priority >= 0 && priority < eRenderPriorityCount);
+    RenderRequestPtr request(new RenderRequest(priority, owner, ownerHash, functor));
+
+    QMutexLocker k(&_imp->queuesMutex);
+    if (_imp->mustQuit) {
+        return;
+    }
+    if (replacePending && owner) {
+        RenderRequestQueue& queue = _imp->queues[priority];
+        for (RenderRequestQueue::iterator it = queue.begin(); it != queue.end();) {
+            if ((*it)->owner == owner) {
+                (*it)->cancelled = 1;
+                _imp->activeCount[priority].fetchAndAddRelaxed(-1);
+                it = queue.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+    _imp->queues[priority].push_back(request);
+    _imp->activeCount[priority].fetchAndAddRelaxed(1);
+    _imp->dispatchPending_locked();
+}
+
+void
+RenderScheduler::cancelStaleRequests(const void* owner,
+                                     U64 currentHash)
+{
+    if (!owner) {
+        return;
+    }
+    QMutexLocker k(&_imp->queuesMutex);
+    _imp->cancelRequests_locked(owner, true, currentHash);
+}
+
+void
+RenderScheduler::cancelAllRequests(const void* owner)
+{
+    if (!owner) {
+        return;
+    }
+    QMutexLocker k(&_imp->queuesMutex);
+    _imp->cancelRequests_locked(owner, false, 0);
+}
+
+bool
+RenderScheduler::isCurrentThreadPreempted() const
+{
+    if (!_imp->currentRequest.hasLocalData()) {
+        return false;
+    }
+    const RenderRequestPtr& request = _imp->currentRequest.localData();
+    if (!request) {
+        return false;
+    }
+    if ((int)request->cancelled) {
+        return true;
+    }
+    if (_imp->hasHigherPriorityWork(request->priority)) {
+        request->preempted = 1;
+        return true;
+    }
+    return false;
+}
+
+bool
+RenderScheduler::hasHigherPriorityWork(Natron::RenderPriorityEnum priority) const
+{
+    return _imp->hasHigherPriorityWork(priority);
+}
+
+void
+RenderScheduler::waitForHigherPriorityWork(Natron::RenderPriorityEnum priority,
+                                           unsigned long timeoutMS)
+{
+    QMutexLocker k(&_imp->queuesMutex);
+    if (_imp->hasHigherPriorityWork(priority)) {
+        _imp->requestFinishedCond.wait(&_imp->queuesMutex, timeoutMS);
+    }
+}
+
+int
+RenderScheduler::getNumActiveRequests(Natron::RenderPriorityEnum priority) const
+{
+    assert(priority >= 0 && priority < eRenderPriorityCount);
+    return (int)_imp->activeCount[priority];
+}
+
+void
+RenderScheduler::quitAndWaitForDone()
+{
+    QMutexLocker k(&_imp->queuesMutex);
+    _imp->mustQuit = true;
+    for (int p = 0; p < eRenderPriorityCount; ++p) {
+        for (RenderRequestQueue::iterator it = _imp->queues[p].begin(); it != _imp->queues[p].end(); ++it) {
+            (*it)->cancelled = 1;
+            _imp->activeCount[p].fetchAndAddRelaxed(-1);
+        }
+        _imp->queues[p].clear();
+    }
+    for (std::list<RenderRequestPtr>::iterator it = _imp->running.begin(); it != _imp->running.end(); ++it) {
+        (*it)->cancelled = 1;
+    }
+    while (!_imp->running.empty()) {
+        _imp->requestFinishedCond.wait(&_imp->queuesMutex);
+    }
+}
@@ -0,0 +1,104 @@
+//  Natron
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef NATRON_ENGINE_RENDERSCHEDULER_H_
+#define NATRON_ENGINE_RENDERSCHEDULER_H_
+
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+
+#include "Global/Macros.h"
+#if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
+#include <boost/function.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/scoped_ptr.hpp>
+#endif
+#include "Global/GlobalDefines.h"
+#include "Global/Enums.h"
+
+/**
+ * @brief The RenderScheduler is the single entry point for all "interactive" render work that
+ * was previously thrown at the global QThreadPool without any ordering: viewer current frame renders,
+ * node previews and analysis (histograms).
+ *
+ * Requests are dispatched on the global thread pool by decreasing priority. As long as a request of a
+ * given priority is queued or running, no request of a lower priority is started. A running request of lower
+ * priority is preempted: EffectInstance::aborted() returns true in its thread (see isCurrentThreadPreempted())
+ * and the request is re-queued once it returns, so that it is resumed when higher priority work is done.
+ *
+ * Each request may carry a token (an owner and the hash of the owner at the time of the request).
+ * Queued requests whose token is stale are dropped when the owner hash changes (see cancelStaleRequests()),
+ * and a running stale request is aborted the same way a preempted one is, without being re-queued.
+ **/
+struct RenderSchedulerPrivate;
+class RenderScheduler
+    : boost::noncopyable
+{
+public:
+
+    typedef boost::function<void ()> Functor;
+
+    RenderScheduler();
+
+    ~RenderScheduler();
+
+    /**
+     * @brief Queues the given functor with the given priority.
+     * @param owner If not NULL, the request is identified by this owner and ownerHash so it can be cancelled later on.
+     * @param replacePending If true, any request of the same owner and priority that is still queued is dropped in favor of this one.
+     **/
+    void schedule(Natron::RenderPriorityEnum priority,
+                  const void* owner,
+                  U64 ownerHash,
+                  bool replacePending,
+                  const Functor& functor);
+
+    /**
+     * @brief Drops all queued requests of the given owner whose hash is different from currentHash,
+     * and aborts the running ones.
+     **/
+    void cancelStaleRequests(const void* owner,U64 currentHash);
+
+    /**
+     * @brief Drops all queued requests of the given owner and aborts the running ones.
+     **/
+    void cancelAllRequests(const void* owner);
+
+    /**
+     * @brief Returns true if the calling thread is running a request which has been cancelled or which should
+     * yield to higher priority work. This is cheap and lock-free, it is called by EffectInstance::aborted().
+     * Threads that are not running a request of the scheduler always return false.
+     **/
+    bool isCurrentThreadPreempted() const WARN_UNUSED_RETURN;
+
+    /**
+     * @brief Returns true if some work with a priority strictly greater than the given priority is either queued or running.
+     **/
+    bool hasHigherPriorityWork(Natron::RenderPriorityEnum priority) const WARN_UNUSED_RETURN;
+
+    /**
+     * @brief Blocks the calling thread until there is no more work with a priority strictly greater than priority,
+     * or until timeoutMS milliseconds elapsed. This is meant for threads not managed by the scheduler (e.g: HistogramCPU)
+     * so they can get out of the way of interactive renders.
+     **/
+    void waitForHigherPriorityWork(Natron::RenderPriorityEnum priority,unsigned long timeoutMS);
+
+    /**
+     * @brief Returns the number of requests of the given priority that are queued or running.
+     **/
+    int getNumActiveRequests(Natron::RenderPriorityEnum priority) const WARN_UNUSED_RETURN;
+
+    /**
+     * @brief Drops all queued requests and waits for the running ones to return.
+     **/
+    void quitAndWaitForDone();
+
+private:
+
+    boost::scoped_ptr<RenderSchedulerPrivate> _imp;
+};
+
+#endif // NATRON_ENGINE_RENDERSCHEDULER_H_
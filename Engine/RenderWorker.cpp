@@ -0,0 +1,727 @@
+//  Natron
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+
+#include "RenderWorker.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#include <QCoreApplication>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QProcess>
+#include <QRegExp>
+#include <QTemporaryFile>
+
+#include "Engine/AppInstance.h"
+#include "Engine/AppManager.h"
+#include "Engine/BlockingBackgroundRender.h"
+#include "Engine/EffectInstance.h"
+#include "Engine/Knob.h"
+#include "Engine/KnobSerialization.h"
+#include "Engine/Node.h"
+#include "Engine/OutputSchedulerThread.h"
+#include "Engine/ProcessHandler.h"
+#include "Engine/ViewerInstance.h"
+
+///How long the coordinator waits for a message of a worker before checking the next one, in milliseconds
+#define NATRON_RENDER_WORKER_POLL_INTERVAL_MS 10
+
+///How long the coordinator waits for the input channel of a worker to accept its connection, in milliseconds
+#define NATRON_RENDER_WORKER_CONNECTION_TIMEOUT_MS 5000
+
+///How long the coordinator waits for a worker to exit once asked to quit, in milliseconds
+#define NATRON_RENDER_WORKER_QUIT_TIMEOUT_MS 30000
+
+namespace {
+
+///Messages are lines: names and values must not break them
+QString
+toMessageField(const QString& str)
+{
+    QString ret = str;
+
+    ret.replace('\t', ' ');
+    ret.replace('\n', ' ');
+    ret.replace('\r', ' ');
+
+    return ret;
+}
+
+void
+removeTrailingNewLines(QString* str)
+{
+    while ( str->endsWith('\n') || str->endsWith('\r') ) {
+        str->chop(1);
+    }
+}
+
+typedef std::list<std::pair<boost::shared_ptr<KnobI>,boost::shared_ptr<KnobI> > > SavedKnobs;
+
+/**
+ * @brief Sets the value of the parameter for the request being rendered. A copy of the parameter is saved beforehand
+ * so that its values, animation and expressions are restored once the request is rendered.
+ **/
+bool
+applyParamOverride(AppInstance* app,
+                   const QString& param,
+                   const QString& value,
+                   SavedKnobs* savedKnobs,
+                   QString* error)
+{
+    ///Node names may contain dots (nodes in groups), hence the parameter name and the dimension are read from the end
+    QStringList parts = param.split('.');
+    int dimension = -1;
+    if (parts.size() >= 3) {
+        bool isDimension;
+        int d = parts.back().toInt(&isDimension);
+        if (isDimension) {
+            dimension = d;
+            parts.pop_back();
+        }
+    }
+    if (parts.size() < 2) {
+        *error = QObject::tr("%1 is not a valid parameter, it must be written <node>.<parameter>[.<dimension>]").arg(param);
+
+        return false;
+    }
+    QString knobName = parts.back();
+    parts.pop_back();
+    QString nodeName = parts.join(".");
+
+    boost::shared_ptr<Natron::Node> node = app->getNodeByFullySpecifiedName( nodeName.toStdString() );
+    if (!node) {
+        *error = QObject::tr("%1 is not the name of a node of the project").arg(nodeName);
+
+        return false;
+    }
+    boost::shared_ptr<KnobI> knob = node->getKnobByName( knobName.toStdString() );
+    if (!knob) {
+        *error = QObject::tr("%1 has no parameter named %2").arg(nodeName).arg(knobName);
+
+        return false;
+    }
+    if ( dimension >= knob->getDimension() ) {
+        *error = QObject::tr("%1 has only %2 dimension(s)").arg(param).arg( knob->getDimension() );
+
+        return false;
+    }
+
+    Knob<int>* isInt = dynamic_cast<Knob<int>*>( knob.get() );
+    Knob<bool>* isBool = dynamic_cast<Knob<bool>*>( knob.get() );
+    Knob<double>* isDouble = dynamic_cast<Knob<double>*>( knob.get() );
+    Knob<std::string>* isString = dynamic_cast<Knob<std::string>*>( knob.get() );
+    if (!isInt && !isBool && !isDouble && !isString) {
+        *error = QObject::tr("%1 cannot be overridden").arg(param);
+
+        return false;
+    }
+
+    ///Convert the value before changing anything
+    bool ok = true;
+    int intValue = 0;
+    bool boolValue = false;
+    double doubleValue = 0.;
+    if (isInt) {
+        intValue = value.toInt(&ok);
+    } else if (isBool) {
+        QString lower = value.toLower();
+        ok = lower == "1" || lower == "0" || lower == "true" || lower == "false";
+        boolValue = lower == "1" || lower == "true";
+    } else if (isDouble) {
+        doubleValue = value.toDouble(&ok);
+    }
+    if (!ok) {
+        *error = QObject::tr("%1 is not a valid value for %2").arg(value).arg(param);
+
+        return false;
+    }
+
+    savedKnobs->push_back( std::make_pair( knob, KnobSerialization(knob,true).getKnob() ) );
+
+    int firstDim = dimension == -1 ? 0 : dimension;
+    int lastDim = dimension == -1 ? knob->getDimension() - 1 : dimension;
+    for (int i = firstDim; i <= lastDim; ++i) {
+        knob->clearExpression(i, true);
+        knob->removeAnimation(i);
+        if (isInt) {
+            isInt->setValue(intValue, i, true);
+        } else if (isBool) {
+            isBool->setValue(boolValue, i, true);
+        } else if (isDouble) {
+            isDouble->setValue(doubleValue, i, true);
+        } else {
+            isString->setValue(value.toStdString(), i, true);
+        }
+    }
+
+    return true;
+} // applyParamOverride
+} // anon namespace
+
+QString
+RenderWorkerRequest::toString() const
+{
+    QString ret(kRenderWorkerRequestShort);
+
+    ret.append('\t');
+    ret.append( toMessageField(writerName) );
+    ret.append('\t');
+    ret.append( frameRangesToString(frameRanges) );
+    ret.append('\t');
+    ret.append(allFrames ? "all" : "chunk");
+    for (std::list<std::pair<QString,QString> >::const_iterator it = paramOverrides.begin(); it != paramOverrides.end(); ++it) {
+        ret.append('\t');
+        ret.append( toMessageField(it->first) );
+        ret.append('=');
+        ret.append( toMessageField(it->second) );
+    }
+
+    return ret;
+}
+
+bool
+RenderWorkerRequest::fromString(const QString& message,
+                                RenderWorkerRequest* request,
+                                QString* error)
+{
+    assert(request && error);
+    QString str = message;
+    removeTrailingNewLines(&str);
+    if ( !str.startsWith(kRenderWorkerRequestShort) ) {
+        *error = QObject::tr("The message is not a render request");
+
+        return false;
+    }
+
+    ///The first field is the empty string between the prefix and the first tabulation
+    QStringList fields = str.mid( std::strlen(kRenderWorkerRequestShort) ).split('\t');
+    if ( (fields.size() < 4) || !fields[0].isEmpty() || fields[1].isEmpty() ) {
+        *error = QObject::tr("The render request must give a Write node, frame ranges and whether they are all the frames to render");
+
+        return false;
+    }
+
+    request->writerName = fields[1];
+    request->frameRanges.clear();
+    if ( !frameRangesFromString(fields[2], &request->frameRanges) ) {
+        *error = QObject::tr("%1 is not a valid list of frame ranges").arg(fields[2]);
+
+        return false;
+    }
+    if ( (fields[3] != "all") && (fields[3] != "chunk") ) {
+        *error = QObject::tr("%1 is not valid, the frame ranges must be followed by all or chunk").arg(fields[3]);
+
+        return false;
+    }
+    request->allFrames = fields[3] == "all";
+    request->paramOverrides.clear();
+    for (int i = 4; i < fields.size(); ++i) {
+        int equal = fields[i].indexOf('=');
+        if (equal <= 0) {
+            *error = QObject::tr("%1 is not a valid parameter override, it must be written <parameter>=<value>").arg(fields[i]);
+
+            return false;
+        }
+        request->paramOverrides.push_back( std::make_pair( fields[i].left(equal), fields[i].mid(equal + 1) ) );
+    }
+
+    return true;
+}
+
+QString
+RenderWorkerRequest::frameRangesToString(const std::vector<std::pair<int,int> >& ranges)
+{
+    QStringList ret;
+
+    for (std::vector<std::pair<int,int> >::const_iterator it = ranges.begin(); it != ranges.end(); ++it) {
+        if (it->first == it->second) {
+            ret.push_back( QString::number(it->first) );
+        } else {
+            ret.push_back( QString::number(it->first) + '-' + QString::number(it->second) );
+        }
+    }
+
+    return ret.join(",");
+}
+
+bool
+RenderWorkerRequest::frameRangesFromString(const QString& str,
+                                           std::vector<std::pair<int,int> >* ranges)
+{
+    assert(ranges);
+    QStringList items = str.split(',');
+    QRegExp rx("(-?\\d+)(?:-(-?\\d+))?");
+    std::vector<std::pair<int,int> > ret;
+    for (int i = 0; i < items.size(); ++i) {
+        if ( !rx.exactMatch( items[i].trimmed() ) ) {
+            return false;
+        }
+        bool ok;
+        int first = rx.cap(1).toInt(&ok);
+        if (!ok) {
+            return false;
+        }
+        int last = first;
+        if ( !rx.cap(2).isEmpty() ) {
+            last = rx.cap(2).toInt(&ok);
+            if ( !ok || (last < first) ) {
+                return false;
+            }
+        }
+        ret.push_back( std::make_pair(first, last) );
+    }
+    *ranges = ret;
+
+    return true;
+}
+
+void
+RenderWorkerRequest::splitFrameRanges(const std::vector<std::pair<int,int> >& ranges,
+                                      int chunkSize,
+                                      std::list<std::pair<int,int> >* chunks)
+{
+    assert(chunks);
+    chunkSize = std::max(chunkSize, 1);
+    for (std::vector<std::pair<int,int> >::const_iterator it = ranges.begin(); it != ranges.end(); ++it) {
+        ///Compare in 64 bits so that ranges ending close to INT_MAX do not overflow
+        for (long long f = it->first; f <= it->second; f += chunkSize) {
+            long long last = std::min( f + chunkSize - 1, (long long)it->second );
+            chunks->push_back( std::make_pair( (int)f, (int)last ) );
+        }
+    }
+}
+
+RenderWorker::RenderWorker(AppInstance* app,
+                           ProcessInputChannel* channel)
+    : _app(app)
+    , _channel(channel)
+    , _currentWriterMutex()
+    , _currentWriter(0)
+    , _aborted(false)
+{
+    assert(_app && _channel);
+    _channel->setRenderWorker(this);
+}
+
+RenderWorker::~RenderWorker()
+{
+    _channel->setRenderWorker(0);
+}
+
+void
+RenderWorker::exec()
+{
+    QString message;
+
+    while ( _channel->waitForMessage(&message) ) {
+        if ( message.startsWith(kRenderWorkerQuitShort) ) {
+            return;
+        }
+        RenderWorkerRequest request;
+        QString error;
+        bool sequential = false;
+        bool ok = RenderWorkerRequest::fromString(message, &request, &error) && render(request, &sequential, &error);
+        if (ok) {
+            appPTR->writeToOutputPipe(QObject::tr("Request rendered"), kRenderWorkerRequestDoneShort);
+        } else if (sequential) {
+            appPTR->writeToOutputPipe(error, kRenderWorkerRequestSequentialShort);
+        } else {
+            appPTR->writeToOutputPipe(error, kRenderWorkerRequestFailedShort + toMessageField(error) );
+        }
+    }
+}
+
+void
+RenderWorker::abortCurrentRequest()
+{
+    QMutexLocker k(&_currentWriterMutex);
+
+    _aborted = true;
+    if (_currentWriter) {
+        _currentWriter->getRenderEngine()->abortRendering(false);
+    }
+}
+
+bool
+RenderWorker::render(const RenderWorkerRequest& request,
+                     bool* sequential,
+                     QString* error)
+{
+    assert(sequential && error);
+    *sequential = false;
+    {
+        QMutexLocker k(&_currentWriterMutex);
+        _aborted = false;
+    }
+
+    boost::shared_ptr<Natron::Node> node = _app->getNodeByFullySpecifiedName( request.writerName.toStdString() );
+    Natron::OutputEffectInstance* writer = node ? dynamic_cast<Natron::OutputEffectInstance*>( node->getLiveInstance() ) : 0;
+    if ( !writer || !node->isOutputNode() || dynamic_cast<ViewerInstance*>(writer) ) {
+        *error = QObject::tr("%1 is not the name of a Write node of the project").arg(request.writerName);
+
+        return false;
+    }
+
+    ///Another worker may be rendering the other frames: a movie file would be written by several processes at once
+    if ( !request.allFrames && (writer->getSequentialPreference() != Natron::eSequentialPreferenceNotSequential) ) {
+        *error = QObject::tr("%1 must render all its frames in order in a single process").arg(request.writerName);
+        *sequential = true;
+
+        return false;
+    }
+
+    SavedKnobs savedKnobs;
+    bool ok = true;
+    for (std::list<std::pair<QString,QString> >::const_iterator it = request.paramOverrides.begin(); it != request.paramOverrides.end(); ++it) {
+        if ( !applyParamOverride(_app, it->first, it->second, &savedKnobs, error) ) {
+            ok = false;
+            break;
+        }
+    }
+
+    for (std::vector<std::pair<int,int> >::const_iterator it = request.frameRanges.begin(); ok && it != request.frameRanges.end(); ++it) {
+        {
+            QMutexLocker k(&_currentWriterMutex);
+            if (_aborted) {
+                break;
+            }
+            _currentWriter = writer;
+        }
+
+        BlockingBackgroundRender backgroundRender(writer);
+        backgroundRender.blockingRender(it->first, it->second); //< doesn't return before rendering is finished
+
+        ///A failed render stops as an aborted one does: the coordinator must not take the chunk for done
+        std::string failure;
+        if ( writer->getRenderEngine()->getRenderFailure(&failure) ) {
+            *error = QObject::tr("%1 failed to render frames %2-%3").arg(request.writerName).arg(it->first).arg(it->second);
+            if ( !failure.empty() ) {
+                error->append( QString(": ") + QString( failure.c_str() ) );
+            }
+            ok = false;
+        }
+
+        QMutexLocker k(&_currentWriterMutex);
+        _currentWriter = 0;
+    }
+
+    {
+        QMutexLocker k(&_currentWriterMutex);
+        if (ok && _aborted) {
+            *error = QObject::tr("Render aborted");
+            ok = false;
+        }
+    }
+
+    ///Restore the parameters in the reverse order so that a parameter overridden twice gets its original value back
+    for (SavedKnobs::reverse_iterator it = savedKnobs.rbegin(); it != savedKnobs.rend(); ++it) {
+        it->first->clone(it->second);
+    }
+
+    return ok;
+} // render
+
+struct RenderCoordinator::Worker
+{
+    enum StateEnum
+    {
+        eStateStarting = 0, //< waiting for the worker to connect to the server and to create its input channel
+        eStateIdle, //< waiting for a chunk
+        eStateBusy, //< rendering chunk
+        eStateDead
+    };
+
+    QProcess* process;
+    QLocalServer* server; //< the worker connects its output channel to it
+    QLocalSocket* outputChannel; //< the messages of the worker, owned by server
+    QLocalSocket* inputChannel; //< the requests sent to the worker
+    StateEnum state;
+    std::vector<std::pair<int,int> > frameRanges; //< the frames being rendered when busy
+    bool allFrames; //< true if frameRanges are all the frames of the render
+    long long framesRendered; //< the frames of frameRanges rendered so far
+
+    Worker()
+        : process(new QProcess)
+        , server(new QLocalServer)
+        , outputChannel(0)
+        , inputChannel(0)
+        , state(eStateStarting)
+        , frameRanges()
+        , allFrames(false)
+        , framesRendered(0)
+    {
+    }
+
+    ~Worker()
+    {
+        delete inputChannel;
+        server->close();
+        delete server;
+        delete process;
+    }
+
+    void write(const QString& message)
+    {
+        if (inputChannel) {
+            inputChannel->write( (message + '\n').toUtf8() );
+            inputChannel->flush();
+        }
+    }
+
+    bool hasExited()
+    {
+        return process->state() == QProcess::NotRunning || process->waitForFinished(0);
+    }
+
+    void kill()
+    {
+        process->kill();
+        process->waitForFinished();
+        state = eStateDead;
+    }
+};
+
+RenderCoordinator::RenderCoordinator(const QString& projectPath,
+                                     int workersCount)
+    : _projectPath(projectPath)
+    , _workersCount(workersCount)
+    , _workers()
+{
+}
+
+RenderCoordinator::~RenderCoordinator()
+{
+    stopWorkers();
+}
+
+bool
+RenderCoordinator::startWorkers(QString* error)
+{
+    for (int i = 0; i < _workersCount; ++i) {
+        Worker* w = new Worker;
+        _workers.push_back(w);
+
+        QString serverName;
+        {
+            QTemporaryFile tmpf( NATRON_APPLICATION_NAME "_WORKER_PIPE_" + QString::number( std::rand() ) );
+            tmpf.open();
+            serverName = tmpf.fileName();
+            tmpf.remove();
+        }
+        if ( !w->server->listen(serverName) ) {
+            *error = QObject::tr("Failed to create the pipe of a render worker: %1").arg( w->server->errorString() );
+
+            return false;
+        }
+
+        if ( !startWorkerProcess(w->process, w->server->fullServerName(), error) ) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool
+RenderCoordinator::startWorkerProcess(QProcess* process,
+                                      const QString& serverName,
+                                      QString* error)
+{
+    QStringList args;
+
+    args << _projectPath << "-b" << "--worker" << "--IPCpipe" << serverName;
+    ///The workers print to the console of the coordinator, this also prevents them from blocking on a full pipe
+    process->setProcessChannelMode(QProcess::ForwardedChannels);
+    process->start(QCoreApplication::applicationFilePath(), args);
+    if ( !process->waitForStarted() ) {
+        *error = QObject::tr("Failed to start a render worker: %1").arg( process->errorString() );
+
+        return false;
+    }
+
+    return true;
+}
+
+void
+RenderCoordinator::stopWorkers()
+{
+    for (std::vector<Worker*>::iterator it = _workers.begin(); it != _workers.end(); ++it) {
+        if ( ( (*it)->state != Worker::eStateDead ) && (*it)->inputChannel ) {
+            if ( (*it)->state == Worker::eStateBusy ) {
+                (*it)->write(kAbortRenderingStringShort);
+            }
+            (*it)->write(kRenderWorkerQuitShort);
+        }
+    }
+    for (std::vector<Worker*>::iterator it = _workers.begin(); it != _workers.end(); ++it) {
+        if ( ( (*it)->state != Worker::eStateDead ) &&
+             ( !(*it)->inputChannel || !(*it)->process->waitForFinished(NATRON_RENDER_WORKER_QUIT_TIMEOUT_MS) ) ) {
+            (*it)->kill();
+        }
+        delete *it;
+    }
+    _workers.clear();
+}
+
+bool
+RenderCoordinator::render(const RenderWorkerRequest& request,
+                          int chunkSize,
+                          QString* error)
+{
+    assert(error);
+    if ( _workers.empty() && !startWorkers(error) ) {
+        return false;
+    }
+
+    long long framesCount = 0;
+    for (std::vector<std::pair<int,int> >::const_iterator it = request.frameRanges.begin(); it != request.frameRanges.end(); ++it) {
+        framesCount += (long long)it->second - it->first + 1;
+    }
+    if (chunkSize <= 0) {
+        ///Several chunks per worker so that a worker done early takes over the frames of a slower one
+        chunkSize = (int)std::max( framesCount / ( (long long)_workersCount * 4 ), 1LL );
+    }
+    std::list<std::pair<int,int> > chunks;
+    RenderWorkerRequest::splitFrameRanges(request.frameRanges, chunkSize, &chunks);
+
+    ///Set once a worker refused a chunk: all the frames must then be rendered by a single worker
+    bool sequential = false;
+    bool allFramesPending = false; //< true when sequential and no worker is rendering all the frames
+
+    long long framesRendered = 0;
+    RenderWorkerRequest chunkRequest = request;
+
+    for (;; ) {
+        bool hasWorkerAlive = false;
+        bool hasWorkerBusy = false;
+        bool receivedMessage = false;
+
+        for (std::vector<Worker*>::iterator it = _workers.begin(); it != _workers.end(); ++it) {
+            Worker* w = *it;
+            if (w->state == Worker::eStateDead) {
+                continue;
+            }
+
+            if ( !w->outputChannel && ( w->server->hasPendingConnections() || w->server->waitForNewConnection(0) ) ) {
+                w->outputChannel = w->server->nextPendingConnection();
+            }
+
+            while ( w->outputChannel && w->outputChannel->canReadLine() ) {
+                receivedMessage = true;
+                QString str = w->outputChannel->readLine();
+                removeTrailingNewLines(&str);
+                if ( str.startsWith(kBgProcessServerCreatedShort) ) {
+                    ///The worker created its input channel, connect to it
+                    if (!w->inputChannel) {
+                        w->inputChannel = new QLocalSocket;
+                        w->inputChannel->connectToServer(str.mid( std::strlen(kBgProcessServerCreatedShort) ), QLocalSocket::ReadWrite);
+                        if ( w->inputChannel->waitForConnected(NATRON_RENDER_WORKER_CONNECTION_TIMEOUT_MS) ) {
+                            w->state = Worker::eStateIdle;
+                        } else {
+                            std::cout << QObject::tr("WARNING: Failed to connect to a render worker, it will not be used.").toStdString() << std::endl;
+                            w->kill();
+                        }
+                    }
+                } else if ( str.startsWith(kFrameRenderedStringShort) ) {
+                    ++framesRendered;
+                    ++w->framesRendered;
+                    QString frameStr = str.mid( std::strlen(kFrameRenderedStringShort) );
+                    QString pStr = QString::number(framesRendered * 100. / std::max(framesCount, 1LL), 'f', 1);
+                    appPTR->writeToOutputPipe(kFrameRenderedStringLong + frameStr + " (" + pStr + "%)", kFrameRenderedStringShort + frameStr);
+                } else if ( str.startsWith(kRenderWorkerRequestDoneShort) ) {
+                    w->state = Worker::eStateIdle;
+                } else if ( str.startsWith(kRenderWorkerRequestSequentialShort) ) {
+                    ///Nothing was rendered. The other workers refuse their chunk too since they have the same Write node
+                    w->state = Worker::eStateIdle;
+                    if (!sequential) {
+                        sequential = true;
+                        allFramesPending = true;
+                        chunks.clear();
+                    }
+                } else if ( str.startsWith(kRenderWorkerRequestFailedShort) ) {
+                    w->state = Worker::eStateIdle;
+                    *error = QObject::tr("Frames %1 failed to render: %2").arg( RenderWorkerRequest::frameRangesToString(w->frameRanges) )
+                             .arg( str.mid( std::strlen(kRenderWorkerRequestFailedShort) ) );
+
+                    return false;
+                }
+                ///Other messages (render started, render finished, progress) are not needed by the coordinator
+                if (w->state == Worker::eStateDead) {
+                    break;
+                }
+            }
+
+            if ( (w->state != Worker::eStateDead) && w->hasExited() ) {
+                if (w->state == Worker::eStateBusy) {
+                    ///Give the frames of the worker to another one
+                    std::cout << QObject::tr("WARNING: A render worker exited while rendering frames %1, they will be rendered again.")
+                        .arg( RenderWorkerRequest::frameRangesToString(w->frameRanges) ).toStdString() << std::endl;
+                    framesRendered -= w->framesRendered;
+                    if (w->allFrames) {
+                        allFramesPending = true;
+                    } else if (!sequential) {
+                        chunks.push_front(w->frameRanges.front());
+                    }
+                }
+                w->state = Worker::eStateDead;
+            }
+
+            if ( (w->state == Worker::eStateIdle) && (allFramesPending || !chunks.empty()) ) {
+                if (allFramesPending) {
+                    w->frameRanges = request.frameRanges;
+                    allFramesPending = false;
+                } else {
+                    w->frameRanges.assign( 1, chunks.front() );
+                    chunks.pop_front();
+                }
+                ///A single chunk may hold all the frames, which the Write nodes rendering in order accept
+                w->allFrames = w->frameRanges == request.frameRanges;
+                w->framesRendered = 0;
+                chunkRequest.frameRanges = w->frameRanges;
+                chunkRequest.allFrames = w->allFrames;
+                w->write( chunkRequest.toString() );
+                w->state = Worker::eStateBusy;
+            }
+
+            if (w->state != Worker::eStateDead) {
+                hasWorkerAlive = true;
+            }
+            if (w->state == Worker::eStateBusy) {
+                hasWorkerBusy = true;
+            }
+        }
+
+        if ( chunks.empty() && !allFramesPending && !hasWorkerBusy ) {
+            return true;
+        }
+        if (!hasWorkerAlive) {
+            *error = QObject::tr("All the render workers exited before the end of the render");
+
+            return false;
+        }
+
+        if (!receivedMessage) {
+            ///Nothing to do until a worker connects or writes a message
+            for (std::vector<Worker*>::iterator it = _workers.begin(); it != _workers.end(); ++it) {
+                if ( (*it)->state == Worker::eStateDead ) {
+                    continue;
+                }
+                if ( (*it)->outputChannel ) {
+                    (*it)->outputChannel->waitForReadyRead(NATRON_RENDER_WORKER_POLL_INTERVAL_MS);
+                } else {
+                    (*it)->server->waitForNewConnection(NATRON_RENDER_WORKER_POLL_INTERVAL_MS);
+                }
+            }
+        }
+    }
+} // render
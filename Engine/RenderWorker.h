@@ -0,0 +1,175 @@
+//  Natron
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef RENDERWORKER_H
+#define RENDERWORKER_H
+
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+
+#include <list>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+
+class AppInstance;
+class ProcessInputChannel;
+class QProcess;
+namespace Natron {
+class OutputEffectInstance;
+}
+
+/**
+ * Render workers are long-lived background processes (NatronRenderer --worker) that load a project once and then render
+ * the requests sent to them by a coordinator, instead of starting a new process, reloading the project, the plug-ins and the
+ * caches for each frame range.
+ *
+ * The coordinator and the worker talk through the same pipes as a background render launched from the GUI, @see ProcessHandler
+ * and ProcessInputChannel: the coordinator hosts the server passed to the worker with --IPCpipe and the worker creates the
+ * input channel the coordinator writes its requests to. Each message is 1 line:
+ * - kRenderWorkerRequestShort: coordinator -> worker, followed by a request, @see RenderWorkerRequest::toString()
+ * - kAbortRenderingStringShort: coordinator -> worker, aborts the request being rendered
+ * - kRenderWorkerQuitShort: coordinator -> worker, the worker exits once the request being rendered is done
+ * - kFrameRenderedStringShort: worker -> coordinator, followed by the frame, as for any background render
+ * - kRenderWorkerRequestDoneShort: worker -> coordinator, the request was rendered, the worker waits for the next one
+ * - kRenderWorkerRequestFailedShort: worker -> coordinator, followed by the error
+ * - kRenderWorkerRequestSequentialShort: worker -> coordinator, the request was not rendered because it has only some of the
+ *   frames of the render and the Write node must render all of them in order in a single process, e.g: a movie file
+ **/
+
+/**
+ * @brief A render request: the frames to render with a Write node and the parameters to change for this request only.
+ **/
+struct RenderWorkerRequest
+{
+    QString writerName; //< fully specified name of the Write node
+    std::vector<std::pair<int,int> > frameRanges; //< [first,last] ranges, rendered in order
+    bool allFrames; //< true if frameRanges are all the frames of the render, false if it is a chunk of them
+
+    ///"<fully specified node name>.<param name>" or "<fully specified node name>.<param name>.<dimension>" and the value
+    ///to give to the parameter, e.g: "Blur1.size.0" "3" or "Write1.filename" "/renders/shot###.exr"
+    std::list<std::pair<QString,QString> > paramOverrides;
+
+    RenderWorkerRequest()
+    : writerName()
+    , frameRanges()
+    , allFrames(true)
+    , paramOverrides()
+    {
+
+    }
+
+    /**
+     * @brief Returns the message to send to a worker: kRenderWorkerRequestShort followed by the writer name, the frame ranges,
+     * "all" or "chunk" and the overrides, separated by tabulations. Names and values cannot contain tabulations nor new lines.
+     **/
+    QString toString() const;
+
+    /**
+     * @brief Parses a message made by toString(). Returns false and sets error if the message is not a valid request.
+     **/
+    static bool fromString(const QString& message,RenderWorkerRequest* request,QString* error);
+
+    /**
+     * @brief Frame ranges are written "first-last" or "frame" and separated by commas, e.g: "1-10,12,20-25"
+     **/
+    static QString frameRangesToString(const std::vector<std::pair<int,int> >& ranges);
+    static bool frameRangesFromString(const QString& str,std::vector<std::pair<int,int> >* ranges);
+
+    /**
+     * @brief Splits the frames of the given ranges in chunks of at most chunkSize contiguous frames.
+     **/
+    static void splitFrameRanges(const std::vector<std::pair<int,int> >& ranges,int chunkSize,
+                                 std::list<std::pair<int,int> >* chunks);
+};
+
+/**
+ * @brief The worker side: renders the requests read from the input channel of the process until the coordinator asks it
+ * to quit or closes the channel.
+ **/
+class RenderWorker
+{
+public:
+
+    RenderWorker(AppInstance* app,ProcessInputChannel* channel);
+
+    ~RenderWorker();
+
+    /**
+     * @brief Blocking: renders the requests as they come and returns once the worker must exit.
+     **/
+    void exec();
+
+    /**
+     * @brief Called by the input channel when the coordinator aborts the request being rendered.
+     **/
+    void abortCurrentRequest();
+
+private:
+
+    /**
+     * @brief Returns false and sets error if the request could not be rendered. sequential is set to true if it was not
+     * rendered because it is a chunk of the frames of a Write node that must render all of them in order.
+     **/
+    bool render(const RenderWorkerRequest& request,bool* sequential,QString* error);
+
+    AppInstance* _app;
+    ProcessInputChannel* _channel;
+
+    mutable QMutex _currentWriterMutex;
+    Natron::OutputEffectInstance* _currentWriter; //< the writer rendering, protected by _currentWriterMutex
+    bool _aborted; //< protected by _currentWriterMutex
+};
+
+/**
+ * @brief A coordinator running on the local machine: it starts workersCount worker processes on the project and distributes
+ * the frames to render to them in small chunks, giving a new chunk to a worker as soon as it is done with the previous one.
+ * If a worker dies, the chunk it was rendering is given to another one.
+ * Write nodes that must render their frames in order (e.g: movie files) refuse chunks: all the frames are then given to 1 worker.
+ * This is used by NatronRenderer --workers and to test the worker protocol without a farm.
+ **/
+class RenderCoordinator
+{
+public:
+
+    RenderCoordinator(const QString& projectPath,int workersCount);
+
+    virtual ~RenderCoordinator();
+
+    /**
+     * @brief Renders the frames with the given writer on the workers. Blocking, returns false and sets error if a chunk
+     * failed to render or if all workers died.
+     * @param chunkSize The number of frames sent at once to a worker, if <= 0 it is computed so that each worker gets
+     * several chunks.
+     **/
+    bool render(const RenderWorkerRequest& request,int chunkSize,QString* error);
+
+protected:
+
+    /**
+     * @brief Starts the process of a worker, NatronRenderer --worker on the project, which connects its output channel
+     * to the server with the given name. Overridden by the tests to start a fake worker.
+     **/
+    virtual bool startWorkerProcess(QProcess* process,const QString& serverName,QString* error);
+
+private:
+
+    struct Worker;
+
+    bool startWorkers(QString* error);
+
+    void stopWorkers();
+
+    QString _projectPath;
+    int _workersCount;
+    std::vector<Worker*> _workers;
+};
+
+#endif // RENDERWORKER_H
@@ -110,6 +110,17 @@ BezierCP::getPositionAtTime(int time,
     return ret;
 }
 
+///Invalidates the tessellations and positions cached by the Bezier holding the point
+static void
+incrementHolderShapeAge(BezierCPPrivate* imp)
+{
+    boost::shared_ptr<Bezier> holder = imp->holder.lock();
+
+    if (holder) {
+        holder->incrementShapeAge();
+    }
+}
+
 void
 BezierCP::setPositionAtTime(int time,
                             double x,
@@ -129,6 +140,7 @@ BezierCP::setPositionAtTime(int time,
         k.setInterpolation(Natron::eKeyframeTypeLinear);
         _imp->curveY->addKeyFrame(k);
     }
+    incrementHolderShapeAge( _imp.get() );
 }
 
 void
@@ -140,6 +152,7 @@ BezierCP::setStaticPosition(double x,
     QMutexLocker l(&_imp->staticPositionMutex);
     _imp->x = x;
     _imp->y = y;
+    incrementHolderShapeAge( _imp.get() );
 }
 
 void
@@ -151,6 +164,7 @@ BezierCP::setLeftBezierStaticPosition(double x,
     QMutexLocker l(&_imp->staticPositionMutex);
     _imp->leftX = x;
     _imp->leftY = y;
+    incrementHolderShapeAge( _imp.get() );
 }
 
 void
@@ -162,6 +176,7 @@ BezierCP::setRightBezierStaticPosition(double x,
     QMutexLocker l(&_imp->staticPositionMutex);
     _imp->rightX = x;
     _imp->rightY = y;
+    incrementHolderShapeAge( _imp.get() );
 }
 
 bool
@@ -283,6 +298,7 @@ BezierCP::setLeftBezierPointAtTime(int time,
         k.setInterpolation(Natron::eKeyframeTypeLinear);
         _imp->curveLeftBezierY->addKeyFrame(k);
     }
+    incrementHolderShapeAge( _imp.get() );
 }
 
 void
@@ -303,6 +319,7 @@ BezierCP::setRightBezierPointAtTime(int time,
         k.setInterpolation(Natron::eKeyframeTypeLinear);
         _imp->curveRightBezierY->addKeyFrame(k);
     }
+    incrementHolderShapeAge( _imp.get() );
 }
 
 
@@ -324,6 +341,7 @@ BezierCP::removeAnimation(int currentTime)
     _imp->curveRightBezierX->clearKeyFrames();
     _imp->curveLeftBezierY->clearKeyFrames();
     _imp->curveRightBezierY->clearKeyFrames();
+    incrementHolderShapeAge( _imp.get() );
 }
 
 void
@@ -352,6 +370,7 @@ BezierCP::removeKeyframe(int time)
         _imp->curveRightBezierY->removeKeyFrameWithTime(time);
     } catch (...) {
     }
+    incrementHolderShapeAge( _imp.get() );
 }
 
 
@@ -398,6 +417,7 @@ BezierCP::setKeyFrameInterpolation(Natron::KeyframeTypeEnum interp,int index)
     _imp->curveLeftBezierY->setKeyFrameInterpolation(interp, index);
     _imp->curveRightBezierX->setKeyFrameInterpolation(interp, index);
     _imp->curveRightBezierY->setKeyFrameInterpolation(interp, index);
+    incrementHolderShapeAge( _imp.get() );
 }
 
 int
@@ -728,6 +748,7 @@ BezierCP::clone(const BezierCP & other)
         _imp->masterTrack = other._imp->masterTrack;
         _imp->offsetTime = other._imp->offsetTime;
     }
+    incrementHolderShapeAge( _imp.get() );
 }
 
 bool
@@ -769,6 +790,7 @@ BezierCP::slaveTo(SequenceTime offsetTime,
     QWriteLocker l(&_imp->masterMutex);
     _imp->masterTrack = track;
     _imp->offsetTime = offsetTime;
+    incrementHolderShapeAge( _imp.get() );
 }
 
 void
@@ -778,6 +800,7 @@ BezierCP::unslave()
     assert(_imp->masterTrack);
     QWriteLocker l(&_imp->masterMutex);
     _imp->masterTrack.reset();
+    incrementHolderShapeAge( _imp.get() );
 }
 
 boost::shared_ptr<Double_Knob>
@@ -1892,68 +1915,44 @@ bezierPointBboxUpdate(const Point & p0,
     }
 }
 
-// compute a bounding box for the bezier segment
-// algorithm:
-// - compute extrema of the cubic, i.e. values of t for
-// which the derivative of the x or y coordinate of the
-// Bezier is 0. If they are in [0,1] then they take part in
-// bbox computation (there can be up to four extrema, 2 for
-// x and 2 for y). the Bbox is the Bbox of these points and the
-// extremal points (P0,P3)
+// get the control polygon of the Bezier segment from 'first' to 'last' evaluated at 'time',
+// at the scale of the given mipmap level
 static void
-bezierSegmentBboxUpdate(const BezierCP & first,
-                        const BezierCP & last,
-                        int time,
-                        unsigned int mipMapLevel,
-                        RectD* bbox) ///< input/output
+bezierSegmentControlPolygon(const BezierCP & first,
+                            const BezierCP & last,
+                            int time,
+                            unsigned int mipMapLevel,
+                            Point* p) ///< output: 4 points
 {
-    Point p0,p1,p2,p3;
-
-    assert(bbox);
-
     try {
-        first.getPositionAtTime(time, &p0.x, &p0.y);
-        first.getRightBezierPointAtTime(time, &p1.x, &p1.y);
-        last.getPositionAtTime(time, &p3.x, &p3.y);
-        last.getLeftBezierPointAtTime(time, &p2.x, &p2.y);
+        first.getPositionAtTime(time, &p[0].x, &p[0].y);
+        first.getRightBezierPointAtTime(time, &p[1].x, &p[1].y);
+        last.getLeftBezierPointAtTime(time, &p[2].x, &p[2].y);
+        last.getPositionAtTime(time, &p[3].x, &p[3].y);
     } catch (const std::exception & e) {
         assert(false);
     }
 
     if (mipMapLevel > 0) {
         int pot = 1 << mipMapLevel;
-        p0.x /= pot;
-        p0.y /= pot;
-
-        p1.x /= pot;
-        p1.y /= pot;
-
-        p2.x /= pot;
-        p2.y /= pot;
-
-        p3.x /= pot;
-        p3.y /= pot;
+        for (int i = 0; i < 4; ++i) {
+            p[i].x /= pot;
+            p[i].y /= pot;
+        }
     }
-    bezierPointBboxUpdate(p0, p1, p2, p3, bbox);
 }
 
+// append the control polygon of each segment of the list, in drawing order
 static void
-bezierSegmentListBboxUpdate(const BezierCPs & points,
-                            bool finished,
-                            int time,
-                            unsigned int mipMapLevel,
-                            RectD* bbox) ///< input/output
+bezierSegmentListControlPolygon(const BezierCPs & points,
+                                bool finished,
+                                int time,
+                                unsigned int mipMapLevel,
+                                std::vector<Point>* polygon) ///< input/output
 {
     if ( points.empty() ) {
         return;
     }
-    if (points.size() == 1) {
-        // only one point
-        Point p0;
-        points.front()->getPositionAtTime(time, &p0.x, &p0.y);
-        updateRange(p0.x, &bbox->x1, &bbox->x2);
-        updateRange(p0.y, &bbox->y1, &bbox->y2);
-    }
     BezierCPs::const_iterator next = points.begin();
     ++next;
     for (BezierCPs::const_iterator it = points.begin(); it != points.end(); ++it,++next) {
@@ -1963,109 +1962,300 @@ bezierSegmentListBboxUpdate(const BezierCPs & points,
             }
             next = points.begin();
         }
-        bezierSegmentBboxUpdate(*(*it), *(*next), time, mipMapLevel, bbox);
+        Point p[4];
+        bezierSegmentControlPolygon(*(*it), *(*next), time, mipMapLevel, p);
+        polygon->insert(polygon->end(), p, p + 4);
     }
 }
 
-// compute nbPointsperSegment points and update the bbox bounding box for the Bezier
-// segment from 'first' to 'last' evaluated at 'time'
-static void
-bezierSegmentEval(const BezierCP & first,
-                  const BezierCP & last,
-                  int time,
-                  unsigned int mipMapLevel,
-                  int nbPointsPerSegment,
-                  std::list< Point >* points, ///< output
-                  RectD* bbox = NULL) ///< input/output (optional)
+// Returns true if no point of the segment is farther than 'tolerance' from the line joining its end points.
+// This uses the bound: distance <= sqrt( max(ux^2,vx^2) + max(uy^2,vy^2) ) / 4
+// with u = 3*P1 - 2*P0 - P3 and v = 3*P2 - 2*P3 - P0
+static inline bool
+bezierSegmentIsFlat(const Point* p,
+                    double tolerance)
 {
-    Point p0,p1,p2,p3;
+    double ux = 3. * p[1].x - 2. * p[0].x - p[3].x;
+    double uy = 3. * p[1].y - 2. * p[0].y - p[3].y;
+    double vx = 3. * p[2].x - 2. * p[3].x - p[0].x;
+    double vy = 3. * p[2].y - 2. * p[3].y - p[0].y;
 
-    try {
-        first.getPositionAtTime(time, &p0.x, &p0.y);
-        first.getRightBezierPointAtTime(time, &p1.x, &p1.y);
-        last.getPositionAtTime(time, &p3.x, &p3.y);
-        last.getLeftBezierPointAtTime(time, &p2.x, &p2.y);
-    } catch (const std::exception & e) {
-        assert(false);
+    return std::max(ux * ux, vx * vx) + std::max(uy * uy, vy * vy) <= 16. * tolerance * tolerance;
+}
+
+// split the segment at t using the de Casteljau construction
+static inline void
+bezierSegmentSplit(const Point* p,
+                   double t,
+                   Point* left, ///< output: 4 points
+                   Point* right) ///< output: 4 points
+{
+    Point p0p1, p1p2, p2p3, p0p1_p1p2, p1p2_p2p3, dest;
+
+    bezierFullPoint(p[0], p[1], p[2], p[3], t, &p0p1, &p1p2, &p2p3, &p0p1_p1p2, &p1p2_p2p3, &dest);
+    left[0] = p[0];
+    left[1] = p0p1;
+    left[2] = p0p1_p1p2;
+    left[3] = dest;
+    right[0] = dest;
+    right[1] = p1p2_p2p3;
+    right[2] = p2p3;
+    right[3] = p[3];
+}
+
+// append the first point of each flat piece of the segment p and of its feather fp, between the parameters t0 and t1.
+// The segment and its feather are split at the same parameters until both are flat.
+static void
+bezierSegmentFlattenPiece(const Point* p,
+                          const Point* fp,
+                          double t0,
+                          double t1,
+                          int depth,
+                          BezierTessellation* tess) ///< input/output
+{
+    if ( ( depth < ROTO_TESSELLATION_MAX_DEPTH ) &&
+         ( !bezierSegmentIsFlat(p, ROTO_TESSELLATION_TOLERANCE) || !bezierSegmentIsFlat(fp, ROTO_TESSELLATION_TOLERANCE) ) ) {
+        Point left[4], right[4], fLeft[4], fRight[4];
+        bezierSegmentSplit(p, 0.5, left, right);
+        bezierSegmentSplit(fp, 0.5, fLeft, fRight);
+        double tMid = (t0 + t1) / 2.;
+        bezierSegmentFlattenPiece(left, fLeft, t0, tMid, depth + 1, tess);
+        bezierSegmentFlattenPiece(right, fRight, tMid, t1, depth + 1, tess);
+
+        return;
     }
+    tess->points.push_back(p[0]);
+    tess->featherPoints.push_back(fp[0]);
+    tess->params.push_back(t0);
+}
 
-    if (mipMapLevel > 0) {
-        int pot = 1 << mipMapLevel;
-        p0.x /= pot;
-        p0.y /= pot;
+// flatten the segment of the given index and its feather.
+// The pieces at both ends are kept as short as they were when each segment was evaluated at 50 fixed points:
+// the renderer takes the normal of the feather at a point from its 2 neighbours, so a long piece ending
+// at a cusp would tilt the feather along the whole piece.
+static void
+bezierSegmentFlatten(const Point* p,
+                     const Point* fp,
+                     int index,
+                     BezierTessellation* tess) ///< input/output
+{
+    const double endPiece = ROTO_TESSELLATION_END_PIECE;
+    Point first[4], middle[4], last[4], rest[4];
+    Point fFirst[4], fMiddle[4], fLast[4], fRest[4];
 
-        p1.x /= pot;
-        p1.y /= pot;
+    bezierSegmentSplit(p, endPiece, first, rest);
+    bezierSegmentSplit(rest, (1. - 2. * endPiece) / (1. - endPiece), middle, last);
+    bezierSegmentSplit(fp, endPiece, fFirst, fRest);
+    bezierSegmentSplit(fRest, (1. - 2. * endPiece) / (1. - endPiece), fMiddle, fLast);
+    bezierSegmentFlattenPiece(first, fFirst, index, index + endPiece, 0, tess);
+    bezierSegmentFlattenPiece(middle, fMiddle, index + endPiece, index + 1. - endPiece, 0, tess);
+    bezierSegmentFlattenPiece(last, fLast, index + 1. - endPiece, index + 1., 0, tess);
+}
 
-        p2.x /= pot;
-        p2.y /= pot;
+static bool
+pointsEqual(const Point & a,
+            const Point & b)
+{
+    return a.x == b.x && a.y == b.y;
+}
 
-        p3.x /= pot;
-        p3.y /= pot;
-    }
+static void
+mergeBbox(const RectD & src,
+          RectD* dst) ///< input/output
+{
+    updateRange(src.x1, &dst->x1, &dst->x2);
+    updateRange(src.x2, &dst->x1, &dst->x2);
+    updateRange(src.y1, &dst->y1, &dst->y2);
+    updateRange(src.y2, &dst->y1, &dst->y2);
+}
 
-    double incr = 1. / (double)(nbPointsPerSegment - 1);
-    Point cur;
-    for (double t = 0.; t <= 1.; t += incr) {
-        bezierPoint(p0, p1, p2, p3, t, &cur);
-        points->push_back(cur);
+static bool
+bezierHasTrackedPoints(const BezierPrivate & imp)
+{
+    for (BezierCPs::const_iterator it = imp.points.begin(); it != imp.points.end(); ++it) {
+        if ( (*it)->isSlaved() ) {
+            return true;
+        }
     }
-    if (bbox) {
-        bezierPointBboxUpdate(p0,  p1,  p2,  p3, bbox);
+    for (BezierCPs::const_iterator it = imp.featherPoints.begin(); it != imp.featherPoints.end(); ++it) {
+        if ( (*it)->isSlaved() ) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// append the position of each point of the list, the bbox is updated with the points and their tangents
+static void
+bezierPointListPositions(const BezierCPs & points,
+                         int time,
+                         std::vector<Point>* positions, ///< input/output
+                         RectD* bbox) ///< input/output
+{
+    for (BezierCPs::const_iterator it = points.begin(); it != points.end(); ++it) {
+        Point p, left, right;
+        (*it)->getPositionAtTime(time, &p.x, &p.y);
+        (*it)->getLeftBezierPointAtTime(time, &left.x, &left.y);
+        (*it)->getRightBezierPointAtTime(time, &right.x, &right.y);
+        positions->push_back(p);
+        updateRange(p.x, &bbox->x1, &bbox->x2);
+        updateRange(p.y, &bbox->y1, &bbox->y2);
+        updateRange(left.x, &bbox->x1, &bbox->x2);
+        updateRange(left.y, &bbox->y1, &bbox->y2);
+        updateRange(right.x, &bbox->x1, &bbox->x2);
+        updateRange(right.y, &bbox->y1, &bbox->y2);
     }
 }
 
 /**
- * @brief Determines if the point (x,y) lies on the bezier curve segment defined by first and last.
- * @returns True if the point is close (according to the acceptance) to the curve, false otherwise.
- * @param param[out] It is set to the parametric value at which the subdivision of the bezier segment
- * yields the closest point to (x,y) on the curve.
+ * @brief Returns the positions of the points of the Bezier at the given time, from the cache of the Bezier if the shape
+ * did not change. Must be called with the item mutex locked.
  **/
-static bool
-bezierSegmentMeetsPoint(const BezierCP & first,
-                        const BezierCP & last,
-                        int time,
-                        double x,
-                        double y,
-                        double distance,
-                        double *param) ///< output
+static BezierPointsAtTimePtr
+getBezierPointsAtTime(BezierPrivate* imp,
+                      int time)
 {
-    Point p0,p1,p2,p3;
+    int shapeAge = imp->shapeAge.fetchAndAddOrdered(0);
+
+    for (std::list<BezierPointsAtTimePtr>::iterator it = imp->pointsAtTime.begin(); it != imp->pointsAtTime.end(); ++it) {
+        if ( (*it)->time != time ) {
+            continue;
+        }
+        BezierPointsAtTimePtr positions = *it;
+        imp->pointsAtTime.erase(it);
+        if ( !positions->tracked && (positions->shapeAge == shapeAge) ) {
+            imp->pointsAtTime.push_front(positions);
 
-    first.getPositionAtTime(time, &p0.x, &p0.y);
-    first.getRightBezierPointAtTime(time, &p1.x, &p1.y);
-    last.getPositionAtTime(time, &p3.x, &p3.y);
-    last.getLeftBezierPointAtTime(time, &p2.x, &p2.y);
+            return positions;
+        }
+        break;
+    }
 
-    ///Use the control polygon to approximate segment length
-    double length = ( std::sqrt( (p1.x - p0.x) * (p1.x - p0.x) + (p1.y - p0.y) * (p1.y - p0.y) ) +
-                      std::sqrt( (p2.x - p1.x) * (p2.x - p1.x) + (p2.y - p1.y) * (p2.y - p1.y) ) +
-                      std::sqrt( (p3.x - p2.x) * (p3.x - p2.x) + (p3.y - p2.y) * (p3.y - p2.y) ) );
-    // increment is the distance divided by the  segment length
-    double incr = length == 0. ? 1. : distance / length;
+    BezierPointsAtTimePtr positions(new BezierPointsAtTime);
+    positions->time = time;
+    positions->shapeAge = shapeAge;
+    positions->tracked = bezierHasTrackedPoints(*imp);
+    positions->bbox.x1 = std::numeric_limits<double>::infinity();
+    positions->bbox.x2 = -std::numeric_limits<double>::infinity();
+    positions->bbox.y1 = std::numeric_limits<double>::infinity();
+    positions->bbox.y2 = -std::numeric_limits<double>::infinity();
+    positions->points.reserve( imp->points.size() );
+    positions->featherPoints.reserve( imp->featherPoints.size() );
+    bezierPointListPositions(imp->points, time, &positions->points, &positions->bbox);
+    bezierPointListPositions(imp->featherPoints, time, &positions->featherPoints, &positions->bbox);
 
-    ///the minimum square distance between a decasteljau point an the given (x,y) point
-    ///we save a sqrt call
-    double sqDistance = distance * distance;
-    double minSqDistance = std::numeric_limits<double>::infinity();
-    double tForMin = -1.;
-    for (double t = 0.; t <= 1.; t += incr) {
-        Point p;
-        bezierPoint(p0, p1, p2, p3, t, &p);
-        double sqdist = (p.x - x) * (p.x - x) + (p.y - y) * (p.y - y);
-        if ( (sqdist <= sqDistance) && (sqdist < minSqDistance) ) {
-            minSqDistance = sqdist;
-            tForMin = t;
+    imp->pointsAtTime.push_front(positions);
+    if (imp->pointsAtTime.size() > ROTO_TESSELLATION_CACHE_SIZE) {
+        imp->pointsAtTime.pop_back();
+    }
+
+    return positions;
+}
+
+/**
+ * @brief Returns the tessellation of the Bezier and of its feather at the given time and mipmap level.
+ * It is taken from the tessellations cached by the Bezier if the shape is unchanged, so that the renderer,
+ * the RoD computation and the interacts do not subdivide the same shape again.
+ * Must be called with the item mutex locked.
+ **/
+static BezierTessellationPtr
+getBezierTessellation(BezierPrivate* imp,
+                      int time,
+                      unsigned int mipMapLevel)
+{
+    ///Read the age before looking at the points, so that a concurrent edit makes the result outdated
+    int shapeAge = imp->shapeAge.fetchAndAddOrdered(0);
+    BezierTessellationPtr cached;
+
+    for (std::list<BezierTessellationPtr>::iterator it = imp->tessellations.begin(); it != imp->tessellations.end(); ++it) {
+        if ( ( (*it)->time == time ) && ( (*it)->mipMapLevel == mipMapLevel ) ) {
+            cached = *it;
+            imp->tessellations.erase(it);
+            break;
         }
     }
+    if ( cached && !cached->tracked && (cached->shapeAge == shapeAge) ) {
+        imp->tessellations.push_front(cached);
 
-    if (minSqDistance <= sqDistance) {
-        *param = tForMin;
+        return cached;
+    }
 
-        return true;
+    std::vector<Point> controlPolygon;
+    bezierSegmentListControlPolygon(imp->points, imp->finished, time, mipMapLevel, &controlPolygon);
+    bezierSegmentListControlPolygon(imp->featherPoints, imp->finished, time, mipMapLevel, &controlPolygon);
+
+    ///The points may have changed at other times, or moved with their track back to the same place
+    if ( cached && ( cached->controlPolygon.size() == controlPolygon.size() ) &&
+         std::equal(controlPolygon.begin(), controlPolygon.end(), cached->controlPolygon.begin(), pointsEqual) ) {
+        cached->shapeAge = shapeAge;
+        imp->tessellations.push_front(cached);
+
+        return cached;
     }
 
-    return false;
+    BezierTessellationPtr tess(new BezierTessellation);
+    tess->time = time;
+    tess->mipMapLevel = mipMapLevel;
+    tess->shapeAge = shapeAge;
+    tess->tracked = bezierHasTrackedPoints(*imp);
+    tess->bbox.x1 = std::numeric_limits<double>::infinity();
+    tess->bbox.x2 = -std::numeric_limits<double>::infinity();
+    tess->bbox.y1 = std::numeric_limits<double>::infinity();
+    tess->bbox.y2 = -std::numeric_limits<double>::infinity();
+    tess->featherBBox = tess->bbox;
+
+    std::size_t nbSegments = controlPolygon.size() / 8;
+    for (std::size_t i = 0; i < nbSegments; ++i) {
+        const Point* p = &controlPolygon[4 * i];
+        const Point* fp = &controlPolygon[4 * (nbSegments + i)];
+        bezierSegmentFlatten(p, fp, (int)i, tess.get());
+        bezierPointBboxUpdate(p[0], p[1], p[2], p[3], &tess->bbox);
+        bezierPointBboxUpdate(fp[0], fp[1], fp[2], fp[3], &tess->featherBBox);
+    }
+    if (nbSegments > 0) {
+        ///close the polygons with the end of the last segment
+        tess->points.push_back(controlPolygon[4 * nbSegments - 1]);
+        tess->featherPoints.push_back(controlPolygon[8 * nbSegments - 1]);
+        tess->params.push_back( (double)nbSegments );
+    } else if ( !imp->points.empty() ) {
+        ///only one point and the curve is not finished: there is no segment but the point is in the bbox
+        Point cp[4], fp[4];
+        bezierSegmentControlPolygon(*imp->points.front(), *imp->points.front(), time, mipMapLevel, cp);
+        bezierSegmentControlPolygon(*imp->featherPoints.front(), *imp->featherPoints.front(), time, mipMapLevel, fp);
+        updateRange(cp[0].x, &tess->bbox.x1, &tess->bbox.x2);
+        updateRange(cp[0].y, &tess->bbox.y1, &tess->bbox.y2);
+        updateRange(fp[0].x, &tess->featherBBox.x1, &tess->featherBBox.x2);
+        updateRange(fp[0].y, &tess->featherBBox.y1, &tess->featherBBox.y2);
+    }
+    tess->controlPolygon.swap(controlPolygon);
+
+    imp->tessellations.push_front(tess);
+    if (imp->tessellations.size() > ROTO_TESSELLATION_CACHE_SIZE) {
+        imp->tessellations.pop_back();
+    }
+
+    return tess;
+} // getBezierTessellation
+
+// squared distance from (x,y) to the segment [a,b], u is set to the position of the nearest point in [0,1]
+static inline double
+squaredDistanceToSegment(double x,
+                         double y,
+                         const Point & a,
+                         const Point & b,
+                         double *u) ///< output
+{
+    double dx = b.x - a.x;
+    double dy = b.y - a.y;
+    double sqLength = dx * dx + dy * dy;
+
+    *u = sqLength == 0. ? 0. : ( (x - a.x) * dx + (y - a.y) * dy ) / sqLength;
+    *u = std::max( 0., std::min(1., *u) );
+    double px = a.x + *u * dx - x;
+    double py = a.y + *u * dy - y;
+
+    return px * px + py * py;
 }
 
 static bool
@@ -2085,38 +2275,6 @@ isPointCloseTo(int time,
     return false;
 }
 
-static bool
-bezierSegmenEqual(int time,
-                  const BezierCP & p0,
-                  const BezierCP & p1,
-                  const BezierCP & s0,
-                  const BezierCP & s1)
-{
-    double prevX,prevY,prevXF,prevYF;
-    double nextX,nextY,nextXF,nextYF;
-
-    p0.getPositionAtTime(time, &prevX, &prevY);
-    p1.getPositionAtTime(time, &nextX, &nextY);
-    s0.getPositionAtTime(time, &prevXF, &prevYF);
-    s1.getPositionAtTime(time, &nextXF, &nextYF);
-    if ( (prevX != prevXF) || (prevY != prevYF) || (nextX != nextXF) || (nextY != nextYF) ) {
-        return true;
-    } else {
-        ///check derivatives
-        double prevRightX,prevRightY,nextLeftX,nextLeftY;
-        double prevRightXF,prevRightYF,nextLeftXF,nextLeftYF;
-        p0.getRightBezierPointAtTime(time, &prevRightX, &prevRightY);
-        p1.getLeftBezierPointAtTime(time, &nextLeftX, &nextLeftY);
-        s0.getRightBezierPointAtTime(time,&prevRightXF, &prevRightYF);
-        s1.getLeftBezierPointAtTime(time, &nextLeftXF, &nextLeftYF);
-        if ( (prevRightX != prevRightXF) || (prevRightY != prevRightYF) || (nextLeftX != nextLeftXF) || (nextLeftY != nextLeftYF) ) {
-            return true;
-        } else {
-            return false;
-        }
-    }
-}
-
 Bezier::Bezier(const boost::shared_ptr<RotoContext>& ctx,
                const std::string & name,
                const boost::shared_ptr<RotoLayer>& parent)
@@ -2164,6 +2322,7 @@ Bezier::clone(const RotoItem* other)
         }
         _imp->finished = otherBezier->_imp->finished;
     }
+    incrementShapeAge();
     RotoDrawableItem::clone(other);
     Q_EMIT cloned();
 }
@@ -2242,6 +2401,7 @@ Bezier::addControlPoint(double x,
         }
         _imp->featherPoints.insert(_imp->featherPoints.end(),fp);
     }
+    incrementShapeAge();
     Q_EMIT controlPointAdded();
     return p;
 }
@@ -2382,6 +2542,7 @@ Bezier::addControlPointAfterIndex(int index,
             setKeyframe(currentTime);
         }
     }
+    incrementShapeAge();
     Q_EMIT controlPointAdded();
     return p;
 } // addControlPointAfterIndex
@@ -2428,41 +2589,38 @@ Bezier::isPointOnCurve(double x,
         return -1;
     }
 
-    ///For each segment find out if the point lies on the bezier
-    int index = 0;
+    ///Most shapes are far from the point: reject them with the bounding box of their points before looking at the curve
+    BezierPointsAtTimePtr positions = getBezierPointsAtTime(_imp.get(), time);
+    if ( ( x < positions->bbox.x1 - distance ) || ( x > positions->bbox.x2 + distance ) ||
+         ( y < positions->bbox.y1 - distance ) || ( y > positions->bbox.y2 + distance ) ) {
+        return -1;
+    }
 
+    ///Find the nearest edge of the tessellation of the curve or of its feather
     assert( _imp->featherPoints.size() == _imp->points.size() );
 
-    BezierCPs::const_iterator fp = _imp->featherPoints.begin();
-    for (BezierCPs::const_iterator it = _imp->points.begin(); it != _imp->points.end(); ++it, ++index,++fp) {
-        BezierCPs::const_iterator next = it;
-        BezierCPs::const_iterator nextFp = fp;
-        ++nextFp;
-        ++next;
-        if ( next == _imp->points.end() ) {
-            if (!_imp->finished) {
-                return -1;
-            } else {
-                next = _imp->points.begin();
-                nextFp = _imp->featherPoints.begin();
-            }
-        }
-        if ( bezierSegmentMeetsPoint(*(*it), *(*next), time, x, y, distance, t) ) {
-            *feather = false;
-
-            return index;
+    BezierTessellationPtr tess = getBezierTessellation(_imp.get(), time, 0);
+    double sqDistance = distance * distance;
+    double minSqDistance = std::numeric_limits<double>::infinity();
+    int index = -1;
+    for (std::size_t i = 0; i + 1 < tess->points.size(); ++i) {
+        double u, featherU;
+        double sqDist = squaredDistanceToSegment(x, y, tess->points[i], tess->points[i + 1], &u);
+        double featherSqDist = squaredDistanceToSegment(x, y, tess->featherPoints[i], tess->featherPoints[i + 1], &featherU);
+        bool isFeather = featherSqDist < sqDist;
+        if (isFeather) {
+            sqDist = featherSqDist;
+            u = featherU;
         }
-        if ( bezierSegmentMeetsPoint(**fp, **nextFp, time, x, y, distance, t) ) {
-            *feather = true;
-
-            return index;
+        if ( (sqDist <= sqDistance) && (sqDist < minSqDistance) ) {
+            minSqDistance = sqDist;
+            index = (int)tess->params[i];
+            *t = tess->params[i] + u * (tess->params[i + 1] - tess->params[i]) - index;
+            *feather = isFeather;
         }
     }
 
-    ///now check the feather points segments only if they are different from the base bezier
-
-
-    return -1;
+    return index;
 } // isPointOnCurve
 
 void
@@ -2472,6 +2630,7 @@ Bezier::setCurveFinished(bool finished)
     assert( QThread::currentThread() == qApp->thread() );
     QMutexLocker l(&itemMutex);
     _imp->finished = finished;
+    incrementShapeAge();
 }
 
 bool
@@ -2508,6 +2667,7 @@ Bezier::removeControlPointByIndex(int index)
         std::advance(itF, index);
         _imp->featherPoints.erase(itF);
     }
+    incrementShapeAge();
     Q_EMIT controlPointRemoved();
 }
 
@@ -3259,68 +3419,48 @@ Bezier::getKeyframesCount() const
 void
 Bezier::evaluateAtTime_DeCasteljau(int time,
                                    unsigned int mipMapLevel,
-                                   int nbPointsPerSegment,
                                    std::list< Natron::Point >* points,
                                    RectD* bbox) const
 {
-    QMutexLocker l(&itemMutex);
-    BezierCPs::const_iterator next = _imp->points.begin();
+    BezierTessellationPtr tess;
+    {
+        QMutexLocker l(&itemMutex);
 
-    if ( _imp->points.empty() ) {
-        return;
-    }
-    ++next;
-    for (BezierCPs::const_iterator it = _imp->points.begin(); it != _imp->points.end(); ++it,++next) {
-        if ( next == _imp->points.end() ) {
-            if (!_imp->finished) {
-                break;
-            }
-            next = _imp->points.begin();
+        if ( _imp->points.empty() ) {
+            return;
         }
-        bezierSegmentEval(*(*it),*(*next), time,mipMapLevel, nbPointsPerSegment, points,bbox);
+        tess = getBezierTessellation(_imp.get(), time, mipMapLevel);
+    }
+    points->insert( points->end(), tess->points.begin(), tess->points.end() );
+    if ( bbox && !tess->points.empty() ) {
+        mergeBbox(tess->bbox, bbox);
     }
 }
 
 void
 Bezier::evaluateFeatherPointsAtTime_DeCasteljau(int time,
                                                 unsigned int mipMapLevel,
-                                                int nbPointsPerSegment,
-                                                bool evaluateIfEqual, ///< evaluate only if feather points are different from control points
                                                 std::list< Natron::Point >* points, ///< output
                                                 RectD* bbox) const ///< output
 {
-    QMutexLocker l(&itemMutex);
+    BezierTessellationPtr tess;
+    {
+        QMutexLocker l(&itemMutex);
 
-    if ( _imp->points.empty() ) {
-        return;
-    }
-    BezierCPs::const_iterator itCp = _imp->points.begin();
-    BezierCPs::const_iterator next = _imp->featherPoints.begin();
-    ++next;
-    BezierCPs::const_iterator nextCp = itCp;
-    ++nextCp;
-    for (BezierCPs::const_iterator it = _imp->featherPoints.begin(); it != _imp->featherPoints.end(); ++it,++itCp,++next,++nextCp) {
-        if ( next == _imp->featherPoints.end() ) {
-            next = _imp->featherPoints.begin();
-        }
-        if ( nextCp == _imp->points.end() ) {
-            if (!_imp->finished) {
-                break;
-            }
-            nextCp = _imp->points.begin();
-        }
-        if ( !evaluateIfEqual && bezierSegmenEqual(time, **itCp, **nextCp, **it, **next) ) {
-            continue;
+        if ( _imp->points.empty() ) {
+            return;
         }
-
-        bezierSegmentEval(*(*it),*(*next), time, mipMapLevel, nbPointsPerSegment, points, bbox);
+        tess = getBezierTessellation(_imp.get(), time, mipMapLevel);
+    }
+    points->insert( points->end(), tess->featherPoints.begin(), tess->featherPoints.end() );
+    if ( bbox && !tess->featherPoints.empty() ) {
+        mergeBbox(tess->featherBBox, bbox);
     }
 }
 
 RectD
 Bezier::getBoundingBox(int time) const
 {
-    std::list<Point> pts;
     RectD bbox; // a very empty bbox
 
     bbox.x1 = std::numeric_limits<double>::infinity();
@@ -3329,10 +3469,13 @@ Bezier::getBoundingBox(int time) const
     bbox.y2 = -std::numeric_limits<double>::infinity();
 
     QMutexLocker l(&itemMutex);
-    bezierSegmentListBboxUpdate(_imp->points, _imp->finished, time, 0, &bbox);
+    if ( !_imp->points.empty() ) {
+        BezierTessellationPtr tess = getBezierTessellation(_imp.get(), time, 0);
+        mergeBbox(tess->bbox, &bbox);
 #pragma message WARN("TODO: use featherPointsAtDistance")
-    // BUG https://github.com/MrKepzie/Natron/issues/145 : the feather Bezier must be moved by featherdistance before RoD computation!
-    bezierSegmentListBboxUpdate(_imp->featherPoints, _imp->finished, time, 0, &bbox);
+        // BUG https://github.com/MrKepzie/Natron/issues/145 : the feather Bezier must be moved by featherdistance before RoD computation!
+        mergeBbox(tess->featherBBox, &bbox);
+    }
     
     
     // EDIT: Partial fix, just pad the BBOX by the feather distance. This might not be accurate but gives at least something
@@ -3345,6 +3488,20 @@ Bezier::getBoundingBox(int time) const
     return bbox;
 }
 
+RectD
+Bezier::getControlPointsBoundingBox(int time) const
+{
+    QMutexLocker l(&itemMutex);
+
+    return getBezierPointsAtTime(_imp.get(), time)->bbox;
+}
+
+void
+Bezier::incrementShapeAge()
+{
+    _imp->shapeAge.ref();
+}
+
 const std::list< boost::shared_ptr<BezierCP> > &
 Bezier::getControlPoints() const
 {
@@ -3391,10 +3548,18 @@ Bezier::isNearbyControlPoint(double x,
     int time = getContext()->getTimelineCurrentTime();
     QMutexLocker l(&itemMutex);
     boost::shared_ptr<BezierCP> cp,fp;
+    BezierPointsAtTimePtr positions = getBezierPointsAtTime(_imp.get(), time);
+
+    if ( ( x < positions->bbox.x1 - acceptance ) || ( x > positions->bbox.x2 + acceptance ) ||
+         ( y < positions->bbox.y1 - acceptance ) || ( y > positions->bbox.y2 + acceptance ) ) {
+        *index = -1;
+
+        return std::make_pair(cp,fp);
+    }
 
     switch (pref) {
     case eControlPointSelectionPrefFeatherFirst: {
-        BezierCPs::const_iterator itF = _imp->findFeatherPointNearby(x, y, acceptance, time, index);
+        BezierCPs::const_iterator itF = _imp->findFeatherPointNearby(x, y, acceptance, *positions, index);
         if ( itF != _imp->featherPoints.end() ) {
             fp = *itF;
             BezierCPs::const_iterator it = _imp->points.begin();
@@ -3403,7 +3568,7 @@ Bezier::isNearbyControlPoint(double x,
 
             return std::make_pair(fp, cp);
         } else {
-            BezierCPs::const_iterator it = _imp->findControlPointNearby(x, y, acceptance, time, index);
+            BezierCPs::const_iterator it = _imp->findControlPointNearby(x, y, acceptance, *positions, index);
             if ( it != _imp->points.end() ) {
                 cp = *it;
                 itF = _imp->featherPoints.begin();
@@ -3418,7 +3583,7 @@ Bezier::isNearbyControlPoint(double x,
     case eControlPointSelectionPrefControlPointFirst:
     case eControlPointSelectionPrefWhateverFirst:
     default: {
-        BezierCPs::const_iterator it = _imp->findControlPointNearby(x, y, acceptance, time, index);
+        BezierCPs::const_iterator it = _imp->findControlPointNearby(x, y, acceptance, *positions, index);
         if ( it != _imp->points.end() ) {
             cp = *it;
             BezierCPs::const_iterator itF = _imp->featherPoints.begin();
@@ -3427,7 +3592,7 @@ Bezier::isNearbyControlPoint(double x,
 
             return std::make_pair(cp, fp);
         } else {
-            BezierCPs::const_iterator itF = _imp->findFeatherPointNearby(x, y, acceptance, time, index);
+            BezierCPs::const_iterator itF = _imp->findFeatherPointNearby(x, y, acceptance, *positions, index);
             if ( itF != _imp->featherPoints.end() ) {
                 fp = *itF;
                 it = _imp->points.begin();
@@ -3529,11 +3694,16 @@ Bezier::controlPointsWithinRect(double l,
     assert( QThread::currentThread() == qApp->thread() );
     QMutexLocker locker(&itemMutex);
     int time = getContext()->getTimelineCurrentTime();
+    BezierPointsAtTimePtr positions = getBezierPointsAtTime(_imp.get(), time);
+    if ( ( positions->bbox.x2 < l - acceptance ) || ( positions->bbox.x1 > r + acceptance ) ||
+         ( positions->bbox.y2 < b - acceptance ) || ( positions->bbox.y1 > t - acceptance ) ) {
+        return ret;
+    }
     int i = 0;
     if ( (mode == 0) || (mode == 1) ) {
         for (BezierCPs::const_iterator it = _imp->points.begin(); it != _imp->points.end(); ++it,++i) {
-            double x,y;
-            (*it)->getPositionAtTime(time, &x, &y);
+            double x = positions->points[i].x;
+            double y = positions->points[i].y;
             if ( ( x >= (l - acceptance) ) && ( x <= (r + acceptance) ) && ( y >= (b - acceptance) ) && ( y <= (t - acceptance) ) ) {
                 std::pair<boost::shared_ptr<BezierCP>,boost::shared_ptr<BezierCP> > p;
                 p.first = *it;
@@ -3547,8 +3717,8 @@ Bezier::controlPointsWithinRect(double l,
     i = 0;
     if ( (mode == 0) || (mode == 2) ) {
         for (BezierCPs::const_iterator it = _imp->featherPoints.begin(); it != _imp->featherPoints.end(); ++it,++i) {
-            double x,y;
-            (*it)->getPositionAtTime(time, &x, &y);
+            double x = positions->featherPoints[i].x;
+            double y = positions->featherPoints[i].y;
             if ( ( x >= (l - acceptance) ) && ( x <= (r + acceptance) ) && ( y >= (b - acceptance) ) && ( y <= (t - acceptance) ) ) {
                 std::pair<boost::shared_ptr<BezierCP>,boost::shared_ptr<BezierCP> > p;
                 p.first = *it;
@@ -3739,6 +3909,7 @@ Bezier::load(const RotoItemSerialization & obj)
             _imp->featherPoints.push_back(fp);
         }
     }
+    incrementShapeAge();
     RotoDrawableItem::load(obj);
 }
 
@@ -4708,6 +4879,8 @@ RotoContext::selectInternal(const boost::shared_ptr<RotoItem> & item)
                     
                     QObject::connect((*it)->getSignalSlotHandler().get(), SIGNAL(keyFrameSet(SequenceTime,int,int,bool)),
                                      this, SLOT(onSelectedKnobCurveChanged()));
+                    QObject::connect((*it)->getSignalSlotHandler().get(), SIGNAL(multipleKeyFramesSet(std::list<SequenceTime>,int,int)),
+                                     this, SLOT(onSelectedKnobCurveChanged()));
                     QObject::connect((*it)->getSignalSlotHandler().get(), SIGNAL(keyFrameRemoved(SequenceTime,int,int)),
                                      this, SLOT(onSelectedKnobCurveChanged()));
                     QObject::connect((*it)->getSignalSlotHandler().get(), SIGNAL(keyFrameMoved(int,int,int)),
@@ -4813,6 +4986,8 @@ RotoContext::deselectInternal(boost::shared_ptr<RotoItem> b)
                     
                     QObject::disconnect((*it)->getSignalSlotHandler().get(), SIGNAL(keyFrameSet(SequenceTime,int,int,bool)),
                                      this, SLOT(onSelectedKnobCurveChanged()));
+                    QObject::disconnect((*it)->getSignalSlotHandler().get(), SIGNAL(multipleKeyFramesSet(std::list<SequenceTime>,int,int)),
+                                     this, SLOT(onSelectedKnobCurveChanged()));
                     QObject::disconnect((*it)->getSignalSlotHandler().get(), SIGNAL(keyFrameRemoved(SequenceTime,int,int)),
                                      this, SLOT(onSelectedKnobCurveChanged()));
                     QObject::disconnect((*it)->getSignalSlotHandler().get(), SIGNAL(keyFrameMoved(int,int,int)),
@@ -5322,18 +5497,18 @@ template <typename PIX,int maxValue>
 static void
 convertCairoImageToNatronImage(cairo_surface_t* cairoImg,
                                Natron::Image* image,
-                               const RectI & pixelRod)
+                               const RectI & window)
 {
     unsigned char* cdata = cairo_image_surface_get_data(cairoImg);
     unsigned char* srcPix = cdata;
     int stride = cairo_image_surface_get_stride(cairoImg);
     int comps = (int)image->getComponentsCount();
 
-    for (int y = 0; y < pixelRod.height(); ++y, srcPix += stride) {
-        PIX* dstPix = (PIX*)image->pixelAt(pixelRod.x1, pixelRod.y1 + y);
+    for (int y = 0; y < window.height(); ++y, srcPix += stride) {
+        PIX* dstPix = (PIX*)image->pixelAt(window.x1, window.y1 + y);
         assert(dstPix);
 
-        for (int x = 0; x < pixelRod.width(); ++x) {
+        for (int x = 0; x < window.width(); ++x) {
             if (comps == 1) {
                 dstPix[x] = PIX( (float)srcPix[x] / 255.f ) * maxValue;;
             } else {
@@ -5349,6 +5524,49 @@ convertCairoImageToNatronImage(cairo_surface_t* cairoImg,
     }
 }
 
+/**
+ * @brief Returns true if rendering the shape may change pixels of the window, in pixel coordinates at the mipmap level.
+ * Cairo operators which are not bounded by the mask (e.g. IN) clear the destination outside of the shape:
+ * shapes using them are always rendered.
+ **/
+static bool
+bezierAffectsRenderWindow(const Bezier & bezier,
+                          int time,
+                          unsigned int mipmapLevel,
+                          const RectI & window)
+{
+    switch ( (cairo_operator_t)bezier.getCompositingOperator() ) {
+    case CAIRO_OPERATOR_IN:
+    case CAIRO_OPERATOR_OUT:
+    case CAIRO_OPERATOR_DEST_IN:
+    case CAIRO_OPERATOR_DEST_ATOP:
+
+        return true;
+    default:
+        break;
+    }
+#ifdef NATRON_ROTO_INVERTIBLE
+    if ( bezier.getInverted(time) ) {
+        return true;
+    }
+#endif
+
+    RectD bbox = bezier.getControlPointsBoundingBox(time);
+    ///The feather extends beyond the curve by the feather distance
+    double featherDistance = std::abs( bezier.getFeatherDistance(time) );
+    bbox.x1 -= featherDistance;
+    bbox.x2 += featherDistance;
+    bbox.y1 -= featherDistance;
+    bbox.y2 += featherDistance;
+    if ( bbox.isNull() ) {
+        return false;
+    }
+    RectI pixelBbox;
+    bbox.toPixelEnclosing(mipmapLevel, 1., &pixelBbox);
+
+    return pixelBbox.intersects(window);
+}
+
 boost::shared_ptr<Natron::Image>
 RotoContext::renderMask(bool useCache,
                         const RectI & roi,
@@ -5448,6 +5666,15 @@ RotoContext::renderMask(bool useCache,
     RectI clippedRoI;
     roi.intersect(pixelRod, &clippedRoI);
 
+    ///Only the render window is drawn and converted, so the shapes which do not overlap it can be skipped
+    for (std::list< boost::shared_ptr<Bezier> >::iterator it = splines.begin(); it != splines.end();) {
+        if ( !bezierAffectsRenderWindow(**it, time, mipmapLevel, clippedRoI) ) {
+            it = splines.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
     cairo_format_t cairoImgFormat;
     switch (components) {
     case Natron::eImageComponentAlpha:
@@ -5465,8 +5692,8 @@ RotoContext::renderMask(bool useCache,
     }
 
     ////Allocate the cairo temporary buffer
-    cairo_surface_t* cairoImg = cairo_image_surface_create( cairoImgFormat, pixelRod.width(), pixelRod.height() );
-    cairo_surface_set_device_offset(cairoImg, -pixelRod.x1, -pixelRod.y1);
+    cairo_surface_t* cairoImg = cairo_image_surface_create( cairoImgFormat, clippedRoI.width(), clippedRoI.height() );
+    cairo_surface_set_device_offset(cairoImg, -clippedRoI.x1, -clippedRoI.y1);
     if (cairo_surface_status(cairoImg) != CAIRO_STATUS_SUCCESS) {
         appPTR->removeFromNodeCache(image);
 
@@ -5481,13 +5708,13 @@ RotoContext::renderMask(bool useCache,
 
     switch (depth) {
     case Natron::eImageBitDepthFloat:
-        convertCairoImageToNatronImage<float, 1>(cairoImg, image.get(), pixelRod);
+        convertCairoImageToNatronImage<float, 1>(cairoImg, image.get(), clippedRoI);
         break;
     case Natron::eImageBitDepthByte:
-        convertCairoImageToNatronImage<unsigned char, 255>(cairoImg, image.get(), pixelRod);
+        convertCairoImageToNatronImage<unsigned char, 255>(cairoImg, image.get(), clippedRoI);
         break;
     case Natron::eImageBitDepthShort:
-        convertCairoImageToNatronImage<unsigned short, 65535>(cairoImg, image.get(), pixelRod);
+        convertCairoImageToNatronImage<unsigned short, 65535>(cairoImg, image.get(), clippedRoI);
         break;
     case Natron::eImageBitDepthNone:
         assert(false);
@@ -5590,8 +5817,8 @@ RotoContextPrivate::renderInternal(cairo_t* cr,
                                -std::numeric_limits<double>::infinity(),
                                -std::numeric_limits<double>::infinity() );
 
-        (*it2)->evaluateFeatherPointsAtTime_DeCasteljau(time, mipmapLevel, 50, true, &featherPolygon, &featherPolyBBox);
-        (*it2)->evaluateAtTime_DeCasteljau(time, mipmapLevel, 50, &bezierPolygon, NULL);
+        (*it2)->evaluateFeatherPointsAtTime_DeCasteljau(time, mipmapLevel, &featherPolygon, &featherPolyBBox);
+        (*it2)->evaluateAtTime_DeCasteljau(time, mipmapLevel, &bezierPolygon, NULL);
 
 
         assert( !featherPolygon.empty() );
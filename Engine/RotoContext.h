@@ -703,31 +703,42 @@ public:
 
     /**
      * @brief Evaluates the spline at the given time and returns the list of all the points on the curve.
-     * @param nbPointsPerSegment controls how many points are used to draw one Bezier segment
+     * The curve is subdivided until the polygon is within ROTO_TESSELLATION_TOLERANCE pixel of it at the given mipmap level:
+     * flat segments give few points and tight curves give many. The result is cached by the Bezier until its shape changes.
      **/
     void evaluateAtTime_DeCasteljau(int time,
                                     unsigned int mipMapLevel,
-                                    int nbPointsPerSegment,
                                     std::list<Natron::Point>* points,
                                     RectD* bbox) const;
 
     /**
-     * @brief Evaluates the bezier formed by the feather points. Segments which are equal to the control points of the bezier
-     * will not be drawn.
+     * @brief Evaluates the bezier formed by the feather points. The feather is subdivided at the same parameters as the curve
+     * so that both lists of points have the same size and the points match one to one.
      **/
     void evaluateFeatherPointsAtTime_DeCasteljau(int time,
                                                  unsigned int mipMapLevel,
-                                                 int nbPointsPerSegment,
-                                                 bool evaluateIfEqual,
                                                  std::list<Natron::Point >* points,
                                                  RectD* bbox) const;
 
     /**
-     * @brief Returns the bounding box of the bezier. The last value computed by evaluateAtTime_DeCasteljau will be returned,
-     * otherwise if it has never been called, evaluateAtTime_DeCasteljau will be called to compute the bounding box.
+     * @brief Returns the bounding box of the bezier and of its feather padded by the feather distance.
+     * It shares the cached tessellation of the curve at mipmap level 0.
      **/
     RectD getBoundingBox(int time) const;
 
+    /**
+     * @brief Returns the bounding box of the control points, feather points and their tangents: the curve and its feather
+     * lie inside it. It is cached until the shape changes so that shapes can be culled cheaply before picking or rendering.
+     * Unlike getBoundingBox() it is not padded by the feather distance.
+     **/
+    RectD getControlPointsBoundingBox(int time) const;
+
+    /**
+     * @brief Called whenever a control point or a feather point of the curve changes. This invalidates the tessellations
+     * and the positions of the points cached by the Bezier.
+     **/
+    void incrementShapeAge();
+
     /**
      * @brief Returns a const ref to the control points of the bezier curve. This can only ever be called on the main thread.
      **/
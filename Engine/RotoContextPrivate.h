@@ -18,6 +18,7 @@
 #include <list>
 #include <map>
 #include <string>
+#include <vector>
 
 #if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
 #include <boost/shared_ptr.hpp>
@@ -25,6 +26,7 @@
 #endif
 
 #include <QMutex>
+#include <QAtomicInt>
 #include <QCoreApplication>
 #include <QThread>
 #include <QReadWriteLock>
@@ -37,6 +39,7 @@
 #include "Engine/Node.h"
 #include "Engine/EffectInstance.h"
 #include "Engine/AppManager.h"
+#include "Engine/Rect.h"
 
 #include "Global/GlobalDefines.h"
 
@@ -47,6 +50,16 @@
 #define ROTO_DEFAULT_COLOR_G 1.
 #define ROTO_DEFAULT_COLOR_B 1.
 
+///Maximum distance in pixels (at the mipmap level of the tessellation) between a Bezier and its tessellation
+#define ROTO_TESSELLATION_TOLERANCE 0.1
+///A Bezier segment is never split into more than 2^ROTO_TESSELLATION_MAX_DEPTH pieces
+#define ROTO_TESSELLATION_MAX_DEPTH 10
+///The length (in parameter space) of the pieces next to the control points, see bezierSegmentFlatten
+#define ROTO_TESSELLATION_END_PIECE (1. / 49.)
+///Number of (time, mipmap level) tessellations kept by each Bezier, this is also the number of times at which
+///the positions of the points are kept
+#define ROTO_TESSELLATION_CACHE_SIZE 4
+
 
 #define kRotoScriptNameHint "Script-name of the item for Python scripts. It cannot be edited."
 
@@ -148,6 +161,75 @@ struct BezierCPPrivate
 class BezierCP;
 typedef std::list< boost::shared_ptr<BezierCP> > BezierCPs;
 
+/**
+ * @brief The positions of the control points and feather points of a Bezier at a given time, with their bounding box.
+ * Shapes are culled and points are picked with these instead of evaluating the animation curves of every point.
+ **/
+struct BezierPointsAtTime
+{
+    int time;
+    int shapeAge; //< the age of the Bezier when the positions were computed
+    bool tracked; //< if a point is slaved to a track it moves without the Bezier changing: the positions are never reused
+
+    std::vector<Natron::Point> points;
+    std::vector<Natron::Point> featherPoints;
+
+    ///The bounding box of the points, feather points and their tangents: the curve and its feather lie inside it
+    RectD bbox;
+
+    BezierPointsAtTime()
+        : time(0)
+          , shapeAge(0)
+          , tracked(false)
+          , points()
+          , featherPoints()
+          , bbox()
+    {
+    }
+};
+
+typedef boost::shared_ptr<BezierPointsAtTime> BezierPointsAtTimePtr;
+
+/**
+ * @brief The polygons approximating a Bezier and its feather at a given time and mipmap level.
+ * The curve and the feather are subdivided at the same parameters so both polygons have the same number of points.
+ * Once built the polygons of a tessellation are never modified, it is replaced when the shape changes.
+ **/
+struct BezierTessellation
+{
+    int time;
+    unsigned int mipMapLevel;
+    int shapeAge; //< the age of the Bezier when it was tessellated
+    bool tracked; //< see BezierPointsAtTime::tracked
+
+    ///The 4 control points of each segment of the curve followed by those of the feather, at the mipmap level.
+    ///They are compared when the age of the shape changed or when points are tracked.
+    std::vector<Natron::Point> controlPolygon;
+    std::vector<Natron::Point> points;
+    std::vector<Natron::Point> featherPoints;
+
+    ///For each point, the index of its segment plus its parameter within the segment
+    std::vector<double> params;
+    RectD bbox;
+    RectD featherBBox;
+
+    BezierTessellation()
+        : time(0)
+          , mipMapLevel(0)
+          , shapeAge(0)
+          , tracked(false)
+          , controlPolygon()
+          , points()
+          , featherPoints()
+          , params()
+          , bbox()
+          , featherBBox()
+    {
+    }
+};
+
+typedef boost::shared_ptr<BezierTessellation> BezierTessellationPtr;
+
 
 struct BezierPrivate
 {
@@ -159,6 +241,9 @@ struct BezierPrivate
     BezierCPs featherPointsAtDistance; //< the precomputed feather points at featherDistance. may
     double featherPointsAtDistanceVal; //< the distance value used to compute featherPointsAtDistance. if == 0., use featherPoints. if Bezier::getFeatherDistance() returns a different value, featherPointsAtDistance must be updated.
     bool finished; //< when finished is true, the last point of the list is connected to the first point of the list.
+    QAtomicInt shapeAge; //< incremented whenever a point changes, see Bezier::incrementShapeAge
+    std::list<BezierTessellationPtr> tessellations; //< most recently used first, protected by the item mutex
+    std::list<BezierPointsAtTimePtr> pointsAtTime; //< most recently used first, protected by the item mutex
 
     BezierPrivate()
         : points()
@@ -167,6 +252,9 @@ struct BezierPrivate
           , featherPointsAtDistance()
           , featherPointsAtDistanceVal(0.)
           , finished(false)
+          , shapeAge(0)
+          , tessellations()
+          , pointsAtTime()
     {
     }
 
@@ -224,15 +312,16 @@ struct BezierPrivate
     BezierCPs::const_iterator findControlPointNearby(double x,
                                                      double y,
                                                      double acceptance,
-                                                     int time,
+                                                     const BezierPointsAtTime & positions,
                                                      int* index) const
     {
         // PRIVATE - should not lock
         int i = 0;
 
+        assert( positions.points.size() == points.size() );
         for (BezierCPs::const_iterator it = points.begin(); it != points.end(); ++it,++i) {
-            double pX,pY;
-            (*it)->getPositionAtTime(time, &pX, &pY);
+            double pX = positions.points[i].x;
+            double pY = positions.points[i].y;
             if ( ( pX >= (x - acceptance) ) && ( pX <= (x + acceptance) ) && ( pY >= (y - acceptance) ) && ( pY <= (y + acceptance) ) ) {
                 *index = i;
 
@@ -246,15 +335,16 @@ struct BezierPrivate
     BezierCPs::const_iterator findFeatherPointNearby(double x,
                                                      double y,
                                                      double acceptance,
-                                                     int time,
+                                                     const BezierPointsAtTime & positions,
                                                      int* index) const
     {
         // PRIVATE - should not lock
         int i = 0;
 
+        assert( positions.featherPoints.size() == featherPoints.size() );
         for (BezierCPs::const_iterator it = featherPoints.begin(); it != featherPoints.end(); ++it,++i) {
-            double pX,pY;
-            (*it)->getPositionAtTime(time, &pX, &pY);
+            double pX = positions.featherPoints[i].x;
+            double pY = positions.featherPoints[i].y;
             if ( ( pX >= (x - acceptance) ) && ( pX <= (x + acceptance) ) && ( pY >= (y - acceptance) ) && ( pY <= (y + acceptance) ) ) {
                 *index = i;
 
@@ -30,6 +30,7 @@
 #include "Engine/Project.h"
 #include "Engine/Plugin.h"
 #include "Engine/Node.h"
+#include "Engine/NumaTopology.h"
 #include "Engine/ViewerInstance.h"
 #include "Engine/StandardPaths.h"
 #include "SequenceParsing.h"
@@ -175,6 +176,25 @@ Settings::initializeKnobs()
     _nThreadsPerEffect->disableSlider();
     _generalTab->addKnob(_nThreadsPerEffect);
 
+    _bindRenderThreadsToNUMANodes = Natron::createKnob<Bool_Knob>(this, "Bind render threads to NUMA nodes");
+    _bindRenderThreadsToNUMANodes->setName("numaBinding");
+    _bindRenderThreadsToNUMANodes->setHintToolTip("On machines with several processors (NUMA nodes), when checked each thread rendering a frame "
+                                                  "is bound to a node and the images it produces are allocated in the memory of that node. "
+                                                  "This avoids costly accesses to the memory of another processor when "
+                                                  "rendering several frames in parallel. This has no effect on machines with a single node.");
+    _bindRenderThreadsToNUMANodes->setAnimationEnabled(false);
+    _generalTab->addKnob(_bindRenderThreadsToNUMANodes);
+    
+    _cacheAwareFrameOrdering = Natron::createKnob<Bool_Knob>(this, "Cache-aware frame ordering");
+    _cacheAwareFrameOrdering->setName("cacheAwareFrameOrdering");
+    _cacheAwareFrameOrdering->setHintToolTip("When rendering on disk a tree containing effects that need several frames of their inputs "
+                                             "(e.g: retiming, motion blur, temporal denoising), when checked render threads "
+                                             "pick the frames that share the most input frames with the frames being rendered, "
+                                             "so that these input frames are still in the cache. When unchecked, frames are handed out to the threads "
+                                             "in sequential order, which may compute the same input frames several times.");
+    _cacheAwareFrameOrdering->setAnimationEnabled(false);
+    _generalTab->addKnob(_cacheAwareFrameOrdering);
+
     _renderInSeparateProcess = Natron::createKnob<Bool_Knob>(this, "Render in a separate process");
     _renderInSeparateProcess->setName("renderNewProcess");
     _renderInSeparateProcess->setAnimationEnabled(false);
@@ -842,6 +862,38 @@ Settings::initializeKnobs()
     _maxDiskCacheNodeGB->setMaximum(100);
     _maxDiskCacheNodeGB->setHintToolTip("The maximum size that may be used by the DiskCache node on disk (in GiB)");
     _cachingTab->addKnob(_maxDiskCacheNodeGB);
+    
+    _diskCacheNodeDecodedFramesMB = Natron::createKnob<Int_Knob>(this, "DiskCache node decoded frames memory (MiB)");
+    _diskCacheNodeDecodedFramesMB->setName("diskCacheNodeDecodedFrames");
+    _diskCacheNodeDecodedFramesMB->setAnimationEnabled(false);
+    _diskCacheNodeDecodedFramesMB->setMinimum(0);
+    _diskCacheNodeDecodedFramesMB->setMaximum(65536);
+    _diskCacheNodeDecodedFramesMB->setHintToolTip("The memory each DiskCache node may use (in MiB) to keep the frames it read most recently "
+                                                  "decoded, so that redrawing them does not read the disk again. This memory is not "
+                                                  "part of the node cache. The last frame read is always kept.");
+    _cachingTab->addKnob(_diskCacheNodeDecodedFramesMB);
+    
+    _shareDiskCacheNode = Natron::createKnob<Bool_Knob>(this, "Share DiskCache node cache with other processes");
+    _shareDiskCacheNode->setName("shareDiskCacheNode");
+    _shareDiskCacheNode->setAnimationEnabled(false);
+    _shareDiskCacheNode->setHintToolTip("WARNING: Changing this parameter requires a restart of the application. \n"
+                                        "When checked, the images cached on disk by the DiskCache node are shared with all the other "
+                                        NATRON_APPLICATION_NAME " processes using the same disk cache path and having this option checked, "
+                                        "including background renders. An image rendered by one process can be read by the others "
+                                        "instead of being computed again. This is useful when running several renderers on the same "
+                                        "machine against the same project.");
+    _cachingTab->addKnob(_shareDiskCacheNode);
+    
+    _diskCacheWriteBehind = Natron::createKnob<Bool_Knob>(this, "Write disk caches in the background");
+    _diskCacheWriteBehind->setName("diskCacheWriteBehind");
+    _diskCacheWriteBehind->setAnimationEnabled(false);
+    _diskCacheWriteBehind->setHintToolTip("WARNING: Changing this parameter requires a restart of the application. \n"
+                                          "When checked, the images cached on disk are kept in RAM while they are in use and are "
+                                          "written to disk by a dedicated thread, with large sequential writes, once they leave the "
+                                          "memory portion of the cache. They are read back entirely when needed again. "
+                                          "When unchecked, they are files mapped in memory that the system writes back whenever it wants, "
+                                          "which may stall renders when many images are written at once.");
+    _cachingTab->addKnob(_diskCacheWriteBehind);
 
 
     _diskCachePath = Natron::createKnob<Path_Knob>(this, "Disk cache path (empty = default)");
@@ -1010,6 +1062,8 @@ Settings::setDefaultValues()
     _numberOfParallelRenders->setDefaultValue(0,0);
     _useThreadPool->setDefaultValue(true);
     _nThreadsPerEffect->setDefaultValue(0);
+    _bindRenderThreadsToNUMANodes->setDefaultValue(false);
+    _cacheAwareFrameOrdering->setDefaultValue(true);
     _renderInSeparateProcess->setDefaultValue(false,0);
     _autoPreviewEnabledForNewProjects->setDefaultValue(true,0);
     _firstReadSetProjectFormat->setDefaultValue(true);
@@ -1044,6 +1098,9 @@ Settings::setDefaultValues()
     _unreachableRAMPercent->setDefaultValue(5);
     _maxViewerDiskCacheGB->setDefaultValue(5,0);
     _maxDiskCacheNodeGB->setDefaultValue(10,0);
+    _diskCacheNodeDecodedFramesMB->setDefaultValue(256,0);
+    _shareDiskCacheNode->setDefaultValue(false);
+    _diskCacheWriteBehind->setDefaultValue(false);
     setCachingLabels();
     _autoTurbo->setDefaultValue(false);
     _usePluginIconsInNodeGraph->setDefaultValue(true);
@@ -1327,6 +1384,7 @@ Settings::restoreSettings()
         appPTR->setNThreadsPerEffect(getNumberOfThreadsPerEffect());
         appPTR->setNThreadsToRender(getNumberOfThreads());
         appPTR->setUseThreadPool(_useThreadPool->getValue());
+        Natron::NUMA::setBindingEnabled(_bindRenderThreadsToNUMANodes->getValue());
     } catch (std::logic_error) {
         // ignore
     }
@@ -1495,6 +1553,8 @@ Settings::onKnobValueChanged(KnobI* k,
     } else if ( k == _useThreadPool.get() ) {
         bool useTP = _useThreadPool->getValue();
         appPTR->setUseThreadPool(useTP);
+    } else if ( k == _bindRenderThreadsToNUMANodes.get() ) {
+        Natron::NUMA::setBindingEnabled(_bindRenderThreadsToNUMANodes->getValue());
     } else if ( k == _customOcioConfigFile.get() ) {
         if (_customOcioConfigFile->isEnabled(0)) {
             tryLoadOpenColorIOConfig();
@@ -1576,6 +1636,24 @@ Settings::getMaximumDiskCacheNodeSize() const
     return (U64)( _maxDiskCacheNodeGB->getValue() ) * std::pow(1024.,3.);
 }
 
+U64
+Settings::getDiskCacheNodeDecodedFramesMaxSize() const
+{
+    return (U64)( _diskCacheNodeDecodedFramesMB->getValue() ) * 1024 * 1024;
+}
+
+bool
+Settings::isDiskCacheNodeSharedAcrossProcesses() const
+{
+    return _shareDiskCacheNode->getValue();
+}
+
+bool
+Settings::isDiskCacheWriteBehindEnabled() const
+{
+    return _diskCacheWriteBehind->getValue();
+}
+
 double
 Settings::getUnreachableRamPercent() const
 {
@@ -2345,6 +2423,12 @@ Settings::useGlobalThreadPool() const
     return _useThreadPool->getValue();
 }
 
+bool
+Settings::isCacheAwareFrameOrderingEnabled() const
+{
+    return _cacheAwareFrameOrdering->getValue();
+}
+
 void
 Settings::setUseGlobalThreadPool(bool use)
 {
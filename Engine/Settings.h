@@ -77,6 +77,12 @@ public:
     U64 getMaximumViewerDiskCacheSize() const;
     
     U64 getMaximumDiskCacheNodeSize() const;
+    
+    U64 getDiskCacheNodeDecodedFramesMaxSize() const;
+    
+    bool isDiskCacheNodeSharedAcrossProcesses() const;
+
+    bool isDiskCacheWriteBehindEnabled() const;
 
     double getUnreachableRamPercent() const;
 
@@ -93,6 +99,8 @@ public:
     bool useGlobalThreadPool() const;
     
     void setUseGlobalThreadPool(bool use) ;
+    
+    bool isCacheAwareFrameOrderingEnabled() const;
 
     std::string getReaderPluginIDForFileType(const std::string & extension);
     std::string getWriterPluginIDForFileType(const std::string & extension);
@@ -283,6 +291,8 @@ private:
     boost::shared_ptr<Int_Knob> _numberOfParallelRenders;
     boost::shared_ptr<Bool_Knob> _useThreadPool;
     boost::shared_ptr<Int_Knob> _nThreadsPerEffect;
+    boost::shared_ptr<Bool_Knob> _bindRenderThreadsToNUMANodes;
+    boost::shared_ptr<Bool_Knob> _cacheAwareFrameOrdering;
     boost::shared_ptr<Bool_Knob> _renderInSeparateProcess;
     boost::shared_ptr<Bool_Knob> _autoPreviewEnabledForNewProjects;
     boost::shared_ptr<Bool_Knob> _firstReadSetProjectFormat;
@@ -322,6 +332,9 @@ private:
     ///The total disk space allowed for all Natron's caches
     boost::shared_ptr<Int_Knob> _maxViewerDiskCacheGB;
     boost::shared_ptr<Int_Knob> _maxDiskCacheNodeGB;
+    boost::shared_ptr<Int_Knob> _diskCacheNodeDecodedFramesMB;
+    boost::shared_ptr<Bool_Knob> _shareDiskCacheNode;
+    boost::shared_ptr<Bool_Knob> _diskCacheWriteBehind;
     boost::shared_ptr<Path_Knob> _diskCachePath;
     
     boost::shared_ptr<Page_Knob> _viewersTab;
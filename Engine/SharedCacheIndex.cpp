@@ -0,0 +1,440 @@
+//  Natron
+//
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+
+#include "SharedCacheIndex.h"
+
+#ifdef __NATRON_WIN32__
+# include <windows.h>
+# include <sys/types.h>
+# include <sys/stat.h>
+#else // unix
+#include <fcntl.h>
+#include <sys/file.h>      // flock
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+
+#include <QtCore/QByteArray>
+#include <QtCore/QDateTime>
+#include <QtCore/QFile>
+#include <QtCore/QMutex>
+#include <QtCore/QDebug>
+#include <QtCore/QCoreApplication>
+
+#include "Global/Macros.h"
+
+///The header of the index: the magic number, the version of the cache and the generation of the index
+#define NATRON_SHARED_CACHE_INDEX_MAGIC "NTCINDEX"
+#define NATRON_SHARED_CACHE_INDEX_MAGIC_SIZE 8
+#define NATRON_SHARED_CACHE_INDEX_HEADER_SIZE (NATRON_SHARED_CACHE_INDEX_MAGIC_SIZE + sizeof(quint32) + sizeof(quint64))
+
+///A record is its type, the size of its data and the data
+#define NATRON_SHARED_CACHE_INDEX_RECORD_HEADER_SIZE (sizeof(quint8) + sizeof(quint32))
+
+namespace {
+
+///What a stat() of the index file returns, to find out cheaply whether another process modified it
+struct FileStamp
+{
+    bool exists;
+    long long size;
+    long long modificationTime;
+    unsigned long long inode;
+
+    FileStamp()
+    : exists(false)
+    , size(0)
+    , modificationTime(0)
+    , inode(0)
+    {
+    }
+
+    bool operator==(const FileStamp& other) const
+    {
+        return exists == other.exists && size == other.size && modificationTime == other.modificationTime && inode == other.inode;
+    }
+};
+
+FileStamp
+getFileStamp(const std::string& filePath)
+{
+    FileStamp ret;
+    struct stat st;
+
+    if (::stat(filePath.c_str(), &st) == 0) {
+        ret.exists = true;
+        ret.size = st.st_size;
+        ret.modificationTime = st.st_mtime;
+        ret.inode = st.st_ino;
+    }
+
+    return ret;
+}
+
+void
+appendRecord(const SharedCacheIndex::Record& record,
+             QByteArray* buffer)
+{
+    quint8 type = record.type;
+    quint32 size = (quint32)record.data.size();
+
+    buffer->append( (const char*)&type, sizeof(type) );
+    buffer->append( (const char*)&size, sizeof(size) );
+    buffer->append( record.data.data(), (int)record.data.size() );
+}
+} // anon namespace
+
+struct SharedCacheIndexPrivate
+{
+    std::string indexFilePath;
+    std::string tmpIndexFilePath;
+    std::string lockFilePath;
+    unsigned int version;
+
+    ///The generation of the index file last read or written, 0 if there is none or it was written by another version
+    quint64 generation;
+
+    ///Where the records not read yet start in the index file
+    qint64 readOffset;
+
+    std::size_t recordsCount;
+
+    ///True once readNewRecords() was called while holding the lock
+    bool synced;
+
+    ///The index file as last read or written, protected by stampMutex
+    mutable QMutex stampMutex;
+    FileStamp stamp;
+
+    ///Protects the index against other threads of this process: file locks are only guaranteed
+    ///to exclude other processes
+    QMutex threadsMutex;
+
+#if defined(__NATRON_UNIX__)
+    int lockFileHandle;
+#elif defined(__NATRON_WIN32__)
+    HANDLE lockFileHandle;
+#endif
+
+    SharedCacheIndexPrivate(const std::string& cachePath,
+                            unsigned int version)
+    : indexFilePath(cachePath + "/sharedIndex." NATRON_CACHE_FILE_EXT)
+    , tmpIndexFilePath()
+    , lockFilePath(cachePath + "/sharedIndex.lock")
+    , version(version)
+    , generation(0)
+    , readOffset(0)
+    , recordsCount(0)
+    , synced(false)
+    , stampMutex()
+    , stamp()
+    , threadsMutex()
+#if defined(__NATRON_UNIX__)
+    , lockFileHandle(-1)
+#elif defined(__NATRON_WIN32__)
+    , lockFileHandle(INVALID_HANDLE_VALUE)
+#endif
+    {
+        std::stringstream ss;
+        ss << indexFilePath << '.' << QCoreApplication::applicationPid() << ".tmp";
+        tmpIndexFilePath = ss.str();
+    }
+
+    bool openLockFile();
+
+    void closeLockFile();
+
+    void updateStamp()
+    {
+        QMutexLocker k(&stampMutex);
+        stamp = getFileStamp(indexFilePath);
+    }
+
+    bool commitIndexFile();
+};
+
+bool
+SharedCacheIndexPrivate::openLockFile()
+{
+#if defined(__NATRON_UNIX__)
+    if (lockFileHandle != -1) {
+        return true;
+    }
+    lockFileHandle = ::open(lockFilePath.c_str(), O_RDWR | O_CREAT, S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH | S_IWOTH);
+    if (lockFileHandle == -1) {
+        qDebug() << "Failed to open the shared cache lock file " << lockFilePath.c_str();
+        return false;
+    }
+    return true;
+#elif defined(__NATRON_WIN32__)
+    if (lockFileHandle != INVALID_HANDLE_VALUE) {
+        return true;
+    }
+    lockFileHandle = ::CreateFileA(lockFilePath.c_str(),
+                                   GENERIC_READ | GENERIC_WRITE,
+                                   FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                   0,
+                                   OPEN_ALWAYS,
+                                   FILE_ATTRIBUTE_NORMAL,
+                                   0);
+    if (lockFileHandle == INVALID_HANDLE_VALUE) {
+        qDebug() << "Failed to open the shared cache lock file " << lockFilePath.c_str();
+        return false;
+    }
+    return true;
+#endif
+}
+
+void
+SharedCacheIndexPrivate::closeLockFile()
+{
+#if defined(__NATRON_UNIX__)
+    if (lockFileHandle != -1) {
+        ::close(lockFileHandle);
+        lockFileHandle = -1;
+    }
+#elif defined(__NATRON_WIN32__)
+    if (lockFileHandle != INVALID_HANDLE_VALUE) {
+        ::CloseHandle(lockFileHandle);
+        lockFileHandle = INVALID_HANDLE_VALUE;
+    }
+#endif
+}
+
+SharedCacheIndex::SharedCacheIndex(const std::string& cachePath,
+                                   unsigned int version)
+: _imp(new SharedCacheIndexPrivate(cachePath,version))
+{
+}
+
+SharedCacheIndex::~SharedCacheIndex()
+{
+    _imp->closeLockFile();
+}
+
+const std::string&
+SharedCacheIndex::getIndexFilePath() const
+{
+    return _imp->indexFilePath;
+}
+
+bool
+SharedCacheIndexPrivate::commitIndexFile()
+{
+#if defined(__NATRON_UNIX__)
+    ///rename() atomically replaces the destination: readers either see the old or the new index
+    return std::rename(tmpIndexFilePath.c_str(), indexFilePath.c_str()) == 0;
+#elif defined(__NATRON_WIN32__)
+    return ::MoveFileExA(tmpIndexFilePath.c_str(), indexFilePath.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#endif
+}
+
+bool
+SharedCacheIndex::hasChanged() const
+{
+    FileStamp current = getFileStamp(_imp->indexFilePath);
+    QMutexLocker k(&_imp->stampMutex);
+
+    return !(current == _imp->stamp);
+}
+
+void
+SharedCacheIndex::readNewRecords(RecordList* records,
+                                 bool* reset)
+{
+    *reset = false;
+    _imp->synced = true;
+
+    QFile file( QString::fromUtf8( _imp->indexFilePath.c_str() ) );
+    bool compatible = file.open(QIODevice::ReadOnly);
+    quint64 generation = 0;
+    if (compatible) {
+        QByteArray header = file.read(NATRON_SHARED_CACHE_INDEX_HEADER_SIZE);
+        quint32 version = 0;
+        if (header.size() == (int)NATRON_SHARED_CACHE_INDEX_HEADER_SIZE) {
+            std::memcpy(&version, header.constData() + NATRON_SHARED_CACHE_INDEX_MAGIC_SIZE, sizeof(version));
+            std::memcpy(&generation, header.constData() + NATRON_SHARED_CACHE_INDEX_MAGIC_SIZE + sizeof(version), sizeof(generation));
+        }
+        compatible = header.size() == (int)NATRON_SHARED_CACHE_INDEX_HEADER_SIZE &&
+                     std::memcmp(header.constData(), NATRON_SHARED_CACHE_INDEX_MAGIC, NATRON_SHARED_CACHE_INDEX_MAGIC_SIZE) == 0 &&
+                     version == _imp->version && generation != 0;
+    }
+    if (!compatible) {
+        ///Nothing was published yet, or by another version: the index is replaced on the next write
+        *reset = _imp->generation != 0;
+        _imp->generation = 0;
+        _imp->readOffset = 0;
+        _imp->recordsCount = 0;
+        _imp->updateStamp();
+
+        return;
+    }
+
+    if (generation != _imp->generation) {
+        ///The index was rewritten by another process
+        *reset = true;
+        _imp->generation = generation;
+        _imp->readOffset = NATRON_SHARED_CACHE_INDEX_HEADER_SIZE;
+        _imp->recordsCount = 0;
+    }
+
+    file.seek(_imp->readOffset);
+    QByteArray data = file.readAll();
+    int pos = 0;
+    while (pos + (int)NATRON_SHARED_CACHE_INDEX_RECORD_HEADER_SIZE <= data.size()) {
+        quint8 type;
+        quint32 size;
+        std::memcpy(&type, data.constData() + pos, sizeof(type));
+        std::memcpy(&size, data.constData() + pos + sizeof(type), sizeof(size));
+        if ( (qint64)pos + NATRON_SHARED_CACHE_INDEX_RECORD_HEADER_SIZE + size > (qint64)data.size() ) {
+            ///Left incomplete by a process that crashed while writing it, it is overwritten by the next append
+            break;
+        }
+        pos += NATRON_SHARED_CACHE_INDEX_RECORD_HEADER_SIZE;
+        Record r;
+        r.type = type;
+        r.data.assign(data.constData() + pos, size);
+        records->push_back(r);
+        pos += size;
+        ++_imp->recordsCount;
+    }
+    _imp->readOffset += pos;
+    _imp->updateStamp();
+}
+
+bool
+SharedCacheIndex::appendRecords(const RecordList& records)
+{
+    assert(_imp->synced);
+    if ( records.empty() ) {
+        return true;
+    }
+    if (_imp->generation == 0) {
+        return rewrite(records);
+    }
+
+    QFile file( QString::fromUtf8( _imp->indexFilePath.c_str() ) );
+    if ( !file.open(QIODevice::ReadWrite) ) {
+        qDebug() << "Failed to write the shared cache index " << _imp->indexFilePath.c_str();
+
+        return false;
+    }
+    if ( file.size() != _imp->readOffset ) {
+        ///Drop a record left incomplete by a process that crashed while writing it
+        file.resize(_imp->readOffset);
+    }
+    QByteArray buffer;
+    for (RecordList::const_iterator it = records.begin(); it != records.end(); ++it) {
+        appendRecord(*it, &buffer);
+    }
+    file.seek(_imp->readOffset);
+    if (file.write(buffer) != buffer.size()) {
+        file.resize(_imp->readOffset);
+        qDebug() << "Failed to write the shared cache index " << _imp->indexFilePath.c_str();
+
+        return false;
+    }
+    file.close();
+    _imp->readOffset += buffer.size();
+    _imp->recordsCount += records.size();
+    _imp->updateStamp();
+
+    return true;
+}
+
+bool
+SharedCacheIndex::rewrite(const RecordList& records)
+{
+    ///A new generation tells the other processes to read the index again from the start
+    quint64 generation = _imp->generation + 1;
+    if (_imp->generation == 0) {
+        ///Do not reuse the generation of an index removed in the meantime
+        generation = (quint64)QDateTime::currentMSecsSinceEpoch();
+    }
+
+    QByteArray buffer(NATRON_SHARED_CACHE_INDEX_MAGIC, NATRON_SHARED_CACHE_INDEX_MAGIC_SIZE);
+    quint32 version = _imp->version;
+    buffer.append( (const char*)&version, sizeof(version) );
+    buffer.append( (const char*)&generation, sizeof(generation) );
+    for (RecordList::const_iterator it = records.begin(); it != records.end(); ++it) {
+        appendRecord(*it, &buffer);
+    }
+    {
+        QFile file( QString::fromUtf8( _imp->tmpIndexFilePath.c_str() ) );
+        if ( !file.open(QIODevice::WriteOnly | QIODevice::Truncate) || (file.write(buffer) != buffer.size()) ) {
+            qDebug() << "Failed to write the shared cache index " << _imp->tmpIndexFilePath.c_str();
+
+            return false;
+        }
+    }
+    if ( !_imp->commitIndexFile() ) {
+        return false;
+    }
+    _imp->generation = generation;
+    _imp->readOffset = buffer.size();
+    _imp->recordsCount = records.size();
+    _imp->synced = true;
+    _imp->updateStamp();
+
+    return true;
+}
+
+std::size_t
+SharedCacheIndex::getRecordsCount() const
+{
+    return _imp->recordsCount;
+}
+
+bool
+SharedCacheIndex::lock()
+{
+    _imp->threadsMutex.lock();
+    _imp->synced = false;
+    if ( !_imp->openLockFile() ) {
+        _imp->threadsMutex.unlock();
+        return false;
+    }
+#if defined(__NATRON_UNIX__)
+    int ret;
+    do {
+        ret = ::flock(_imp->lockFileHandle, LOCK_EX);
+    } while (ret == -1 && errno == EINTR);
+    if (ret == -1) {
+        _imp->threadsMutex.unlock();
+        return false;
+    }
+#elif defined(__NATRON_WIN32__)
+    OVERLAPPED overlapped;
+    ZeroMemory(&overlapped, sizeof(overlapped));
+    if ( !::LockFileEx(_imp->lockFileHandle, LOCKFILE_EXCLUSIVE_LOCK, 0, 1, 0, &overlapped) ) {
+        _imp->threadsMutex.unlock();
+        return false;
+    }
+#endif
+    return true;
+}
+
+void
+SharedCacheIndex::unlock()
+{
+#if defined(__NATRON_UNIX__)
+    ::flock(_imp->lockFileHandle, LOCK_UN);
+#elif defined(__NATRON_WIN32__)
+    OVERLAPPED overlapped;
+    ZeroMemory(&overlapped, sizeof(overlapped));
+    ::UnlockFileEx(_imp->lockFileHandle, 0, 1, 0, &overlapped);
+#endif
+    _imp->threadsMutex.unlock();
+}
@@ -0,0 +1,159 @@
+//  Natron
+//
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef NATRON_ENGINE_SHAREDCACHEINDEX_H_
+#define NATRON_ENGINE_SHAREDCACHEINDEX_H_
+
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+
+#include <list>
+#include <string>
+
+#include "Global/Macros.h"
+#if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
+#include <boost/noncopyable.hpp>
+#include <boost/scoped_ptr.hpp>
+#endif
+#include "Global/GlobalDefines.h"
+
+/**
+ * @brief The index of the entries of a disk cache that is shared by several Natron processes
+ * (e.g: several NatronRenderer instances rendering the same project on the same machine).
+ *
+ * The index is a file living next to the cache entries (sharedIndex.ntc). It is a journal of records
+ * appended by the processes: entries published (their backing file is complete and flushed, so they can be
+ * used by any process), accessed or removed. Each process keeps the state built from the records it read and
+ * only reads the records appended since, so that looking-up or publishing entries does not cost a read of the
+ * whole index. Once the journal holds too many obsolete records it is rewritten by the process holding the lock,
+ * which bumps the generation stored in its header: the other processes then read it again from the start.
+ *
+ * All accesses to the index file must be done while holding the lock: it is both a process-wide
+ * mutex and an exclusive lock on a file (flock on Unix, LockFileEx on Windows), so that processes and
+ * threads of a same process exclude each other.
+ *
+ * This class only deals with the file locking and the storage of the records, the content of the records
+ * is (de)serialized by the Cache itself since it depends on the type of the entries.
+ **/
+struct SharedCacheIndexPrivate;
+class SharedCacheIndex
+    : boost::noncopyable
+{
+public:
+
+    /**
+     * @brief Lock the index for the lifetime of the object
+     **/
+    class Locker
+    {
+        SharedCacheIndex* _index;
+        bool _locked;
+
+    public:
+
+        Locker(SharedCacheIndex* index)
+        : _index(index)
+        , _locked(index->lock())
+        {
+        }
+
+        ~Locker()
+        {
+            if (_locked) {
+                _index->unlock();
+            }
+        }
+
+        bool isLocked() const
+        {
+            return _locked;
+        }
+    };
+
+    enum RecordTypeEnum
+    {
+        eRecordTypePublish = 0, //< an entry was published
+        eRecordTypeAccess, //< a published entry was used, for the LRU eviction across processes
+        eRecordTypeRemove //< a published entry was evicted and its file removed
+    };
+
+    struct Record
+    {
+        unsigned char type;
+        std::string data;
+
+        Record()
+        : type(0)
+        , data()
+        {
+        }
+
+        Record(RecordTypeEnum type_,
+               const std::string& data_)
+        : type( (unsigned char)type_ )
+        , data(data_)
+        {
+        }
+    };
+
+    typedef std::list<Record> RecordList;
+
+    /**
+     * @brief version is the version of the cache: an index written by another version is ignored and replaced.
+     **/
+    SharedCacheIndex(const std::string& cachePath,unsigned int version);
+
+    ~SharedCacheIndex();
+
+    /**
+     * @brief Returns the path of the index file. It may not exist yet if nothing was ever published.
+     **/
+    const std::string& getIndexFilePath() const;
+
+    /**
+     * @brief Returns true if the index file was modified since this process last read or wrote it.
+     * This does not lock the index and only costs a stat() of the file.
+     **/
+    bool hasChanged() const;
+
+    /**
+     * @brief Reads the records appended since the last call. The lock must be held.
+     * If the index was rewritten or removed since then, reset is set to true and records holds the whole
+     * index: the state built from the records read before must be discarded.
+     **/
+    void readNewRecords(RecordList* records,bool* reset);
+
+    /**
+     * @brief Appends records to the index. The lock must be held and readNewRecords() must have been called
+     * since it was taken so that the records are appended after the ones known by this process.
+     **/
+    bool appendRecords(const RecordList& records);
+
+    /**
+     * @brief Atomically replaces the whole index by the given records. The lock must be held.
+     **/
+    bool rewrite(const RecordList& records);
+
+    /**
+     * @brief Returns the number of records in the index file as last read or written by this process.
+     **/
+    std::size_t getRecordsCount() const;
+
+    /**
+     * @brief Blocks until the index is locked by the calling thread. Returns false if the lock file
+     * could not be opened, in which case the index must not be used.
+     **/
+    bool lock();
+
+    void unlock();
+
+private:
+
+    boost::scoped_ptr<SharedCacheIndexPrivate> _imp;
+};
+
+#endif // NATRON_ENGINE_SHAREDCACHEINDEX_H_
@@ -91,10 +91,7 @@ Timer::waitUntilNextFrameIsDue ()
         // variables and return without waiting.
         //
 
-        gettimeofday (&_lastFrameTime, 0);
-        _timingError = 0;
-        _lastFpsFrameTime = _lastFrameTime;
-        _framesSinceLastFpsFrame = 0;
+        resetTiming();
 
         return;
     }
@@ -183,6 +180,45 @@ Timer::waitUntilNextFrameIsDue ()
     _framesSinceLastFpsFrame += 1;
 } // waitUntilNextFrameIsDue
 
+void
+Timer::resetTiming ()
+{
+    gettimeofday (&_lastFrameTime, 0);
+    _timingError = 0;
+    _lastFpsFrameTime = _lastFrameTime;
+    _framesSinceLastFpsFrame = 0;
+}
+
+double
+Timer::getTimeUntilNextFrameIsDue () const
+{
+    double spf;
+    {
+        QMutexLocker l(_mutex);
+        spf = _spf;
+    }
+    timeval now;
+    gettimeofday (&now, 0);
+
+    double timeSinceLastFrame =  now.tv_sec  - _lastFrameTime.tv_sec +
+                               (now.tv_usec - _lastFrameTime.tv_usec) * 1e-6f;
+
+    return spf - timeSinceLastFrame - _timingError;
+}
+
+void
+Timer::skipFrame ()
+{
+    double spf;
+    {
+        QMutexLocker l(_mutex);
+        spf = _spf;
+    }
+    long usec = _lastFrameTime.tv_usec + (long)(spf * 1e6);
+    _lastFrameTime.tv_sec += usec / 1000000;
+    _lastFrameTime.tv_usec = usec % 1000000;
+}
+
 void
 Timer::setDesiredFrameRate (double fps)
 {
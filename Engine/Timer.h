@@ -90,6 +90,27 @@ public:
     void    waitUntilNextFrameIsDue ();
 
 
+    //--------------------------------------------------------
+    // Frame dropping: getTimeUntilNextFrameIsDue() returns the
+    // number of seconds waitUntilNextFrameIsDue() would sleep,
+    // which is negative if the next frame is already late.
+    // skipFrame() moves the schedule one frame ahead without
+    // displaying anything, so that the playback catches up
+    // with the wall clock instead of slowing down.
+    //--------------------------------------------------------
+
+    double  getTimeUntilNextFrameIsDue () const;
+    void    skipFrame ();
+
+
+    //--------------------------------------------------------
+    // Forget about the frames displayed so far, e.g when a new
+    // playback starts: the next frame is due one frame from now.
+    //--------------------------------------------------------
+
+    void    resetTiming ();
+
+
     //-------------------------------------------------
     // Set and get the frame rate, in frames per second
     //-------------------------------------------------
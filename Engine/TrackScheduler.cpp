@@ -0,0 +1,456 @@
+//  Natron
+//
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+
+#include "TrackScheduler.h"
+
+CLANG_DIAG_OFF(deprecated)
+CLANG_DIAG_OFF(uninitialized)
+#include <QtCore/QMutex>
+#include <QtCore/QWaitCondition>
+#include <QtConcurrentMap>
+#include <QtConcurrentRun>
+CLANG_DIAG_ON(deprecated)
+CLANG_DIAG_ON(uninitialized)
+
+#include <boost/bind.hpp>
+
+#include "Engine/AppInstance.h"
+#include "Engine/AppManager.h"
+#include "Engine/EffectInstance.h"
+#include "Engine/Image.h"
+#include "Engine/KnobTypes.h"
+#include "Engine/Node.h"
+#include "Engine/TimeLine.h"
+
+using namespace Natron;
+
+namespace {
+
+///The node feeding tracks and the track that will read its images
+struct TrackerInput
+{
+    boost::shared_ptr<Natron::Node> input;
+    Natron::EffectInstance* track;
+};
+
+void
+handleTrackNextAndPrevious(Button_Knob* selectedInstance,
+                           SequenceTime currentFrame)
+{
+    selectedInstance->getHolder()->onKnobValueChanged_public(selectedInstance,eValueChangedReasonNatronInternalEdited,currentFrame,
+                                                             true);
+}
+
+/**
+ * @brief Renders the image the track will fetch from its input at the given time so that it is in the
+ * node cache when the track asks for it.
+ **/
+void
+prefetchTrackerInput(const TrackerInput & input,
+                     const TimeLine* timeline,
+                     int time)
+{
+    Natron::EffectInstance* effect = input.input->getLiveInstance();
+    if (!effect) {
+        return;
+    }
+    U64 nodeHash = input.input->getHashValue();
+    ParallelRenderArgsSetter frameRenderArgs(input.input.get(),
+                                             time,
+                                             0, //< trackers only track view 0 (left)
+                                             false,
+                                             true,
+                                             true,
+                                             nodeHash,
+                                             false,
+                                             timeline);
+    RenderScale scale;
+    scale.x = scale.y = 1.;
+    RectD rod;
+    bool isProjectFormat;
+    Natron::StatusEnum stat = effect->getRegionOfDefinition_public(nodeHash, time, scale, 0, &rod, &isProjectFormat);
+    if ( (stat == eStatusFailed) || rod.isNull() ) {
+        return;
+    }
+    RectI renderWindow;
+    rod.toPixelEnclosing(0, effect->getPreferredAspectRatio(), &renderWindow);
+
+    ///Render with the components and bit depth the track asks for, so that its request is a cache hit
+    Natron::ImageComponentsEnum components;
+    Natron::ImageBitDepthEnum depth;
+    input.track->getPreferredDepthAndComponents(0, &components, &depth);
+
+    try {
+        (void)effect->renderRoI( EffectInstance::RenderRoIArgs( time,
+                                                                scale,
+                                                                0,
+                                                                0,
+                                                                false,
+                                                                renderWindow,
+                                                                rod,
+                                                                components,
+                                                                depth ) );
+    } catch (...) {
+        ///The track will render (and report the error) itself
+    }
+}
+
+void
+prefetchTrackerInputs(const std::list<TrackerInput> & inputs,
+                      const TimeLine* timeline,
+                      int time)
+{
+    for (std::list<TrackerInput>::const_iterator it = inputs.begin(); it != inputs.end(); ++it) {
+        prefetchTrackerInput(*it, timeline, time);
+    }
+}
+
+}
+
+struct TrackArgs
+{
+    int start,end;
+    bool forward;
+    std::list<Button_Knob*> instances;
+};
+
+struct TrackSchedulerPrivate
+{
+    Natron::Node* tracker;
+
+    QMutex argsMutex;
+    TrackArgs curArgs,requestedArgs;
+
+    mutable QMutex mustQuitMutex;
+    bool mustQuit;
+    QWaitCondition mustQuitCond;
+
+    mutable QMutex abortRequestedMutex;
+    int abortRequested;
+    QWaitCondition abortRequestedCond;
+
+    QMutex startRequesstMutex;
+    int startRequests;
+    QWaitCondition startRequestsCond;
+
+    mutable QMutex isWorkingMutex;
+    bool isWorking;
+    QWaitCondition isWorkingCond;
+
+    mutable QMutex updateViewerMutex;
+    bool updateViewerOnTrackingEnabled;
+
+    TrackSchedulerPrivate(Natron::Node* tracker)
+    : tracker(tracker)
+    , argsMutex()
+    , curArgs()
+    , requestedArgs()
+    , mustQuitMutex()
+    , mustQuit(false)
+    , mustQuitCond()
+    , abortRequestedMutex()
+    , abortRequested(0)
+    , abortRequestedCond()
+    , startRequesstMutex()
+    , startRequests(0)
+    , startRequestsCond()
+    , isWorkingMutex()
+    , isWorking(false)
+    , isWorkingCond()
+    , updateViewerMutex()
+    , updateViewerOnTrackingEnabled(true)
+    {
+
+    }
+
+    bool checkForExit()
+    {
+        QMutexLocker k(&mustQuitMutex);
+        if (mustQuit) {
+            mustQuit = false;
+            mustQuitCond.wakeAll();
+            return true;
+        }
+        return false;
+    }
+
+    ///Returns the distinct inputs of the tracks
+    void getTrackerInputs(const std::list<Button_Knob*> & instances,
+                          std::list<TrackerInput>* inputs) const
+    {
+        for (std::list<Button_Knob*>::const_iterator it = instances.begin(); it != instances.end(); ++it) {
+            Natron::EffectInstance* track = dynamic_cast<Natron::EffectInstance*>( (*it)->getHolder() );
+            if (!track) {
+                continue;
+            }
+            boost::shared_ptr<Natron::Node> input = track->getNode()->getInput(0);
+            if (!input) {
+                continue;
+            }
+            bool found = false;
+            for (std::list<TrackerInput>::iterator it2 = inputs->begin(); it2 != inputs->end(); ++it2) {
+                if (it2->input == input) {
+                    found = true;
+                    break;
+                }
+            }
+            if (!found) {
+                TrackerInput i;
+                i.input = input;
+                i.track = track;
+                inputs->push_back(i);
+            }
+        }
+    }
+
+};
+
+
+TrackScheduler::TrackScheduler(Natron::Node* tracker)
+: QThread()
+, _imp(new TrackSchedulerPrivate(tracker))
+{
+    setObjectName("TrackScheduler");
+}
+
+TrackScheduler::~TrackScheduler()
+{
+
+}
+
+bool
+TrackScheduler::isWorking() const
+{
+    QMutexLocker k(&_imp->isWorkingMutex);
+    return _imp->isWorking;
+}
+
+void
+TrackScheduler::waitForTrackingFinished()
+{
+    QMutexLocker k(&_imp->isWorkingMutex);
+    while (_imp->isWorking) {
+        _imp->isWorkingCond.wait(&_imp->isWorkingMutex);
+    }
+}
+
+void
+TrackScheduler::setUpdateViewerOnTracking(bool update)
+{
+    QMutexLocker k(&_imp->updateViewerMutex);
+    _imp->updateViewerOnTrackingEnabled = update;
+}
+
+bool
+TrackScheduler::isUpdateViewerOnTrackingEnabled() const
+{
+    QMutexLocker k(&_imp->updateViewerMutex);
+    return _imp->updateViewerOnTrackingEnabled;
+}
+
+void
+TrackScheduler::run()
+{
+    for (;;) {
+
+        ///Check for exit of the thread
+        if (_imp->checkForExit()) {
+            QMutexLocker k(&_imp->isWorkingMutex);
+            _imp->isWorking = false;
+            _imp->isWorkingCond.wakeAll();
+            return;
+        }
+
+        ///Flag that we're working
+        {
+            QMutexLocker k(&_imp->isWorkingMutex);
+            _imp->isWorking = true;
+        }
+
+        ///Copy the requested args to the args used for processing
+        {
+            QMutexLocker k(&_imp->argsMutex);
+            _imp->curArgs = _imp->requestedArgs;
+        }
+
+        boost::shared_ptr<TimeLine> timeline = _imp->tracker->getApp()->getTimeLine();
+
+        int end = _imp->curArgs.end;
+        int start = _imp->curArgs.start;
+        int cur = start;
+
+        int framesCount = _imp->curArgs.forward ? (end - start) : (start - end);
+
+        bool reportProgress = _imp->curArgs.instances.size() > 1 || framesCount > 1;
+        if (reportProgress) {
+            Q_EMIT trackingStarted();
+        }
+
+        std::list<TrackerInput> inputs;
+        _imp->getTrackerInputs(_imp->curArgs.instances, &inputs);
+
+        while (cur != end) {
+
+            int next = _imp->curArgs.forward ? cur + 1 : cur - 1;
+
+            ///Tracking from cur fetches the input at cur and next: while the tracks run, render the input at the
+            ///frame after next in the global thread pool so the next step does not wait for it to be decoded
+            QFuture<void> prefetch;
+            if ( (next != end) && !inputs.empty() ) {
+                int prefetchTime = _imp->curArgs.forward ? next + 1 : next - 1;
+                prefetch = QtConcurrent::run(boost::bind(&prefetchTrackerInputs, inputs, timeline.get(), prefetchTime));
+            }
+
+            ///Launch parallel thread for each track using the global thread pool
+            QtConcurrent::map(_imp->curArgs.instances,
+                              boost::bind(&handleTrackNextAndPrevious,
+                                          _1,
+                                          cur)).waitForFinished();
+
+            prefetch.waitForFinished();
+
+            cur = next;
+            double progress;
+            if (_imp->curArgs.forward) {
+                progress = (double)(cur - start) / framesCount;
+            } else {
+                progress = (double)(start - cur) / framesCount;
+            }
+
+            ///Ok all tracks are finished now for this frame, refresh viewer if needed
+            if ( isUpdateViewerOnTrackingEnabled() && !appPTR->isBackground() ) {
+                timeline->seekFrame(cur, true, 0, Natron::eTimelineChangeReasonPlaybackSeek);
+            }
+
+            if (reportProgress) {
+                ///Notify we progressed of 1 frame
+                Q_EMIT progressUpdate(progress);
+            }
+
+            ///Check for abortion
+            {
+                QMutexLocker k(&_imp->abortRequestedMutex);
+                if (_imp->abortRequested > 0) {
+                    _imp->abortRequested = 0;
+                    _imp->abortRequestedCond.wakeAll();
+                    break;
+                }
+            }
+
+        }
+
+        if (reportProgress) {
+            Q_EMIT trackingFinished();
+        }
+
+        ///Flag that we're no longer working, unless another tracking was requested meanwhile
+        {
+            QMutexLocker l(&_imp->startRequesstMutex);
+            QMutexLocker k(&_imp->isWorkingMutex);
+            _imp->isWorking = _imp->startRequests > 0;
+            if (!_imp->isWorking) {
+                _imp->isWorkingCond.wakeAll();
+            }
+        }
+
+        ///Make sure we really reset the abort flag
+        {
+            QMutexLocker k(&_imp->abortRequestedMutex);
+            if (_imp->abortRequested > 0) {
+                _imp->abortRequested = 0;
+
+            }
+        }
+
+        ///Sleep or restart if we've requests in the queue
+        {
+            QMutexLocker k(&_imp->startRequesstMutex);
+            while (_imp->startRequests <= 0) {
+                _imp->startRequestsCond.wait(&_imp->startRequesstMutex);
+            }
+            _imp->startRequests = 0;
+        }
+
+    }
+}
+
+void
+TrackScheduler::track(int startingFrame,int end,bool forward, const std::list<Button_Knob*> & selectedInstances)
+{
+    if ((forward && startingFrame >= end) || (!forward && startingFrame <= end)) {
+        Q_EMIT trackingFinished();
+        return;
+    }
+    {
+        QMutexLocker k(&_imp->argsMutex);
+        _imp->requestedArgs.start = startingFrame;
+        _imp->requestedArgs.end = end;
+        _imp->requestedArgs.forward = forward;
+        _imp->requestedArgs.instances = selectedInstances;
+    }
+    ///Flag that we're working now so that waitForTrackingFinished() called right after does wait
+    {
+        QMutexLocker k(&_imp->isWorkingMutex);
+        _imp->isWorking = true;
+    }
+    if (isRunning()) {
+        QMutexLocker k(&_imp->startRequesstMutex);
+        ++_imp->startRequests;
+        _imp->startRequestsCond.wakeAll();
+    } else {
+        start();
+    }
+}
+
+
+void TrackScheduler::abortTracking()
+{
+    if (!isRunning() || !isWorking()) {
+        return;
+    }
+
+
+    {
+        QMutexLocker k(&_imp->abortRequestedMutex);
+        ++_imp->abortRequested;
+        _imp->abortRequestedCond.wakeAll();
+    }
+
+}
+
+void
+TrackScheduler::quitThread()
+{
+    if (!isRunning()) {
+        return;
+    }
+
+    abortTracking();
+
+    {
+        QMutexLocker k(&_imp->mustQuitMutex);
+        _imp->mustQuit = true;
+
+        {
+            QMutexLocker k(&_imp->startRequesstMutex);
+            ++_imp->startRequests;
+            _imp->startRequestsCond.wakeAll();
+        }
+
+        while (_imp->mustQuit) {
+            _imp->mustQuitCond.wait(&_imp->mustQuitMutex);
+        }
+
+    }
+
+
+    wait();
+
+}
@@ -0,0 +1,97 @@
+//  Natron
+//
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef NATRON_ENGINE_TRACKSCHEDULER_H_
+#define NATRON_ENGINE_TRACKSCHEDULER_H_
+
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+
+#include <list>
+
+#include "Global/Macros.h"
+CLANG_DIAG_OFF(deprecated)
+CLANG_DIAG_OFF(uninitialized)
+#include <QtCore/QThread>
+CLANG_DIAG_ON(deprecated)
+CLANG_DIAG_ON(uninitialized)
+#if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
+#include <boost/scoped_ptr.hpp>
+#endif
+
+///The buttons of a track instance that track to the previous/next frame
+#define kTrackPreviousButtonName "trackPrevious"
+#define kTrackNextButtonName "trackNext"
+
+class Button_Knob;
+namespace Natron {
+class Node;
+}
+
+/**
+ * @brief Tracks the instances of a multi-instance tracker node over a frame range in a separate thread.
+ * Each frame, all the tracks are tracked in parallel using the global thread pool, while the tracker
+ * input that the next frame will need is rendered in the node cache.
+ * It does not need a user interface: the tracker panel and the Python API (Effect.track) both drive
+ * the scheduler of the tracker node.
+ **/
+struct TrackSchedulerPrivate;
+class TrackScheduler : public QThread
+{
+    Q_OBJECT
+
+public:
+
+    TrackScheduler(Natron::Node* tracker);
+
+    virtual ~TrackScheduler();
+
+    /**
+     * @brief Track the selectedInstances, calling the instance change action on each button (either the previous or
+     * next button) in a separate thread.
+     * @param start the first frame to track, if forward is true then start < end
+     * @param end the next frame after the last frame to track (a la STL iterators), if forward is true then end > start
+     **/
+    void track(int start,int end,bool forward,const std::list<Button_Knob*> & selectedInstances);
+
+    void abortTracking();
+
+    void quitThread();
+
+    bool isWorking() const;
+
+    /**
+     * @brief Blocks the calling thread until all the requested tracking is done.
+     * This must not be called from the main thread unless the application is in background mode.
+     **/
+    void waitForTrackingFinished();
+
+    /**
+     * @brief If enabled, the timeline is moved to each tracked frame so the viewer shows the tracking.
+     * This is never done in background mode.
+     **/
+    void setUpdateViewerOnTracking(bool update);
+
+    bool isUpdateViewerOnTrackingEnabled() const;
+
+Q_SIGNALS:
+
+    void trackingStarted();
+
+    void trackingFinished();
+
+    void progressUpdate(double progress);
+
+private:
+
+    virtual void run() OVERRIDE FINAL;
+
+    boost::scoped_ptr<TrackSchedulerPrivate> _imp;
+
+};
+
+#endif // NATRON_ENGINE_TRACKSCHEDULER_H_
@@ -394,6 +394,15 @@ enum DisplayChannelsEnum
     eDisplayChannelsA,
     eDisplayChannelsY
 };
+
+enum RenderPriorityEnum
+{
+    eRenderPriorityBackground = 0, ///< batch work that may be delayed indefinitely (e.g: cache pre-fill)
+    eRenderPriorityAnalysis, ///< histograms and other analysis of already rendered images
+    eRenderPriorityPreview, ///< node graph previews
+    eRenderPriorityViewer, ///< interactive viewer renders, these preempt everything else
+    eRenderPriorityCount
+};
     
 }
 Q_DECLARE_METATYPE(Natron::StandardButtons)
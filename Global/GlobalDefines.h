@@ -85,6 +85,13 @@ typedef OfxRangeD RangeD;
 
 #define kBgProcessServerCreatedShort "--bg_server_created"
 
+///these are used between a render worker and its coordinator, @see RenderWorker.h
+#define kRenderWorkerRequestShort "--worker_render"
+#define kRenderWorkerRequestDoneShort "--worker_done"
+#define kRenderWorkerRequestFailedShort "--worker_failed"
+#define kRenderWorkerRequestSequentialShort "--worker_sequential"
+#define kRenderWorkerQuitShort "--worker_quit"
+
 
 #define kNodeGraphObjectName "nodeGraph"
 #define kCurveEditorObjectName "curveEditor"
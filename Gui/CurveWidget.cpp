@@ -300,12 +300,17 @@ CurveGui::drawCurve(int curveIndex,
         return;
     }
     
+    ///First find all the points to draw, then evaluate the curve at all the points that are not keyframes at once
+    std::vector<double> evalX;
+    std::vector<int> evalVertex;
     std::pair<KeyFrame,bool> isX1AKey;
     while ( x1 < (w - 1) ) {
         double x,y;
         if (!isX1AKey.second) {
             x = _curveWidget->toZoomCoordinates(x1,0).x();
-            y = evaluate(x);
+            y = 0.;
+            evalX.push_back(x);
+            evalVertex.push_back( (int)vertices.size() + 1 );
         } else {
             x = isX1AKey.first.getTime();
             y = isX1AKey.first.getValue();
@@ -318,9 +323,15 @@ CurveGui::drawCurve(int curveIndex,
     //also add the last point
     {
         double x = _curveWidget->toZoomCoordinates(x1,0).x();
-        double y = evaluate(x);
+        evalX.push_back(x);
+        evalVertex.push_back( (int)vertices.size() + 1 );
         vertices.push_back( (float)x );
-        vertices.push_back( (float)y );
+        vertices.push_back( 0.f );
+    }
+    std::vector<double> evalY( evalX.size() );
+    evaluate( &evalX.front(), (int)evalX.size(), &evalY.front() );
+    for (U32 i = 0; i < evalY.size(); ++i) {
+        vertices[evalVertex[i]] = (float)evalY[i];
     }
     
     QPointF btmLeft = _curveWidget->toZoomCoordinates(0,_curveWidget->height() - 1);
@@ -485,6 +496,20 @@ CurveGui::evaluate(double x) const
     }
 }
 
+void
+CurveGui::evaluate(const double* x,
+                   int count,
+                   double* y) const
+{
+    // always running in the main thread
+    assert( qApp && qApp->thread() == QThread::currentThread() );
+    try {
+        getInternalCurve()->getValuesAt(x,count,y,false);
+    } catch (...) {
+        std::fill(y, y + count, 0.);
+    }
+}
+
 void
 CurveGui::setVisible(bool visible)
 {
@@ -667,6 +692,16 @@ BezierCPCurveGui::evaluate(double x) const
     }
 }
 
+void
+BezierCPCurveGui::evaluate(const double* x,
+                           int count,
+                           double* y) const
+{
+    for (int i = 0; i < count; ++i) {
+        y[i] = evaluate(x[i]);
+    }
+}
+
 std::pair<double,double>
 BezierCPCurveGui::getCurveYRange() const
 {
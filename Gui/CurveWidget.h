@@ -125,6 +125,11 @@ public:
      * The coordinates are those of the curve, not of the widget.
      **/
     virtual double evaluate(double x) const;
+
+    /**
+     * @brief Same as evaluate() for count x positions sorted in increasing order.
+     **/
+    virtual void evaluate(const double* x,int count,double* y) const;
     
     virtual boost::shared_ptr<Curve>  getInternalCurve() const;
 
@@ -237,6 +242,7 @@ public:
     boost::shared_ptr<Bezier> getBezier() const ;
     
     virtual double evaluate(double x) const;
+    virtual void evaluate(const double* x,int count,double* y) const;
     virtual std::pair<double,double> getCurveYRange() const;
 
     virtual bool areKeyFramesTimeClampedToIntegers() const { return true; }
@@ -26,6 +26,7 @@
 #include "Engine/ViewerInstance.h"
 #include "Engine/Lut.h"
 #include "Engine/Image.h"
+#include "Engine/OutputSchedulerThread.h"
 #include "Gui/ViewerGL.h"
 
 using std::cout; using std::endl;
@@ -195,6 +196,37 @@ InfoViewerWidget::setFps(double actualFps,
     if ( !_fpsLabel->isVisible() ) {
         _fpsLabel->show();
     }
+    refreshPlaybackStatisticsToolTip();
+}
+
+void
+InfoViewerWidget::setPlaybackStatistics(int /*droppedFrames*/,
+                                        int /*lateFrames*/)
+{
+    refreshPlaybackStatisticsToolTip();
+}
+
+void
+InfoViewerWidget::refreshPlaybackStatisticsToolTip()
+{
+    ViewerInstance* internalNode = viewer->getInternalNode();
+    RenderEngine* engine = internalNode ? internalNode->getRenderEngine() : 0;
+    if (!engine) {
+        _fpsLabel->setToolTip( QString() );
+        return;
+    }
+    PlaybackStatistics stats;
+    engine->getPlaybackStatistics(&stats);
+    QString tooltip = tr("%1 fps on average since the playback started (%2 fps requested).")
+                      .arg(stats.achievedFps, 0, 'f', 1)
+                      .arg(stats.desiredFps, 0, 'f', 1);
+    if ( (stats.droppedFrames > 0) || (stats.lateFrames > 0) ) {
+        tooltip.append('\n');
+        tooltip.append( tr("%1 frame(s) dropped and %2 frame(s) displayed late.")
+                        .arg(stats.droppedFrames)
+                        .arg(stats.lateFrames) );
+    }
+    _fpsLabel->setToolTip(tooltip);
 }
 
 void
@@ -67,6 +67,7 @@ public Q_SLOTS:
     void hideColorAndMouseInfo();
     void showColorAndMouseInfo();
     void setFps(double actualFps,double desiredFps);
+    void setPlaybackStatistics(int droppedFrames,int lateFrames);
     void hideFps();
 
 private:
@@ -74,6 +75,9 @@ private:
     virtual QSize sizeHint() const OVERRIDE FINAL;
     virtual QSize minimumSizeHint() const OVERRIDE FINAL;
     
+    ///Sets the tooltip of the fps label from the statistics of the current playback session
+    void refreshPlaybackStatisticsToolTip();
+    
 private:
     
 
@@ -151,6 +151,7 @@ KnobGui::KnobGui(boost::shared_ptr<KnobI> knob,
         QObject::connect( handler,SIGNAL( refreshGuiCurve(int)),this,SLOT( onRefreshGuiCurve(int) ) );
         QObject::connect( handler,SIGNAL( valueChanged(int,int) ),this,SLOT( onInternalValueChanged(int,int) ) );
         QObject::connect( handler,SIGNAL( keyFrameSet(SequenceTime,int,int,bool) ),this,SLOT( onInternalKeySet(SequenceTime,int,int,bool) ) );
+        QObject::connect( handler,SIGNAL( multipleKeyFramesSet(std::list<SequenceTime>,int,int) ),this,SLOT( onInternalMultipleKeysSet(std::list<SequenceTime>,int,int) ) );
         QObject::connect( handler,SIGNAL( keyFrameRemoved(SequenceTime,int,int) ),this,SLOT( onInternalKeyRemoved(SequenceTime,int,int) ) );
         QObject::connect( handler,SIGNAL( keyFrameMoved(int,int,int)), this, SLOT( onKeyFrameMoved(int,int,int)));
         QObject::connect( handler,SIGNAL( secretChanged() ),this,SLOT( setSecret() ) );
@@ -1217,6 +1218,21 @@ KnobGui::onInternalKeySet(SequenceTime time,
     updateCurveEditorKeyframes();
 }
 
+void
+KnobGui::onInternalMultipleKeysSet(std::list<SequenceTime> times,
+                                   int /*dimension*/,
+                                   int reason)
+{
+    if ((Natron::ValueChangedReasonEnum)reason != Natron::eValueChangedReasonUserEdited) {
+        boost::shared_ptr<KnobI> knob = getKnob();
+        if ( !knob->getIsSecret() && knob->isDeclaredByPlugin()) {
+            knob->getHolder()->getApp()->getTimeLine()->addMultipleKeyframeIndicatorsAdded(times, true);
+        }
+    }
+    
+    updateCurveEditorKeyframes();
+}
+
 void
 KnobGui::onInternalKeyRemoved(SequenceTime time,
                               int /*dimension*/,
@@ -1616,7 +1632,7 @@ KnobGui::linkTo(int dimension)
             thisKnob->endChanges();
 
 
-            thisKnob->getHolder()->getApp()->triggerAutoSave();
+            isEffect->getApp()->triggerAutoSave( isEffect->getNode() );
         }
     }
 }
@@ -217,6 +217,8 @@ public Q_SLOTS:
 
     void onInternalKeySet(SequenceTime time,int dimension,int reason,bool added);
 
+    void onInternalMultipleKeysSet(std::list<SequenceTime> times,int dimension,int reason);
+
     void onInternalKeyRemoved(SequenceTime time,int dimension,int reason);
 
     void onInternalAnimationAboutToBeRemoved();
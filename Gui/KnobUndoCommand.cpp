@@ -389,7 +389,7 @@ MultipleKnobEditsUndoCommand::redo()
         Natron::EffectInstance* effect = dynamic_cast<Natron::EffectInstance*>(holder);
         if (effect) {
             if (!firstRedoCalled) {
-                effect->getApp()->triggerAutoSave();
+                effect->getApp()->triggerAutoSave( effect->getNode() );
             }
             holderName = effect->getNode()->getLabel().c_str();
         }
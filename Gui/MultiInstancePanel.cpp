@@ -54,12 +54,11 @@ CLANG_DIAG_ON(uninitialized)
 #include "Engine/EffectInstance.h"
 #include "Engine/Curve.h"
 #include "Engine/TimeLine.h"
+#include "Engine/TrackScheduler.h"
 
 #include <ofxNatron.h>
 
 #define kTrackBackwardButtonName "trackBackward"
-#define kTrackPreviousButtonName "trackPrevious"
-#define kTrackNextButtonName "trackNext"
 #define kTrackForwardButtonName "trackForward"
 #define kTrackCenterName "center"
 #define kTrackInvertName "invert"
@@ -1588,9 +1587,6 @@ struct TrackerPanelPrivate
     TrackerPanel* publicInterface;
     Button* averageTracksButton;
     
-    mutable QMutex updateViewerMutex;
-    bool updateViewerOnTrackingEnabled;
-    
     QLabel* exportLabel;
     QWidget* exportContainer;
     QHBoxLayout* exportLayout;
@@ -1600,15 +1596,12 @@ struct TrackerPanelPrivate
     boost::shared_ptr<Int_Knob> referenceFrame;
 
     
-    TrackScheduler scheduler;
-
+    TrackScheduler* scheduler; //< owned by the tracker node
     
 
     TrackerPanelPrivate(TrackerPanel* publicInterface)
         : publicInterface(publicInterface)
           , averageTracksButton(0)
-          , updateViewerMutex()
-          , updateViewerOnTrackingEnabled(true)
           , exportLabel(0)
           , exportContainer(0)
           , exportLayout(0)
@@ -1616,7 +1609,7 @@ struct TrackerPanelPrivate
           , exportButton(0)
           , transformPage()
           , referenceFrame()
-          , scheduler(publicInterface)
+          , scheduler(0)
     {
     }
 
@@ -1631,14 +1624,18 @@ TrackerPanel::TrackerPanel(const boost::shared_ptr<NodeGui> & node)
     : MultiInstancePanel(node)
       , _imp( new TrackerPanelPrivate(this) )
 {
-    QObject::connect(&_imp->scheduler, SIGNAL(trackingStarted()), this, SLOT(onTrackingStarted()));
-    QObject::connect(&_imp->scheduler, SIGNAL(trackingFinished()), this, SLOT(onTrackingFinished()));
-    QObject::connect(&_imp->scheduler, SIGNAL(progressUpdate(double)), this, SLOT(onTrackingProgressUpdate(double)));
+    _imp->scheduler = node->getNode()->getTrackScheduler();
+    assert(_imp->scheduler);
+    QObject::connect(_imp->scheduler, SIGNAL(trackingStarted()), this, SLOT(onTrackingStarted()));
+    QObject::connect(_imp->scheduler, SIGNAL(trackingFinished()), this, SLOT(onTrackingFinished()));
+    QObject::connect(_imp->scheduler, SIGNAL(progressUpdate(double)), this, SLOT(onTrackingProgressUpdate(double)));
 }
 
 TrackerPanel::~TrackerPanel()
 {
-    _imp->scheduler.quitThread();
+    ///The scheduler thread is quit by the tracker node
+    _imp->scheduler->abortTracking();
+    QObject::disconnect(_imp->scheduler, 0, this, 0);
 }
 
 void
@@ -1850,22 +1847,6 @@ TrackerPanel::onButtonTriggered(Button_Knob* button)
     }
 }
 
-static void
-handleTrackNextAndPrevious(Button_Knob* selectedInstance,
-                           SequenceTime currentFrame)
-{
-//        ///When a reason of eValueChangedReasonUserEdited is given, the tracker plug-in will move the timeline so just send it
-//        ///upon the last track if we want to update the viewer
-//        Natron::ValueChangedReasonEnum reason;
-//        if (updateViewer) {
-//            reason = next == selectedInstances.end() ? eValueChangedReasonNatronGuiEdited : eValueChangedReasonNatronInternalEdited;
-//        } else {
-//            reason = eValueChangedReasonNatronInternalEdited;
-//        }
-        selectedInstance->getHolder()->onKnobValueChanged_public(selectedInstance,eValueChangedReasonNatronInternalEdited,currentFrame,
-                                                                 true);
-}
-
 void
 TrackerPanel::onTrackingStarted()
 {
@@ -1892,7 +1873,7 @@ TrackerPanel::onTrackingProgressUpdate(double progress)
 {
     if (getGui()) {
         if (!getGui()->progressUpdate(getMainInstance()->getLiveInstance(), progress)) {
-            _imp->scheduler.abortTracking();
+            _imp->scheduler->abortTracking();
         }
     }
 }
@@ -1942,7 +1923,7 @@ TrackerPanel::trackBackward()
     int end = leftBound - 1;
     int start = getApp()->getTimeLine()->currentFrame();
     
-    _imp->scheduler.track(start, end, false, instanceButtons);
+    _imp->scheduler->track(start, end, false, instanceButtons);
     
     return true;
 } // trackBackward
@@ -1964,7 +1945,7 @@ TrackerPanel::trackForward()
     int end = rightBound + 1;
     int start = timeline->currentFrame();
     
-    _imp->scheduler.track(start, end, true, instanceButtons);
+    _imp->scheduler->track(start, end, true, instanceButtons);
     
     return true;
 
@@ -1973,7 +1954,7 @@ TrackerPanel::trackForward()
 void
 TrackerPanel::stopTracking()
 {
-    _imp->scheduler.abortTracking();
+    _imp->scheduler->abortTracking();
 }
 
 bool
@@ -1997,7 +1978,7 @@ TrackerPanel::trackPrevious()
     int start = timeline->currentFrame();
     int end = start - 1;
     
-    _imp->scheduler.track(start, end, false, instanceButtons);
+    _imp->scheduler->track(start, end, false, instanceButtons);
 
     return true;
 }
@@ -2023,7 +2004,7 @@ TrackerPanel::trackNext()
     int start = timeline->currentFrame();
     int end = start + 1;
     
-    _imp->scheduler.track(start, end, true, instanceButtons);
+    _imp->scheduler->track(start, end, true, instanceButtons);
     
     return true;
 }
@@ -2081,15 +2062,13 @@ TrackerPanel::clearForwardAnimationForSelection()
 void
 TrackerPanel::setUpdateViewerOnTracking(bool update)
 {
-    QMutexLocker k(&_imp->updateViewerMutex);
-    _imp->updateViewerOnTrackingEnabled = update;
+    _imp->scheduler->setUpdateViewerOnTracking(update);
 }
 
 bool
 TrackerPanel::isUpdateViewerOnTrackingEnabled() const
 {
-    QMutexLocker k(&_imp->updateViewerMutex);
-    return _imp->updateViewerOnTrackingEnabled;
+    return _imp->scheduler->isUpdateViewerOnTrackingEnabled();
 }
 
 void
@@ -2285,264 +2264,3 @@ TrackerPanel::showMenuForInstance(Natron::Node* instance)
         centerKnob->copyAnimationToClipboard();
     }
 }
-
-
-struct TrackArgs
-{
-    int start,end;
-    bool forward;
-    std::list<Button_Knob*> instances;
-};
-
-struct TrackSchedulerPrivate
-{
-    const TrackerPanel* panel;
-    
-    QMutex argsMutex;
-    TrackArgs curArgs,requestedArgs;
-    
-    mutable QMutex mustQuitMutex;
-    bool mustQuit;
-    QWaitCondition mustQuitCond;
-    
-    mutable QMutex abortRequestedMutex;
-    int abortRequested;
-    QWaitCondition abortRequestedCond;
-    
-    QMutex startRequesstMutex;
-    int startRequests;
-    QWaitCondition startRequestsCond;
-    
-    mutable QMutex isWorkingMutex;
-    bool isWorking;
-    
-    
-    TrackSchedulerPrivate(const TrackerPanel* panel)
-    : panel(panel)
-    , argsMutex()
-    , curArgs()
-    , requestedArgs()
-    , mustQuitMutex()
-    , mustQuit(false)
-    , mustQuitCond()
-    , abortRequestedMutex()
-    , abortRequested(0)
-    , abortRequestedCond()
-    , startRequesstMutex()
-    , startRequests(0)
-    , startRequestsCond()
-    , isWorkingMutex()
-    , isWorking(false)
-    {
-        
-    }
-    
-    bool checkForExit()
-    {
-        QMutexLocker k(&mustQuitMutex);
-        if (mustQuit) {
-            mustQuit = false;
-            mustQuitCond.wakeAll();
-            return true;
-        }
-        return false;
-    }
-    
-};
-
-
-TrackScheduler::TrackScheduler(const TrackerPanel* panel)
-: QThread()
-, _imp(new TrackSchedulerPrivate(panel))
-{
-    setObjectName("TrackScheduler");
-}
-
-TrackScheduler::~TrackScheduler()
-{
-    
-}
-
-bool
-TrackScheduler::isWorking() const
-{
-    QMutexLocker k(&_imp->isWorkingMutex);
-    return _imp->isWorking;
-}
-
-void
-TrackScheduler::run()
-{
-    for (;;) {
-        
-        ///Check for exit of the thread
-        if (_imp->checkForExit()) {
-            return;
-        }
-        
-        ///Flag that we're working
-        {
-            QMutexLocker k(&_imp->isWorkingMutex);
-            _imp->isWorking = true;
-        }
-        
-        ///Copy the requested args to the args used for processing
-        {
-            QMutexLocker k(&_imp->argsMutex);
-            _imp->curArgs = _imp->requestedArgs;
-        }
-        
-        boost::shared_ptr<TimeLine> timeline = _imp->panel->getApp()->getTimeLine();
-
-        int end = _imp->curArgs.end;
-        int start = _imp->curArgs.start;
-        int cur = start;
-        
-        int framesCount = _imp->curArgs.forward ? (end - start) : (start - end);
-        
-        bool reportProgress = _imp->curArgs.instances.size() > 1 || framesCount > 1;
-        if (reportProgress) {
-            Q_EMIT trackingStarted();
-        }
-        
-        while (cur != end) {
-            
-            
-            ///Launch parallel thread for each track using the global thread pool
-            QtConcurrent::map(_imp->curArgs.instances,
-                              boost::bind(&handleTrackNextAndPrevious,
-                                          _1,
-                                          cur)).waitForFinished();
-            
-            
-            double progress;
-            if (_imp->curArgs.forward) {
-                ++cur;
-                progress = (double)(cur - start) / framesCount;
-            } else {
-                --cur;
-                progress = (double)(start - cur) / framesCount;
-            }
-            
-            ///Ok all tracks are finished now for this frame, refresh viewer if needed
-            bool updateViewer = _imp->panel->isUpdateViewerOnTrackingEnabled();
-            if (updateViewer) {
-                timeline->seekFrame(cur, true, 0, Natron::eTimelineChangeReasonPlaybackSeek);
-            }
-
-            if (reportProgress) {
-                ///Notify we progressed of 1 frame
-                Q_EMIT progressUpdate(progress);
-            }
-            
-            ///Check for abortion
-            {
-                QMutexLocker k(&_imp->abortRequestedMutex);
-                if (_imp->abortRequested > 0) {
-                    _imp->abortRequested = 0;
-                    _imp->abortRequestedCond.wakeAll();
-                    break;
-                }
-            }
-
-        }
-        
-        if (reportProgress) {
-            Q_EMIT trackingFinished();
-        }
-        
-        ///Flag that we're no longer working
-        {
-            QMutexLocker k(&_imp->isWorkingMutex);
-            _imp->isWorking = false;
-        }
-        
-        ///Make sure we really reset the abort flag
-        {
-            QMutexLocker k(&_imp->abortRequestedMutex);
-            if (_imp->abortRequested > 0) {
-                _imp->abortRequested = 0;
-                
-            }
-        }
-        
-        ///Sleep or restart if we've requests in the queue
-        {
-            QMutexLocker k(&_imp->startRequesstMutex);
-            while (_imp->startRequests <= 0) {
-                _imp->startRequestsCond.wait(&_imp->startRequesstMutex);
-            }
-            _imp->startRequests = 0;
-        }
-        
-    }
-}
-
-void
-TrackScheduler::track(int startingFrame,int end,bool forward, const std::list<Button_Knob*> & selectedInstances)
-{
-    if ((forward && startingFrame >= end) || (!forward && startingFrame <= end)) {
-        Q_EMIT trackingFinished();
-        return;
-    }
-    {
-        QMutexLocker k(&_imp->argsMutex);
-        _imp->requestedArgs.start = startingFrame;
-        _imp->requestedArgs.end = end;
-        _imp->requestedArgs.forward = forward;
-        _imp->requestedArgs.instances = selectedInstances;
-    }
-    if (isRunning()) {
-        QMutexLocker k(&_imp->startRequesstMutex);
-        ++_imp->startRequests;
-        _imp->startRequestsCond.wakeAll();
-    } else {
-        start();
-    }
-}
-
-
-void TrackScheduler::abortTracking()
-{
-    if (!isRunning() || !isWorking()) {
-        return;
-    }
-    
-    
-    {
-        QMutexLocker k(&_imp->abortRequestedMutex);
-        ++_imp->abortRequested;
-        _imp->abortRequestedCond.wakeAll();
-    }
-    
-}
-
-void
-TrackScheduler::quitThread()
-{
-    if (!isRunning()) {
-        return;
-    }
-    
-    abortTracking();
-    
-    {
-        QMutexLocker k(&_imp->mustQuitMutex);
-        _imp->mustQuit = true;
-
-        {
-            QMutexLocker k(&_imp->startRequesstMutex);
-            ++_imp->startRequests;
-            _imp->startRequestsCond.wakeAll();
-        }
-        
-        while (_imp->mustQuit) {
-            _imp->mustQuitCond.wait(&_imp->mustQuitMutex);
-        }
-
-    }
-
-    
-    wait();
-    
-}
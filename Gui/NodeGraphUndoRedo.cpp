@@ -492,7 +492,7 @@ ConnectCommand::doConnect(const boost::shared_ptr<Natron::Node> &oldSrc,
     
     ViewerInstance* isDstAViewer = dynamic_cast<ViewerInstance*>(internalDst->getLiveInstance() );
     if (!isDstAViewer) {
-        _graph->getGui()->getApp()->triggerAutoSave();
+        _graph->getGui()->getApp()->triggerAutoSave(internalDst);
     }
 
 }
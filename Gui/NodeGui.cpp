@@ -16,12 +16,12 @@
 
 #include <cassert>
 #include <boost/scoped_array.hpp>
+#include <boost/bind.hpp>
 
 CLANG_DIAG_OFF(deprecated)
 CLANG_DIAG_OFF(uninitialized)
 #include <QLayout>
 #include <QAction>
-#include <QtConcurrentRun>
 #include <QFontMetrics>
 #include <QMenu>
 #include <QTextDocument> // for Qt::convertFromPlainText
@@ -67,6 +67,7 @@ CLANG_DIAG_ON(uninitialized)
 #include "Engine/Plugin.h"
 #include "Engine/BackDrop.h"
 #include "Engine/Knob.h"
+#include "Engine/RenderScheduler.h"
 #define NATRON_STATE_INDICATOR_OFFSET 5
 
 #define NATRON_EDGE_DROP_TOLERANCE 15
@@ -225,6 +226,11 @@ NodeGui::NodeGui(QGraphicsItem *parent)
 
 NodeGui::~NodeGui()
 {
+    ///Drop the previews still queued for this node
+    NodePtr node = _internalNode.lock();
+    if (node) {
+        appPTR->getRenderScheduler()->cancelAllRequests( node.get() );
+    }
     deleteReferences();
 
     delete _bitDepthWarning;
@@ -1024,7 +1030,11 @@ NodeGui::updatePreviewImage(int time)
         
         ensurePreviewCreated();
 
-        QtConcurrent::run(this,&NodeGui::computePreviewImage,time);
+        ///A newer preview request for this node replaces any pending one, and requests made with
+        ///an older hash are dropped by the scheduler when the hash changes
+        appPTR->getRenderScheduler()->schedule(Natron::eRenderPriorityPreview, node.get(), node->getHashValue(), true,
+                                               boost::bind(&NodeGui::computePreviewImageIfAlive,
+                                                           boost::weak_ptr<NodeGui>( shared_from_this() ),time));
     }
 }
 
@@ -1041,7 +1051,22 @@ NodeGui::forceComputePreview(int time)
         
         ensurePreviewCreated();
 
-        QtConcurrent::run(this,&NodeGui::computePreviewImage,time);
+        ///A newer preview request for this node replaces any pending one, and requests made with
+        ///an older hash are dropped by the scheduler when the hash changes
+        appPTR->getRenderScheduler()->schedule(Natron::eRenderPriorityPreview, node.get(), node->getHashValue(), true,
+                                               boost::bind(&NodeGui::computePreviewImageIfAlive,
+                                                           boost::weak_ptr<NodeGui>( shared_from_this() ),time));
+    }
+}
+
+void
+NodeGui::computePreviewImageIfAlive(const boost::weak_ptr<NodeGui>& gui,
+                                    int time)
+{
+    ///The node may have been deleted while the request was queued
+    boost::shared_ptr<NodeGui> isAlive = gui.lock();
+    if (isAlive) {
+        isAlive->computePreviewImage(time);
     }
 }
 
@@ -2548,7 +2573,7 @@ NodeGui::onSwitchInputActionTriggered()
         for (std::list<ViewerInstance* >::iterator it = viewers.begin(); it != viewers.end(); ++it) {
             (*it)->renderCurrentFrame(true);
         }
-        node->getApp()->triggerAutoSave();
+        node->getApp()->triggerAutoSave(node);
     }
 }
 
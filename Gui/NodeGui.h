@@ -487,6 +487,11 @@ private:
     
     void setAboveItem(QGraphicsItem* item);
 
+    /**
+     * @brief The preview requests queued in the RenderScheduler only hold a weak reference to the NodeGui.
+     **/
+    static void computePreviewImageIfAlive(const boost::weak_ptr<NodeGui>& gui,int time);
+
     void computePreviewImage(int time);
 
     void populateMenu();
@@ -868,7 +868,7 @@ RotoGui::drawOverlays(double /*scaleX*/,
             // then check if the bbox is visible
             // if the bbox is visible, compute the polygon and draw it.
             std::list< Point > points;
-            (*it)->evaluateAtTime_DeCasteljau(time,0, 100, &points, NULL);
+            (*it)->evaluateAtTime_DeCasteljau(time, 0, &points, NULL);
             
             bool locked = (*it)->isLockedRecursive();
             double curveColor[4];
@@ -900,7 +900,7 @@ RotoGui::drawOverlays(double /*scaleX*/,
                 // It should first compute the bbox (this is cheap)
                 // then check if the bbox is visible
                 // if the bbox is visible, compute the polygon and draw it.
-                (*it)->evaluateFeatherPointsAtTime_DeCasteljau(time,0, 100, true, &featherPoints, &featherBBox);
+                (*it)->evaluateFeatherPointsAtTime_DeCasteljau(time, 0, &featherPoints, &featherBBox);
                 
                 if ( !featherPoints.empty() ) {
                     glLineStipple(2, 0xAAAA);
@@ -2316,7 +2316,7 @@ RotoGui::moveSelectedCpsWithKeyArrows(int x,
                                                           (double)y * pixelScale.second,time) );
         _imp->computeSelectedCpsBBOX();
         _imp->context->evaluateChange();
-        _imp->node->getNode()->getApp()->triggerAutoSave();
+        _imp->node->getNode()->getApp()->triggerAutoSave( _imp->node->getNode() );
         _imp->viewerTab->onRotoEvaluatedForThisViewer();
     }
 }
@@ -2328,7 +2328,7 @@ RotoGui::evaluate(bool redraw)
         _imp->viewer->redraw();
     }
     _imp->context->evaluateChange();
-    _imp->node->getNode()->getApp()->triggerAutoSave();
+    _imp->node->getNode()->getApp()->triggerAutoSave( _imp->node->getNode() );
     _imp->viewerTab->onRotoEvaluatedForThisViewer();
 }
 
@@ -2336,7 +2336,7 @@ void
 RotoGui::autoSaveAndRedraw()
 {
     _imp->viewer->redraw();
-    _imp->node->getNode()->getApp()->triggerAutoSave();
+    _imp->node->getNode()->getApp()->triggerAutoSave( _imp->node->getNode() );
 }
 
 bool
@@ -2348,7 +2348,7 @@ RotoGui::penUp(double /*scaleX*/,
 {
     if (_imp->evaluateOnPenUp) {
         _imp->context->evaluateChange();
-        _imp->node->getNode()->getApp()->triggerAutoSave();
+        _imp->node->getNode()->getApp()->triggerAutoSave( _imp->node->getNode() );
 
         //sync other viewers linked to this roto
         _imp->viewerTab->onRotoEvaluatedForThisViewer();
@@ -2553,7 +2553,7 @@ RotoGui::keyUp(double /*scaleX*/,
 
     if (_imp->evaluateOnKeyUp) {
         _imp->context->evaluateChange();
-        _imp->node->getNode()->getApp()->triggerAutoSave();
+        _imp->node->getNode()->getApp()->triggerAutoSave( _imp->node->getNode() );
         _imp->viewerTab->onRotoEvaluatedForThisViewer();
         _imp->evaluateOnKeyUp = false;
     }
@@ -2911,7 +2911,7 @@ RotoGui::RotoGuiPrivate::isNearbyFeatherBar(int time,
                            std::numeric_limits<double>::infinity(),
                            -std::numeric_limits<double>::infinity(),
                            -std::numeric_limits<double>::infinity() );
-        (*it)->evaluateFeatherPointsAtTime_DeCasteljau(time, 0, 50, true, &polygon, &polygonBBox);
+        (*it)->evaluateFeatherPointsAtTime_DeCasteljau(time, 0, &polygon, &polygonBBox);
 
         std::list<boost::shared_ptr<BezierCP> >::const_iterator itF = fps.begin();
         std::list<boost::shared_ptr<BezierCP> >::const_iterator nextF = itF;
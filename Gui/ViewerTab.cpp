@@ -3303,10 +3303,14 @@ ViewerTab::manageSlotsForInfoWidget(int textureIndex,
     assert(engine);
     if (connect) {
         QObject::connect( engine, SIGNAL( fpsChanged(double,double) ), _imp->infoWidget[textureIndex], SLOT( setFps(double,double) ) );
+        QObject::connect( engine, SIGNAL( playbackStatisticsChanged(int,int) ), _imp->infoWidget[textureIndex],
+                          SLOT( setPlaybackStatistics(int,int) ) );
         QObject::connect( engine,SIGNAL( renderFinished(int) ),_imp->infoWidget[textureIndex],SLOT( hideFps() ) );
     } else {
         QObject::disconnect( engine, SIGNAL( fpsChanged(double,double) ), _imp->infoWidget[textureIndex],
                             SLOT( setFps(double,double) ) );
+        QObject::disconnect( engine, SIGNAL( playbackStatisticsChanged(int,int) ), _imp->infoWidget[textureIndex],
+                             SLOT( setPlaybackStatistics(int,int) ) );
         QObject::disconnect( engine,SIGNAL( renderFinished(int) ),_imp->infoWidget[textureIndex],SLOT( hideFps() ) );
     }
 }
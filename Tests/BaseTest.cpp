@@ -241,3 +241,24 @@ TEST_F(BaseTest,SimpleNodeConnections) {
     disconnectNodes(generator, writer, false);
     connectNodes(generator, writer, 0, true);
 }
+
+///Nodes are found by name after being created and renamed
+TEST_F(BaseTest,NodeLookupByName) {
+    boost::shared_ptr<Node> generator = createNode(_dotGeneratorPluginID);
+    boost::shared_ptr<Node> writer = createNode(_writeOIIOPluginID);
+    boost::shared_ptr<Project> project = _app->getProject();
+
+    std::string generatorName = generator->getScriptName();
+    EXPECT_EQ( generator, project->getNodeByName(generatorName) );
+    EXPECT_EQ( writer, project->getNodeByName( writer->getScriptName() ) );
+    EXPECT_EQ( writer, project->getNodeByFullySpecifiedName( writer->getScriptName() ) );
+
+    ///A name already taken is refused
+    EXPECT_FALSE( generator->setScriptName( writer->getScriptName() ) );
+
+    ASSERT_TRUE( generator->setScriptName("RenamedGenerator") );
+    EXPECT_EQ( generator, project->getNodeByName("RenamedGenerator") );
+    EXPECT_EQ( (Natron::Node*)NULL, project->getNodeByName(generatorName).get() );
+    EXPECT_TRUE( project->checkIfNodeNameExists("RenamedGenerator", writer.get()) );
+    EXPECT_FALSE( project->checkIfNodeNameExists("RenamedGenerator", generator.get()) );
+}
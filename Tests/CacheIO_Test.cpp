@@ -0,0 +1,107 @@
+//  Natron
+//
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include <QtCore/QDir>
+
+#include "Engine/CacheIO.h"
+#include "Engine/MemoryFile.h"
+
+using namespace Natron;
+
+namespace {
+std::string
+tmpFilePath(const char* name)
+{
+    return QDir::temp().absoluteFilePath( QString(name) ).toStdString();
+}
+
+char*
+allocatePattern(std::size_t size,
+                char seed)
+{
+    char* data = (char*)allocateLazilyCommittedMemory(size);
+
+    for (std::size_t i = 0; i < size; ++i) {
+        data[i] = (char)(seed + i);
+    }
+
+    return data;
+}
+}
+
+TEST(CacheIO,WrittenDataIsReadBack)
+{
+    std::string path = tmpFilePath("NatronCacheIOTest1.tmp");
+    std::remove( path.c_str() );
+    ASSERT_TRUE( CacheIO::createFile(path) );
+    EXPECT_FALSE( CacheIO::createFile(path) );
+
+    const std::size_t size = 3 * 1024 * 1024 + 17;
+    char* expected = allocatePattern(size, 3);
+    CacheIO::PendingWritePtr write = CacheIO::queueWrite(path, allocatePattern(size, 3), size);
+    EXPECT_TRUE( CacheIO::waitForWrite(write) );
+    EXPECT_FALSE( CacheIO::isWritePending(write) );
+
+    ///The write is done: there is nothing to reclaim, the data is in the file
+    EXPECT_TRUE(CacheIO::reclaimWrite(write) == 0);
+
+    std::size_t readSize = 0;
+    char* data = (char*)CacheIO::readFile(path, &readSize);
+    ASSERT_TRUE(data != 0);
+    EXPECT_EQ(size, readSize);
+    EXPECT_EQ( 0, std::memcmp(data, expected, size) );
+
+    freeLazilyCommittedMemory(data, readSize);
+    freeLazilyCommittedMemory(expected, size);
+    std::remove( path.c_str() );
+}
+
+TEST(CacheIO,QueuedWritesCanBeReclaimed)
+{
+    std::string path = tmpFilePath("NatronCacheIOTest2.tmp");
+    std::remove( path.c_str() );
+
+    const std::size_t size = 1024 * 1024;
+    CacheIO::StatsRecorder recorder;
+    CacheIO::PendingWritePtr write = CacheIO::queueWrite(path, allocatePattern(size, 7), size);
+    void* data = CacheIO::reclaimWrite(write);
+    if (data) {
+        ///The write did not start: we got our data back and nothing was written
+        EXPECT_EQ( (char)7, ((char*)data)[0] );
+        EXPECT_EQ( (char)(7 + 1000), ((char*)data)[1000] );
+        freeLazilyCommittedMemory(data, size);
+    } else {
+        std::size_t readSize = 0;
+        data = CacheIO::readFile(path, &readSize);
+        ASSERT_TRUE(data != 0);
+        EXPECT_EQ( (char)(7 + 1000), ((char*)data)[1000] );
+        freeLazilyCommittedMemory(data, readSize);
+    }
+    EXPECT_FALSE( CacheIO::isWritePending(write) );
+
+    CacheIO::Stats stats;
+    recorder.getStats(&stats);
+    EXPECT_EQ(0, stats.queueDepth);
+    EXPECT_EQ( (U64)1, stats.writes + stats.reclaimedWrites );
+    std::remove( path.c_str() );
+}
+
+TEST(CacheIO,MissingFileIsNotRead)
+{
+    std::size_t size = 1;
+    EXPECT_TRUE(CacheIO::readFile(tmpFilePath("NatronCacheIOTestMissing.tmp"), &size) == 0);
+    EXPECT_EQ( (std::size_t)0, size );
+}
@@ -8,6 +8,10 @@
 // "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
 #include <Python.h>
 
+#include <algorithm>
+#include <list>
+#include <vector>
+
 #include <gtest/gtest.h>
 
 #include <QString>
@@ -105,3 +109,67 @@ TEST(Curve,Basic)
 }
 
 
+
+TEST(Curve,GetValuesAt)
+{
+    Curve c;
+
+    EXPECT_TRUE( c.addKeyFrame( KeyFrame(0.,10.,0.,0.,Natron::eKeyframeTypeSmooth) ) );
+    EXPECT_TRUE( c.addKeyFrame( KeyFrame(10.,20.,0.,0.,Natron::eKeyframeTypeLinear) ) );
+    EXPECT_TRUE( c.addKeyFrame( KeyFrame(15.,-5.,0.,0.,Natron::eKeyframeTypeConstant) ) );
+    EXPECT_TRUE( c.addKeyFrame( KeyFrame(30.,40.,0.,0.,Natron::eKeyframeTypeCatmullRom) ) );
+
+    // from before the first keyframe to after the last keyframe, some times falling exactly on keyframes
+    const int count = 201;
+    std::vector<double> values(count);
+    c.getValuesAt(-10., 0.25, count, &values.front());
+    for (int i = 0; i < count; ++i) {
+        EXPECT_EQ( c.getValueAt(-10. + i * 0.25), values[i] );
+    }
+
+    // arbitrary sorted times, with several segments without any time
+    const double times[] = { -3., 0., 0., 2.5, 29.9, 30., 100. };
+    const int nTimes = sizeof(times) / sizeof(times[0]);
+    double timesValues[nTimes];
+    c.getValuesAt(times, nTimes, timesValues);
+    for (int i = 0; i < nTimes; ++i) {
+        EXPECT_EQ( c.getValueAt(times[i]), timesValues[i] );
+    }
+}
+
+TEST(Curve,AddKeyFrames)
+{
+    Curve c;
+    Curve expected;
+
+    EXPECT_TRUE( c.addKeyFrame( KeyFrame(5.,1.,0.,0.,Natron::eKeyframeTypeSmooth) ) );
+    EXPECT_TRUE( expected.addKeyFrame( KeyFrame(5.,1.,0.,0.,Natron::eKeyframeTypeSmooth) ) );
+
+    // unsorted, replacing the keyframe at 5 and interleaved with it
+    std::vector<KeyFrame> keys;
+    keys.push_back( KeyFrame(20.,-3.,0.,0.,Natron::eKeyframeTypeCatmullRom) );
+    keys.push_back( KeyFrame(0.,10.,0.,0.,Natron::eKeyframeTypeSmooth) );
+    keys.push_back( KeyFrame(5.,7.,0.,0.,Natron::eKeyframeTypeSmooth) );
+    keys.push_back( KeyFrame(12.,4.,0.,0.,Natron::eKeyframeTypeCubic) );
+    std::list<double> added;
+    c.addKeyFrames(keys, &added);
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+        ignore_result( expected.addKeyFrame(keys[i]) );
+    }
+
+    EXPECT_EQ( (std::size_t)3, added.size() );
+    EXPECT_TRUE( std::find(added.begin(), added.end(), 5.) == added.end() );
+    ASSERT_EQ( expected.getKeyFramesCount(), c.getKeyFramesCount() );
+    for (int i = 0; i < c.getKeyFramesCount(); ++i) {
+        KeyFrame k, e;
+        EXPECT_TRUE( c.getKeyFrameWithIndex(i, &k) );
+        EXPECT_TRUE( expected.getKeyFrameWithIndex(i, &e) );
+        EXPECT_EQ( e.getTime(), k.getTime() );
+        EXPECT_EQ( e.getValue(), k.getValue() );
+        EXPECT_DOUBLE_EQ( e.getLeftDerivative(), k.getLeftDerivative() );
+        EXPECT_DOUBLE_EQ( e.getRightDerivative(), k.getRightDerivative() );
+    }
+    for (double t = -5.; t < 25.; t += 0.5) {
+        EXPECT_DOUBLE_EQ( expected.getValueAt(t), c.getValueAt(t) );
+    }
+}
@@ -0,0 +1,315 @@
+//  Natron
+//
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+
+#include <cstring>
+#include <list>
+
+#include <gtest/gtest.h>
+
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+
+#include "Engine/DiskCacheNodeStorage.h"
+#include "Engine/Image.h"
+#include "Engine/ImageKey.h"
+
+using namespace Natron;
+
+namespace {
+QString
+emptyStorageDirectory(const char* name)
+{
+    QString directory = QDir::temp().absoluteFilePath( QString(name) );
+    DiskCacheNodeStorage storage;
+
+    storage.setDirectory(directory);
+    storage.clear();
+
+    return directory;
+}
+
+QString
+dataFilePath(const QString& directory)
+{
+    return directory + QDir::separator() + "frames.data";
+}
+
+QString
+indexFilePath(const QString& directory)
+{
+    return directory + QDir::separator() + "frames.index";
+}
+
+///A smooth gradient compresses well, noise does not compress at all
+boost::shared_ptr<Image>
+makeImage(int width,
+          int height,
+          float seed,
+          bool noise)
+{
+    RectI bounds(0, 0, width, height);
+    RectD rod(0, 0, width, height);
+    boost::shared_ptr<Image> image( new Image(eImageComponentRGBA, rod, bounds, 0, 1., eImageBitDepthFloat) );
+    unsigned int state = (unsigned int)(seed * 1000) + 1;
+
+    for (int y = bounds.y1; y < bounds.y2; ++y) {
+        float* pix = (float*)image->pixelAt(bounds.x1, y);
+        for (int x = bounds.x1; x < bounds.x2; ++x) {
+            for (int c = 0; c < 4; ++c, ++pix) {
+                if (noise) {
+                    state = state * 1664525u + 1013904223u;
+                    *pix = (float)state / 4294967296.f;
+                } else {
+                    *pix = seed + x * 0.001f + y * 0.01f + c;
+                }
+            }
+        }
+    }
+
+    return image;
+}
+
+ImageKey
+makeKey(U64 hash,
+        SequenceTime time)
+{
+    return ImageKey(hash, true, time, 0);
+}
+
+void
+expectSameImage(const boost::shared_ptr<Image>& expected,
+                const std::list<boost::shared_ptr<Image> >& images)
+{
+    ASSERT_EQ( (std::size_t)1, images.size() );
+    const boost::shared_ptr<Image>& image = images.front();
+    RectI bounds = expected->getBounds();
+    ASSERT_EQ( bounds, image->getBounds() );
+    EXPECT_EQ( expected->getComponents(), image->getComponents() );
+    EXPECT_EQ( expected->getBitDepth(), image->getBitDepth() );
+    std::size_t rowSize = expected->getRowElements() * sizeof(float);
+    for (int y = bounds.y1; y < bounds.y2; ++y) {
+        ASSERT_EQ( 0, std::memcmp(expected->pixelAt(bounds.x1, y), image->pixelAt(bounds.x1, y), rowSize) ) << "row " << y;
+    }
+}
+}
+
+TEST(DiskCacheNodeStorage,FramesAreReadBack)
+{
+    QString directory = emptyStorageDirectory("NatronDiskCacheNodeStorageTest1");
+    DiskCacheNodeStorage storage;
+    storage.setDirectory(directory);
+
+    ///The height is not a multiple of the rows compressed together
+    boost::shared_ptr<Image> image = makeImage(100, 70, 0.5f, false);
+    ASSERT_TRUE( storage.store(1, 3, 0, image, false) );
+
+    std::list<boost::shared_ptr<Image> > images;
+    storage.get(makeKey(1, 3), 0, false, &images);
+    expectSameImage(image, images);
+
+    ///The compression is lossless and smooth images take less room than their pixels
+    EXPECT_LT( QFileInfo( dataFilePath(directory) ).size(), (qint64)image->dataSize() );
+
+    EXPECT_TRUE( storage.hasFrame(1, 3, 0, 0, false) );
+    EXPECT_FALSE( storage.hasFrame(1, 4, 0, 0, false) );
+
+    ///Frames rendered with another hash are only returned when ignoring the hash
+    EXPECT_FALSE( storage.hasFrame(2, 3, 0, 0, false) );
+    EXPECT_TRUE( storage.hasFrame(2, 3, 0, 0, true) );
+    images.clear();
+    storage.get(makeKey(2, 3), 0, false, &images);
+    EXPECT_TRUE( images.empty() );
+    storage.get(makeKey(2, 3), 0, true, &images);
+    EXPECT_EQ( (std::size_t)1, images.size() );
+
+    storage.clear();
+    EXPECT_FALSE( storage.hasFrame(1, 3, 0, 0, false) );
+    EXPECT_FALSE( QFile::exists( dataFilePath(directory) ) );
+}
+
+TEST(DiskCacheNodeStorage,IndexIsReloaded)
+{
+    QString directory = emptyStorageDirectory("NatronDiskCacheNodeStorageTest2");
+    boost::shared_ptr<Image> first = makeImage(64, 64, 1.f, false);
+    boost::shared_ptr<Image> second = makeImage(64, 64, 2.f, false);
+    boost::shared_ptr<Image> replacement = makeImage(64, 64, 3.f, false);
+    {
+        DiskCacheNodeStorage storage;
+        storage.setDirectory(directory);
+        ASSERT_TRUE( storage.store(1, 1, 0, first, false) );
+        ASSERT_TRUE( storage.store(1, 2, 0, second, false) );
+        ASSERT_TRUE( storage.store(1, 1, 0, replacement, false) );
+    }
+
+    ///Later records replace earlier ones for the same frame
+    DiskCacheNodeStorage storage;
+    storage.setDirectory(directory);
+    std::list<boost::shared_ptr<Image> > images;
+    storage.get(makeKey(1, 1), 0, false, &images);
+    expectSameImage(replacement, images);
+    images.clear();
+    storage.get(makeKey(1, 2), 0, false, &images);
+    expectSameImage(second, images);
+
+    storage.clear();
+}
+
+TEST(DiskCacheNodeStorage,TruncatedIndexRecordIsDropped)
+{
+    QString directory = emptyStorageDirectory("NatronDiskCacheNodeStorageTest3");
+    boost::shared_ptr<Image> first = makeImage(64, 64, 1.f, false);
+    boost::shared_ptr<Image> second = makeImage(64, 64, 2.f, false);
+    boost::shared_ptr<Image> third = makeImage(64, 64, 3.f, false);
+    {
+        DiskCacheNodeStorage storage;
+        storage.setDirectory(directory);
+        ASSERT_TRUE( storage.store(1, 1, 0, first, false) );
+        ASSERT_TRUE( storage.store(1, 2, 0, second, false) );
+    }
+
+    ///As if the process crashed while writing the record of the second frame
+    qint64 indexSize = QFileInfo( indexFilePath(directory) ).size();
+    ASSERT_TRUE( QFile::resize(indexFilePath(directory), indexSize - 3) );
+    {
+        DiskCacheNodeStorage storage;
+        storage.setDirectory(directory);
+        EXPECT_TRUE( storage.hasFrame(1, 1, 0, 0, false) );
+        EXPECT_FALSE( storage.hasFrame(1, 2, 0, 0, false) );
+
+        ///The next records are appended after the last valid one
+        ASSERT_TRUE( storage.store(1, 3, 0, third, false) );
+    }
+
+    DiskCacheNodeStorage storage;
+    storage.setDirectory(directory);
+    std::list<boost::shared_ptr<Image> > images;
+    storage.get(makeKey(1, 1), 0, false, &images);
+    expectSameImage(first, images);
+    images.clear();
+    storage.get(makeKey(1, 3), 0, false, &images);
+    expectSameImage(third, images);
+
+    storage.clear();
+}
+
+TEST(DiskCacheNodeStorage,CorruptedDataIsNotReturned)
+{
+    QString directory = emptyStorageDirectory("NatronDiskCacheNodeStorageTest4");
+    boost::shared_ptr<Image> first = makeImage(64, 64, 1.f, false);
+    boost::shared_ptr<Image> second = makeImage(64, 64, 2.f, false);
+    qint64 firstFrameEnd;
+    {
+        DiskCacheNodeStorage storage;
+        storage.setDirectory(directory);
+        ASSERT_TRUE( storage.store(1, 1, 0, first, false) );
+        firstFrameEnd = QFileInfo( dataFilePath(directory) ).size();
+        ASSERT_TRUE( storage.store(1, 2, 0, second, false) );
+    }
+
+    ///Overwrite the compressed data of the second frame
+    {
+        QFile dataFile( dataFilePath(directory) );
+        ASSERT_TRUE( dataFile.open(QIODevice::ReadWrite) );
+        ASSERT_TRUE( dataFile.seek(firstFrameEnd + 20) );
+        QByteArray garbage(16, (char)0xA5);
+        ASSERT_EQ( garbage.size(), dataFile.write(garbage) );
+    }
+    {
+        DiskCacheNodeStorage storage;
+        storage.setDirectory(directory);
+        std::list<boost::shared_ptr<Image> > images;
+        storage.get(makeKey(1, 2), 0, false, &images);
+        EXPECT_TRUE( images.empty() );
+        storage.get(makeKey(1, 1), 0, false, &images);
+        expectSameImage(first, images);
+    }
+
+    ///Records referencing data past the end of the data file are dropped
+    ASSERT_TRUE( QFile::resize(dataFilePath(directory), firstFrameEnd - 1) );
+    DiskCacheNodeStorage storage;
+    storage.setDirectory(directory);
+    EXPECT_FALSE( storage.hasFrame(1, 1, 0, 0, false) );
+    EXPECT_FALSE( storage.hasFrame(1, 2, 0, 0, false) );
+
+    storage.clear();
+}
+
+TEST(DiskCacheNodeStorage,ReplacedFramesAreCompacted)
+{
+    QString directory = emptyStorageDirectory("NatronDiskCacheNodeStorageTest5");
+    DiskCacheNodeStorage storage;
+    storage.setDirectory(directory);
+
+    ///Noise does not compress: each 512x512 RGBA float frame takes 4MiB in the data file
+    boost::shared_ptr<Image> image;
+    const int replacements = 20;
+    qint64 frameSize = 0;
+    for (int i = 0; i < replacements; ++i) {
+        image = makeImage(512, 512, (float)i, true);
+        ASSERT_TRUE( storage.store(1, 1, 0, image, false) );
+        if (i == 0) {
+            frameSize = QFileInfo( dataFilePath(directory) ).size();
+        }
+    }
+
+    ///Without compaction the data file would hold all the replaced frames
+    qint64 dataSize = QFileInfo( dataFilePath(directory) ).size();
+    EXPECT_LT(dataSize, frameSize * replacements / 2);
+    EXPECT_FALSE( QFile::exists( dataFilePath(directory) + ".tmp" ) );
+
+    std::list<boost::shared_ptr<Image> > images;
+    storage.get(makeKey(1, 1), 0, false, &images);
+    expectSameImage(image, images);
+
+    ///The compacted index is valid
+    DiskCacheNodeStorage reloaded;
+    reloaded.setDirectory(directory);
+    images.clear();
+    reloaded.get(makeKey(1, 1), 0, false, &images);
+    expectSameImage(image, images);
+
+    storage.clear();
+}
+
+TEST(DiskCacheNodeStorage,CopyKeepsTheOriginalFrames)
+{
+    QString original = emptyStorageDirectory("NatronDiskCacheNodeStorageTest6a");
+    QString copy = emptyStorageDirectory("NatronDiskCacheNodeStorageTest6b");
+    QString moved = emptyStorageDirectory("NatronDiskCacheNodeStorageTest6c");
+    boost::shared_ptr<Image> image = makeImage(64, 64, 1.f, false);
+
+    DiskCacheNodeStorage storage;
+    storage.setDirectory(original);
+    ASSERT_TRUE( storage.store(1, 1, 0, image, false) );
+
+    ///e.g: the project was saved under another name, the original project keeps its frames
+    storage.copyToDirectory(copy);
+    EXPECT_EQ( copy, storage.getDirectory() );
+    std::list<boost::shared_ptr<Image> > images;
+    storage.get(makeKey(1, 1), 0, false, &images);
+    expectSameImage(image, images);
+    {
+        DiskCacheNodeStorage originalStorage;
+        originalStorage.setDirectory(original);
+        EXPECT_TRUE( originalStorage.hasFrame(1, 1, 0, 0, false) );
+        originalStorage.clear();
+    }
+
+    storage.moveToDirectory(moved);
+    EXPECT_TRUE( storage.hasFrame(1, 1, 0, 0, false) );
+    {
+        DiskCacheNodeStorage copyStorage;
+        copyStorage.setDirectory(copy);
+        EXPECT_FALSE( copyStorage.hasFrame(1, 1, 0, 0, false) );
+    }
+
+    storage.clear();
+}
@@ -108,3 +108,88 @@ TEST(ImageKeyTest,Difference) {
     ASSERT_TRUE(keyHash1 != keyHash2);
 }
 
+
+TEST(ImageTest,SparseImageSize) {
+    ///A large image with a bitmap: only the memory of what is rendered should be counted
+    RectI bounds(0,0,4096,2160);
+    RectD rod(0,0,4096,2160);
+    Natron::Image img(Natron::eImageComponentRGBA, rod, bounds, 0, 1., Natron::eImageBitDepthFloat, true);
+    std::size_t bitmapSize = bounds.area();
+    std::size_t fullSize = img.dataSize();
+
+    ASSERT_EQ( (std::size_t)bounds.area() * 4 * sizeof(float), fullSize );
+    if ( !img.isSparse() ) {
+        ///Debug builds fill new images with red
+        ASSERT_EQ( fullSize + bitmapSize, img.size() );
+
+        return;
+    }
+    ASSERT_EQ( bitmapSize, img.size() );
+
+    ///The memory is zero-initialized
+    ASSERT_EQ( 0.f, *(const float*)img.pixelAt(2000, 2000) );
+
+    ///Each row of the tile is a page at most, it spans 1 or 2 pages
+    RectI tile(100,100,356,356);
+    std::size_t pageSize = Natron::getMemoryPageSize();
+    img.markForRendered(tile);
+    std::size_t committed = img.size() - bitmapSize;
+    EXPECT_GE( committed, tile.height() * pageSize );
+    EXPECT_LE( committed, 2 * tile.height() * pageSize );
+
+    ///Rendering the same pixels again does not change the size
+    img.markForRendered(tile);
+    EXPECT_EQ( committed, img.size() - bitmapSize );
+
+    img.markForRendered(bounds);
+    EXPECT_EQ( fullSize + bitmapSize, img.size() );
+}
+
+TEST(ImageTest,ConvertedCopiesAreReused) {
+    RectI bounds(0,0,64,64);
+    RectD rod(0,0,64,64);
+    Natron::Image img(Natron::eImageComponentRGBA, rod, bounds, 0, 1., Natron::eImageBitDepthFloat, true);
+
+    for (int y = bounds.y1; y < bounds.y2; ++y) {
+        float* pix = (float*)img.pixelAt(bounds.x1, y);
+        for (int x = bounds.x1; x < bounds.x2; ++x, pix += 4) {
+            pix[0] = pix[1] = pix[2] = 0.25f;
+            pix[3] = x < 32 ? 0.f : 1.f;
+        }
+    }
+    img.markForRendered(bounds);
+    std::size_t sizeBefore = img.size();
+
+    RectI left(0,0,32,64);
+    boost::shared_ptr<Natron::Image> alpha = img.getConvertedCopy(left, Natron::eImageComponentAlpha, Natron::eImageBitDepthByte,
+                                                                  Natron::eViewerColorSpaceLinear, Natron::eViewerColorSpaceLinear,
+                                                                  -1, false);
+    ASSERT_TRUE(alpha);
+    EXPECT_EQ( Natron::eImageComponentAlpha, alpha->getComponents() );
+    EXPECT_EQ( Natron::eImageBitDepthByte, alpha->getBitDepth() );
+    EXPECT_EQ( 0, *alpha->pixelAt(10, 10) );
+
+    ///Only the left half was converted
+    std::list<RectI> rest;
+    alpha->getRestToRender(bounds, rest);
+    ASSERT_FALSE( rest.empty() );
+
+    ///The same conversion gives back the same copy, which now has both halves converted
+    boost::shared_ptr<Natron::Image> again = img.getConvertedCopy(bounds, Natron::eImageComponentAlpha, Natron::eImageBitDepthByte,
+                                                                  Natron::eViewerColorSpaceLinear, Natron::eViewerColorSpaceLinear,
+                                                                  -1, false);
+    EXPECT_EQ( alpha.get(), again.get() );
+    EXPECT_EQ( 255, *again->pixelAt(40, 10) );
+    rest.clear();
+    again->getRestToRender(bounds, rest);
+    EXPECT_TRUE( rest.empty() );
+
+    ///The copy is counted in the size of the image
+    EXPECT_EQ( sizeBefore + again->size(), img.size() );
+
+    ///Clearing the bitmap of the source invalidates the conversion
+    img.clearBitmap(left);
+    rest.clear();
+    again->getRestToRender(bounds, rest);
+    EXPECT_FALSE( rest.empty() );
+}
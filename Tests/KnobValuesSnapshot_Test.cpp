@@ -0,0 +1,238 @@
+//  Natron
+//
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+
+#include "BaseTest.h"
+
+#include <QSemaphore>
+#include <QtConcurrentRun>
+
+#include "Engine/EffectInstance.h"
+#include "Engine/KnobTypes.h"
+#include "Engine/KnobValuesSnapshot.h"
+#include "Engine/Node.h"
+
+using namespace Natron;
+
+namespace {
+
+struct RenderThreadReads
+{
+    QSemaphore argsSet; //< released by the render thread once the render args are set
+    QSemaphore valueChanged; //< released by the main thread once the knob value is changed
+    double valueInRender;
+    double valueAtTimeInRender;
+    double valueAfterRender;
+    double valueAtTimeAfterRender;
+};
+
+void
+readKnobDuringRender(Node* node,
+                     Double_Knob* knob,
+                     RenderThreadReads* reads)
+{
+    {
+        ParallelRenderArgsSetter frameArgs(node, 1, 0, false, false, false, node->getHashValue(), false, NULL);
+        reads->argsSet.release();
+        reads->valueChanged.acquire();
+        reads->valueInRender = knob->getValue(0);
+        reads->valueAtTimeInRender = knob->getValueAtTime(1, 0);
+    }
+    reads->valueAfterRender = knob->getValue(0);
+    reads->valueAtTimeAfterRender = knob->getValueAtTime(1, 0);
+}
+
+}
+
+TEST_F(BaseTest,KnobValuesSnapshotStaticValues)
+{
+    boost::shared_ptr<Node> generator = createNode(_dotGeneratorPluginID);
+    EffectInstance* effect = generator->getLiveInstance();
+
+    boost::shared_ptr<Double_Knob> doubleKnob = effect->createKnob<Double_Knob>("snapshotDouble");
+    boost::shared_ptr<Int_Knob> intKnob = effect->createKnob<Int_Knob>("snapshotInt");
+    boost::shared_ptr<Bool_Knob> boolKnob = effect->createKnob<Bool_Knob>("snapshotBool");
+    boost::shared_ptr<String_Knob> stringKnob = effect->createKnob<String_Knob>("snapshotString");
+    doubleKnob->setValue(0.5, 0);
+    intKnob->setValue(3, 0);
+    boolKnob->setValue(true, 0);
+    stringKnob->setValue("value", 0);
+
+    KnobValuesSnapshot snapshot(effect, 1, 42);
+    EXPECT_EQ( 1, snapshot.getTime() );
+    EXPECT_EQ( (U64)42, snapshot.getNodeHash() );
+
+    double value;
+    ASSERT_TRUE( snapshot.getValue(doubleKnob.get(), 1, 0, false, &value) );
+    EXPECT_EQ(0.5, value);
+    ASSERT_TRUE( snapshot.getValue(intKnob.get(), 1, 0, false, &value) );
+    EXPECT_EQ(3., value);
+    ASSERT_TRUE( snapshot.getValue(boolKnob.get(), 1, 0, false, &value) );
+    EXPECT_EQ(1., value);
+
+    ///Strings are not captured
+    EXPECT_FALSE( snapshot.getValue(stringKnob.get(), 1, 0, false, &value) );
+
+    ///Other times are read through the knob
+    EXPECT_FALSE( snapshot.getValue(doubleKnob.get(), 2, 0, false, &value) );
+
+    ///The snapshot is immutable
+    doubleKnob->setValue(2., 0);
+    ASSERT_TRUE( snapshot.getValue(doubleKnob.get(), 1, 0, false, &value) );
+    EXPECT_EQ(0.5, value);
+}
+
+TEST_F(BaseTest,KnobValuesSnapshotAnimatedValues)
+{
+    boost::shared_ptr<Node> generator = createNode(_dotGeneratorPluginID);
+    EffectInstance* effect = generator->getLiveInstance();
+
+    boost::shared_ptr<Double_Knob> knob = effect->createKnob<Double_Knob>("snapshotAnimated");
+    knob->setValueAtTime(1, 1., 0);
+    knob->setValueAtTime(11, 11., 0);
+
+    KnobValuesSnapshot atFirstKey(effect, 1, 0);
+    KnobValuesSnapshot betweenKeys(effect, 6, 0);
+    KnobValuesSnapshot atLastKey(effect, 11, 0);
+
+    double value;
+    ASSERT_TRUE( atFirstKey.getValue(knob.get(), 1, 0, false, &value) );
+    EXPECT_EQ(1., value);
+    ASSERT_TRUE( atLastKey.getValue(knob.get(), 11, 0, false, &value) );
+    EXPECT_EQ(11., value);
+
+    ///Interpolated values are resolved through the animation curve
+    ASSERT_TRUE( betweenKeys.getValue(knob.get(), 6, 0, false, &value) );
+    EXPECT_EQ(knob->getValueAtTime(6, 0, false), value);
+    EXPECT_NE(1., value);
+    EXPECT_NE(11., value);
+
+    ///Each snapshot only answers for its own time
+    EXPECT_FALSE( atFirstKey.getValue(knob.get(), 11, 0, false, &value) );
+    EXPECT_FALSE( atLastKey.getValue(knob.get(), 1, 0, false, &value) );
+}
+
+TEST_F(BaseTest,KnobValuesSnapshotDimensions)
+{
+    boost::shared_ptr<Node> generator = createNode(_dotGeneratorPluginID);
+    EffectInstance* effect = generator->getLiveInstance();
+
+    boost::shared_ptr<Double_Knob> knob = effect->createKnob<Double_Knob>("snapshotDimensions", 3);
+    knob->setValue(1., 0);
+    knob->setValue(-2., 1);
+    knob->setValue(3., 2);
+    knob->setMinimum(0., 1);
+
+    KnobValuesSnapshot snapshot(effect, 1, 0);
+
+    double value;
+    ASSERT_TRUE( snapshot.getValue(knob.get(), 1, 0, false, &value) );
+    EXPECT_EQ(1., value);
+    ASSERT_TRUE( snapshot.getValue(knob.get(), 1, 2, false, &value) );
+    EXPECT_EQ(3., value);
+
+    ///Both the raw and the clamped values are captured
+    ASSERT_TRUE( snapshot.getValue(knob.get(), 1, 1, false, &value) );
+    EXPECT_EQ(-2., value);
+    ASSERT_TRUE( snapshot.getValue(knob.get(), 1, 1, true, &value) );
+    EXPECT_EQ(0., value);
+
+    EXPECT_FALSE( snapshot.getValue(knob.get(), 1, 3, false, &value) );
+    EXPECT_FALSE( snapshot.getValue(knob.get(), 1, -1, false, &value) );
+
+    ///Knobs of other holders are not in the snapshot
+    boost::shared_ptr<Node> other = createNode(_dotGeneratorPluginID);
+    boost::shared_ptr<Double_Knob> otherKnob = other->getLiveInstance()->createKnob<Double_Knob>("snapshotOther");
+    EXPECT_FALSE( snapshot.getValue(otherKnob.get(), 1, 0, false, &value) );
+}
+
+TEST_F(BaseTest,KnobValuesSnapshotReadDuringRender)
+{
+    boost::shared_ptr<Node> generator = createNode(_dotGeneratorPluginID);
+    boost::shared_ptr<Double_Knob> knob = generator->getLiveInstance()->createKnob<Double_Knob>("snapshotRendered");
+    knob->setValue(0.5, 0);
+
+    ///Snapshots are only taken by render threads
+    RenderThreadReads reads;
+    QFuture<void> render = QtConcurrent::run(readKnobDuringRender, generator.get(), knob.get(), &reads);
+    reads.argsSet.acquire();
+    knob->setValue(2., 0);
+    reads.valueChanged.release();
+    render.waitForFinished();
+
+    ///The render reads the values of the knob when the frame render started
+    EXPECT_EQ(0.5, reads.valueInRender);
+    EXPECT_EQ(0.5, reads.valueAtTimeInRender);
+
+    ///Outside of the render args, the live value is read
+    EXPECT_EQ(2., reads.valueAfterRender);
+    EXPECT_EQ(2., reads.valueAtTimeAfterRender);
+    EXPECT_EQ( 2., knob->getValue(0) );
+}
+
+TEST_F(BaseTest,KnobValuesSnapshotTypedKnobs)
+{
+    boost::shared_ptr<Node> generator = createNode(_dotGeneratorPluginID);
+    EffectInstance* effect = generator->getLiveInstance();
+
+    KnobValuesSnapshot::TypedKnobs knobs;
+    KnobValuesSnapshot::getTypedKnobs(effect, &knobs);
+    U64 version = effect->getKnobsVersion();
+
+    ///Adding a knob changes the version, so that the cached typed knobs are found again
+    boost::shared_ptr<Int_Knob> intKnob = effect->createKnob<Int_Knob>("snapshotTyped");
+    intKnob->setValue(7, 0);
+    EXPECT_NE( version, effect->getKnobsVersion() );
+
+    KnobValuesSnapshot::TypedKnobs newKnobs;
+    KnobValuesSnapshot::getTypedKnobs(effect, &newKnobs);
+    ASSERT_EQ(knobs.size() + 1, newKnobs.size());
+    for (U32 i = 1; i < newKnobs.size(); ++i) {
+        EXPECT_LT(newKnobs[i - 1].knob, newKnobs[i].knob);
+    }
+
+    double value;
+    KnobValuesSnapshot outdated(knobs, 1, 0);
+    EXPECT_FALSE( outdated.getValue(intKnob.get(), 1, 0, false, &value) );
+    KnobValuesSnapshot snapshot(newKnobs, 1, 0);
+    ASSERT_TRUE( snapshot.getValue(intKnob.get(), 1, 0, false, &value) );
+    EXPECT_EQ(7., value);
+}
+
+TEST_F(BaseTest,KnobGetValuesAtUnsortedTimes)
+{
+    boost::shared_ptr<Node> generator = createNode(_dotGeneratorPluginID);
+    EffectInstance* effect = generator->getLiveInstance();
+
+    boost::shared_ptr<Double_Knob> knob = effect->createKnob<Double_Knob>("valuesAtTimes");
+    knob->setValueAtTime(1, 1., 0);
+    knob->setValueAtTime(5, 10., 0);
+    knob->setValueAtTime(11, -4., 0);
+
+    ///Unsorted, with duplicates, before and after the keyframes
+    std::vector<int> times;
+    times.push_back(8);
+    times.push_back(2);
+    times.push_back(11);
+    times.push_back(-3);
+    times.push_back(8);
+    times.push_back(5);
+    times.push_back(20);
+    times.push_back(2);
+
+    std::vector<double> values;
+    knob->getValuesAtTimes(times, 0, &values);
+    ASSERT_EQ( times.size(), values.size() );
+    for (std::size_t i = 0; i < times.size(); ++i) {
+        EXPECT_EQ(knob->getValueAtTime(times[i], 0), values[i]);
+    }
+    EXPECT_EQ(values[0], values[4]);
+    EXPECT_EQ(values[1], values[7]);
+    EXPECT_EQ(10., values[5]);
+}
@@ -0,0 +1,189 @@
+//  Natron
+//
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+
+#include "BaseTest.h"
+
+#include <list>
+#include <sstream>
+#include <string>
+
+#include <QDir>
+#include <QFile>
+
+#include "Engine/AppInstance.h"
+#include "Engine/EffectInstance.h"
+#include "Engine/KnobTypes.h"
+#include "Engine/Node.h"
+#include "Engine/Project.h"
+#include "Engine/ProjectSerialization.h"
+
+using namespace Natron;
+
+namespace {
+
+QString
+journalPath(const char* name)
+{
+    QString path = QDir::temp().absoluteFilePath( QString(name) );
+
+    QFile::remove(path);
+
+    return path;
+}
+
+///The serialization of a live project references its knobs: write it and read it back to freeze the values
+void
+takeSnapshot(AppInstance* app,
+             ProjectSerialization* snapshot)
+{
+    ProjectSerialization live(app);
+
+    live.initialize( app->getProject().get() );
+    std::stringstream ss;
+    {
+        boost::archive::xml_oarchive oArchive(ss);
+        oArchive << boost::serialization::make_nvp("Project", live);
+    }
+    boost::archive::xml_iarchive iArchive(ss);
+    iArchive >> boost::serialization::make_nvp("Project", *snapshot);
+}
+
+boost::shared_ptr<NodeSerialization>
+findNode(const ProjectSerialization & project,
+         const std::string & scriptName)
+{
+    const std::list< boost::shared_ptr<NodeSerialization> > & nodes = project.getNodesSerialization().getNodesSerialization();
+
+    for (std::list< boost::shared_ptr<NodeSerialization> >::const_iterator it = nodes.begin(); it != nodes.end(); ++it) {
+        if ( (*it)->getNodeScriptName() == scriptName ) {
+            return *it;
+        }
+    }
+
+    return boost::shared_ptr<NodeSerialization>();
+}
+
+double
+knobValue(const NodeSerialization & node,
+          const std::string & knobName)
+{
+    const NodeSerialization::KnobValues & knobs = node.getKnobsValues();
+
+    for (NodeSerialization::KnobValues::const_iterator it = knobs.begin(); it != knobs.end(); ++it) {
+        if ( (*it)->getName() == knobName ) {
+            Knob<double>* isDouble = dynamic_cast<Knob<double>*>( (*it)->getKnob().get() );
+            if (isDouble) {
+                return isDouble->getValue(0);
+            }
+        }
+    }
+    ADD_FAILURE() << "No double knob named " << knobName;
+
+    return 0.;
+}
+
+void
+appendEntry(const boost::shared_ptr<Node> & node,
+            const Project* project,
+            const QString & journal)
+{
+    std::list< boost::shared_ptr<Node> > nodes;
+
+    nodes.push_back(node);
+    ProjectJournalEntrySerialization entry;
+    entry.initialize(nodes, project);
+    ASSERT_TRUE( entry.appendToJournal(journal) );
+}
+
+}
+
+TEST_F(BaseTest,ProjectJournalReplay)
+{
+    boost::shared_ptr<Node> generator = createNode(_dotGeneratorPluginID);
+    boost::shared_ptr<Node> writer = createNode(_writeOIIOPluginID);
+    boost::shared_ptr<Project> project = _app->getProject();
+
+    boost::shared_ptr<Double_Knob> knob = generator->getLiveInstance()->createKnob<Double_Knob>("journalKnob");
+    knob->setValue(1., 0);
+
+    ProjectSerialization snapshot(_app);
+    takeSnapshot(_app, &snapshot);
+
+    QString journal = journalPath("natronProjectJournalReplay.journal");
+
+    ///A knob change, then a connection change
+    knob->setValue(2., 0);
+    appendEntry(generator, project.get(), journal);
+    connectNodes(generator, writer, 0, true);
+    appendEntry(writer, project.get(), journal);
+
+    ///The snapshot is not affected until the journal is replayed
+    boost::shared_ptr<NodeSerialization> generatorState = findNode( snapshot, generator->getScriptName() );
+    boost::shared_ptr<NodeSerialization> writerState = findNode( snapshot, writer->getScriptName() );
+    ASSERT_TRUE(generatorState && writerState);
+    EXPECT_EQ( 1., knobValue(*generatorState, "journalKnob") );
+    EXPECT_TRUE( writerState->getInputs().empty() || writerState->getInputs()[0].empty() );
+
+    EXPECT_EQ( 2, snapshot.replayJournal(journal) );
+
+    generatorState = findNode( snapshot, generator->getScriptName() );
+    writerState = findNode( snapshot, writer->getScriptName() );
+    ASSERT_TRUE(generatorState && writerState);
+    EXPECT_EQ( 2., knobValue(*generatorState, "journalKnob") );
+    ASSERT_FALSE( writerState->getInputs().empty() );
+    EXPECT_EQ( generator->getScriptName(), writerState->getInputs()[0] );
+
+    QFile::remove(journal);
+}
+
+TEST_F(BaseTest,ProjectJournalTruncatedEntry)
+{
+    boost::shared_ptr<Node> generator = createNode(_dotGeneratorPluginID);
+    boost::shared_ptr<Project> project = _app->getProject();
+
+    boost::shared_ptr<Double_Knob> knob = generator->getLiveInstance()->createKnob<Double_Knob>("journalKnob");
+    knob->setValue(1., 0);
+
+    ProjectSerialization snapshot(_app);
+    takeSnapshot(_app, &snapshot);
+
+    QString journal = journalPath("natronProjectJournalTruncated.journal");
+    knob->setValue(2., 0);
+    appendEntry(generator, project.get(), journal);
+
+    ///Write the last entry aside and only append its beginning, as a crash during the write would
+    QString lastEntry = journalPath("natronProjectJournalLastEntry.journal");
+    knob->setValue(3., 0);
+    appendEntry(generator, project.get(), lastEntry);
+    QByteArray lastEntryData;
+    {
+        QFile f(lastEntry);
+        ASSERT_TRUE( f.open(QIODevice::ReadOnly) );
+        lastEntryData = f.readAll();
+    }
+    ASSERT_GT(lastEntryData.size(), 16);
+    {
+        QFile f(journal);
+        ASSERT_TRUE( f.open(QIODevice::WriteOnly | QIODevice::Append) );
+        EXPECT_EQ( (qint64)lastEntryData.size() - 16, f.write( lastEntryData.left(lastEntryData.size() - 16) ) );
+    }
+
+    ///The complete entry is applied, the truncated one is ignored
+    EXPECT_EQ( 1, snapshot.replayJournal(journal) );
+    boost::shared_ptr<NodeSerialization> generatorState = findNode( snapshot, generator->getScriptName() );
+    ASSERT_TRUE(generatorState);
+    EXPECT_EQ( 2., knobValue(*generatorState, "journalKnob") );
+
+    ///A missing journal leaves the snapshot untouched
+    EXPECT_EQ( 0, snapshot.replayJournal( journalPath("natronProjectJournalMissing.journal") ) );
+
+    QFile::remove(journal);
+    QFile::remove(lastEntry);
+}
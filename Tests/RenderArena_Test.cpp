@@ -0,0 +1,92 @@
+//  Natron
+//
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+
+#include <map>
+
+#include <gtest/gtest.h>
+
+#include "Engine/RenderArena.h"
+
+using namespace Natron;
+
+typedef std::map<int,double,std::less<int>,RenderArenaAllocator<std::pair<const int,double> > > ArenaMap;
+
+TEST(RenderArena,AllocationsAreCountedPerFrame)
+{
+    RenderArena::resetStats();
+    for (int frame = 0; frame < 2; ++frame) {
+        RenderArena::FrameScope scope;
+        RenderRectsList rects;
+        for (int i = 0; i < 100; ++i) {
+            rects.push_back( RectI(0, 0, i, i) );
+        }
+        ArenaMap roi;
+        for (int i = 0; i < 100; ++i) {
+            roi[i] = i;
+        }
+        EXPECT_EQ( 100, (int)rects.size() );
+        EXPECT_EQ( 99, rects.back().x2 );
+        EXPECT_EQ( 42., roi[42] );
+    }
+
+    RenderArena::Stats stats;
+    RenderArena::getStats(&stats);
+    EXPECT_EQ( (U64)2, stats.frames );
+    EXPECT_EQ( (U64)400, stats.allocations );
+    ///The blocks of the first frame are reused by the second one
+    EXPECT_LE( stats.heapAllocations, (U64)1 );
+}
+
+TEST(RenderArena,NestedScopesAndHeapFallback)
+{
+    RenderArena::resetStats();
+    RenderRectsList outsideFrame;
+    outsideFrame.push_back( RectI(0, 0, 1, 1) );
+    {
+        RenderArena::FrameScope scope;
+        {
+            RenderArena::FrameScope nested;
+            outsideFrame.push_back( RectI(0, 0, 2, 2) );
+        }
+        RenderArena::Stats stats;
+        RenderArena::getStats(&stats);
+        ///The frame is not over yet
+        EXPECT_EQ( (U64)0, stats.frames );
+    }
+    RenderArena::Stats stats;
+    RenderArena::getStats(&stats);
+    EXPECT_EQ( (U64)1, stats.frames );
+    EXPECT_EQ( (U64)1, stats.allocations );
+    EXPECT_EQ( 2, (int)outsideFrame.size() );
+}
+
+TEST(RenderArena,MemoryOutlivingTheFrame)
+{
+    RenderRectsList survivor;
+    {
+        RenderArena::FrameScope scope;
+        for (int i = 0; i < 10; ++i) {
+            survivor.push_back( RectI(i, i, i + 1, i + 1) );
+        }
+    }
+    ///The next frame must not overwrite the rectangles still referenced
+    {
+        RenderArena::FrameScope scope;
+        RenderRectsList other;
+        for (int i = 0; i < 10; ++i) {
+            other.push_back( RectI(-1, -1, -1, -1) );
+        }
+    }
+    int i = 0;
+    for (RenderRectsList::iterator it = survivor.begin(); it != survivor.end(); ++it, ++i) {
+        EXPECT_EQ(i, it->x1);
+        EXPECT_EQ(i + 1, it->y2);
+    }
+}
@@ -0,0 +1,209 @@
+//  Natron
+//
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+
+#include "BaseTest.h"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QProcess>
+#include <QProcessEnvironment>
+
+#include "Global/GlobalDefines.h"
+#include "Global/Macros.h"
+#include "Engine/RenderWorker.h"
+
+///Set in the environment of the fake workers started by RenderCoordinatorFailedChunk to the name of the coordinator server
+#define kFakeRenderWorkerPipeEnv "NATRON_TEST_FAKE_RENDER_WORKER_PIPE"
+
+///The frame that the fake workers fail to render
+#define kFakeRenderWorkerFailingFrame 5
+
+namespace {
+
+///Starts this test program running only RenderWorkerFake, which plays the worker side of the protocol
+class FakeWorkersCoordinator
+    : public RenderCoordinator
+{
+public:
+
+    FakeWorkersCoordinator(int workersCount)
+        : RenderCoordinator(QString(), workersCount)
+    {
+    }
+
+private:
+
+    virtual bool startWorkerProcess(QProcess* process,
+                                    const QString& serverName,
+                                    QString* error) OVERRIDE FINAL
+    {
+        QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
+
+        env.insert(kFakeRenderWorkerPipeEnv, serverName);
+        process->setProcessEnvironment(env);
+        process->setProcessChannelMode(QProcess::ForwardedChannels);
+        process->start( QCoreApplication::applicationFilePath(), QStringList() << "--gtest_filter=BaseTest.RenderWorkerFake" );
+        if ( !process->waitForStarted() ) {
+            *error = process->errorString();
+
+            return false;
+        }
+
+        return true;
+    }
+};
+
+void
+writeLine(QLocalSocket* socket,
+          const QString& message)
+{
+    socket->write( (message + '\n').toUtf8() );
+    socket->flush();
+}
+
+}
+
+TEST(RenderWorkerRequest,FrameRanges) {
+    std::vector<std::pair<int,int> > ranges;
+
+    ASSERT_TRUE( RenderWorkerRequest::frameRangesFromString("1-10,12, 20-25,-5--2", &ranges) );
+    ASSERT_EQ( (std::size_t)4, ranges.size() );
+    EXPECT_EQ( std::make_pair(1,10), ranges[0] );
+    EXPECT_EQ( std::make_pair(12,12), ranges[1] );
+    EXPECT_EQ( std::make_pair(20,25), ranges[2] );
+    EXPECT_EQ( std::make_pair(-5,-2), ranges[3] );
+    EXPECT_EQ( QString("1-10,12,20-25,-5--2"), RenderWorkerRequest::frameRangesToString(ranges) );
+
+    EXPECT_FALSE( RenderWorkerRequest::frameRangesFromString("", &ranges) );
+    EXPECT_FALSE( RenderWorkerRequest::frameRangesFromString("10-1", &ranges) ) << "A range must not be reversed";
+    EXPECT_FALSE( RenderWorkerRequest::frameRangesFromString("1-10,", &ranges) );
+    EXPECT_FALSE( RenderWorkerRequest::frameRangesFromString("1-a", &ranges) );
+    EXPECT_EQ( (std::size_t)4, ranges.size() ) << "Ranges are left untouched on failure";
+}
+
+TEST(RenderWorkerRequest,SplitFrameRanges) {
+    std::vector<std::pair<int,int> > ranges;
+    ranges.push_back( std::make_pair(1,10) );
+    ranges.push_back( std::make_pair(20,21) );
+
+    std::list<std::pair<int,int> > chunks;
+    RenderWorkerRequest::splitFrameRanges(ranges, 4, &chunks);
+    ASSERT_EQ( (std::size_t)4, chunks.size() );
+    std::list<std::pair<int,int> >::iterator it = chunks.begin();
+    EXPECT_EQ( std::make_pair(1,4), *it++ );
+    EXPECT_EQ( std::make_pair(5,8), *it++ );
+    EXPECT_EQ( std::make_pair(9,10), *it++ ) << "Chunks do not span several ranges";
+    EXPECT_EQ( std::make_pair(20,21), *it++ );
+
+    chunks.clear();
+    RenderWorkerRequest::splitFrameRanges(ranges, 0, &chunks);
+    EXPECT_EQ( (std::size_t)12, chunks.size() ) << "A chunk has at least 1 frame";
+}
+
+TEST(RenderWorkerRequest,Message) {
+    RenderWorkerRequest request;
+    request.writerName = "Write1";
+    request.frameRanges.push_back( std::make_pair(1,10) );
+    request.frameRanges.push_back( std::make_pair(15,15) );
+    request.allFrames = false;
+    request.paramOverrides.push_back( std::make_pair( QString("Write1.filename"), QString("/renders/shot_###.exr") ) );
+    request.paramOverrides.push_back( std::make_pair( QString("Group1.Blur1.size.0"), QString("a=b") ) );
+
+    QString message = request.toString();
+    ASSERT_TRUE( message.startsWith(kRenderWorkerRequestShort) );
+    ASSERT_EQ( -1, message.indexOf('\n') ) << "A request is a single line";
+
+    RenderWorkerRequest read;
+    QString error;
+    ASSERT_TRUE( RenderWorkerRequest::fromString(message + '\n', &read, &error) ) << error.toStdString();
+    EXPECT_EQ(request.writerName, read.writerName);
+    EXPECT_EQ(request.frameRanges, read.frameRanges);
+    EXPECT_FALSE(read.allFrames);
+    EXPECT_EQ(request.paramOverrides, read.paramOverrides) << "Values may contain '='";
+
+    EXPECT_FALSE( RenderWorkerRequest::fromString(kRenderWorkerQuitShort, &read, &error) );
+    EXPECT_FALSE( error.isEmpty() );
+    EXPECT_FALSE( RenderWorkerRequest::fromString(QString(kRenderWorkerRequestShort) + "\tWrite1", &read, &error) );
+    EXPECT_FALSE( RenderWorkerRequest::fromString(QString(kRenderWorkerRequestShort) + "\tWrite1\t1-10", &read, &error) );
+    EXPECT_FALSE( RenderWorkerRequest::fromString(QString(kRenderWorkerRequestShort) + "\tWrite1\t1-10\tsome", &read, &error) );
+    EXPECT_FALSE( RenderWorkerRequest::fromString(QString(kRenderWorkerRequestShort) + "\tWrite1\t1-10\tall\tnoValue", &read, &error) );
+    ASSERT_TRUE( RenderWorkerRequest::fromString(QString(kRenderWorkerRequestShort) + "\tWrite1\t1-10\tall", &read, &error) );
+    EXPECT_TRUE(read.allFrames);
+}
+
+///Not a test on its own: the worker process started by RenderCoordinatorFailedChunk
+TEST_F(BaseTest,RenderWorkerFake)
+{
+    QString pipe = QProcessEnvironment::systemEnvironment().value(kFakeRenderWorkerPipeEnv);
+    if ( pipe.isEmpty() ) {
+        return;
+    }
+
+    QLocalSocket output;
+    output.connectToServer(pipe, QLocalSocket::ReadWrite);
+    ASSERT_TRUE( output.waitForConnected(5000) );
+
+    QLocalServer inputServer;
+    ASSERT_TRUE( inputServer.listen( QDir::temp().absoluteFilePath( "NatronFakeRenderWorker" + QString::number( QCoreApplication::applicationPid() ) ) ) );
+    writeLine( &output, QString(kBgProcessServerCreatedShort) + inputServer.fullServerName() );
+    ASSERT_TRUE( inputServer.waitForNewConnection(5000) );
+    QLocalSocket* input = inputServer.nextPendingConnection();
+
+    for (;;) {
+        while ( !input->canReadLine() ) {
+            if ( !input->waitForReadyRead(30000) ) {
+                return;
+            }
+        }
+        QString message = QString::fromUtf8( input->readLine() );
+        message.remove('\n');
+        if ( message.startsWith(kRenderWorkerQuitShort) ) {
+            return;
+        }
+        if ( !message.startsWith(kRenderWorkerRequestShort) ) {
+            ///e.g: the abort of the chunks still rendering when the coordinator gives up
+            continue;
+        }
+        RenderWorkerRequest request;
+        QString error;
+        ASSERT_TRUE( RenderWorkerRequest::fromString(message, &request, &error) ) << error.toStdString();
+
+        bool failed = false;
+        for (std::vector<std::pair<int,int> >::const_iterator it = request.frameRanges.begin(); it != request.frameRanges.end(); ++it) {
+            for (int f = it->first; f <= it->second; ++f) {
+                if (f == kFakeRenderWorkerFailingFrame) {
+                    failed = true;
+                } else if (!failed) {
+                    writeLine( &output, QString(kFrameRenderedStringShort) + QString::number(f) );
+                }
+            }
+        }
+        if (failed) {
+            writeLine( &output, QString(kRenderWorkerRequestFailedShort) + "Fake failure" );
+        } else {
+            writeLine(&output, kRenderWorkerRequestDoneShort);
+        }
+    }
+}
+
+TEST_F(BaseTest,RenderCoordinatorFailedChunk)
+{
+    RenderWorkerRequest request;
+    request.writerName = "Write1";
+    request.frameRanges.push_back( std::make_pair(1,10) );
+
+    FakeWorkersCoordinator coordinator(2);
+    QString error;
+    EXPECT_FALSE( coordinator.render(request, 2, &error) ) << "The chunk holding the failing frame must fail the render";
+    EXPECT_NE( -1, error.indexOf("5-6") ) << error.toStdString();
+    EXPECT_NE( -1, error.indexOf("Fake failure") ) << error.toStdString();
+}
@@ -153,10 +153,16 @@ SOURCES += \
     google-test/src/gtest_main.cc \
     google-mock/src/gmock-all.cc \
     BaseTest.cpp \
+    CacheIO_Test.cpp \
+    DiskCacheNodeStorage_Test.cpp \
     Hash64_Test.cpp \
     Image_Test.cpp \
     Lut_Test.cpp \
     File_Knob_Test.cpp \
+    KnobValuesSnapshot_Test.cpp \
+    ProjectJournal_Test.cpp \
+    RenderArena_Test.cpp \
+    RenderWorker_Test.cpp \
     Curve_Test.cpp
 
 HEADERS += \